@@ -51,6 +51,10 @@ private:
     std::unique_ptr<std::unordered_map<unsigned int, double>> point_hash_map_;
     std::unique_ptr<std::unordered_map<unsigned int, double>> marker_hash_map_;
 
+    //! version of the map whose landmarks have been sent (the changes after it are sent next)
+    uint64_t landmark_version_ = 0;
+    bool landmark_version_is_valid_ = false;
+
     double current_pose_hash_ = 0;
     int frame_hash_ = 0;
 
@@ -66,7 +70,8 @@ private:
                                       const std::vector<std::shared_ptr<stella_vslam::data::landmark>>& all_landmarks,
                                       const std::set<std::shared_ptr<stella_vslam::data::landmark>>& local_landmarks,
                                       const std::vector<std::shared_ptr<stella_vslam::data::marker>>& all_markers,
-                                      const stella_vslam::Mat44_t& current_camera_pose);
+                                      const stella_vslam::Mat44_t& current_camera_pose,
+                                      const std::vector<unsigned int>* erased_landmark_ids = nullptr);
 
     std::string base64_encode(unsigned char const* bytes_to_encode, unsigned int in_len);
 };
@@ -3,6 +3,7 @@
 #include "stella_vslam/data/keyframe.h"
 #include "stella_vslam/data/landmark.h"
 #include "stella_vslam/data/marker.h"
+#include "stella_vslam/data/map_database.h"
 #include "stella_vslam/publish/frame_publisher.h"
 #include "stella_vslam/publish/map_publisher.h"
 
@@ -47,34 +48,53 @@ std::string data_serializer::serialize_messages(const std::vector<std::string>&
 }
 
 std::string data_serializer::serialize_map_diff() {
+    const auto current_camera_pose = map_publisher_->get_current_cam_pose();
+
+    const double pose_hash = get_mat_hash(current_camera_pose);
+    if (pose_hash == current_pose_hash_) {
+        current_pose_hash_ = pose_hash;
+        return "";
+    }
+    current_pose_hash_ = pose_hash;
+
     std::vector<std::shared_ptr<stella_vslam::data::keyframe>> keyframes;
     map_publisher_->get_keyframes(keyframes);
 
+    // only the landmarks changed since the last message are sent if the change journal covers them
     std::vector<std::shared_ptr<stella_vslam::data::landmark>> all_landmarks;
     std::set<std::shared_ptr<stella_vslam::data::landmark>> local_landmarks;
+    std::vector<unsigned int> erased_landmark_ids;
+    bool landmarks_are_changes = false;
     if (publish_points_) {
-        map_publisher_->get_landmarks(all_landmarks, local_landmarks);
+        stella_vslam::data::map_changes changes;
+        map_publisher_->get_changes_since(landmark_version_, changes);
+        if (landmark_version_is_valid_ && changes.is_complete_) {
+            all_landmarks = std::move(changes.updated_lms_);
+            erased_landmark_ids = std::move(changes.erased_lm_ids_);
+            map_publisher_->get_local_landmarks(local_landmarks);
+            landmarks_are_changes = true;
+        }
+        else {
+            map_publisher_->get_landmarks(all_landmarks, local_landmarks);
+        }
+        landmark_version_ = changes.version_;
+        landmark_version_is_valid_ = true;
     }
 
     std::vector<std::shared_ptr<stella_vslam::data::marker>> all_markers;
     map_publisher_->get_markers(all_markers);
 
-    const auto current_camera_pose = map_publisher_->get_current_cam_pose();
-
-    const double pose_hash = get_mat_hash(current_camera_pose);
-    if (pose_hash == current_pose_hash_) {
-        current_pose_hash_ = pose_hash;
-        return "";
-    }
-    current_pose_hash_ = pose_hash;
-
-    return serialize_as_protobuf(keyframes, all_landmarks, local_landmarks, all_markers, current_camera_pose);
+    return serialize_as_protobuf(keyframes, all_landmarks, local_landmarks, all_markers, current_camera_pose,
+                                 landmarks_are_changes ? &erased_landmark_ids : nullptr);
 }
 
 std::vector<std::string> data_serializer::serialize_map_diff(size_t max_keyframes, size_t max_landmarks) {
     std::vector<std::string> results;
     stella_vslam::Mat44_t dummy_pose = stella_vslam::Mat44_t::Identity();
 
+    // all the landmarks are sent, so the next diff starts from this version
+    const auto map_version = map_publisher_->get_map_version();
+
     std::vector<std::shared_ptr<stella_vslam::data::keyframe>> keyframes;
     map_publisher_->get_keyframes(keyframes);
 
@@ -121,6 +141,10 @@ std::vector<std::string> data_serializer::serialize_map_diff(size_t max_keyframe
     });
 
     results.push_back(serialize_as_protobuf(keyframes, all_landmarks, local_landmarks, all_markers, current_camera_pose));
+    if (publish_points_) {
+        landmark_version_ = map_version;
+        landmark_version_is_valid_ = true;
+    }
     return results;
 }
 
@@ -138,7 +162,8 @@ std::string data_serializer::serialize_as_protobuf(const std::vector<std::shared
                                                    const std::vector<std::shared_ptr<stella_vslam::data::landmark>>& all_landmarks,
                                                    const std::set<std::shared_ptr<stella_vslam::data::landmark>>& local_landmarks,
                                                    const std::vector<std::shared_ptr<stella_vslam::data::marker>>& all_markers,
-                                                   const stella_vslam::Mat44_t& current_camera_pose) {
+                                                   const stella_vslam::Mat44_t& current_camera_pose,
+                                                   const std::vector<unsigned int>* erased_landmark_ids) {
     map_segment::map map;
     auto message = map.add_messages();
     message->set_tag("0");
@@ -241,47 +266,84 @@ std::string data_serializer::serialize_as_protobuf(const std::vector<std::shared
 
     // 3. landmark registration
 
-    std::unordered_map<unsigned int, double> next_point_hash_map;
-    for (const auto& landmark : all_landmarks) {
-        if (!landmark || landmark->will_be_erased()) {
-            continue;
+    if (erased_landmark_ids) {
+        // all_landmarks contains only the changed landmarks
+        for (const auto& landmark : all_landmarks) {
+            if (!landmark || landmark->will_be_erased()) {
+                continue;
+            }
+
+            const auto id = landmark->id_;
+            const auto pos = landmark->get_pos_in_world();
+            const auto zip = get_vec_hash(pos);
+            const auto itr = point_hash_map_->find(id);
+            if (itr != point_hash_map_->end() && itr->second == zip) {
+                continue;
+            }
+            (*point_hash_map_)[id] = zip;
+            const unsigned int rgb[] = {0, 0, 0};
+
+            // add to protocol buffers
+            auto landmark_obj = map.add_landmarks();
+            landmark_obj->set_id(id);
+            for (int i = 0; i < 3; i++) {
+                landmark_obj->add_coords(pos[i]);
+            }
+            for (int i = 0; i < 3; i++) {
+                landmark_obj->add_color(rgb[i]);
+            }
+        }
+        for (const auto id : *erased_landmark_ids) {
+            if (!point_hash_map_->erase(id)) {
+                continue;
+            }
+            auto landmark_obj = map.add_landmarks();
+            landmark_obj->set_id(id);
         }
+    }
+    else {
+        std::unordered_map<unsigned int, double> next_point_hash_map;
+        for (const auto& landmark : all_landmarks) {
+            if (!landmark || landmark->will_be_erased()) {
+                continue;
+            }
 
-        const auto id = landmark->id_;
-        const auto pos = landmark->get_pos_in_world();
-        const auto zip = get_vec_hash(pos);
+            const auto id = landmark->id_;
+            const auto pos = landmark->get_pos_in_world();
+            const auto zip = get_vec_hash(pos);
 
-        // point exists on next_point_zip.
-        next_point_hash_map[id] = zip;
+            // point exists on next_point_zip.
+            next_point_hash_map[id] = zip;
 
-        // remove point from point_zip.
-        if (point_hash_map_->count(id) != 0) {
-            if (point_hash_map_->at(id) == zip) {
+            // remove point from point_zip.
+            if (point_hash_map_->count(id) != 0) {
+                if (point_hash_map_->at(id) == zip) {
+                    point_hash_map_->erase(id);
+                    continue;
+                }
                 point_hash_map_->erase(id);
-                continue;
             }
-            point_hash_map_->erase(id);
-        }
-        const unsigned int rgb[] = {0, 0, 0};
+            const unsigned int rgb[] = {0, 0, 0};
 
-        // add to protocol buffers
-        auto landmark_obj = map.add_landmarks();
-        landmark_obj->set_id(id);
-        for (int i = 0; i < 3; i++) {
-            landmark_obj->add_coords(pos[i]);
-        }
-        for (int i = 0; i < 3; i++) {
-            landmark_obj->add_color(rgb[i]);
+            // add to protocol buffers
+            auto landmark_obj = map.add_landmarks();
+            landmark_obj->set_id(id);
+            for (int i = 0; i < 3; i++) {
+                landmark_obj->add_coords(pos[i]);
+            }
+            for (int i = 0; i < 3; i++) {
+                landmark_obj->add_color(rgb[i]);
+            }
         }
-    }
-    // removed points are remaining in "point_zips".
-    for (const auto& itr : *point_hash_map_) {
-        const auto id = itr.first;
+        // removed points are remaining in "point_zips".
+        for (const auto& itr : *point_hash_map_) {
+            const auto id = itr.first;
 
-        auto landmark_obj = map.add_landmarks();
-        landmark_obj->set_id(id);
+            auto landmark_obj = map.add_landmarks();
+            landmark_obj->set_id(id);
+        }
+        *point_hash_map_ = next_point_hash_map;
     }
-    *point_hash_map_ = next_point_hash_map;
 
     // 4. local landmark registration
 
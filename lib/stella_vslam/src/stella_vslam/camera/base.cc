@@ -1,5 +1,6 @@
 #include "stella_vslam/camera/base.h"
 
+#include <cmath>
 #include <iostream>
 #include <opencv2/core/mat.hpp>
 
@@ -8,6 +9,23 @@
 namespace stella_vslam {
 namespace camera {
 
+//! Samples of the undistorted points and the bearing vectors on a regular grid over the distorted image
+//! (stored as structure of arrays, in the row-major order of the grid)
+struct undistortion_table {
+    //! interval of the samples in pixels
+    unsigned int step_;
+    float inv_step_;
+    //! number of the samples in each row and column
+    unsigned int num_cols_;
+    unsigned int num_rows_;
+
+    std::vector<float> undist_x_;
+    std::vector<float> undist_y_;
+    std::vector<float> bearing_x_;
+    std::vector<float> bearing_y_;
+    std::vector<float> bearing_z_;
+};
+
 base::base(const std::string& name, const setup_type_t setup_type, const model_type_t model_type, const color_order_t color_order,
            const unsigned int cols, const unsigned int rows, const double fps,
            const double focal_x_baseline, const double true_baseline, const double depth_thr)
@@ -166,5 +184,176 @@ void base::convert_bearings_to_points(const eigen_alloc_vector<Vec3_t>& bearings
                    [this](const Vec3_t& bearing) { return convert_bearing_to_point(bearing); });
 }
 
+void base::reproject_points_to_image(const Mat33_t& rot_cw, const Vec3_t& trans_cw, const eigen_alloc_vector<Vec3_t>& pos_ws,
+                                     eigen_alloc_vector<Vec2_t>& reprojs, std::vector<float>& x_rights, std::vector<uint8_t>& in_image) const {
+    reprojs.resize(pos_ws.size());
+    x_rights.resize(pos_ws.size());
+    in_image.resize(pos_ws.size());
+    for (unsigned int idx = 0; idx < pos_ws.size(); ++idx) {
+        in_image[idx] = reproject_to_image(rot_cw, trans_cw, pos_ws[idx], reprojs[idx], x_rights[idx]);
+    }
+}
+
+namespace {
+
+template<bool Inclusive>
+void reproject_points_with_pinhole(const Mat33_t& rot_cw, const Vec3_t& trans_cw, const eigen_alloc_vector<Vec3_t>& pos_ws,
+                                   const double fx, const double fy, const double cx, const double cy,
+                                   const double focal_x_baseline, const image_bounds& img_bounds,
+                                   eigen_alloc_vector<Vec2_t>& reprojs, std::vector<float>& x_rights, std::vector<uint8_t>& in_image) {
+    const unsigned int num_points = pos_ws.size();
+    const double r_00 = rot_cw(0, 0), r_01 = rot_cw(0, 1), r_02 = rot_cw(0, 2);
+    const double r_10 = rot_cw(1, 0), r_11 = rot_cw(1, 1), r_12 = rot_cw(1, 2);
+    const double r_20 = rot_cw(2, 0), r_21 = rot_cw(2, 1), r_22 = rot_cw(2, 2);
+    const double t_0 = trans_cw(0), t_1 = trans_cw(1), t_2 = trans_cw(2);
+    const double min_x = img_bounds.min_x_, max_x = img_bounds.max_x_;
+    const double min_y = img_bounds.min_y_, max_y = img_bounds.max_y_;
+    for (unsigned int idx = 0; idx < num_points; ++idx) {
+        const Vec3_t& pos_w = pos_ws[idx];
+        const double x_c = r_00 * pos_w(0) + r_01 * pos_w(1) + r_02 * pos_w(2) + t_0;
+        const double y_c = r_10 * pos_w(0) + r_11 * pos_w(1) + r_12 * pos_w(2) + t_1;
+        const double z_c = r_20 * pos_w(0) + r_21 * pos_w(1) + r_22 * pos_w(2) + t_2;
+
+        // NOTE: the values are meaningless if the point is behind the camera, and in_image becomes 0 in that case
+        const double z_inv = 1.0 / z_c;
+        const double x = fx * x_c * z_inv + cx;
+        const double y = fy * y_c * z_inv + cy;
+        reprojs[idx](0) = x;
+        reprojs[idx](1) = y;
+        x_rights[idx] = x - focal_x_baseline * z_inv;
+        if (Inclusive) {
+            in_image[idx] = (0.0 < z_c) & (min_x <= x) & (x <= max_x) & (min_y <= y) & (y <= max_y);
+        }
+        else {
+            in_image[idx] = (0.0 < z_c) & (min_x < x) & (x < max_x) & (min_y < y) & (y < max_y);
+        }
+    }
+}
+
+} // namespace
+
+void base::reproject_points_to_image_with_pinhole(const Mat33_t& rot_cw, const Vec3_t& trans_cw, const eigen_alloc_vector<Vec3_t>& pos_ws,
+                                                  const double fx, const double fy, const double cx, const double cy,
+                                                  const bounds_policy_t bounds_policy,
+                                                  eigen_alloc_vector<Vec2_t>& reprojs, std::vector<float>& x_rights, std::vector<uint8_t>& in_image) const {
+    reprojs.resize(pos_ws.size());
+    x_rights.resize(pos_ws.size());
+    in_image.resize(pos_ws.size());
+
+    // same computation as reproject_to_image(), without branches in the loop so that it can be vectorized
+    if (bounds_policy == bounds_policy_t::Inclusive) {
+        reproject_points_with_pinhole<true>(rot_cw, trans_cw, pos_ws, fx, fy, cx, cy, focal_x_baseline_, img_bounds_,
+                                            reprojs, x_rights, in_image);
+    }
+    else {
+        reproject_points_with_pinhole<false>(rot_cw, trans_cw, pos_ws, fx, fy, cx, cy, focal_x_baseline_, img_bounds_,
+                                             reprojs, x_rights, in_image);
+    }
+}
+
+void base::build_undistortion_table(const unsigned int step) {
+    if (step == 0) {
+        undist_table_.reset();
+        return;
+    }
+
+    auto table = std::unique_ptr<undistortion_table>(new undistortion_table());
+    table->step_ = step;
+    table->inv_step_ = 1.0f / step;
+    // the last samples lie on or outside of the right and bottom borders
+    table->num_cols_ = (cols_ + step - 1) / step + 1;
+    table->num_rows_ = (rows_ + step - 1) / step + 1;
+
+    std::vector<cv::Point2f> dist_pts;
+    dist_pts.reserve(table->num_cols_ * table->num_rows_);
+    for (unsigned int row = 0; row < table->num_rows_; ++row) {
+        for (unsigned int col = 0; col < table->num_cols_; ++col) {
+            dist_pts.emplace_back(col * step, row * step);
+        }
+    }
+
+    // the exact undistortion is computed once for all the samples
+    std::vector<cv::Point2f> undist_pts;
+    undistort_points(dist_pts, undist_pts);
+    eigen_alloc_vector<Vec3_t> bearings;
+    convert_points_to_bearings(undist_pts, bearings);
+
+    const auto num_samples = undist_pts.size();
+    table->undist_x_.resize(num_samples);
+    table->undist_y_.resize(num_samples);
+    table->bearing_x_.resize(num_samples);
+    table->bearing_y_.resize(num_samples);
+    table->bearing_z_.resize(num_samples);
+    for (unsigned int idx = 0; idx < num_samples; ++idx) {
+        table->undist_x_[idx] = undist_pts[idx].x;
+        table->undist_y_[idx] = undist_pts[idx].y;
+        table->bearing_x_[idx] = bearings[idx](0);
+        table->bearing_y_[idx] = bearings[idx](1);
+        table->bearing_z_[idx] = bearings[idx](2);
+    }
+
+    spdlog::info("built the undistortion table ({} x {} samples, step: {} px)", table->num_cols_, table->num_rows_, step);
+    undist_table_ = std::move(table);
+}
+
+bool base::undistortion_table_is_built() const {
+    return static_cast<bool>(undist_table_);
+}
+
+void base::undistort_keypoints_and_convert_to_bearings(const std::vector<cv::KeyPoint>& dist_keypts, std::vector<cv::KeyPoint>& undist_keypts,
+                                                       eigen_alloc_vector<Vec3_t>& bearings) const {
+    if (!undist_table_) {
+        undistort_keypoints(dist_keypts, undist_keypts);
+        bearings.clear();
+        convert_keypoints_to_bearings(undist_keypts, bearings);
+        return;
+    }
+
+    const auto& table = *undist_table_;
+    const float max_grid_x = table.num_cols_ - 1;
+    const float max_grid_y = table.num_rows_ - 1;
+
+    undist_keypts.resize(dist_keypts.size());
+    bearings.resize(dist_keypts.size());
+    for (unsigned long idx = 0; idx < dist_keypts.size(); ++idx) {
+        const auto& dist_keypt = dist_keypts[idx];
+        auto& undist_keypt = undist_keypts[idx];
+        undist_keypt.angle = dist_keypt.angle;
+        undist_keypt.size = dist_keypt.size;
+        undist_keypt.octave = dist_keypt.octave;
+
+        const float grid_x = dist_keypt.pt.x * table.inv_step_;
+        const float grid_y = dist_keypt.pt.y * table.inv_step_;
+        // NOTE: NaN also falls back to the exact computation
+        if (!(0.0f <= grid_x && grid_x < max_grid_x && 0.0f <= grid_y && grid_y < max_grid_y)) {
+            undist_keypt.pt = undistort_point(dist_keypt.pt);
+            bearings[idx] = convert_point_to_bearing(undist_keypt.pt);
+            continue;
+        }
+
+        // bilinear interpolation
+        const unsigned int col = static_cast<unsigned int>(grid_x);
+        const unsigned int row = static_cast<unsigned int>(grid_y);
+        const float dx = grid_x - col;
+        const float dy = grid_y - row;
+        const float w_00 = (1.0f - dx) * (1.0f - dy);
+        const float w_01 = dx * (1.0f - dy);
+        const float w_10 = (1.0f - dx) * dy;
+        const float w_11 = dx * dy;
+        const unsigned int i_00 = row * table.num_cols_ + col;
+        const unsigned int i_01 = i_00 + 1;
+        const unsigned int i_10 = i_00 + table.num_cols_;
+        const unsigned int i_11 = i_10 + 1;
+
+        undist_keypt.pt.x = w_00 * table.undist_x_[i_00] + w_01 * table.undist_x_[i_01] + w_10 * table.undist_x_[i_10] + w_11 * table.undist_x_[i_11];
+        undist_keypt.pt.y = w_00 * table.undist_y_[i_00] + w_01 * table.undist_y_[i_01] + w_10 * table.undist_y_[i_10] + w_11 * table.undist_y_[i_11];
+
+        const Vec3_t bearing{w_00 * table.bearing_x_[i_00] + w_01 * table.bearing_x_[i_01] + w_10 * table.bearing_x_[i_10] + w_11 * table.bearing_x_[i_11],
+                             w_00 * table.bearing_y_[i_00] + w_01 * table.bearing_y_[i_01] + w_10 * table.bearing_y_[i_10] + w_11 * table.bearing_y_[i_11],
+                             w_00 * table.bearing_z_[i_00] + w_01 * table.bearing_z_[i_01] + w_10 * table.bearing_z_[i_10] + w_11 * table.bearing_z_[i_11]};
+        bearings[idx] = bearing.normalized();
+    }
+}
+
 } // namespace camera
 } // namespace stella_vslam
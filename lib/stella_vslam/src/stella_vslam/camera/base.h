@@ -5,6 +5,7 @@
 
 #include <string>
 #include <limits>
+#include <memory>
 
 #include <opencv2/core/types.hpp>
 #include <yaml-cpp/yaml.h>
@@ -53,6 +54,8 @@ struct image_bounds {
     float max_y_ = 0.0;
 };
 
+struct undistortion_table;
+
 class base {
 public:
     //! Constructor
@@ -174,6 +177,50 @@ public:
 
     //! Convert bearing vectors to undistorted points
     virtual void convert_bearings_to_points(const eigen_alloc_vector<Vec3_t>& bearings, std::vector<cv::Point2f>& undist_pts) const;
+
+    //! Reproject the specified 3D points to image using camera pose and projection model
+    //! (in_image is set to 1 for the points reprojected to inside of image, and to 0 for the others)
+    virtual void reproject_points_to_image(const Mat33_t& rot_cw, const Vec3_t& trans_cw, const eigen_alloc_vector<Vec3_t>& pos_ws,
+                                           eigen_alloc_vector<Vec2_t>& reprojs, std::vector<float>& x_rights, std::vector<uint8_t>& in_image) const;
+
+    //-------------------------
+    // Lookup table
+
+    /**
+     * Build the lookup table from the distorted pixel coordinates to the undistorted points and the bearing vectors
+     * (the table is sampled at the interval of step pixels and bilinearly interpolated)
+     * This function must be called before the camera is shared, because the table is not guarded by any mutex.
+     * @param step interval of the samples in pixels (0: do not use the table)
+     */
+    void build_undistortion_table(const unsigned int step);
+
+    //! Return true if the lookup table has been built
+    bool undistortion_table_is_built() const;
+
+    //! Undistort keypoints and convert them to bearing vectors in a single pass
+    //! (the lookup table is used if it has been built)
+    void undistort_keypoints_and_convert_to_bearings(const std::vector<cv::KeyPoint>& dist_keypts, std::vector<cv::KeyPoint>& undist_keypts,
+                                                     eigen_alloc_vector<Vec3_t>& bearings) const;
+
+protected:
+    //! Bounds check of the reprojections
+    enum class bounds_policy_t {
+        //! the points on the bounds are outside of the image
+        Exclusive,
+        //! the points on the bounds are inside of the image
+        Inclusive
+    };
+
+    //! Reproject the specified 3D points with the pinhole projection of the intrinsics
+    //! (used by the models whose reproject_to_image() is the pinhole projection followed by the bounds check)
+    void reproject_points_to_image_with_pinhole(const Mat33_t& rot_cw, const Vec3_t& trans_cw, const eigen_alloc_vector<Vec3_t>& pos_ws,
+                                                const double fx, const double fy, const double cx, const double cy,
+                                                const bounds_policy_t bounds_policy,
+                                                eigen_alloc_vector<Vec2_t>& reprojs, std::vector<float>& x_rights, std::vector<uint8_t>& in_image) const;
+
+private:
+    //! lookup table of the undistorted points and the bearing vectors (nullptr if not built)
+    std::unique_ptr<const undistortion_table> undist_table_;
 };
 
 std::ostream& operator<<(std::ostream& os, const base& params);
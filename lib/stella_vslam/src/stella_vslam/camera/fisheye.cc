@@ -43,7 +43,9 @@ fisheye::fisheye(const YAML::Node& yaml_node)
               yaml_node["k3"].as<double>(),
               yaml_node["k4"].as<double>(),
               yaml_node["focal_x_baseline"].as<double>(0.0),
-              yaml_node["depth_threshold"].as<double>(40.0)) {}
+              yaml_node["depth_threshold"].as<double>(40.0)) {
+    build_undistortion_table(yaml_node["undistortion_table_step"].as<unsigned int>(0));
+}
 
 fisheye::~fisheye() {
     spdlog::debug("DESTRUCT: camera::fisheye");
@@ -186,6 +188,12 @@ bool fisheye::reproject_to_image(const Mat33_t& rot_cw, const Vec3_t& trans_cw,
             && img_bounds_.min_y_ < reproj(1) && reproj(1) < img_bounds_.max_y_);
 }
 
+void fisheye::reproject_points_to_image(const Mat33_t& rot_cw, const Vec3_t& trans_cw, const eigen_alloc_vector<Vec3_t>& pos_ws,
+                                        eigen_alloc_vector<Vec2_t>& reprojs, std::vector<float>& x_rights, std::vector<uint8_t>& in_image) const {
+    reproject_points_to_image_with_pinhole(rot_cw, trans_cw, pos_ws, fx_, fy_, cx_, cy_, bounds_policy_t::Exclusive,
+                                           reprojs, x_rights, in_image);
+}
+
 bool fisheye::reproject_to_bearing(const Mat33_t& rot_cw, const Vec3_t& trans_cw, const Vec3_t& pos_w, Vec3_t& reproj) const {
     // convert to camera-coordinates
     reproj = rot_cw * pos_w + trans_cw;
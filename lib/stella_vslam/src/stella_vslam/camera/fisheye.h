@@ -41,6 +41,8 @@ public:
     //! Override for optimization
     void undistort_points(const std::vector<cv::Point2f>& dist_pts, std::vector<cv::Point2f>& undist_pts) const override final;
     void undistort_keypoints(const std::vector<cv::KeyPoint>& dist_keypt, std::vector<cv::KeyPoint>& undist_keypt) const override final;
+    void reproject_points_to_image(const Mat33_t& rot_cw, const Vec3_t& trans_cw, const eigen_alloc_vector<Vec3_t>& pos_ws,
+                                   eigen_alloc_vector<Vec2_t>& reprojs, std::vector<float>& x_rights, std::vector<uint8_t>& in_image) const override final;
 
     //-------------------------
     // Parameters specific to this model
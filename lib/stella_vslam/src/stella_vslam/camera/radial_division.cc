@@ -39,7 +39,9 @@ radial_division::radial_division(const YAML::Node& yaml_node)
                       yaml_node["cy"].as<double>(),
                       yaml_node["distortion"].as<double>(),
                       yaml_node["focal_x_baseline"].as<double>(0.0),
-                      yaml_node["depth_threshold"].as<double>(40.0)) {}
+                      yaml_node["depth_threshold"].as<double>(40.0)) {
+    build_undistortion_table(yaml_node["undistortion_table_step"].as<unsigned int>(0));
+}
 
 radial_division::~radial_division() {
     spdlog::debug("DESTRUCT: camera::radial_division");
@@ -132,6 +134,12 @@ bool radial_division::reproject_to_image(const Mat33_t& rot_cw, const Vec3_t& tr
     return true;
 }
 
+void radial_division::reproject_points_to_image(const Mat33_t& rot_cw, const Vec3_t& trans_cw, const eigen_alloc_vector<Vec3_t>& pos_ws,
+                                                eigen_alloc_vector<Vec2_t>& reprojs, std::vector<float>& x_rights, std::vector<uint8_t>& in_image) const {
+    reproject_points_to_image_with_pinhole(rot_cw, trans_cw, pos_ws, fx_, fy_, cx_, cy_, bounds_policy_t::Inclusive,
+                                           reprojs, x_rights, in_image);
+}
+
 bool radial_division::reproject_to_bearing(const Mat33_t& rot_cw, const Vec3_t& trans_cw, const Vec3_t& pos_w, Vec3_t& reproj) const {
     reproj = rot_cw * pos_w + trans_cw;
 
@@ -43,6 +43,10 @@ public:
 
     nlohmann::json to_json() const override final;
 
+    //! Override for optimization
+    void reproject_points_to_image(const Mat33_t& rot_cw, const Vec3_t& trans_cw, const eigen_alloc_vector<Vec3_t>& pos_ws,
+                                   eigen_alloc_vector<Vec2_t>& reprojs, std::vector<float>& x_rights, std::vector<uint8_t>& in_image) const override final;
+
     //-------------------------
     // Parameters specific to this model
 
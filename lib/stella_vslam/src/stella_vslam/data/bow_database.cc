@@ -5,9 +5,29 @@
 
 #include <spdlog/spdlog.h>
 
+#include <algorithm>
+#include <limits>
+
 namespace stella_vslam {
 namespace data {
 
+namespace {
+//! temporary variables for the queries, which are reused by each thread to avoid allocation
+struct query_scratch {
+    //! number of shared words for each dense index (all zero between queries)
+    std::vector<unsigned int> num_common_words_;
+    //! dense indices of the keyframes which share at least one word with the query
+    std::vector<unsigned int> candidate_indices_;
+    //! rejection flag for each dense index (all false between queries)
+    std::vector<bool> is_rejected_;
+};
+
+query_scratch& get_query_scratch() {
+    thread_local query_scratch scratch;
+    return scratch;
+}
+} // namespace
+
 bow_database::bow_database(bow_vocabulary* bow_vocab)
     : bow_vocab_(bow_vocab) {
     spdlog::debug("CONSTRUCT: data::bow_database");
@@ -21,38 +41,65 @@ bow_database::~bow_database() {
 void bow_database::add_keyframe(const std::shared_ptr<keyframe>& keyfrm) {
     std::lock_guard<std::mutex> lock(mtx_);
 
-    // Append keyframe to the corresponding index in keyframes_in_node_ list
+    assert(!keyfrm_id_to_index_.count(keyfrm->id_));
+    const unsigned int idx = keyfrms_.size();
+    keyfrms_.push_back(keyfrm);
+    keyfrm_id_to_index_[keyfrm->id_] = idx;
+
+    // Append the dense index to the corresponding posting lists
     for (const auto& node_id_and_weight : keyfrm->bow_vec_) {
-        keyfrms_in_node_[node_id_and_weight.first].push_back(keyfrm);
+        keyfrm_indices_in_node_[node_id_and_weight.first].push_back(idx);
     }
 }
 
-void bow_database::erase_keyframe(const std::shared_ptr<keyframe>& keyfrm) {
+void bow_database::add_keyframes(const std::vector<std::shared_ptr<keyframe>>& keyfrms) {
+    // sort by ID so that the dense indices are in the same order as when the keyframes were added one by one
+    auto sorted_keyfrms = keyfrms;
+    std::sort(sorted_keyfrms.begin(), sorted_keyfrms.end(),
+              [](const std::shared_ptr<keyframe>& keyfrm1, const std::shared_ptr<keyframe>& keyfrm2) {
+                  return keyfrm1->id_ < keyfrm2->id_;
+              });
+
     std::lock_guard<std::mutex> lock(mtx_);
 
-    // Delete keyframe from the coresponding index in keyframes_in_node_ list
-    for (const auto& node_id_and_weight : keyfrm->bow_vec_) {
-        // first: node ID, second: weight
-        if (!static_cast<bool>(keyfrms_in_node_.count(node_id_and_weight.first))) {
-            continue;
-        }
-        // Obtain keyframe which shares word
-        auto& keyfrms_in_node = keyfrms_in_node_.at(node_id_and_weight.first);
-
-        // std::list::erase only accepts iterator
-        for (auto itr = keyfrms_in_node.begin(), lend = keyfrms_in_node.end(); itr != lend; itr++) {
-            if (keyfrm->id_ == (*itr)->id_) {
-                keyfrms_in_node.erase(itr);
-                break;
-            }
+    keyfrms_.reserve(keyfrms_.size() + sorted_keyfrms.size());
+    for (const auto& keyfrm : sorted_keyfrms) {
+        assert(!keyfrm_id_to_index_.count(keyfrm->id_));
+        const unsigned int idx = keyfrms_.size();
+        keyfrms_.push_back(keyfrm);
+        keyfrm_id_to_index_[keyfrm->id_] = idx;
+
+        for (const auto& node_id_and_weight : keyfrm->bow_vec_) {
+            keyfrm_indices_in_node_[node_id_and_weight.first].push_back(idx);
         }
     }
 }
 
+void bow_database::erase_keyframe(const std::shared_ptr<keyframe>& keyfrm) {
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    const auto itr = keyfrm_id_to_index_.find(keyfrm->id_);
+    if (itr == keyfrm_id_to_index_.end()) {
+        return;
+    }
+
+    // Leave a tombstone instead of searching the posting lists,
+    // which are cleaned up all at once when the tombstones occupy half of the database
+    keyfrms_.at(itr->second) = nullptr;
+    keyfrm_id_to_index_.erase(itr);
+    ++num_erased_keyfrms_;
+    if (keyfrms_.size() < 2 * num_erased_keyfrms_) {
+        compact();
+    }
+}
+
 void bow_database::clear() {
     std::lock_guard<std::mutex> lock(mtx_);
     spdlog::info("clear BoW database");
-    keyfrms_in_node_.clear();
+    keyfrms_.clear();
+    keyfrm_id_to_index_.clear();
+    num_erased_keyfrms_ = 0;
+    keyfrm_indices_in_node_.clear();
 }
 
 std::vector<std::shared_ptr<keyframe>> bow_database::acquire_keyframes(const bow_vector& bow_vec, const float min_score,
@@ -60,9 +107,14 @@ std::vector<std::shared_ptr<keyframe>> bow_database::acquire_keyframes(const bow
                                                                        const std::set<std::shared_ptr<keyframe>>& keyfrms_to_reject) {
     // Step 1.
     // Count up the number of nodes, words which are shared with query_keyframe, for all the keyframes in DoW database
+    // (the lock is held only while reading the posting lists, and the scores are computed without it)
 
-    const auto num_common_words = compute_num_common_words(bow_vec, keyfrms_to_reject);
-    if (num_common_words.empty()) {
+    std::vector<candidate> candidates;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        candidates = collect_candidates(bow_vec, keyfrms_to_reject);
+    }
+    if (candidates.empty()) {
         return std::vector<std::shared_ptr<keyframe>>();
     }
 
@@ -70,9 +122,9 @@ std::vector<std::shared_ptr<keyframe>> bow_database::acquire_keyframes(const bow
     // for the following selection of candidate keyframes.
     // (Delete frames from candidates if it has less shared words than 80% of the max_num_common_words)
     unsigned int max_num_common_words = 0;
-    for (const auto& keyfrm_num_common_words_pair : num_common_words) {
-        if (max_num_common_words < keyfrm_num_common_words_pair.second) {
-            max_num_common_words = keyfrm_num_common_words_pair.second;
+    for (const auto& cand : candidates) {
+        if (max_num_common_words < cand.num_common_words_) {
+            max_num_common_words = cand.num_common_words_;
         }
     }
     const auto min_num_common_words_thr = static_cast<unsigned int>(num_common_words_thr_ratio * max_num_common_words);
@@ -82,68 +134,96 @@ std::vector<std::shared_ptr<keyframe>> bow_database::acquire_keyframes(const bow
     // by calculating similarity score between each candidate and the query keyframe.
 
     float best_score = min_score;
-    const auto scores = compute_scores(num_common_words, bow_vec, min_num_common_words_thr, min_score, best_score);
-    if (scores.empty()) {
-        return std::vector<std::shared_ptr<keyframe>>();
-    }
+    auto scores = compute_scores(bow_vec, candidates, min_num_common_words_thr, min_score, best_score);
 
-    std::unordered_set<std::shared_ptr<keyframe>> final_candidates;
-    for (const auto& keyfrm_score : scores) {
-        const auto keyfrm = keyfrm_score.first;
-        final_candidates.insert(keyfrm);
+    // Rank the candidates by the score (the scores are computed in the order of addition)
+    std::stable_sort(scores.begin(), scores.end(),
+                     [](const std::pair<unsigned int, float>& idx_score1, const std::pair<unsigned int, float>& idx_score2) {
+                         return idx_score1.second > idx_score2.second;
+                     });
+
+    std::vector<std::shared_ptr<keyframe>> final_candidates;
+    final_candidates.reserve(scores.size());
+    for (const auto& idx_score : scores) {
+        final_candidates.push_back(candidates[idx_score.first].keyfrm_);
     }
-    return std::vector<std::shared_ptr<keyframe>>(final_candidates.begin(), final_candidates.end());
+    return final_candidates;
 }
 
-std::unordered_map<std::shared_ptr<keyframe>, unsigned int>
-bow_database::compute_num_common_words(const bow_vector& bow_vec,
-                                       const std::set<std::shared_ptr<keyframe>>& keyfrms_to_reject) const {
-    std::unordered_map<std::shared_ptr<keyframe>, unsigned int> num_common_words;
+std::vector<bow_database::candidate> bow_database::collect_candidates(const bow_vector& bow_vec,
+                                                                      const std::set<std::shared_ptr<keyframe>>& keyfrms_to_reject) const {
+    auto& scratch = get_query_scratch();
+    auto& num_common_words = scratch.num_common_words_;
+    auto& candidate_indices = scratch.candidate_indices_;
+    auto& is_rejected = scratch.is_rejected_;
+    if (num_common_words.size() < keyfrms_.size()) {
+        num_common_words.resize(keyfrms_.size(), 0);
+        is_rejected.resize(keyfrms_.size(), false);
+    }
+    candidate_indices.clear();
 
-    std::lock_guard<std::mutex> lock(mtx_);
+    std::vector<unsigned int> rejected_indices;
+    rejected_indices.reserve(keyfrms_to_reject.size());
+    for (const auto& keyfrm : keyfrms_to_reject) {
+        const auto itr = keyfrm_id_to_index_.find(keyfrm->id_);
+        if (itr != keyfrm_id_to_index_.end()) {
+            is_rejected[itr->second] = true;
+            rejected_indices.push_back(itr->second);
+        }
+    }
 
     // Count the number of shared words for keyframes which share the word with the query keyframe
     for (const auto& node_id_and_weight : bow_vec) {
         // first: node ID, second: weight
         // If not in the BoW database, continue
-        if (!static_cast<bool>(keyfrms_in_node_.count(node_id_and_weight.first))) {
+        const auto itr = keyfrm_indices_in_node_.find(node_id_and_weight.first);
+        if (itr == keyfrm_indices_in_node_.end()) {
             continue;
         }
-        // Get a keyframe which shares the word (node ID) with the query
-        const auto& keyfrms_in_node = keyfrms_in_node_.at(node_id_and_weight.first);
-        // For each keyframe, increase shared word number one by one
-        for (const auto& keyfrm_in_node : keyfrms_in_node) {
-            // If far enough from the query keyframe, store it as the initial loop candidates
-            if (!static_cast<bool>(keyfrms_to_reject.count(keyfrm_in_node))) {
-                // Initialize if not in num_common_words
-                if (!static_cast<bool>(num_common_words.count(keyfrm_in_node))) {
-                    num_common_words[keyfrm_in_node] = 0;
-                }
-                // Count up the number of words
-                ++num_common_words.at(keyfrm_in_node);
+        // For each keyframe which shares the word (node ID) with the query, increase shared word number one by one
+        for (const auto idx : itr->second) {
+            // Skip the erased keyframes and the ones to be rejected
+            if (!keyfrms_[idx] || is_rejected[idx]) {
+                continue;
+            }
+            if (num_common_words[idx]++ == 0) {
+                candidate_indices.push_back(idx);
             }
         }
     }
 
-    return num_common_words;
+    for (const auto idx : rejected_indices) {
+        is_rejected[idx] = false;
+    }
+
+    // keep the result independent of the order of the words
+    std::sort(candidate_indices.begin(), candidate_indices.end());
+
+    std::vector<candidate> candidates;
+    candidates.reserve(candidate_indices.size());
+    for (const auto idx : candidate_indices) {
+        candidates.push_back(candidate{keyfrms_[idx], num_common_words[idx]});
+        // Reset the counter for the next query
+        num_common_words[idx] = 0;
+    }
+    return candidates;
 }
 
-std::unordered_map<std::shared_ptr<keyframe>, float>
-bow_database::compute_scores(const std::unordered_map<std::shared_ptr<keyframe>, unsigned int>& num_common_words,
-                             const bow_vector& bow_vec,
+std::vector<std::pair<unsigned int, float>>
+bow_database::compute_scores(const bow_vector& bow_vec,
+                             const std::vector<candidate>& candidates,
                              const unsigned int min_num_common_words_thr,
                              const float min_score,
                              float& best_score) const {
-    std::unordered_map<std::shared_ptr<keyframe>, float> scores;
+    std::vector<std::pair<unsigned int, float>> scores;
 
     best_score = min_score;
 
-    for (const auto& keyfrm_num_common_words_pair : num_common_words) {
-        const auto& keyfrm = keyfrm_num_common_words_pair.first;
-        if (min_num_common_words_thr < keyfrm_num_common_words_pair.second) {
+    for (unsigned int i = 0; i < candidates.size(); ++i) {
+        if (min_num_common_words_thr < candidates[i].num_common_words_) {
             // Calculate similarity score with query keyframe
             // for the keyframes which have more shared words than minimum common words
-            const auto score = data::bow_vocabulary_util::score(bow_vocab_, bow_vec, keyfrm->bow_vec_);
+            const auto score = data::bow_vocabulary_util::score(bow_vocab_, bow_vec, candidates[i].keyfrm_->bow_vec_);
             if (min_score > score) {
                 continue;
             }
@@ -151,12 +231,49 @@ bow_database::compute_scores(const std::unordered_map<std::shared_ptr<keyframe>,
                 best_score = score;
             }
             // Store score
-            scores[keyfrm] = score;
+            scores.emplace_back(i, score);
         }
     }
 
     return scores;
 }
 
+void bow_database::compact() {
+    // map from the old index to the new one
+    constexpr unsigned int erased = std::numeric_limits<unsigned int>::max();
+    std::vector<unsigned int> new_indices(keyfrms_.size(), erased);
+    unsigned int num_keyfrms = 0;
+    for (unsigned int idx = 0; idx < keyfrms_.size(); ++idx) {
+        if (!keyfrms_[idx]) {
+            continue;
+        }
+        new_indices[idx] = num_keyfrms;
+        keyfrm_id_to_index_.at(keyfrms_[idx]->id_) = num_keyfrms;
+        if (idx != num_keyfrms) {
+            keyfrms_[num_keyfrms] = std::move(keyfrms_[idx]);
+        }
+        ++num_keyfrms;
+    }
+    keyfrms_.resize(num_keyfrms);
+    num_erased_keyfrms_ = 0;
+
+    // Renumber the posting lists in place (the order is preserved)
+    for (auto itr = keyfrm_indices_in_node_.begin(); itr != keyfrm_indices_in_node_.end();) {
+        auto& indices = itr->second;
+        unsigned int num_indices = 0;
+        for (const auto idx : indices) {
+            if (new_indices[idx] != erased) {
+                indices[num_indices++] = new_indices[idx];
+            }
+        }
+        if (num_indices == 0) {
+            itr = keyfrm_indices_in_node_.erase(itr);
+            continue;
+        }
+        indices.resize(num_indices);
+        ++itr;
+    }
+}
+
 } // namespace data
 } // namespace stella_vslam
@@ -4,12 +4,11 @@
 #include "stella_vslam/data/bow_vocabulary.h"
 
 #include <mutex>
-#include <list>
 #include <vector>
 #include <set>
 #include <unordered_map>
-#include <unordered_set>
 #include <memory>
+#include <utility>
 
 namespace stella_vslam {
 namespace data {
@@ -36,6 +35,12 @@ public:
      */
     void add_keyframe(const std::shared_ptr<keyframe>& keyfrm);
 
+    /**
+     * Add keyframes to the database at once (e.g. after loading a map)
+     * @param keyfrms
+     */
+    void add_keyframes(const std::vector<std::shared_ptr<keyframe>>& keyfrms);
+
     /**
      * Erase the keyframe from the database
      * @param keyfrm
@@ -49,6 +54,7 @@ public:
 
     /**
      * Acquire keyframes over score
+     * (NOTE: the keyframes are sorted in descending order of the score, and in the order of addition if the scores are equal)
      */
     std::vector<std::shared_ptr<keyframe>> acquire_keyframes(const bow_vector& bow_vec, const float min_score = 0.0f,
                                                              const float num_common_words_thr_ratio = 0.8f,
@@ -60,37 +66,58 @@ protected:
      */
     void initialize();
 
+    //! keyframe which shares at least one word with the query
+    struct candidate {
+        std::shared_ptr<keyframe> keyfrm_;
+        unsigned int num_common_words_;
+    };
+
     /**
-     * Compute the number of shared words
+     * Collect the keyframes which share words with the query, in the order of addition
+     * (NOTE: mtx_ must be locked)
      * @param bow_vec
      * @param keyfrms_to_reject
-     * @return number of shared words between the query and the each of keyframes contained in the database (key: keyframes that share word with query keyframe, value: number of shared words)
+     * @return candidates with the number of shared words
      */
-    std::unordered_map<std::shared_ptr<keyframe>, unsigned int>
-    compute_num_common_words(const bow_vector& bow_vec,
-                             const std::set<std::shared_ptr<keyframe>>& keyfrms_to_reject = {}) const;
+    std::vector<candidate> collect_candidates(const bow_vector& bow_vec,
+                                              const std::set<std::shared_ptr<keyframe>>& keyfrms_to_reject = {}) const;
 
     /**
-     * Compute scores (scores_) between the query and the each of keyframes contained in the database
-     * @param num_common_words
+     * Compute scores between the query and the candidates
+     * (NOTE: mtx_ need not be locked)
      * @param bow_vec
+     * @param candidates
      * @param min_num_common_words_thr
-     * @return similarity scores between the query and the each of keyframes contained in the database (key: keyframes that share word with query keyframe, value: score)
+     * @param min_score
+     * @param best_score
+     * @return similarity scores between the query and the candidates (first: index in candidates, second: score)
      */
-    std::unordered_map<std::shared_ptr<keyframe>, float>
-    compute_scores(const std::unordered_map<std::shared_ptr<keyframe>, unsigned int>& num_common_words,
-                   const bow_vector& bow_vec,
+    std::vector<std::pair<unsigned int, float>>
+    compute_scores(const bow_vector& bow_vec,
+                   const std::vector<candidate>& candidates,
                    const unsigned int min_num_common_words_thr,
                    const float min_score,
                    float& best_score) const;
 
+    /**
+     * Remove the erased keyframes from keyfrms_ and the posting lists, and renumber the remaining keyframes
+     * (NOTE: mtx_ must be locked)
+     */
+    void compact();
+
     //-----------------------------------------
     // BoW feature vectors
 
     //! mutex to access BoW database
     mutable std::mutex mtx_;
-    //! BoW database
-    std::unordered_map<unsigned int, std::list<std::shared_ptr<keyframe>>> keyfrms_in_node_;
+    //! keyframes in the database, indexed by the dense index (nullptr if erased)
+    std::vector<std::shared_ptr<keyframe>> keyfrms_;
+    //! map from keyframe ID to the dense index
+    std::unordered_map<unsigned int, unsigned int> keyfrm_id_to_index_;
+    //! number of the erased keyframes still occupying keyfrms_ and the posting lists
+    unsigned int num_erased_keyfrms_ = 0;
+    //! posting lists (key: node ID, value: dense indices of the keyframes which have the node)
+    std::unordered_map<unsigned int, std::vector<unsigned int>> keyfrm_indices_in_node_;
 
     //-----------------------------------------
     // BoW vocabulary
@@ -1,6 +1,7 @@
 #include "stella_vslam/data/bow_vocabulary.h"
 #include "stella_vslam/util/converter.h"
 #include <spdlog/spdlog.h>
+#include <nlohmann/json.hpp>
 
 namespace stella_vslam {
 namespace data {
@@ -47,6 +48,78 @@ bow_vocabulary* load(std::string path) {
     return bow_vocab;
 }
 
+std::string get_fingerprint(bow_vocabulary* bow_vocab) {
+#ifdef USE_DBOW2
+    // FNV-1a hash of the descriptors and the weights of the words
+    uint64_t hash = 14695981039346656037ull;
+    const auto hash_bytes = [&hash](const unsigned char* data, const size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ data[i]) * 1099511628211ull;
+        }
+    };
+    for (unsigned int word_id = 0; word_id < bow_vocab->size(); ++word_id) {
+        const cv::Mat word = bow_vocab->getWord(word_id);
+        hash_bytes(word.data, word.total() * word.elemSize());
+        const double weight = bow_vocab->getWordWeight(word_id);
+        hash_bytes(reinterpret_cast<const unsigned char*>(&weight), sizeof(weight));
+    }
+    return "dbow2:" + std::to_string(bow_vocab->size()) + ":" + std::to_string(hash);
+#else
+    return "fbow:" + std::to_string(bow_vocab->size()) + ":" + std::to_string(bow_vocab->hash());
+#endif
+}
+
+nlohmann::json convert_bow_vector_to_json(const bow_vector& bow_vec) {
+    std::vector<unsigned int> words;
+    std::vector<double> weights;
+    words.reserve(bow_vec.size());
+    weights.reserve(bow_vec.size());
+    for (const auto& word_weight : bow_vec) {
+        words.push_back(word_weight.first);
+        weights.push_back(word_weight.second);
+    }
+    return {{"words", words}, {"weights", weights}};
+}
+
+void convert_json_to_bow_vector(const nlohmann::json& json_bow_vec, bow_vector& bow_vec) {
+    const auto words = json_bow_vec.at("words").get<std::vector<unsigned int>>();
+    const auto weights = json_bow_vec.at("weights").get<std::vector<double>>();
+    assert(words.size() == weights.size());
+    bow_vec.clear();
+    for (unsigned int i = 0; i < words.size(); ++i) {
+#ifdef USE_DBOW2
+        bow_vec.emplace_hint(bow_vec.end(), words.at(i), weights.at(i));
+#else
+        // NOTE: fbow::_float can only be assigned from a float lvalue
+        float weight = weights.at(i);
+        bow_vec[words.at(i)] = weight;
+#endif
+    }
+}
+
+nlohmann::json convert_bow_feature_vector_to_json(const bow_feature_vector& bow_feat_vec) {
+    std::vector<unsigned int> nodes;
+    std::vector<std::vector<unsigned int>> indices;
+    nodes.reserve(bow_feat_vec.size());
+    indices.reserve(bow_feat_vec.size());
+    for (const auto& node_indices : bow_feat_vec) {
+        nodes.push_back(node_indices.first);
+        indices.emplace_back(node_indices.second.begin(), node_indices.second.end());
+    }
+    return {{"nodes", nodes}, {"indices", indices}};
+}
+
+void convert_json_to_bow_feature_vector(const nlohmann::json& json_bow_feat_vec, bow_feature_vector& bow_feat_vec) {
+    const auto nodes = json_bow_feat_vec.at("nodes").get<std::vector<unsigned int>>();
+    const auto& json_indices = json_bow_feat_vec.at("indices");
+    assert(nodes.size() == json_indices.size());
+    bow_feat_vec.clear();
+    for (unsigned int i = 0; i < nodes.size(); ++i) {
+        const auto indices = json_indices.at(i).get<std::vector<unsigned int>>();
+        bow_feat_vec[nodes.at(i)].assign(indices.begin(), indices.end());
+    }
+}
+
 }; // namespace bow_vocabulary_util
 }; // namespace data
 }; // namespace stella_vslam
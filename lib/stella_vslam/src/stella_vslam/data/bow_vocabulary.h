@@ -10,6 +10,8 @@
 #include <fbow/vocabulary.h>
 #endif // USE_DBOW2
 
+#include <nlohmann/json_fwd.hpp>
+
 namespace stella_vslam {
 namespace data {
 namespace bow_vocabulary_util {
@@ -18,6 +20,17 @@ float score(bow_vocabulary* bow_vocab, const bow_vector& bow_vec1, const bow_vec
 void compute_bow(bow_vocabulary* bow_vocab, const cv::Mat& descriptors, bow_vector& bow_vec, bow_feature_vector& bow_feat_vec);
 bow_vocabulary* load(std::string path);
 
+/**
+ * Get a string which identifies the vocabulary (its size and a hash of its contents),
+ * so that BoW vectors stored with a map can be checked against the vocabulary used to load it
+ */
+std::string get_fingerprint(bow_vocabulary* bow_vocab);
+
+nlohmann::json convert_bow_vector_to_json(const bow_vector& bow_vec);
+void convert_json_to_bow_vector(const nlohmann::json& json_bow_vec, bow_vector& bow_vec);
+nlohmann::json convert_bow_feature_vector_to_json(const bow_feature_vector& bow_feat_vec);
+void convert_json_to_bow_feature_vector(const nlohmann::json& json_bow_feat_vec, bow_feature_vector& bow_feat_vec);
+
 }; // namespace bow_vocabulary_util
 }; // namespace data
 }; // namespace stella_vslam
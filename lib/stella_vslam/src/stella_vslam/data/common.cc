@@ -81,36 +81,63 @@ cv::Mat convert_json_to_descriptors(const nlohmann::json& json_descriptors) {
 }
 
 void assign_keypoints_to_grid(const camera::base* camera, const std::vector<cv::KeyPoint>& undist_keypts,
-                              std::vector<std::vector<std::vector<unsigned int>>>& keypt_indices_in_cells,
+                              keypoint_grid& keypt_indices_in_cells,
                               unsigned int num_grid_cols, unsigned int num_grid_rows) {
     double inv_cell_width = static_cast<double>(num_grid_cols) / (camera->img_bounds_.max_x_ - camera->img_bounds_.min_x_);
     double inv_cell_height = static_cast<double>(num_grid_rows) / (camera->img_bounds_.max_y_ - camera->img_bounds_.min_y_);
 
-    // Pre-allocate memory
     const unsigned int num_keypts = undist_keypts.size();
-    const unsigned int num_to_reserve = 0.5 * num_keypts / (num_grid_cols * num_grid_rows);
-    keypt_indices_in_cells.resize(num_grid_cols);
-    for (auto& keypt_indices_in_row : keypt_indices_in_cells) {
-        keypt_indices_in_row.resize(num_grid_rows);
-        for (auto& keypt_indices_in_cell : keypt_indices_in_row) {
-            keypt_indices_in_cell.reserve(num_to_reserve);
+    const unsigned int num_cells = num_grid_cols * num_grid_rows;
+    auto& cell_offsets = keypt_indices_in_cells.cell_offsets_;
+    auto& keypt_indices = keypt_indices_in_cells.keypt_indices_;
+
+    // Count the keypoints in each cell (counting sort)
+    cell_offsets.assign(num_cells + 1, 0);
+    for (unsigned int idx = 0; idx < num_keypts; ++idx) {
+        int cell_idx_x, cell_idx_y;
+        if (get_cell_indices(camera, undist_keypts.at(idx), num_grid_cols, num_grid_rows, inv_cell_width, inv_cell_height, cell_idx_x, cell_idx_y)) {
+            ++cell_offsets[cell_idx_x * num_grid_rows + cell_idx_y + 1];
         }
     }
+    for (unsigned int cell_idx = 0; cell_idx < num_cells; ++cell_idx) {
+        cell_offsets[cell_idx + 1] += cell_offsets[cell_idx];
+    }
 
-    // Calculate cell position and store
+    // Scatter the keypoint indices, using cell_offsets[cell_idx] as the write cursor of each cell
+    keypt_indices.resize(cell_offsets[num_cells]);
     for (unsigned int idx = 0; idx < num_keypts; ++idx) {
-        const auto& keypt = undist_keypts.at(idx);
         int cell_idx_x, cell_idx_y;
-        if (get_cell_indices(camera, keypt, num_grid_cols, num_grid_rows, inv_cell_width, inv_cell_height, cell_idx_x, cell_idx_y)) {
-            keypt_indices_in_cells.at(cell_idx_x).at(cell_idx_y).push_back(idx);
+        if (get_cell_indices(camera, undist_keypts.at(idx), num_grid_cols, num_grid_rows, inv_cell_width, inv_cell_height, cell_idx_x, cell_idx_y)) {
+            keypt_indices[cell_offsets[cell_idx_x * num_grid_rows + cell_idx_y]++] = idx;
+        }
+    }
+    // Each cursor now points to the beginning of the next cell, so shift them back
+    for (unsigned int cell_idx = num_cells; 0 < cell_idx; --cell_idx) {
+        cell_offsets[cell_idx] = cell_offsets[cell_idx - 1];
+    }
+    cell_offsets[0] = 0;
+
+    // Sort the indices in each cell by scale level so that level filters can skip whole runs.
+    // The keypoints are usually extracted level by level, so this is a no-op in most cases.
+    for (unsigned int cell_idx = 0; cell_idx < num_cells; ++cell_idx) {
+        const auto begin = keypt_indices.begin() + cell_offsets[cell_idx];
+        const auto end = keypt_indices.begin() + cell_offsets[cell_idx + 1];
+        for (auto it = begin + (begin != end); it < end; ++it) {
+            const unsigned int idx = *it;
+            const int octave = undist_keypts[idx].octave;
+            auto jt = it;
+            for (; begin < jt && octave < undist_keypts[*(jt - 1)].octave; --jt) {
+                *jt = *(jt - 1);
+            }
+            *jt = idx;
         }
     }
 }
 
 auto assign_keypoints_to_grid(const camera::base* camera, const std::vector<cv::KeyPoint>& undist_keypts,
                               unsigned int num_grid_cols, unsigned int num_grid_rows)
-    -> std::vector<std::vector<std::vector<unsigned int>>> {
-    std::vector<std::vector<std::vector<unsigned int>>> keypt_indices_in_cells;
+    -> keypoint_grid {
+    keypoint_grid keypt_indices_in_cells;
     assign_keypoints_to_grid(camera, undist_keypts, keypt_indices_in_cells, num_grid_cols, num_grid_rows);
     return keypt_indices_in_cells;
 }
@@ -118,62 +145,74 @@ auto assign_keypoints_to_grid(const camera::base* camera, const std::vector<cv::
 std::vector<unsigned int> get_keypoints_in_cell(const camera::base* camera, const data::frame_observation& frm_obs,
                                                 const float ref_x, const float ref_y, const float margin,
                                                 const int min_level, const int max_level) {
-    return get_keypoints_in_cell(camera, frm_obs.undist_keypts_, frm_obs.keypt_indices_in_cells_,
-                                 ref_x, ref_y, margin,
-                                 frm_obs.num_grid_cols_, frm_obs.num_grid_rows_,
-                                 min_level, max_level);
+    std::vector<unsigned int> indices;
+    get_keypoints_in_cell(camera, frm_obs, ref_x, ref_y, margin, min_level, max_level, indices);
+    return indices;
 }
 
-std::vector<unsigned int> get_keypoints_in_cell(const camera::base* camera, const std::vector<cv::KeyPoint>& undist_keypts,
-                                                const std::vector<std::vector<std::vector<unsigned int>>>& keypt_indices_in_cells,
-                                                const float ref_x, const float ref_y, const float margin,
-                                                const unsigned int num_grid_cols, const unsigned int num_grid_rows,
-                                                const int min_level, const int max_level) {
+void get_keypoints_in_cell(const camera::base* camera, const data::frame_observation& frm_obs,
+                           const float ref_x, const float ref_y, const float margin,
+                           const int min_level, const int max_level,
+                           std::vector<unsigned int>& indices) {
+    get_keypoints_in_cell(camera, frm_obs.undist_keypts_, frm_obs.keypt_indices_in_cells_,
+                          ref_x, ref_y, margin,
+                          frm_obs.num_grid_cols_, frm_obs.num_grid_rows_,
+                          min_level, max_level, indices);
+}
+
+void get_keypoints_in_cell(const camera::base* camera, const std::vector<cv::KeyPoint>& undist_keypts,
+                           const keypoint_grid& keypt_indices_in_cells,
+                           const float ref_x, const float ref_y, const float margin,
+                           const unsigned int num_grid_cols, const unsigned int num_grid_rows,
+                           const int min_level, const int max_level,
+                           std::vector<unsigned int>& indices) {
+    indices.clear();
+
+    if (keypt_indices_in_cells.empty()) {
+        return;
+    }
+
     double inv_cell_width = static_cast<double>(num_grid_cols) / (camera->img_bounds_.max_x_ - camera->img_bounds_.min_x_);
     double inv_cell_height = static_cast<double>(num_grid_rows) / (camera->img_bounds_.max_y_ - camera->img_bounds_.min_y_);
 
-    std::vector<unsigned int> indices;
-
     const int min_cell_idx_x = std::max(0, cvFloor((ref_x - camera->img_bounds_.min_x_ - margin) * inv_cell_width));
     if (static_cast<int>(num_grid_cols) <= min_cell_idx_x) {
-        return indices;
+        return;
     }
 
     const int max_cell_idx_x = std::min(static_cast<int>(num_grid_cols - 1), cvCeil((ref_x - camera->img_bounds_.min_x_ + margin) * inv_cell_width));
     if (max_cell_idx_x < 0) {
-        return indices;
+        return;
     }
 
     const int min_cell_idx_y = std::max(0, cvFloor((ref_y - camera->img_bounds_.min_y_ - margin) * inv_cell_height));
     if (static_cast<int>(num_grid_rows) <= min_cell_idx_y) {
-        return indices;
+        return;
     }
 
     const int max_cell_idx_y = std::min(static_cast<int>(num_grid_rows - 1), cvCeil((ref_y - camera->img_bounds_.min_y_ + margin) * inv_cell_height));
     if (max_cell_idx_y < 0) {
-        return indices;
+        return;
     }
 
-    indices.reserve(undist_keypts.size());
-
     const bool check_min_level = 0 <= min_level;
     const bool check_max_level = 0 <= max_level;
 
     for (int cell_idx_x = min_cell_idx_x; cell_idx_x <= max_cell_idx_x; ++cell_idx_x) {
+        // The cells in the same column are adjacent in memory
+        const unsigned int first_cell_idx = cell_idx_x * num_grid_rows;
         for (int cell_idx_y = min_cell_idx_y; cell_idx_y <= max_cell_idx_y; ++cell_idx_y) {
-            const auto& keypt_indices_in_cell = keypt_indices_in_cells.at(cell_idx_x).at(cell_idx_y);
-            if (keypt_indices_in_cell.empty()) {
-                continue;
-            }
-
-            for (unsigned int idx : keypt_indices_in_cell) {
-                const auto& undist_keypt = undist_keypts.at(idx);
+            const auto* const end = keypt_indices_in_cells.cell_end(first_cell_idx + cell_idx_y);
+            for (const auto* it = keypt_indices_in_cells.cell_begin(first_cell_idx + cell_idx_y); it != end; ++it) {
+                const unsigned int idx = *it;
+                const auto& undist_keypt = undist_keypts[idx];
 
+                // The indices in the cell are sorted by scale level
                 if (check_min_level && undist_keypt.octave < min_level) {
                     continue;
                 }
                 if (check_max_level && max_level < undist_keypt.octave) {
-                    continue;
+                    break;
                 }
 
                 const float dist_x = undist_keypt.pt.x - ref_x;
@@ -185,8 +224,6 @@ std::vector<unsigned int> get_keypoints_in_cell(const camera::base* camera, cons
             }
         }
     }
-
-    return indices;
 }
 
 Vec3_t triangulate_stereo(const camera::base* camera,
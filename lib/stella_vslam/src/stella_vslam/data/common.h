@@ -3,6 +3,7 @@
 
 #include "stella_vslam/type.h"
 #include "stella_vslam/camera/base.h"
+#include "stella_vslam/data/keypoint_grid.h"
 
 #include <opencv2/core/mat.hpp>
 #include <opencv2/core/types.hpp>
@@ -31,12 +32,13 @@ cv::Mat convert_json_to_descriptors(const nlohmann::json& json_descriptors);
 
 /**
  * Assign all keypoints to cells to accelerate projection matching
+ * (The buffers of keypt_indices_in_cells are reused if it has already been built)
  * @param camera
  * @param undist_keypts
  * @param keypt_indices_in_cells
  */
 void assign_keypoints_to_grid(const camera::base* camera, const std::vector<cv::KeyPoint>& undist_keypts,
-                              std::vector<std::vector<std::vector<unsigned int>>>& keypt_indices_in_cells,
+                              keypoint_grid& keypt_indices_in_cells,
                               unsigned int num_grid_cols, unsigned int num_grid_rows);
 
 /**
@@ -47,7 +49,7 @@ void assign_keypoints_to_grid(const camera::base* camera, const std::vector<cv::
  */
 auto assign_keypoints_to_grid(const camera::base* camera, const std::vector<cv::KeyPoint>& undist_keypts,
                               unsigned int num_grid_cols, unsigned int num_grid_rows)
-    -> std::vector<std::vector<std::vector<unsigned int>>>;
+    -> keypoint_grid;
 
 /**
  * Get x-y index of the cell in which the specified keypoint is assigned
@@ -77,13 +79,18 @@ inline bool get_cell_indices(const camera::base* camera, const cv::KeyPoint& key
  * @param margin
  * @param min_level
  * @param max_level
- * @return
+ * @param indices output (cleared, then filled; its capacity is reused)
  */
-std::vector<unsigned int> get_keypoints_in_cell(const camera::base* camera, const std::vector<cv::KeyPoint>& undist_keypts,
-                                                const std::vector<std::vector<std::vector<unsigned int>>>& keypt_indices_in_cells,
-                                                const float ref_x, const float ref_y, const float margin,
-                                                const unsigned int num_grid_cols, const unsigned int num_grid_rows,
-                                                const int min_level = -1, const int max_level = -1);
+void get_keypoints_in_cell(const camera::base* camera, const std::vector<cv::KeyPoint>& undist_keypts,
+                           const keypoint_grid& keypt_indices_in_cells,
+                           const float ref_x, const float ref_y, const float margin,
+                           const unsigned int num_grid_cols, const unsigned int num_grid_rows,
+                           const int min_level, const int max_level,
+                           std::vector<unsigned int>& indices);
+void get_keypoints_in_cell(const camera::base* camera, const frame_observation& frm_obs,
+                           const float ref_x, const float ref_y, const float margin,
+                           const int min_level, const int max_level,
+                           std::vector<unsigned int>& indices);
 std::vector<unsigned int> get_keypoints_in_cell(const camera::base* camera, const frame_observation& frm_obs,
                                                 const float ref_x, const float ref_y, const float margin,
                                                 const int min_level = -1, const int max_level = -1);
@@ -83,6 +83,36 @@ bool frame::can_observe(const std::shared_ptr<landmark>& lm, const float ray_cos
     return true;
 }
 
+void frame::can_observe(const landmark_batch& lms, const float ray_cos_thr,
+                        eigen_alloc_vector<Vec2_t>& reprojs, std::vector<float>& x_rights,
+                        std::vector<unsigned int>& pred_scale_levels, std::vector<uint8_t>& is_observable) const {
+    const unsigned int num_lms = lms.size();
+    camera_->reproject_points_to_image(rot_cw_, trans_cw_, lms.pos_ws_, reprojs, x_rights, is_observable);
+    pred_scale_levels.resize(num_lms);
+
+    const float margin_far = 1.3;
+    const float margin_near = 1.0 / margin_far;
+    const unsigned int num_scale_levels = orb_params_->num_levels_;
+    const auto& scale_factors = orb_params_->scale_factors_;
+    for (unsigned int idx = 0; idx < num_lms; ++idx) {
+        const Vec3_t cam_to_lm_vec = lms.pos_ws_[idx] - trans_wc_;
+        const float cam_to_lm_dist = cam_to_lm_vec.norm();
+        const bool inside_in_orb_scale = margin_near * lms.min_valid_dists_[idx] <= cam_to_lm_dist
+                                         && cam_to_lm_dist <= margin_far * lms.max_valid_dists_[idx];
+        const bool inside_in_view = ray_cos_thr * cam_to_lm_dist <= cam_to_lm_vec.dot(lms.obs_mean_normals_[idx]);
+        is_observable[idx] &= lms.is_valid_[idx] & inside_in_orb_scale & inside_in_view;
+
+        // same as landmark::predict_scale_level(), but the logarithm is replaced by the comparisons with the scale factors
+        // (ceil(log(ratio) / log(scale_factor)) is the number of the levels whose scale factors are smaller than ratio)
+        const float ratio = lms.max_valid_dists_[idx] / cam_to_lm_dist;
+        unsigned int pred_scale_level = 0;
+        for (unsigned int level = 0; level + 1 < num_scale_levels; ++level) {
+            pred_scale_level += scale_factors[level] < ratio;
+        }
+        pred_scale_levels[idx] = pred_scale_level;
+    }
+}
+
 bool frame::has_landmark(const std::shared_ptr<landmark>& lm) const {
     return static_cast<bool>(landmarks_idx_map_.count(lm));
 }
@@ -32,6 +32,7 @@ namespace data {
 
 class keyframe;
 class landmark;
+struct landmark_batch;
 
 class frame {
 public:
@@ -126,6 +127,14 @@ public:
     bool can_observe(const std::shared_ptr<landmark>& lm, const float ray_cos_thr,
                      Vec2_t& reproj, float& x_right, unsigned int& pred_scale_level) const;
 
+    /**
+     * Check observability of the landmarks at once
+     * (is_observable is set to 1 for the observable landmarks. The landmarks whose attributes are not valid are not observable)
+     */
+    void can_observe(const landmark_batch& lms, const float ray_cos_thr,
+                     eigen_alloc_vector<Vec2_t>& reprojs, std::vector<float>& x_rights,
+                     std::vector<unsigned int>& pred_scale_levels, std::vector<uint8_t>& is_observable) const;
+
     bool has_landmark(const std::shared_ptr<landmark>& lm) const;
 
     void add_landmark(const std::shared_ptr<landmark>&, const unsigned int idx);
@@ -2,6 +2,7 @@
 #define STELLA_VSLAM_DATA_FRAME_OBSERVATION_H
 
 #include "stella_vslam/type.h"
+#include "stella_vslam/data/keypoint_grid.h"
 
 #include <opencv2/core/mat.hpp>
 #include <opencv2/core/types.hpp>
@@ -30,7 +31,7 @@ struct frame_observation {
     //! depths
     std::vector<float> depths_;
     //! keypoint indices in each of the cells
-    std::vector<std::vector<std::vector<unsigned int>>> keypt_indices_in_cells_;
+    keypoint_grid keypt_indices_in_cells_;
     //! number of columns of grid to accelerate reprojection matching
     unsigned int num_grid_cols_;
     //! number of rows of grid to accelerate reprojection matching
@@ -2,98 +2,429 @@
 #include "stella_vslam/data/keyframe.h"
 #include "stella_vslam/data/frame_statistics.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iterator>
+
+#include <spdlog/spdlog.h>
+
 namespace stella_vslam {
 namespace data {
 
-void frame_statistics::update_frame_statistics(const data::frame& frm, const bool is_lost) {
-    if (frm.pose_is_valid()) {
-        const Mat44_t rel_cam_pose_from_ref_keyfrm = frm.get_pose_cw() * frm.ref_keyfrm_->get_pose_wc();
+frame_statistics::frame_statistics(const unsigned int chunk_size,
+                                   const unsigned int max_num_chunks_in_memory,
+                                   const std::string& spill_path,
+                                   const bool use_single_precision)
+    : chunk_size_(std::max(1u, chunk_size)), max_num_chunks_in_memory_(max_num_chunks_in_memory),
+      spill_path_(spill_path), use_single_precision_(use_single_precision) {
+    if (0 < max_num_chunks_in_memory_ && !spill_path_.empty()) {
+        spill_ofs_.open(spill_path_, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!spill_ofs_.is_open()) {
+            spdlog::critical("cannot create a file at {}", spill_path_);
+            throw std::runtime_error("cannot create a file at " + spill_path_);
+        }
+    }
+}
 
-        frm_ids_of_ref_keyfrms_[frm.ref_keyfrm_].push_back(frm.id_);
+frame_statistics::frame_statistics(const YAML::Node& yaml_node)
+    : frame_statistics(yaml_node["chunk_size"].as<unsigned int>(4096),
+                       yaml_node["max_num_chunks_in_memory"].as<unsigned int>(0),
+                       yaml_node["spill_path"].as<std::string>(""),
+                       yaml_node["use_single_precision"].as<bool>(false)) {}
 
-        ++num_valid_frms_;
-        assert(!ref_keyfrms_.count(frm.id_));
-        ref_keyfrms_[frm.id_] = frm.ref_keyfrm_;
-        assert(!rel_cam_poses_from_ref_keyfrms_.count(frm.id_));
-        rel_cam_poses_from_ref_keyfrms_[frm.id_] = rel_cam_pose_from_ref_keyfrm;
-        assert(!timestamps_.count(frm.id_));
-        timestamps_[frm.id_] = frm.timestamp_;
+frame_statistics::~frame_statistics() {
+    abort_compaction();
+    if (spill_ofs_.is_open()) {
+        spill_ofs_.close();
+        std::remove(spill_path_.c_str());
+    }
+}
+
+void frame_statistics::update_frame_statistics(const data::frame& frm, const bool is_lost) {
+    if (!frm.pose_is_valid()) {
+        return;
     }
 
-    assert(!is_lost_frms_.count(frm.id_));
-    is_lost_frms_[frm.id_] = is_lost;
+    const Mat44_t rel_cam_pose_from_ref_keyfrm = frm.get_pose_cw() * frm.ref_keyfrm_->get_pose_wc();
+    push_back(frm.id_, frm.ref_keyfrm_->id_, rel_cam_pose_from_ref_keyfrm, frm.timestamp_, is_lost);
+    ++num_valid_frms_;
 }
 
 void frame_statistics::replace_reference_keyframe(const std::shared_ptr<data::keyframe>& old_keyfrm, const std::shared_ptr<data::keyframe>& new_keyfrm) {
-    // Delete keyframes and update associations.
+    // The correction is computed with the current poses:
+    // T_cr(new) = T_cr(old) * T_rw(old) * T_wr(new)
+    const Mat44_t correction = old_keyfrm->get_pose_cw() * new_keyfrm->get_pose_wc();
+
+    finish_compaction(false);
+
+    // The frames in memory are updated in place
+    auto old_itr = frm_positions_of_ref_keyfrms_.find(old_keyfrm->id_);
+    if (old_itr != frm_positions_of_ref_keyfrms_.end()) {
+        const auto old_positions = std::move(old_itr->second);
+        frm_positions_of_ref_keyfrms_.erase(old_itr);
+        for (const auto pos : old_positions) {
+            auto& chk = make_chunk_unique(chunks_.at(pos / chunk_size_ - num_evicted_chunks_));
+            const unsigned int i = pos % chunk_size_;
+            set_rel_cam_pose(chk, i, get_rel_cam_pose(chk, i) * correction);
+            chk.ref_keyfrm_ids_[i] = new_keyfrm->id_;
+        }
+        // the positions are kept in the ascending order, so that the evicted ones are removed from the front
+        auto& new_positions = frm_positions_of_ref_keyfrms_[new_keyfrm->id_];
+        std::deque<uint64_t> merged_positions;
+        std::merge(new_positions.begin(), new_positions.end(), old_positions.begin(), old_positions.end(),
+                   std::back_inserter(merged_positions));
+        new_positions = std::move(merged_positions);
+    }
+
+    // The spilled chunks are corrected when they are read,
+    // and the spill file is rewritten so that the number of the replacements is bounded
+    if (0 < num_spilled_chunks_) {
+        replacements_[old_keyfrm->id_] = replacement{new_keyfrm->id_, correction};
+        if (chunk_size_ <= replacements_.size()) {
+            start_compaction();
+        }
+    }
+}
+
+unsigned int frame_statistics::get_num_valid_frames() const {
+    return num_valid_frms_;
+}
+
+frame_statistics::snapshot frame_statistics::get_snapshot() const {
+    snapshot snap;
+    snap.spill_path_ = spill_path_;
+    snap.num_spilled_chunks_ = num_spilled_chunks_;
+    if (0 < num_spilled_chunks_) {
+        snap.spill_ifs_ = std::make_shared<std::ifstream>(spill_path_, std::ios::in | std::ios::binary);
+    }
+    snap.num_discarded_frms_ = num_discarded_frms_;
+    snap.chunks_.assign(chunks_.begin(), chunks_.end());
+    snap.compacting_replacements_ = compacting_replacements_;
+    snap.replacements_ = replacements_;
+    return snap;
+}
+
+void frame_statistics::for_each_frame(const std::function<void(const frame_record&)>& visitor) const {
+    get_snapshot().for_each_frame(visitor);
+}
+
+void frame_statistics::snapshot::for_each_frame(const std::function<void(const frame_record&)>& visitor) const {
+    if (0 < num_discarded_frms_) {
+        spdlog::warn("{} old frames were discarded from frame statistics", num_discarded_frms_);
+    }
+
+    if (0 < num_spilled_chunks_) {
+        auto& ifs = *spill_ifs_;
+        if (!ifs.is_open()) {
+            spdlog::critical("cannot load the file at {}", spill_path_);
+            throw std::runtime_error("cannot load the file at " + spill_path_);
+        }
+        ifs.clear();
+        ifs.seekg(0);
+        chunk chk;
+        for (unsigned int i = 0; i < num_spilled_chunks_; ++i) {
+            if (!read_chunk(ifs, chk)) {
+                spdlog::error("the spilled frame statistics are broken in {}", spill_path_);
+                break;
+            }
+            if (compacting_replacements_) {
+                apply_replacements(chk, *compacting_replacements_);
+            }
+            apply_replacements(chk, replacements_);
+            for_each_frame_in_chunk(chk, visitor);
+        }
+    }
+
+    for (const auto& chk : chunks_) {
+        for_each_frame_in_chunk(*chk, visitor);
+    }
+}
+
+void frame_statistics::clear() {
+    abort_compaction();
+    num_valid_frms_ = 0;
+    chunks_.clear();
+    num_evicted_chunks_ = 0;
+    frm_positions_of_ref_keyfrms_.clear();
+    num_spilled_chunks_ = 0;
+    num_discarded_frms_ = 0;
+    replacements_.clear();
+    if (spill_ofs_.is_open()) {
+        spill_ofs_.close();
+        spill_ofs_.open(spill_path_, std::ios::out | std::ios::binary | std::ios::trunc);
+    }
+}
+
+void frame_statistics::push_back(const unsigned int frm_id, const unsigned int ref_keyfrm_id, const Mat44_t& rel_cam_pose_cr,
+                                 const double timestamp, const bool is_lost) {
+    assert(chunks_.empty() || chunks_.back()->size() == 0 || chunks_.back()->frm_ids_.back() < frm_id);
+    finish_compaction(false);
+    if (chunks_.empty() || chunks_.back()->size() == chunk_size_) {
+        chunks_.push_back(std::make_shared<chunk>());
+        auto& chk = *chunks_.back();
+        chk.frm_ids_.reserve(chunk_size_);
+        chk.ref_keyfrm_ids_.reserve(chunk_size_);
+        chk.timestamps_.reserve(chunk_size_);
+        chk.is_lost_.reserve(chunk_size_);
+        if (use_single_precision_) {
+            chk.rel_cam_poses_f_.reserve(pose_size_ * chunk_size_);
+        }
+        else {
+            chk.rel_cam_poses_.reserve(pose_size_ * chunk_size_);
+        }
+        evict_chunks();
+    }
 
-    assert(num_valid_frms_ == rel_cam_poses_from_ref_keyfrms_.size());
-    assert(num_valid_frms_ == ref_keyfrms_.size());
-    assert(num_valid_frms_ == timestamps_.size());
-    assert(num_valid_frms_ <= is_lost_frms_.size());
+    auto& chk = make_chunk_unique(chunks_.back());
+    const uint64_t pos = (num_evicted_chunks_ + chunks_.size() - 1) * chunk_size_ + chk.size();
+    frm_positions_of_ref_keyfrms_[ref_keyfrm_id].push_back(pos);
+    chk.frm_ids_.push_back(frm_id);
+    chk.ref_keyfrm_ids_.push_back(ref_keyfrm_id);
+    chk.timestamps_.push_back(timestamp);
+    chk.is_lost_.push_back(is_lost);
+    if (use_single_precision_) {
+        chk.rel_cam_poses_f_.resize(chk.rel_cam_poses_f_.size() + pose_size_);
+    }
+    else {
+        chk.rel_cam_poses_.resize(chk.rel_cam_poses_.size() + pose_size_);
+    }
+    set_rel_cam_pose(chk, chk.size() - 1, rel_cam_pose_cr);
+}
+
+frame_statistics::chunk& frame_statistics::make_chunk_unique(std::shared_ptr<chunk>& chk) {
+    // NOTE: the snapshots are taken under the same lock as the modifications,
+    // so the chunk cannot become shared after it is checked
+    if (chk.use_count() != 1) {
+        auto copied = std::make_shared<chunk>(*chk);
+        copied->frm_ids_.reserve(chk->frm_ids_.capacity());
+        copied->ref_keyfrm_ids_.reserve(chk->ref_keyfrm_ids_.capacity());
+        copied->timestamps_.reserve(chk->timestamps_.capacity());
+        copied->is_lost_.reserve(chk->is_lost_.capacity());
+        copied->rel_cam_poses_.reserve(chk->rel_cam_poses_.capacity());
+        copied->rel_cam_poses_f_.reserve(chk->rel_cam_poses_f_.capacity());
+        chk = copied;
+    }
+    return *chk;
+}
 
-    // Finish if no need to replace keyframes
-    if (!frm_ids_of_ref_keyfrms_.count(old_keyfrm)) {
+void frame_statistics::evict_chunks() {
+    if (max_num_chunks_in_memory_ == 0 || compaction_.valid()) {
         return;
     }
+    while (max_num_chunks_in_memory_ < chunks_.size()) {
+        const auto& evicted_chk = *chunks_.front();
+        if (spill_ofs_.is_open()) {
+            write_chunk(spill_ofs_, evicted_chk);
+            ++num_spilled_chunks_;
+        }
+        else {
+            num_discarded_frms_ += evicted_chk.size();
+        }
 
-    // Search frames referencing old_keyfrm which is to be deleted.
-    const auto frm_ids = frm_ids_of_ref_keyfrms_.at(old_keyfrm);
+        // remove the evicted frames from the index
+        const uint64_t end_pos = (num_evicted_chunks_ + 1) * chunk_size_;
+        for (const auto ref_keyfrm_id : evicted_chk.ref_keyfrm_ids_) {
+            auto itr = frm_positions_of_ref_keyfrms_.find(ref_keyfrm_id);
+            if (itr == frm_positions_of_ref_keyfrms_.end()) {
+                continue;
+            }
+            auto& positions = itr->second;
+            while (!positions.empty() && positions.front() < end_pos) {
+                positions.pop_front();
+            }
+            if (positions.empty()) {
+                frm_positions_of_ref_keyfrms_.erase(itr);
+            }
+        }
 
-    for (const auto frm_id : frm_ids) {
-        assert(*ref_keyfrms_.at(frm_id) == *old_keyfrm);
+        chunks_.pop_front();
+        ++num_evicted_chunks_;
+    }
+}
+
+void frame_statistics::start_compaction() {
+    if (compaction_.valid()) {
+        // the replacements are accumulated until the running compaction finishes
+        return;
+    }
+    spdlog::debug("apply {} keyframe replacements to the spilled frame statistics", replacements_.size());
 
-        // Get pose and relative pose of the old keyframe
-        const Mat44_t old_ref_cam_pose_cw = old_keyfrm->get_pose_cw();
-        const Mat44_t old_rel_cam_pose_cr = rel_cam_poses_from_ref_keyfrms_.at(frm_id);
+    // The spill file is not appended while it is compacted (see evict_chunks()),
+    // and the replacements are applied by the snapshots until the compacted file replaces it
+    auto replacements = std::make_shared<const replacement_map_t>(std::move(replacements_));
+    replacements_.clear();
+    compacting_replacements_ = replacements;
+    const unsigned int num_chunks = num_spilled_chunks_;
+    compaction_ = std::async(std::launch::async, [this, num_chunks, replacements] {
+        write_compacted_spill_file(num_chunks, *replacements);
+    });
+}
 
-        // Replace pointer of the keyframe to new_keyfrm
-        ref_keyfrms_.at(frm_id) = new_keyfrm;
+void frame_statistics::finish_compaction(const bool wait) {
+    if (!compaction_.valid()) {
+        return;
+    }
+    if (!wait && compaction_.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return;
+    }
+    compaction_.get();
 
-        // Update relative pose
-        const Mat44_t new_ref_cam_pose_cw = new_keyfrm->get_pose_cw();
-        const Mat44_t new_rel_cam_pose_cr = old_rel_cam_pose_cr * old_ref_cam_pose_cw * new_ref_cam_pose_cw.inverse();
-        rel_cam_poses_from_ref_keyfrms_.at(frm_id) = new_rel_cam_pose_cr;
+    // the snapshots keep the old file open, to which the replacements in them are applied
+    spill_ofs_.close();
+    const auto tmp_path = spill_path_ + ".tmp";
+    if (std::rename(tmp_path.c_str(), spill_path_.c_str()) != 0) {
+        spdlog::critical("cannot rewrite the file at {}", spill_path_);
+        throw std::runtime_error("cannot rewrite the file at " + spill_path_);
     }
+    spill_ofs_.open(spill_path_, std::ios::out | std::ios::binary | std::ios::app);
+    compacting_replacements_.reset();
 
-    // Update frames referencing new_keyfrm
-    auto& new_frm_ids = frm_ids_of_ref_keyfrms_[new_keyfrm];
-    new_frm_ids.insert(new_frm_ids.end(), frm_ids.begin(), frm_ids.end());
-    // Remove frames referencing old_keyfrm
-    frm_ids_of_ref_keyfrms_.erase(old_keyfrm);
+    // spill the chunks kept during the compaction
+    evict_chunks();
 }
 
-std::unordered_map<std::shared_ptr<data::keyframe>, std::vector<unsigned int>> frame_statistics::get_frame_id_of_reference_keyframes() const {
-    return frm_ids_of_ref_keyfrms_;
+void frame_statistics::write_compacted_spill_file(const unsigned int num_chunks, const replacement_map_t& replacements) const {
+    const auto tmp_path = spill_path_ + ".tmp";
+    std::ifstream ifs(spill_path_, std::ios::in | std::ios::binary);
+    std::ofstream ofs(tmp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!ifs.is_open() || !ofs.is_open()) {
+        spdlog::critical("cannot rewrite the file at {}", spill_path_);
+        throw std::runtime_error("cannot rewrite the file at " + spill_path_);
+    }
+    chunk chk;
+    for (unsigned int i = 0; i < num_chunks; ++i) {
+        if (!read_chunk(ifs, chk)) {
+            spdlog::critical("the spilled frame statistics are broken in {}", spill_path_);
+            throw std::runtime_error("the spilled frame statistics are broken in " + spill_path_);
+        }
+        apply_replacements(chk, replacements);
+        write_chunk(ofs, chk);
+    }
 }
 
-unsigned int frame_statistics::get_num_valid_frames() const {
-    return num_valid_frms_;
+void frame_statistics::abort_compaction() {
+    if (!compaction_.valid()) {
+        return;
+    }
+    compaction_.wait();
+    compaction_ = std::future<void>();
+    compacting_replacements_.reset();
+    std::remove((spill_path_ + ".tmp").c_str());
 }
 
-std::map<unsigned int, std::shared_ptr<data::keyframe>> frame_statistics::get_reference_keyframes() const {
-    return {ref_keyfrms_.begin(), ref_keyfrms_.end()};
+void frame_statistics::write_chunk(std::ofstream& ofs, const chunk& chk) const {
+    const auto write_column = [&ofs](const void* data, const size_t size) {
+        ofs.write(reinterpret_cast<const char*>(data), size);
+    };
+    const uint32_t num_frms = chk.size();
+    const uint8_t is_single_precision = !chk.rel_cam_poses_f_.empty();
+    write_column(&num_frms, sizeof(num_frms));
+    write_column(&is_single_precision, sizeof(is_single_precision));
+    write_column(chk.frm_ids_.data(), num_frms * sizeof(uint32_t));
+    write_column(chk.ref_keyfrm_ids_.data(), num_frms * sizeof(uint32_t));
+    write_column(chk.timestamps_.data(), num_frms * sizeof(double));
+    write_column(chk.is_lost_.data(), num_frms * sizeof(uint8_t));
+    if (is_single_precision) {
+        write_column(chk.rel_cam_poses_f_.data(), pose_size_ * num_frms * sizeof(float));
+    }
+    else {
+        write_column(chk.rel_cam_poses_.data(), pose_size_ * num_frms * sizeof(double));
+    }
+    // the spill file is read while it is open
+    ofs.flush();
+    if (!ofs.good()) {
+        spdlog::critical("cannot write frame statistics to {}", spill_path_);
+        throw std::runtime_error("cannot write frame statistics to " + spill_path_);
+    }
 }
 
-eigen_alloc_map<unsigned int, Mat44_t> frame_statistics::get_relative_cam_poses() const {
-    return {rel_cam_poses_from_ref_keyfrms_.begin(), rel_cam_poses_from_ref_keyfrms_.end()};
+bool frame_statistics::read_chunk(std::ifstream& ifs, chunk& chk) {
+    const auto read_column = [&ifs](void* data, const size_t size) {
+        ifs.read(reinterpret_cast<char*>(data), size);
+    };
+    uint32_t num_frms = 0;
+    uint8_t is_single_precision = 0;
+    read_column(&num_frms, sizeof(num_frms));
+    read_column(&is_single_precision, sizeof(is_single_precision));
+    if (!ifs.good()) {
+        return false;
+    }
+    chk.frm_ids_.resize(num_frms);
+    chk.ref_keyfrm_ids_.resize(num_frms);
+    chk.timestamps_.resize(num_frms);
+    chk.is_lost_.resize(num_frms);
+    read_column(chk.frm_ids_.data(), num_frms * sizeof(uint32_t));
+    read_column(chk.ref_keyfrm_ids_.data(), num_frms * sizeof(uint32_t));
+    read_column(chk.timestamps_.data(), num_frms * sizeof(double));
+    read_column(chk.is_lost_.data(), num_frms * sizeof(uint8_t));
+    if (is_single_precision) {
+        chk.rel_cam_poses_.clear();
+        chk.rel_cam_poses_f_.resize(pose_size_ * num_frms);
+        read_column(chk.rel_cam_poses_f_.data(), pose_size_ * num_frms * sizeof(float));
+    }
+    else {
+        chk.rel_cam_poses_f_.clear();
+        chk.rel_cam_poses_.resize(pose_size_ * num_frms);
+        read_column(chk.rel_cam_poses_.data(), pose_size_ * num_frms * sizeof(double));
+    }
+    return ifs.good();
 }
 
-std::map<unsigned int, double> frame_statistics::get_timestamps() const {
-    return {timestamps_.begin(), timestamps_.end()};
+Mat44_t frame_statistics::get_rel_cam_pose(const chunk& chk, const unsigned int i) {
+    const bool is_single_precision = !chk.rel_cam_poses_f_.empty();
+    double pose[pose_size_];
+    for (unsigned int j = 0; j < pose_size_; ++j) {
+        pose[j] = is_single_precision ? chk.rel_cam_poses_f_[pose_size_ * i + j] : chk.rel_cam_poses_[pose_size_ * i + j];
+    }
+    Mat44_t rel_cam_pose_cr = Mat44_t::Identity();
+    rel_cam_pose_cr.block<3, 3>(0, 0) = Quat_t(pose[3], pose[0], pose[1], pose[2]).normalized().toRotationMatrix();
+    rel_cam_pose_cr.block<3, 1>(0, 3) = Vec3_t(pose[4], pose[5], pose[6]);
+    return rel_cam_pose_cr;
 }
 
-std::map<unsigned int, bool> frame_statistics::get_lost_frames() const {
-    return {is_lost_frms_.begin(), is_lost_frms_.end()};
+void frame_statistics::set_rel_cam_pose(chunk& chk, const unsigned int i, const Mat44_t& rel_cam_pose_cr) {
+    const Quat_t quat_cr = Quat_t(Mat33_t(rel_cam_pose_cr.block<3, 3>(0, 0))).normalized();
+    const Vec3_t trans_cr = rel_cam_pose_cr.block<3, 1>(0, 3);
+    const double pose[pose_size_] = {quat_cr.x(), quat_cr.y(), quat_cr.z(), quat_cr.w(), trans_cr(0), trans_cr(1), trans_cr(2)};
+    if (!chk.rel_cam_poses_f_.empty()) {
+        std::copy(pose, pose + pose_size_, chk.rel_cam_poses_f_.begin() + pose_size_ * i);
+    }
+    else {
+        std::copy(pose, pose + pose_size_, chk.rel_cam_poses_.begin() + pose_size_ * i);
+    }
 }
 
-void frame_statistics::clear() {
-    num_valid_frms_ = 0;
-    frm_ids_of_ref_keyfrms_.clear();
-    ref_keyfrms_.clear();
-    rel_cam_poses_from_ref_keyfrms_.clear();
-    timestamps_.clear();
-    is_lost_frms_.clear();
+void frame_statistics::apply_replacements(chunk& chk, const replacement_map_t& replacements) {
+    if (replacements.empty()) {
+        return;
+    }
+    for (unsigned int i = 0; i < chk.size(); ++i) {
+        auto itr = replacements.find(chk.ref_keyfrm_ids_[i]);
+        if (itr == replacements.end()) {
+            continue;
+        }
+        // follow the keyframes which replaced the erased ones
+        Mat44_t rel_cam_pose_cr = get_rel_cam_pose(chk, i);
+        while (itr != replacements.end()) {
+            rel_cam_pose_cr = rel_cam_pose_cr * itr->second.correction_;
+            chk.ref_keyfrm_ids_[i] = itr->second.new_keyfrm_id_;
+            itr = replacements.find(chk.ref_keyfrm_ids_[i]);
+        }
+        set_rel_cam_pose(chk, i, rel_cam_pose_cr);
+    }
+}
+
+void frame_statistics::for_each_frame_in_chunk(const chunk& chk, const std::function<void(const frame_record&)>& visitor) {
+    frame_record record;
+    for (unsigned int i = 0; i < chk.size(); ++i) {
+        record.frm_id_ = chk.frm_ids_[i];
+        record.ref_keyfrm_id_ = chk.ref_keyfrm_ids_[i];
+        record.timestamp_ = chk.timestamps_[i];
+        record.is_lost_ = chk.is_lost_[i];
+        record.rel_cam_pose_cr_ = get_rel_cam_pose(chk, i);
+        visitor(record);
+    }
 }
 
 } // namespace data
@@ -3,9 +3,17 @@
 
 #include "stella_vslam/type.h"
 
-#include <vector>
-#include <unordered_map>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <future>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <yaml-cpp/yaml.h>
 
 namespace stella_vslam {
 namespace data {
@@ -13,20 +21,110 @@ namespace data {
 class frame;
 class keyframe;
 
+/**
+ * Trajectory of the tracked frames
+ * The frames are stored in fixed-size chunks of columns (the relative pose is stored as a quaternion and a translation),
+ * and the reference keyframes are referred by their IDs so that the erased keyframes are not kept alive.
+ * The number of the chunks in memory can be bounded, then the oldest chunk is spilled to a file (or discarded if no file is given).
+ */
 class frame_statistics {
+private:
+    //! Columns of the consecutive frames
+    struct chunk {
+        std::vector<uint32_t> frm_ids_;
+        std::vector<uint32_t> ref_keyfrm_ids_;
+        std::vector<double> timestamps_;
+        std::vector<uint8_t> is_lost_;
+        //! Rotation (x, y, z, w) and translation of the relative poses, in double or single precision
+        std::vector<double> rel_cam_poses_;
+        std::vector<float> rel_cam_poses_f_;
+
+        size_t size() const {
+            return frm_ids_.size();
+        }
+    };
+
+    //! Keyframe which replaced an erased keyframe, and the pose correction (T_old_new) applied to the relative poses
+    struct replacement {
+        unsigned int new_keyfrm_id_;
+        Mat44_t correction_;
+
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    };
+
+    using replacement_map_t = eigen_alloc_unord_map<unsigned int, replacement>;
+
+    //! Positions of the frames in memory which refer to each keyframe, in the ascending order
+    //! (the position of a frame is (the index of the chunk since the start) * chunk_size_ + (the index in the chunk))
+    using frame_positions_t = std::unordered_map<unsigned int, std::deque<uint64_t>>;
+
 public:
+    //! Statistics of a frame, whose relative pose is expressed against the current reference keyframe
+    struct frame_record {
+        unsigned int frm_id_;
+        unsigned int ref_keyfrm_id_;
+        Mat44_t rel_cam_pose_cr_;
+        double timestamp_;
+        bool is_lost_;
+
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    };
+
+    /**
+     * Frames contained at a moment, which can be visited without locking the owner
+     * (the chunks in memory are shared with the owner, which copies a chunk before modifying it while it is shared)
+     */
+    class snapshot {
+    public:
+        /**
+         * Visit the valid frames in the ascending order of the IDs (including the spilled ones)
+         * @param visitor
+         */
+        void for_each_frame(const std::function<void(const frame_record&)>& visitor) const;
+
+    private:
+        friend class frame_statistics;
+
+        std::string spill_path_;
+        //! Spill file opened when the snapshot is taken (it stays valid even if the file is rewritten afterward)
+        std::shared_ptr<std::ifstream> spill_ifs_;
+        unsigned int num_spilled_chunks_ = 0;
+        unsigned int num_discarded_frms_ = 0;
+        std::vector<std::shared_ptr<const chunk>> chunks_;
+        //! Replacements being applied to the spill file by the compaction (applied before replacements_)
+        std::shared_ptr<const replacement_map_t> compacting_replacements_;
+        replacement_map_t replacements_;
+    };
+
     /**
      * Constructor
+     * @param chunk_size number of the frames in a chunk
+     * @param max_num_chunks_in_memory maximum number of the chunks kept in memory (0: unlimited)
+     * @param spill_path path of the file to which the old chunks are spilled (empty: the old chunks are discarded)
+     * @param use_single_precision if true, the relative poses are stored in single precision
      */
-    frame_statistics() = default;
+    explicit frame_statistics(const unsigned int chunk_size = 4096,
+                              const unsigned int max_num_chunks_in_memory = 0,
+                              const std::string& spill_path = "",
+                              const bool use_single_precision = false);
+
+    /**
+     * Constructor
+     * @param yaml_node
+     */
+    explicit frame_statistics(const YAML::Node& yaml_node);
 
     /**
      * Destructor
      */
-    virtual ~frame_statistics() = default;
+    virtual ~frame_statistics();
+
+    frame_statistics(const frame_statistics&) = delete;
+    frame_statistics& operator=(const frame_statistics&) = delete;
 
     /**
      * Update frame statistics
+     * (NOTE: the frames must be given in the ascending order of the IDs)
      * @param frm
      * @param is_lost
      */
@@ -39,12 +137,6 @@ public:
      */
     void replace_reference_keyframe(const std::shared_ptr<data::keyframe>& old_keyfrm, const std::shared_ptr<data::keyframe>& new_keyfrm);
 
-    /**
-     * Get frame IDs of each of the reference keyframes
-     * @return
-     */
-    std::unordered_map<std::shared_ptr<data::keyframe>, std::vector<unsigned int>> get_frame_id_of_reference_keyframes() const;
-
     /**
      * Get the number of the contained valid frames
      * @return
@@ -52,28 +144,16 @@ public:
     unsigned int get_num_valid_frames() const;
 
     /**
-     * Get reference keyframes of each of the frames
-     * @return
-     */
-    std::map<unsigned int, std::shared_ptr<data::keyframe>> get_reference_keyframes() const;
-
-    /**
-     * Get relative camera poses from the corresponding reference keyframes
-     * @return
-     */
-    eigen_alloc_map<unsigned int, Mat44_t> get_relative_cam_poses() const;
-
-    /**
-     * Get timestamps
+     * Get the snapshot of the frames (the spilled chunks are read when the snapshot is visited)
      * @return
      */
-    std::map<unsigned int, double> get_timestamps() const;
+    snapshot get_snapshot() const;
 
     /**
-     * Get lost frame flags
-     * @return
+     * Visit the valid frames in the ascending order of the IDs (including the spilled ones)
+     * @param visitor
      */
-    std::map<unsigned int, bool> get_lost_frames() const;
+    void for_each_frame(const std::function<void(const frame_record&)>& visitor) const;
 
     /**
      * Clear frame statistics
@@ -81,21 +161,80 @@ public:
     void clear();
 
 private:
-    //! Reference keyframe, frame ID associated with the keyframe
-    std::unordered_map<std::shared_ptr<data::keyframe>, std::vector<unsigned int>> frm_ids_of_ref_keyfrms_;
+    //! Number of the elements of a compact relative pose
+    static constexpr unsigned int pose_size_ = 7;
+
+    //! Append a frame to the last chunk
+    void push_back(const unsigned int frm_id, const unsigned int ref_keyfrm_id, const Mat44_t& rel_cam_pose_cr,
+                   const double timestamp, const bool is_lost);
+
+    //! Copy the chunk if it is shared with snapshots, so that it can be modified
+    static chunk& make_chunk_unique(std::shared_ptr<chunk>& chk);
+
+    //! Spill or discard the oldest chunk if the number of the chunks exceeds the limit
+    //! (the chunks are kept in memory while the spill file is being compacted)
+    void evict_chunks();
+
+    //! Start applying the accumulated replacements to the spill file in the background
+    void start_compaction();
+
+    //! Replace the spill file with the compacted one if the compaction has finished (or wait for it)
+    void finish_compaction(const bool wait);
+
+    //! Write the first num_chunks chunks of the spill file to the temporary file with the replacements applied
+    //! (this is called in the background, and refers only to the constant members)
+    void write_compacted_spill_file(const unsigned int num_chunks, const replacement_map_t& replacements) const;
+
+    //! Discard the running compaction
+    void abort_compaction();
+
+    //! Write a chunk to a file
+    void write_chunk(std::ofstream& ofs, const chunk& chk) const;
+
+    //! Read a chunk from the spill file
+    static bool read_chunk(std::ifstream& ifs, chunk& chk);
+
+    //! Get the relative pose of the i-th frame in a chunk
+    static Mat44_t get_rel_cam_pose(const chunk& chk, const unsigned int i);
+
+    //! Set the relative pose of the i-th frame in a chunk
+    static void set_rel_cam_pose(chunk& chk, const unsigned int i, const Mat44_t& rel_cam_pose_cr);
+
+    //! Follow the replacements of the reference keyframes in a chunk
+    static void apply_replacements(chunk& chk, const replacement_map_t& replacements);
+
+    //! Visit the frames in a chunk
+    static void for_each_frame_in_chunk(const chunk& chk, const std::function<void(const frame_record&)>& visitor);
+
+    const unsigned int chunk_size_;
+    const unsigned int max_num_chunks_in_memory_;
+    const std::string spill_path_;
+    const bool use_single_precision_;
+
+    //! Chunks in memory (the last one is being filled)
+    std::deque<std::shared_ptr<chunk>> chunks_;
+    //! Number of the chunks removed from the front of chunks_
+    uint64_t num_evicted_chunks_ = 0;
+    //! Index of the frames in memory by the reference keyframe
+    frame_positions_t frm_positions_of_ref_keyfrms_;
+
+    //! Spill file
+    std::ofstream spill_ofs_;
+    //! Number of the chunks in the spill file
+    unsigned int num_spilled_chunks_ = 0;
+    //! Number of the discarded frames
+    unsigned int num_discarded_frms_ = 0;
 
     //! Number of valid frames
     unsigned int num_valid_frms_ = 0;
 
-    // Size of all the following variables is the number of frames
-    //! Reference keyframes for each frame
-    std::unordered_map<unsigned int, std::shared_ptr<data::keyframe>> ref_keyfrms_;
-    //! Relative pose against reference keyframe for each frame
-    eigen_alloc_unord_map<unsigned int, Mat44_t> rel_cam_poses_from_ref_keyfrms_;
-    //! Timestamp for each frame
-    std::unordered_map<unsigned int, double> timestamps_;
-    //! Flag whether each frame is lost or not
-    std::unordered_map<unsigned int, bool> is_lost_frms_;
+    //! Replacements of the keyframes referred by the spilled chunks
+    //! (the chunks in memory are updated in place, and the spill file is rewritten in the background when chunk_size_ replacements are accumulated)
+    replacement_map_t replacements_;
+    //! Replacements being applied to the spill file by the running compaction
+    std::shared_ptr<const replacement_map_t> compacting_replacements_;
+    //! Running compaction of the spill file
+    std::future<void> compaction_;
 };
 
 } // namespace data
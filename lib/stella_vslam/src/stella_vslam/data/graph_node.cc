@@ -23,7 +23,7 @@ void graph_node::add_connection(const std::shared_ptr<keyframe>& keyfrm, const u
     }
 
     if (need_update) {
-        update_covisibility_orders_impl();
+        covisibility_orders_are_outdated_ = true;
     }
 }
 
@@ -36,7 +36,7 @@ void graph_node::erase_connection(const std::shared_ptr<keyframe>& keyfrm) {
     }
 
     if (need_update) {
-        update_covisibility_orders_impl();
+        covisibility_orders_are_outdated_ = true;
     }
 }
 
@@ -52,37 +52,35 @@ void graph_node::erase_all_connections() {
     connected_keyfrms_and_num_shared_lms_.clear();
     ordered_covisibilities_.clear();
     ordered_num_shared_lms_.clear();
+    covisibility_orders_are_outdated_ = false;
 }
 
 void graph_node::update_connections(unsigned int min_num_shared_lms) {
     const auto owner_keyfrm = owner_keyfrm_.lock();
-    const auto landmarks = owner_keyfrm->get_landmarks();
+
+    // the numbers of shared landmarks are counted up when the landmark observations are added
+    std::vector<std::pair<std::shared_ptr<keyframe>, unsigned int>> keyfrms_and_num_shared_lms;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        keyfrms_and_num_shared_lms.reserve(keyfrms_and_num_shared_lms_.size());
+        for (const auto& id_and_keyfrm_and_num_shared_lms : keyfrms_and_num_shared_lms_) {
+            const auto& keyfrm_and_num_shared_lms = id_and_keyfrm_and_num_shared_lms.second;
+            keyfrms_and_num_shared_lms.emplace_back(keyfrm_and_num_shared_lms.first.lock(), keyfrm_and_num_shared_lms.second);
+        }
+    }
 
     id_ordered_map<std::weak_ptr<keyframe>, unsigned int> keyfrm_to_num_shared_lms;
 
-    for (const auto& lm : landmarks) {
-        if (!lm) {
+    for (const auto& keyfrm_and_num_shared_lms : keyfrms_and_num_shared_lms) {
+        const auto& keyfrm = keyfrm_and_num_shared_lms.first;
+        if (!keyfrm) {
             continue;
         }
-        if (lm->will_be_erased()) {
+        if (keyfrm->graph_node_->get_spanning_parent() == nullptr && !keyfrm->graph_node_->is_spanning_root()) {
             continue;
         }
-
-        const auto observations = lm->get_observations();
-
-        for (const auto& obs : observations) {
-            auto keyfrm = obs.first;
-            auto locked_keyfrm = keyfrm.lock();
-
-            if (locked_keyfrm->graph_node_->spanning_parent_.expired() && !locked_keyfrm->graph_node_->is_spanning_root()) {
-                continue;
-            }
-            if (locked_keyfrm->id_ == owner_keyfrm->id_) {
-                continue;
-            }
-            // count up number of shared landmarks of `keyfrm`
-            keyfrm_to_num_shared_lms[keyfrm]++;
-        }
+        // the keyframes are already in ascending order of the IDs
+        keyfrm_to_num_shared_lms.emplace_hint(keyfrm_to_num_shared_lms.end(), keyfrm, keyfrm_and_num_shared_lms.second);
     }
 
     if (keyfrm_to_num_shared_lms.empty()) {
@@ -142,6 +140,7 @@ void graph_node::update_connections(unsigned int min_num_shared_lms) {
 
         ordered_covisibilities_ = ordered_covisibilities;
         ordered_num_shared_lms_ = ordered_num_shared_lms;
+        covisibility_orders_are_outdated_ = false;
 
         if (spanning_parent_.expired() && !is_spanning_root_impl()) {
             // set the parent of spanning tree
@@ -153,12 +152,36 @@ void graph_node::update_connections(unsigned int min_num_shared_lms) {
     }
 }
 
+void graph_node::increase_num_shared_landmarks(const std::shared_ptr<keyframe>& keyfrm) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto& keyfrm_and_num_shared_lms = keyfrms_and_num_shared_lms_[keyfrm->id_];
+    keyfrm_and_num_shared_lms.first = keyfrm;
+    ++keyfrm_and_num_shared_lms.second;
+}
+
+void graph_node::decrease_num_shared_landmarks(const std::shared_ptr<keyframe>& keyfrm) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    auto itr = keyfrms_and_num_shared_lms_.find(keyfrm->id_);
+    if (itr == keyfrms_and_num_shared_lms_.end()) {
+        return;
+    }
+    if (--itr->second.second == 0) {
+        keyfrms_and_num_shared_lms_.erase(itr);
+    }
+}
+
 void graph_node::update_covisibility_orders() {
     std::lock_guard<std::mutex> lock(mtx_);
     update_covisibility_orders_impl();
 }
 
-void graph_node::update_covisibility_orders_impl() {
+void graph_node::update_covisibility_orders_if_needed() const {
+    if (covisibility_orders_are_outdated_) {
+        update_covisibility_orders_impl();
+    }
+}
+
+void graph_node::update_covisibility_orders_impl() const {
     std::vector<std::pair<unsigned int, std::shared_ptr<keyframe>>> num_shared_lms_and_keyfrm_pairs;
     num_shared_lms_and_keyfrm_pairs.reserve(connected_keyfrms_and_num_shared_lms_.size());
 
@@ -178,6 +201,7 @@ void graph_node::update_covisibility_orders_impl() {
         ordered_covisibilities_.push_back(num_shared_lms_and_keyfrm_pair.second);
         ordered_num_shared_lms_.push_back(num_shared_lms_and_keyfrm_pair.first);
     }
+    covisibility_orders_are_outdated_ = false;
 }
 
 std::set<std::shared_ptr<keyframe>> graph_node::get_connected_keyframes() const {
@@ -193,6 +217,7 @@ std::set<std::shared_ptr<keyframe>> graph_node::get_connected_keyframes() const
 
 std::vector<std::shared_ptr<keyframe>> graph_node::get_covisibilities() const {
     std::lock_guard<std::mutex> lock(mtx_);
+    update_covisibility_orders_if_needed();
     std::vector<std::shared_ptr<keyframe>> covisibilities;
 
     for (const auto& covisibility : ordered_covisibilities_) {
@@ -205,24 +230,32 @@ std::vector<std::shared_ptr<keyframe>> graph_node::get_covisibilities() const {
 }
 
 std::vector<std::shared_ptr<keyframe>> graph_node::get_top_n_covisibilities(const unsigned int num_covisibilities) const {
-    std::lock_guard<std::mutex> lock(mtx_);
     std::vector<std::shared_ptr<keyframe>> covisibilities;
+    get_top_n_covisibilities(num_covisibilities, covisibilities);
+    return covisibilities;
+}
+
+void graph_node::get_top_n_covisibilities(const unsigned int num_covisibilities, std::vector<std::shared_ptr<keyframe>>& covisibilities) const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    update_covisibility_orders_if_needed();
+    covisibilities.clear();
     unsigned int i = 0;
     for (const auto& covisibility : ordered_covisibilities_) {
         if (i == num_covisibilities) {
             break;
         }
-        if (covisibility.expired()) {
+        auto locked_covisibility = covisibility.lock();
+        if (!locked_covisibility) {
             continue;
         }
-        covisibilities.push_back(covisibility.lock());
+        covisibilities.push_back(std::move(locked_covisibility));
         i++;
     }
-    return covisibilities;
 }
 
 std::vector<std::shared_ptr<keyframe>> graph_node::get_covisibilities_over_min_num_shared_lms(const unsigned int min_num_shared_lms) const {
     std::lock_guard<std::mutex> lock(mtx_);
+    update_covisibility_orders_if_needed();
 
     if (ordered_covisibilities_.empty()) {
         return std::vector<std::shared_ptr<keyframe>>();
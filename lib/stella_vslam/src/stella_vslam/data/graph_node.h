@@ -44,10 +44,22 @@ public:
     void erase_all_connections();
 
     /**
-     * Update the connections and the covisibilities by referring landmark observations
+     * Update the connections and the covisibilities by referring the numbers of shared landmarks
      */
     void update_connections(unsigned int min_num_shared_lms);
 
+    /**
+     * Increase the number of shared landmarks with specified keyframe
+     * (NOTE: this function is called when the keyframes start to observe the same landmark)
+     */
+    void increase_num_shared_landmarks(const std::shared_ptr<keyframe>& keyfrm);
+
+    /**
+     * Decrease the number of shared landmarks with specified keyframe
+     * (NOTE: this function is called when the keyframes stop to observe the same landmark)
+     */
+    void decrease_num_shared_landmarks(const std::shared_ptr<keyframe>& keyfrm);
+
     /**
      * Update the order of the covisibilities
      * (NOTE: the new keyframe won't inserted)
@@ -69,6 +81,11 @@ public:
      */
     std::vector<std::shared_ptr<keyframe>> get_top_n_covisibilities(const unsigned int num_covisibilities) const;
 
+    /**
+     * Get the top-n covisibility keyframes into the given buffer (which is cleared first)
+     */
+    void get_top_n_covisibilities(const unsigned int num_covisibilities, std::vector<std::shared_ptr<keyframe>>& covisibilities) const;
+
     /**
      * Get the covisibility keyframes which have shared landmarks over the threshold
      */
@@ -157,7 +174,12 @@ private:
      * Update the order of the covisibilities (without mutex)
      * (NOTE: the new keyframe won't inserted)
      */
-    void update_covisibility_orders_impl();
+    void update_covisibility_orders_impl() const;
+
+    /**
+     * Update the order of the covisibilities if the connections have been changed since the last update (without mutex)
+     */
+    void update_covisibility_orders_if_needed() const;
 
     /**
      * Extract intersection from the two lists of keyframes
@@ -178,10 +200,15 @@ private:
     //! all connected keyframes and the number of shared landmarks between the keyframes
     id_ordered_map<std::weak_ptr<keyframe>, unsigned int> connected_keyfrms_and_num_shared_lms_;
 
+    //! number of shared landmarks with each of the keyframes (keyed by the keyframe ID), which is kept up to date with the landmark observations
+    std::map<unsigned int, std::pair<std::weak_ptr<keyframe>, unsigned int>> keyfrms_and_num_shared_lms_;
+
     //! covisibility keyframe in descending order of the number of shared landmarks
-    std::vector<std::weak_ptr<keyframe>> ordered_covisibilities_;
+    mutable std::vector<std::weak_ptr<keyframe>> ordered_covisibilities_;
     //! number of shared landmarks in descending order
-    std::vector<unsigned int> ordered_num_shared_lms_;
+    mutable std::vector<unsigned int> ordered_num_shared_lms_;
+    //! if true, the connections have been changed and the covisibilities must be sorted again before being read
+    mutable bool covisibility_orders_are_outdated_ = false;
 
     //! parent of spanning tree
     std::weak_ptr<keyframe> spanning_parent_;
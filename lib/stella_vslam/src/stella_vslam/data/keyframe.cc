@@ -5,6 +5,7 @@
 #include "stella_vslam/data/marker.h"
 #include "stella_vslam/data/marker2d.h"
 #include "stella_vslam/data/map_database.h"
+#include "stella_vslam/data/map_change_journal.h"
 #include "stella_vslam/data/bow_database.h"
 #include "stella_vslam/data/camera_database.h"
 #include "stella_vslam/data/orb_params_database.h"
@@ -164,7 +165,6 @@ std::shared_ptr<keyframe> keyframe::make_keyframe(
 std::shared_ptr<keyframe> keyframe::from_stmt(sqlite3_stmt* stmt,
                                               camera_database* cam_db,
                                               orb_params_database* orb_params_db,
-                                              bow_vocabulary* bow_vocab,
                                               unsigned int next_keyframe_id) {
     const char* p;
     int column_id = 0;
@@ -230,19 +230,14 @@ std::shared_ptr<keyframe> keyframe::from_stmt(sqlite3_stmt* stmt,
         markers_2d = markers2d_from_blob(num_markers, markers_blob);
     }
 
+    // NOTE: bearings and BoW are computed later in map_database::reconstruct_keyframes()
     auto bearings = eigen_alloc_vector<Vec3_t>();
-    camera->convert_keypoints_to_bearings(undist_keypts, bearings);
-    assert(bearings.size() == num_keypts);
 
     // Construct a new object
     data::bow_vector bow_vec;
     data::bow_feature_vector bow_feat_vec;
     // Construct frame_observation
     frame_observation frm_obs{descriptors, undist_keypts, bearings, stereo_x_right, depths};
-    // Compute BoW
-    if (bow_vocab) {
-        data::bow_vocabulary_util::compute_bow(bow_vocab, descriptors, bow_vec, bow_feat_vec);
-    }
     // NOTE: 3D marker info will be filled in later based on loaded markers
     auto keyfrm = data::keyframe::make_keyframe(
         id + next_keyframe_id, timestamp, pose_cw, camera, orb_params,
@@ -251,7 +246,7 @@ std::shared_ptr<keyframe> keyframe::from_stmt(sqlite3_stmt* stmt,
     return keyfrm;
 }
 
-nlohmann::json keyframe::to_json() const {
+nlohmann::json keyframe::to_json(const bool save_bow_vectors) const {
     // extract landmark IDs
     std::vector<int> landmark_ids(landmarks_.size(), -1);
     for (unsigned int i = 0; i < landmark_ids.size(); ++i) {
@@ -280,23 +275,30 @@ nlohmann::json keyframe::to_json() const {
 
     // TODO: msgpack format does not yet support markers save/load
 
-    return {{"ts", timestamp_},
-            {"cam", camera_->name_},
-            {"orb_params", orb_params_->name_},
-            // camera pose
-            {"rot_cw", convert_rotation_to_json(pose_cw_.block<3, 3>(0, 0))},
-            {"trans_cw", convert_translation_to_json(pose_cw_.block<3, 1>(0, 3))},
-            // features and observations
-            {"n_keypts", frm_obs_.undist_keypts_.size()},
-            {"undist_keypts", convert_keypoints_to_json(frm_obs_.undist_keypts_)},
-            {"x_rights", frm_obs_.stereo_x_right_},
-            {"depths", frm_obs_.depths_},
-            {"descs", convert_descriptors_to_json(frm_obs_.descriptors_)},
-            {"lm_ids", landmark_ids},
-            // graph information
-            {"span_parent", spanning_parent ? spanning_parent->id_ : -1},
-            {"span_children", spanning_child_ids},
-            {"loop_edges", loop_edge_ids}};
+    nlohmann::json json_keyfrm = {{"ts", timestamp_},
+                                  {"cam", camera_->name_},
+                                  {"orb_params", orb_params_->name_},
+                                  // camera pose
+                                  {"rot_cw", convert_rotation_to_json(pose_cw_.block<3, 3>(0, 0))},
+                                  {"trans_cw", convert_translation_to_json(pose_cw_.block<3, 1>(0, 3))},
+                                  // features and observations
+                                  {"n_keypts", frm_obs_.undist_keypts_.size()},
+                                  {"undist_keypts", convert_keypoints_to_json(frm_obs_.undist_keypts_)},
+                                  {"x_rights", frm_obs_.stereo_x_right_},
+                                  {"depths", frm_obs_.depths_},
+                                  {"descs", convert_descriptors_to_json(frm_obs_.descriptors_)},
+                                  {"lm_ids", landmark_ids},
+                                  // graph information
+                                  {"span_parent", spanning_parent ? spanning_parent->id_ : -1},
+                                  {"span_children", spanning_child_ids},
+                                  {"loop_edges", loop_edge_ids}};
+
+    if (save_bow_vectors && bow_is_available()) {
+        json_keyfrm["bow_vec"] = bow_vocabulary_util::convert_bow_vector_to_json(bow_vec_);
+        json_keyfrm["bow_feat_vec"] = bow_vocabulary_util::convert_bow_feature_vector_to_json(bow_feat_vec_);
+    }
+
+    return json_keyfrm;
 }
 
 bool keyframe::bind_to_stmt(sqlite3* db, sqlite3_stmt* stmt) const {
@@ -374,6 +376,15 @@ void keyframe::set_pose_cw(const Mat44_t& pose_cw) {
     pose_wc_ = Mat44_t::Identity();
     pose_wc_.block<3, 3>(0, 0) = rot_wc;
     pose_wc_.block<3, 1>(0, 3) = trans_wc_;
+
+    if (journal_) {
+        journal_->record_keyframe_change(id_, map_change_type_t::Updated);
+    }
+}
+
+void keyframe::set_change_journal(map_change_journal* journal) {
+    std::lock_guard<std::mutex> lock(mtx_pose_);
+    journal_ = journal;
 }
 
 Mat44_t keyframe::get_pose_cw() const {
@@ -31,6 +31,7 @@ class landmark;
 class marker;
 class marker2d;
 class map_database;
+class map_change_journal;
 class bow_database;
 class camera_database;
 class orb_params_database;
@@ -66,7 +67,6 @@ public:
     static std::shared_ptr<keyframe> from_stmt(sqlite3_stmt* stmt,
                                                camera_database* cam_db,
                                                orb_params_database* orb_params_db,
-                                               bow_vocabulary* bow_vocab,
                                                unsigned int next_keyframe_id);
 
     // operator overrides
@@ -79,8 +79,9 @@ public:
 
     /**
      * Encode this keyframe information as JSON
+     * @param save_bow_vectors if true, BoW vectors are also encoded so that they need not be recomputed on load
      */
-    nlohmann::json to_json() const;
+    nlohmann::json to_json(const bool save_bow_vectors = false) const;
 
     /**
      * Save this keyframe information to db
@@ -110,6 +111,11 @@ public:
      */
     void set_pose_cw(const Mat44_t& pose_cw);
 
+    /**
+     * Set the journal to record the updates of the pose (nullptr: do not record)
+     */
+    void set_change_journal(map_change_journal* journal);
+
     /**
      * Get the camera pose
      */
@@ -298,6 +304,8 @@ private:
     Mat44_t pose_cw_;
     //! camera pose from the current to the world
     Mat44_t pose_wc_;
+    //! journal of the map database which this keyframe belongs to (protected by mtx_pose_)
+    map_change_journal* journal_ = nullptr;
     //! camera center
     Vec3_t trans_wc_;
 
@@ -0,0 +1,38 @@
+#ifndef STELLA_VSLAM_DATA_KEYPOINT_GRID_H
+#define STELLA_VSLAM_DATA_KEYPOINT_GRID_H
+
+#include <vector>
+
+namespace stella_vslam {
+namespace data {
+
+/**
+ * Keypoint indices assigned to the grid cells, stored in compressed sparse row format.
+ * The cells are laid out column-major (cell_idx_x * num_grid_rows + cell_idx_y),
+ * and the indices in each cell are sorted by scale level, then by keypoint index.
+ */
+struct keypoint_grid {
+    //! offsets of each cell in keypt_indices_ (number of cells + 1 elements)
+    std::vector<unsigned int> cell_offsets_;
+    //! keypoint indices of all the cells in a contiguous array
+    std::vector<unsigned int> keypt_indices_;
+
+    bool empty() const {
+        return cell_offsets_.empty();
+    }
+
+    //! pointer to the first keypoint index in the cell
+    const unsigned int* cell_begin(const unsigned int cell_idx) const {
+        return keypt_indices_.data() + cell_offsets_[cell_idx];
+    }
+
+    //! pointer past the last keypoint index in the cell
+    const unsigned int* cell_end(const unsigned int cell_idx) const {
+        return keypt_indices_.data() + cell_offsets_[cell_idx + 1];
+    }
+};
+
+} // namespace data
+} // namespace stella_vslam
+
+#endif // STELLA_VSLAM_DATA_KEYPOINT_GRID_H
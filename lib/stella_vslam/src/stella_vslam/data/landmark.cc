@@ -2,7 +2,12 @@
 #include "stella_vslam/data/keyframe.h"
 #include "stella_vslam/data/landmark.h"
 #include "stella_vslam/data/map_database.h"
+#include "stella_vslam/data/map_change_journal.h"
 #include "stella_vslam/match/base.h"
+#include "stella_vslam/match/hamming.h"
+
+#include <algorithm>
+#include <cstring>
 
 #include <nlohmann/json.hpp>
 
@@ -11,6 +16,49 @@
 namespace stella_vslam {
 namespace data {
 
+namespace {
+
+//! bijective hash of keyframe IDs, used to sample observations independently of their order
+inline unsigned int hash_keyframe_id(unsigned int id) {
+    // finalizer of MurmurHash3
+    id ^= id >> 16;
+    id *= 0x85ebca6bu;
+    id ^= id >> 13;
+    id *= 0xc2b2ae35u;
+    id ^= id >> 16;
+    return id;
+}
+
+//! Count up the landmark shared between the keyframe and each of the other observers in the covisibility graph
+void increase_num_shared_landmarks(landmark::observations_t::const_iterator first, landmark::observations_t::const_iterator last,
+                                   const std::shared_ptr<keyframe>& keyfrm) {
+    for (auto itr = first; itr != last; ++itr) {
+        const auto observer = itr->first.lock();
+        if (!observer || observer->id_ == keyfrm->id_) {
+            continue;
+        }
+        observer->graph_node_->increase_num_shared_landmarks(keyfrm);
+        keyfrm->graph_node_->increase_num_shared_landmarks(observer);
+    }
+}
+
+//! Count down the landmark shared between the keyframe and each of the other observers in the covisibility graph
+void decrease_num_shared_landmarks(landmark::observations_t::const_iterator first, landmark::observations_t::const_iterator last,
+                                   const std::shared_ptr<keyframe>& keyfrm) {
+    for (auto itr = first; itr != last; ++itr) {
+        const auto observer = itr->first.lock();
+        if (!observer || observer->id_ == keyfrm->id_) {
+            continue;
+        }
+        observer->graph_node_->decrease_num_shared_landmarks(keyfrm);
+        keyfrm->graph_node_->decrease_num_shared_landmarks(observer);
+    }
+}
+
+} // namespace
+
+constexpr unsigned int landmark::max_num_descriptor_samples;
+
 landmark::landmark(unsigned int id, const Vec3_t& pos_w, const std::shared_ptr<keyframe>& ref_keyfrm)
     : id_(id), first_keyfrm_id_(ref_keyfrm->id_), pos_w_(pos_w),
       ref_keyfrm_(ref_keyfrm) {}
@@ -85,6 +133,13 @@ void landmark::set_pos_in_world(const Vec3_t& pos_w) {
     SPDLOG_TRACE("landmark::set_pos_in_world {}", id_);
     pos_w_ = pos_w;
     has_valid_prediction_parameters_ = false;
+    if (arena_) {
+        arena_->set_pos_in_world(handle_, pos_w_);
+        arena_->invalidate_prediction_parameters(handle_);
+    }
+    if (journal_) {
+        journal_->record_landmark_change(id_, map_change_type_t::Updated);
+    }
 }
 
 Vec3_t landmark::get_pos_in_world() const {
@@ -107,11 +162,19 @@ void landmark::add_observation(const std::shared_ptr<keyframe>& keyfrm, unsigned
     std::lock_guard<std::mutex> lock(mtx_observations_);
     SPDLOG_TRACE("landmark::add_observation {} {} {}", id_, keyfrm->id_, idx);
     assert(!static_cast<bool>(observations_.count(keyfrm)));
+    increase_num_shared_landmarks(observations_.cbegin(), observations_.cend(), keyfrm);
     observations_[keyfrm] = idx;
     assert(static_cast<bool>(observations_.count(keyfrm)));
 
     has_valid_prediction_parameters_ = false;
     has_representative_descriptor_ = false;
+    {
+        std::lock_guard<std::mutex> lock2(mtx_position_);
+        if (arena_) {
+            arena_->invalidate_prediction_parameters(handle_);
+            arena_->invalidate_descriptor(handle_);
+        }
+    }
 
     if (!keyfrm->frm_obs_.stereo_x_right_.empty() && 0 <= keyfrm->frm_obs_.stereo_x_right_.at(idx)) {
         num_observations_ += 2;
@@ -137,9 +200,17 @@ void landmark::erase_observation(map_database* map_db, const std::shared_ptr<key
         }
 
         observations_.erase(keyfrm);
+        decrease_num_shared_landmarks(observations_.cbegin(), observations_.cend(), keyfrm);
 
         has_valid_prediction_parameters_ = false;
         has_representative_descriptor_ = false;
+        {
+            std::lock_guard<std::mutex> lock2(mtx_position_);
+            if (arena_) {
+                arena_->invalidate_prediction_parameters(handle_);
+                arena_->invalidate_descriptor(handle_);
+            }
+        }
 
         if (observations_.empty()) {
             discard = true;
@@ -209,36 +280,74 @@ void landmark::compute_descriptor() {
 
     // Append features of corresponding points
     std::vector<cv::Mat> descriptors;
+    std::vector<unsigned int> keyfrm_id_hashes;
     descriptors.reserve(observations.size());
+    keyfrm_id_hashes.reserve(observations.size());
     for (const auto& observation : observations) {
         auto keyfrm = observation.first.lock();
         const auto idx = observation.second;
 
         if (!keyfrm->will_be_erased()) {
             descriptors.push_back(keyfrm->frm_obs_.descriptors_.row(idx));
+            keyfrm_id_hashes.push_back(hash_keyframe_id(keyfrm->id_));
+        }
+    }
+
+    // All the observing keyframes are being erased, so the current descriptor is kept
+    if (descriptors.empty()) {
+        return;
+    }
+
+    // Keep the observations whose keyframe ID hashes are the smallest,
+    // so that the sample changes only a little when an observation is added or removed
+    // (the order of the descriptors is preserved to select the same medoid as the complete set in case of ties)
+    if (max_num_descriptor_samples < descriptors.size()) {
+        auto sorted_hashes = keyfrm_id_hashes;
+        std::nth_element(sorted_hashes.begin(), sorted_hashes.begin() + (max_num_descriptor_samples - 1), sorted_hashes.end());
+        const auto max_hash = sorted_hashes.at(max_num_descriptor_samples - 1);
+        unsigned int num_samples = 0;
+        for (unsigned int i = 0; i < descriptors.size(); ++i) {
+            if (keyfrm_id_hashes.at(i) <= max_hash) {
+                descriptors.at(num_samples++) = descriptors.at(i);
+            }
         }
+        assert(num_samples == max_num_descriptor_samples);
+        descriptors.resize(num_samples);
+    }
+
+    // Pack the descriptors into a contiguous buffer for the batched Hamming distance kernel
+    const auto num_descs = descriptors.size();
+    constexpr unsigned int desc_size = 32;
+    std::vector<uint8_t> packed_descs(num_descs * desc_size);
+    std::vector<unsigned int> desc_indices(num_descs);
+    for (unsigned int i = 0; i < num_descs; ++i) {
+        std::memcpy(packed_descs.data() + i * desc_size, descriptors.at(i).ptr<uint8_t>(), desc_size);
+        desc_indices.at(i) = i;
     }
 
     // Get median of Hamming distance
     // Calculate all the Hamming distances between every pair of the features
-    const auto num_descs = descriptors.size();
-    std::vector<std::vector<unsigned int>> hamm_dists(num_descs, std::vector<unsigned int>(num_descs));
+    std::vector<unsigned int> hamm_dists(num_descs * num_descs);
     for (unsigned int i = 0; i < num_descs; ++i) {
-        hamm_dists.at(i).at(i) = 0;
+        auto row = hamm_dists.data() + i * num_descs;
+        row[i] = 0;
+        match::hamming::compute_distances_256(packed_descs.data() + i * desc_size, packed_descs.data(), desc_size,
+                                              desc_indices.data() + i + 1, num_descs - i - 1, row + i + 1);
         for (unsigned int j = i + 1; j < num_descs; ++j) {
-            const auto dist = match::compute_descriptor_distance_32(descriptors.at(i), descriptors.at(j));
-            hamm_dists.at(i).at(j) = dist;
-            hamm_dists.at(j).at(i) = dist;
+            hamm_dists.at(j * num_descs + i) = row[j];
         }
     }
 
     // Get the nearest value to median
     unsigned int best_median_dist = match::MAX_HAMMING_DIST;
     unsigned int best_idx = 0;
+    const auto median_pos = static_cast<unsigned int>(0.5 * (num_descs - 1));
+    std::vector<unsigned int> partial_hamm_dists(num_descs);
     for (unsigned idx = 0; idx < num_descs; ++idx) {
-        std::vector<unsigned int> partial_hamm_dists(hamm_dists.at(idx).begin(), hamm_dists.at(idx).begin() + num_descs);
-        std::sort(partial_hamm_dists.begin(), partial_hamm_dists.end());
-        const auto median_dist = partial_hamm_dists.at(static_cast<unsigned int>(0.5 * (num_descs - 1)));
+        const auto row = hamm_dists.begin() + idx * num_descs;
+        std::copy(row, row + num_descs, partial_hamm_dists.begin());
+        std::nth_element(partial_hamm_dists.begin(), partial_hamm_dists.begin() + median_pos, partial_hamm_dists.end());
+        const auto median_dist = partial_hamm_dists.at(median_pos);
 
         if (median_dist < best_median_dist) {
             best_median_dist = median_dist;
@@ -250,6 +359,10 @@ void landmark::compute_descriptor() {
         std::lock_guard<std::mutex> lock(mtx_observations_);
         descriptor_ = descriptors.at(best_idx).clone();
         has_representative_descriptor_ = true;
+        std::lock_guard<std::mutex> lock2(mtx_position_);
+        if (arena_) {
+            arena_->set_descriptor(handle_, descriptor_);
+        }
     }
 }
 
@@ -313,6 +426,9 @@ void landmark::update_mean_normal_and_obs_scale_variance() {
         min_valid_dist_ = min_valid_dist;
         mean_normal_ = mean_normal;
         has_valid_prediction_parameters_ = true;
+        if (arena_) {
+            arena_->set_prediction_parameters(handle_, mean_normal_, min_valid_dist_, max_valid_dist_);
+        }
     }
 }
 
@@ -360,6 +476,13 @@ void landmark::prepare_for_erasing(map_database* map_db) {
         observations = observations_;
         observations_.clear();
         will_be_erased_ = true;
+        // count down every pair of the observers
+        for (auto itr = observations.cbegin(); itr != observations.cend(); ++itr) {
+            const auto keyfrm = itr->first.lock();
+            if (keyfrm) {
+                decrease_num_shared_landmarks(std::next(itr), observations.cend(), keyfrm);
+            }
+        }
     }
 
     for (const auto& keyfrm_and_idx : observations) {
@@ -446,5 +569,40 @@ nlohmann::json landmark::to_json() const {
             {"n_fnd", num_observed_}};
 }
 
+void landmark::attach_to_arena(landmark_arena* arena) {
+    std::lock_guard<std::mutex> lock1(mtx_observations_);
+    std::lock_guard<std::mutex> lock2(mtx_position_);
+    assert(!arena_);
+    arena_ = arena;
+    handle_ = arena_->allocate(id_);
+    arena_->set_pos_in_world(handle_, pos_w_);
+    if (has_valid_prediction_parameters_) {
+        arena_->set_prediction_parameters(handle_, mean_normal_, min_valid_dist_, max_valid_dist_);
+    }
+    if (has_representative_descriptor_) {
+        arena_->set_descriptor(handle_, descriptor_);
+    }
+}
+
+void landmark::detach_from_arena() {
+    std::lock_guard<std::mutex> lock(mtx_position_);
+    if (!arena_) {
+        return;
+    }
+    arena_->release(handle_);
+    arena_ = nullptr;
+    handle_ = landmark_handle();
+}
+
+landmark_handle landmark::get_handle() const {
+    std::lock_guard<std::mutex> lock(mtx_position_);
+    return handle_;
+}
+
+void landmark::set_change_journal(map_change_journal* journal) {
+    std::lock_guard<std::mutex> lock(mtx_position_);
+    journal_ = journal;
+}
+
 } // namespace data
 } // namespace stella_vslam
@@ -2,6 +2,7 @@
 #define STELLA_VSLAM_DATA_LANDMARK_H
 
 #include "stella_vslam/type.h"
+#include "stella_vslam/data/landmark_arena.h"
 
 #include <map>
 #include <mutex>
@@ -20,6 +21,7 @@ class frame;
 class keyframe;
 
 class map_database;
+class map_change_journal;
 
 class landmark : public std::enable_shared_from_this<landmark> {
 public:
@@ -97,7 +99,11 @@ public:
     //! get representative descriptor
     cv::Mat get_descriptor() const;
 
+    //! maximum number of the observed descriptors used to compute the representative descriptor
+    static constexpr unsigned int max_num_descriptor_samples = 64;
+
     //! compute representative descriptor
+    //! (the medoid of the observed descriptors, or of at most max_num_descriptor_samples of them sampled by keyframe ID)
     void compute_descriptor();
 
     //! update observation mean normal and ORB scale variance
@@ -133,6 +139,16 @@ public:
     //! encode landmark information as JSON
     nlohmann::json to_json() const;
 
+    //! store the attributes in the arena and keep them up to date (called when this landmark is added to the map database)
+    void attach_to_arena(landmark_arena* arena);
+    //! release the slot in the arena (called when this landmark is erased from the map database)
+    void detach_from_arena();
+    //! get the handle in the arena (invalid if this landmark is not in the map database)
+    landmark_handle get_handle() const;
+
+    //! set the journal to record the updates of the position (nullptr: do not record)
+    void set_change_journal(map_change_journal* journal);
+
 public:
     unsigned int id_;
     unsigned int first_keyfrm_id_ = 0;
@@ -180,6 +196,13 @@ private:
     //! min valid distance between landmark and camera
     float max_valid_dist_ = 0;
 
+    //! arena which mirrors the attributes (protected by mtx_position_)
+    landmark_arena* arena_ = nullptr;
+    //! handle in the arena
+    landmark_handle handle_;
+    //! journal of the map database which this landmark belongs to (protected by mtx_position_)
+    map_change_journal* journal_ = nullptr;
+
     mutable std::mutex mtx_position_;
     mutable std::mutex mtx_observations_;
 };
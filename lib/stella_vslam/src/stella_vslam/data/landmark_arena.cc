@@ -0,0 +1,246 @@
+#include "stella_vslam/data/landmark_arena.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+namespace stella_vslam {
+namespace data {
+
+constexpr uint32_t landmark_handle::invalid_index;
+constexpr unsigned int landmark_arena::block_size;
+constexpr unsigned int landmark_arena::max_num_blocks;
+constexpr unsigned int landmark_arena::descriptor_size;
+
+cv::Mat landmark_batch::get_descriptor(const unsigned int i) const {
+    return cv::Mat(1, landmark_arena::descriptor_size, CV_8U,
+                   const_cast<uint8_t*>(descriptors_.data() + i * landmark_arena::descriptor_size));
+}
+
+landmark_arena::slot::slot() {
+    lock_.clear();
+}
+
+landmark_arena::slot_lock::slot_lock(const slot& s)
+    : slot_(s) {
+    while (slot_.lock_.test_and_set(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+landmark_arena::slot_lock::~slot_lock() {
+    slot_.lock_.clear(std::memory_order_release);
+}
+
+landmark_arena::landmark_arena()
+    : blocks_(new std::atomic<block*>[max_num_blocks]) {
+    for (unsigned int i = 0; i < max_num_blocks; ++i) {
+        blocks_[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+landmark_arena::~landmark_arena() {
+    for (unsigned int i = 0; i < max_num_blocks; ++i) {
+        delete blocks_[i].load(std::memory_order_relaxed);
+    }
+}
+
+landmark_handle landmark_arena::allocate(const unsigned int lm_id) {
+    landmark_handle handle;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (!free_indices_.empty()) {
+            handle.index_ = free_indices_.back();
+            free_indices_.pop_back();
+        }
+        else {
+            handle.index_ = num_slots_.load(std::memory_order_relaxed);
+            if (handle.index_ % block_size == 0) {
+                const auto block_idx = handle.index_ / block_size;
+                if (max_num_blocks <= block_idx) {
+                    throw std::runtime_error("the number of the landmarks exceeds the capacity of the arena");
+                }
+                blocks_[block_idx].store(new block, std::memory_order_release);
+            }
+            num_slots_.store(handle.index_ + 1, std::memory_order_release);
+        }
+    }
+
+    auto& s = *get_slot(handle.index_);
+    slot_lock lock(s);
+    handle.generation_ = s.generation_;
+    s.lm_id_ = lm_id;
+    s.flags_ = slot_flag::alive;
+    return handle;
+}
+
+void landmark_arena::release(const landmark_handle& handle) {
+    auto s = get_slot(handle.index_);
+    if (!s) {
+        return;
+    }
+    {
+        slot_lock lock(*s);
+        if (!s->is_alive(handle)) {
+            return;
+        }
+        s->flags_ = 0;
+        ++s->generation_;
+    }
+    std::lock_guard<std::mutex> lock(mtx_);
+    free_indices_.push_back(handle.index_);
+}
+
+void landmark_arena::clear() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    // keep the generations so that the handles issued before are stale
+    free_indices_.clear();
+    const auto num_slots = num_slots_.load(std::memory_order_relaxed);
+    for (uint32_t idx = 0; idx < num_slots; ++idx) {
+        auto& s = *get_slot(idx);
+        {
+            slot_lock lock_slot(s);
+            if (s.flags_ & slot_flag::alive) {
+                ++s.generation_;
+            }
+            s.flags_ = 0;
+        }
+        free_indices_.push_back(idx);
+    }
+}
+
+bool landmark_arena::is_alive(const landmark_handle& handle) const {
+    const auto s = get_slot(handle.index_);
+    if (!s) {
+        return false;
+    }
+    slot_lock lock(*s);
+    return s->is_alive(handle);
+}
+
+unsigned int landmark_arena::get_num_landmarks() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return num_slots_.load(std::memory_order_relaxed) - free_indices_.size();
+}
+
+void landmark_arena::set_pos_in_world(const landmark_handle& handle, const Vec3_t& pos_w) {
+    const auto s = get_slot(handle.index_);
+    if (!s) {
+        return;
+    }
+    slot_lock lock(*s);
+    if (!s->is_alive(handle)) {
+        return;
+    }
+    s->pos_w_ = pos_w;
+}
+
+void landmark_arena::set_prediction_parameters(const landmark_handle& handle, const Vec3_t& mean_normal,
+                                               const float min_valid_dist, const float max_valid_dist) {
+    const auto s = get_slot(handle.index_);
+    if (!s) {
+        return;
+    }
+    slot_lock lock(*s);
+    if (!s->is_alive(handle)) {
+        return;
+    }
+    s->mean_normal_ = mean_normal;
+    s->min_valid_dist_ = min_valid_dist;
+    s->max_valid_dist_ = max_valid_dist;
+    s->flags_ |= slot_flag::has_prediction_parameters;
+}
+
+void landmark_arena::invalidate_prediction_parameters(const landmark_handle& handle) {
+    const auto s = get_slot(handle.index_);
+    if (!s) {
+        return;
+    }
+    slot_lock lock(*s);
+    if (!s->is_alive(handle)) {
+        return;
+    }
+    s->flags_ &= ~slot_flag::has_prediction_parameters;
+}
+
+void landmark_arena::set_descriptor(const landmark_handle& handle, const cv::Mat& descriptor) {
+    assert(descriptor.isContinuous() && descriptor.total() * descriptor.elemSize() == descriptor_size);
+    const auto s = get_slot(handle.index_);
+    if (!s) {
+        return;
+    }
+    slot_lock lock(*s);
+    if (!s->is_alive(handle)) {
+        return;
+    }
+    std::memcpy(s->descriptor_, descriptor.data, descriptor_size);
+    s->flags_ |= slot_flag::has_descriptor;
+}
+
+void landmark_arena::invalidate_descriptor(const landmark_handle& handle) {
+    const auto s = get_slot(handle.index_);
+    if (!s) {
+        return;
+    }
+    slot_lock lock(*s);
+    if (!s->is_alive(handle)) {
+        return;
+    }
+    s->flags_ &= ~slot_flag::has_descriptor;
+}
+
+void landmark_arena::gather(const std::vector<landmark_handle>& handles, landmark_batch& batch) const {
+    const unsigned int num_handles = handles.size();
+    batch.pos_ws_.resize(num_handles);
+    batch.obs_mean_normals_.resize(num_handles);
+    batch.min_valid_dists_.resize(num_handles);
+    batch.max_valid_dists_.resize(num_handles);
+    batch.descriptors_.resize(num_handles * descriptor_size);
+    batch.has_descriptor_.resize(num_handles);
+    batch.is_valid_.resize(num_handles);
+
+    for (unsigned int i = 0; i < num_handles; ++i) {
+        const auto& handle = handles[i];
+        const auto s = get_slot(handle.index_);
+        bool is_valid = false;
+        bool has_descriptor = false;
+        if (s) {
+            slot_lock lock(*s);
+            if (s->is_alive(handle)) {
+                is_valid = s->flags_ & slot_flag::has_prediction_parameters;
+                has_descriptor = s->flags_ & slot_flag::has_descriptor;
+                if (is_valid) {
+                    batch.pos_ws_[i] = s->pos_w_;
+                    batch.obs_mean_normals_[i] = s->mean_normal_;
+                    batch.min_valid_dists_[i] = s->min_valid_dist_;
+                    batch.max_valid_dists_[i] = s->max_valid_dist_;
+                }
+                if (has_descriptor) {
+                    std::memcpy(batch.descriptors_.data() + i * descriptor_size, s->descriptor_, descriptor_size);
+                }
+            }
+        }
+        // the invalid entries are also processed by the vectorized reprojection, so they must be initialized
+        if (!is_valid) {
+            batch.pos_ws_[i].setZero();
+            batch.obs_mean_normals_[i].setZero();
+            batch.min_valid_dists_[i] = 0;
+            batch.max_valid_dists_[i] = 0;
+        }
+        if (!has_descriptor) {
+            std::memset(batch.descriptors_.data() + i * descriptor_size, 0, descriptor_size);
+        }
+        batch.is_valid_[i] = is_valid;
+        batch.has_descriptor_[i] = has_descriptor;
+    }
+}
+
+landmark_arena::slot* landmark_arena::get_slot(const uint32_t index) const {
+    if (num_slots_.load(std::memory_order_acquire) <= index) {
+        return nullptr;
+    }
+    return &blocks_[index / block_size].load(std::memory_order_acquire)->slots_[index % block_size];
+}
+
+} // namespace data
+} // namespace stella_vslam
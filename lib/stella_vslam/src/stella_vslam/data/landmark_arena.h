@@ -0,0 +1,216 @@
+#ifndef STELLA_VSLAM_DATA_LANDMARK_ARENA_H
+#define STELLA_VSLAM_DATA_LANDMARK_ARENA_H
+
+#include "stella_vslam/type.h"
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <opencv2/core/mat.hpp>
+
+namespace stella_vslam {
+namespace data {
+
+/**
+ * Handle of a landmark in landmark_arena
+ * The slot of an erased landmark is reused, and the generation tells the handles of the old and new landmarks apart.
+ */
+struct landmark_handle {
+    static constexpr uint32_t invalid_index = std::numeric_limits<uint32_t>::max();
+
+    //! index of the slot
+    uint32_t index_ = invalid_index;
+    //! generation of the slot when the handle was issued
+    uint32_t generation_ = 0;
+
+    bool is_valid() const {
+        return index_ != invalid_index;
+    }
+};
+
+/**
+ * Attributes of the landmarks gathered from landmark_arena, which are processed at once (e.g. frame::can_observe)
+ */
+struct landmark_batch {
+    //! world coordinates
+    eigen_alloc_vector<Vec3_t> pos_ws_;
+    //! observation mean normals
+    eigen_alloc_vector<Vec3_t> obs_mean_normals_;
+    //! min valid distances between landmark and camera
+    std::vector<float> min_valid_dists_;
+    //! max valid distances between landmark and camera
+    std::vector<float> max_valid_dists_;
+    //! representative descriptors (landmark_arena::descriptor_size bytes for each landmark)
+    std::vector<uint8_t> descriptors_;
+    //! 1 if the descriptor is valid (it is independent of is_valid_)
+    std::vector<uint8_t> has_descriptor_;
+    //! 1 if the position and the prediction parameters are valid, 0 if the handle is stale or the prediction parameters are not available
+    //! (the attributes of the invalid entries are zero)
+    std::vector<uint8_t> is_valid_;
+
+    unsigned int size() const {
+        return is_valid_.size();
+    }
+
+    //! Get the descriptor of the i-th landmark as a matrix header (valid while the batch is alive)
+    cv::Mat get_descriptor(const unsigned int i) const;
+};
+
+/**
+ * Dense storage of the landmark attributes used for the projection matching
+ * (position, mean normal, valid distance range and representative descriptor)
+ * The attributes are stored in fixed-size blocks of slots indexed by the handles, so that many landmarks can be processed
+ * without chasing the pointers of data::landmark and touching their reference counts.
+ * The slots never move once they are allocated, so the attributes are written and read under the lock of each slot,
+ * and the mutex of the arena is locked only when a slot is allocated or released.
+ * (NOTE: data::landmark still owns the attributes and writes them through to the arena while it is in the map database)
+ */
+class landmark_arena {
+public:
+    //! number of the slots in a block
+    static constexpr unsigned int block_size = 1024;
+    //! maximum number of the blocks
+    static constexpr unsigned int max_num_blocks = 1 << 16;
+    //! size of a descriptor (bytes)
+    static constexpr unsigned int descriptor_size = 32;
+
+    /**
+     * Constructor
+     */
+    landmark_arena();
+
+    /**
+     * Destructor
+     */
+    ~landmark_arena();
+
+    landmark_arena(const landmark_arena&) = delete;
+    landmark_arena& operator=(const landmark_arena&) = delete;
+
+    /**
+     * Allocate a slot for the landmark
+     * (NOTE: the attributes are invalid until they are set)
+     * @param lm_id
+     * @return
+     */
+    landmark_handle allocate(const unsigned int lm_id);
+
+    /**
+     * Release the slot of the landmark (the handle becomes stale)
+     * @param handle
+     */
+    void release(const landmark_handle& handle);
+
+    /**
+     * Release all the slots
+     */
+    void clear();
+
+    /**
+     * Whether the handle refers to a landmark in the arena
+     * @param handle
+     * @return
+     */
+    bool is_alive(const landmark_handle& handle) const;
+
+    /**
+     * Get the number of the landmarks in the arena
+     * @return
+     */
+    unsigned int get_num_landmarks() const;
+
+    //-----------------------------------------
+    // attributes (the setters ignore the stale handles)
+
+    void set_pos_in_world(const landmark_handle& handle, const Vec3_t& pos_w);
+
+    void set_prediction_parameters(const landmark_handle& handle, const Vec3_t& mean_normal,
+                                   const float min_valid_dist, const float max_valid_dist);
+    void invalidate_prediction_parameters(const landmark_handle& handle);
+
+    void set_descriptor(const landmark_handle& handle, const cv::Mat& descriptor);
+    void invalidate_descriptor(const landmark_handle& handle);
+
+    /**
+     * Gather the position, the prediction parameters and the descriptor of the landmarks in the order of the handles
+     * (only the slots are locked one by one)
+     * @param handles
+     * @param batch
+     */
+    void gather(const std::vector<landmark_handle>& handles, landmark_batch& batch) const;
+
+private:
+    //! flags of the slots
+    enum slot_flag : uint8_t {
+        alive = 1 << 0,
+        has_prediction_parameters = 1 << 1,
+        has_descriptor = 1 << 2,
+    };
+
+    //! slot of a landmark
+    struct slot {
+        slot();
+
+        //! spin lock of the attributes below
+        mutable std::atomic_flag lock_;
+        //! generation, which is incremented when the slot is released
+        uint32_t generation_ = 0;
+        //! flags
+        uint8_t flags_ = 0;
+        //! landmark ID
+        unsigned int lm_id_ = 0;
+        //! world coordinates
+        Vec3_t pos_w_ = Vec3_t::Zero();
+        //! observation mean normal
+        Vec3_t mean_normal_ = Vec3_t::Zero();
+        //! min valid distance between landmark and camera
+        float min_valid_dist_ = 0;
+        //! max valid distance between landmark and camera
+        float max_valid_dist_ = 0;
+        //! representative descriptor
+        uint8_t descriptor_[descriptor_size] = {};
+
+        //! Whether the handle refers to the landmark in this slot (the slot must be locked)
+        bool is_alive(const landmark_handle& handle) const {
+            return generation_ == handle.generation_ && (flags_ & slot_flag::alive);
+        }
+    };
+
+    //! RAII lock of a slot
+    class slot_lock {
+    public:
+        explicit slot_lock(const slot& s);
+        ~slot_lock();
+
+    private:
+        const slot& slot_;
+    };
+
+    //! block of the slots
+    struct block {
+        slot slots_[block_size];
+    };
+
+    //! Get the slot of the handle (nullptr if the index is out of range)
+    slot* get_slot(const uint32_t index) const;
+
+    //! blocks (their addresses are published before the number of the slots)
+    std::unique_ptr<std::atomic<block*>[]> blocks_;
+    //! number of the slots which can be accessed
+    std::atomic<uint32_t> num_slots_{0};
+
+    //! released slots to be reused
+    std::vector<uint32_t> free_indices_;
+
+    //! mutex for the allocation and the release of the slots
+    mutable std::mutex mtx_;
+};
+
+} // namespace data
+} // namespace stella_vslam
+
+#endif // STELLA_VSLAM_DATA_LANDMARK_ARENA_H
@@ -0,0 +1,103 @@
+#include "stella_vslam/data/map_change_journal.h"
+
+#include <algorithm>
+
+namespace stella_vslam {
+namespace data {
+
+void map_change_journal::change_log::clear() {
+    live_.clear();
+    live_index_.clear();
+    erased_.clear();
+}
+
+map_change_journal::map_change_journal(const unsigned int max_num_erased)
+    : max_num_erased_(max_num_erased) {}
+
+void map_change_journal::record_keyframe_change(const unsigned int id, const map_change_type_t type) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    record_impl(keyfrm_log_, id, type);
+}
+
+void map_change_journal::record_landmark_change(const unsigned int id, const map_change_type_t type) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    record_impl(lm_log_, id, type);
+}
+
+uint64_t map_change_journal::get_version() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return version_;
+}
+
+bool map_change_journal::get_changes_since(const uint64_t version, std::vector<map_change>& keyfrm_changes,
+                                           std::vector<map_change>& lm_changes, uint64_t& current_version,
+                                           const bool include_landmarks) const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    keyfrm_changes.clear();
+    lm_changes.clear();
+    current_version = version_;
+    if (version < keyfrm_log_.oldest_available_version_) {
+        return false;
+    }
+    if (include_landmarks && version < lm_log_.oldest_available_version_) {
+        return false;
+    }
+    collect_changes(keyfrm_log_, version, keyfrm_changes);
+    if (include_landmarks) {
+        collect_changes(lm_log_, version, lm_changes);
+    }
+    return true;
+}
+
+void map_change_journal::reset() {
+    std::lock_guard<std::mutex> lock(mtx_);
+    keyfrm_log_.clear();
+    lm_log_.clear();
+    ++version_;
+    keyfrm_log_.oldest_available_version_ = version_;
+    lm_log_.oldest_available_version_ = version_;
+}
+
+void map_change_journal::record_impl(change_log& log, const unsigned int id, const map_change_type_t type) {
+    ++version_;
+    map_change change{id, version_, type};
+
+    const auto itr = log.live_index_.find(id);
+    if (itr != log.live_index_.end()) {
+        // the element has not been published as added yet if it is added after the version of the consumer
+        if (itr->second->type_ == map_change_type_t::Added && type == map_change_type_t::Updated) {
+            change.type_ = map_change_type_t::Added;
+        }
+        log.live_.erase(itr->second);
+        log.live_index_.erase(itr);
+    }
+
+    if (type == map_change_type_t::Erased) {
+        log.erased_.push_back(change);
+        if (max_num_erased_ < log.erased_.size()) {
+            // the consumers older than the discarded erasure cannot know it
+            log.oldest_available_version_ = std::max(log.oldest_available_version_, log.erased_.front().version_);
+            log.erased_.pop_front();
+        }
+        return;
+    }
+
+    log.live_.push_back(change);
+    log.live_index_[id] = std::prev(log.live_.end());
+}
+
+void map_change_journal::collect_changes(const change_log& log, const uint64_t version, std::vector<map_change>& changes) {
+    const auto begin = changes.size();
+    for (auto itr = log.live_.rbegin(); itr != log.live_.rend() && version < itr->version_; ++itr) {
+        changes.push_back(*itr);
+    }
+    for (auto itr = log.erased_.rbegin(); itr != log.erased_.rend() && version < itr->version_; ++itr) {
+        changes.push_back(*itr);
+    }
+    std::sort(changes.begin() + begin, changes.end(), [](const map_change& a, const map_change& b) {
+        return a.version_ < b.version_;
+    });
+}
+
+} // namespace data
+} // namespace stella_vslam
@@ -0,0 +1,115 @@
+#ifndef STELLA_VSLAM_DATA_MAP_CHANGE_JOURNAL_H
+#define STELLA_VSLAM_DATA_MAP_CHANGE_JOURNAL_H
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace stella_vslam {
+namespace data {
+
+enum class map_change_type_t : uint8_t {
+    Added,
+    Updated,
+    Erased
+};
+
+/**
+ * The latest change of a keyframe or a landmark
+ */
+struct map_change {
+    //! ID of the keyframe or the landmark
+    unsigned int id_;
+    //! version of the map when the change was recorded
+    uint64_t version_;
+    //! type of the change (Added is kept if the element is updated after it was added)
+    map_change_type_t type_;
+};
+
+/**
+ * Versioned journal of the changes of the keyframes and the landmarks in the map database
+ * Only the latest change of each element is kept, so that the changes since a version can be obtained
+ * at the cost proportional to the number of the changed elements, not to the size of the map.
+ */
+class map_change_journal {
+public:
+    /**
+     * Constructor
+     * @param max_num_erased maximum number of the erasures kept for each element type
+     *        (the older versions become unavailable when the erasures are discarded)
+     */
+    explicit map_change_journal(const unsigned int max_num_erased = 100000);
+
+    /**
+     * Destructor
+     */
+    ~map_change_journal() = default;
+
+    map_change_journal(const map_change_journal&) = delete;
+    map_change_journal& operator=(const map_change_journal&) = delete;
+
+    //! Record a change of the keyframe
+    void record_keyframe_change(const unsigned int id, const map_change_type_t type);
+
+    //! Record a change of the landmark
+    void record_landmark_change(const unsigned int id, const map_change_type_t type);
+
+    //! Get the current version
+    uint64_t get_version() const;
+
+    /**
+     * Get the latest changes of the keyframes and the landmarks since the version (in ascending order of the versions)
+     * @param version
+     * @param keyfrm_changes
+     * @param lm_changes
+     * @param current_version
+     * @param include_landmarks if false, lm_changes is left empty and the discarded erasures of the landmarks are ignored
+     * @return false if the changes since the version are not available anymore (the consumer needs to read the whole map)
+     */
+    bool get_changes_since(const uint64_t version, std::vector<map_change>& keyfrm_changes,
+                           std::vector<map_change>& lm_changes, uint64_t& current_version,
+                           const bool include_landmarks = true) const;
+
+    /**
+     * Discard all the changes (the versions before this call become unavailable)
+     */
+    void reset();
+
+private:
+    //! changes of a type of the elements
+    struct change_log {
+        //! latest changes of the elements in the map, in ascending order of the versions
+        std::list<map_change> live_;
+        //! position of each element in live_
+        std::unordered_map<unsigned int, std::list<map_change>::iterator> live_index_;
+        //! erasures in ascending order of the versions
+        std::list<map_change> erased_;
+        //! changes after this version are available
+        uint64_t oldest_available_version_ = 0;
+
+        void clear();
+    };
+
+    //! Record a change (without mutex)
+    void record_impl(change_log& log, const unsigned int id, const map_change_type_t type);
+
+    //! Append the changes after the version (without mutex)
+    static void collect_changes(const change_log& log, const uint64_t version, std::vector<map_change>& changes);
+
+    const unsigned int max_num_erased_;
+
+    change_log keyfrm_log_;
+    change_log lm_log_;
+
+    //! version of the latest change
+    uint64_t version_ = 0;
+
+    mutable std::mutex mtx_;
+};
+
+} // namespace data
+} // namespace stella_vslam
+
+#endif // STELLA_VSLAM_DATA_MAP_CHANGE_JOURNAL_H
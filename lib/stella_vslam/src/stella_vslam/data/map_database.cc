@@ -18,10 +18,10 @@
 namespace stella_vslam {
 namespace data {
 
-std::mutex map_database::mtx_database_;
+util::shared_mutex map_database::mtx_database_;
 
-map_database::map_database(unsigned int min_num_shared_lms)
-    : fixed_keyframe_id_threshold_(0), min_num_shared_lms_(min_num_shared_lms) {
+map_database::map_database(unsigned int min_num_shared_lms, const YAML::Node& frm_stats_params)
+    : fixed_keyframe_id_threshold_(0), min_num_shared_lms_(min_num_shared_lms), frm_stats_(frm_stats_params) {
     spdlog::debug("CONSTRUCT: data::map_database");
 }
 
@@ -44,11 +44,17 @@ void map_database::add_keyframe(const std::shared_ptr<keyframe>& keyfrm) {
     std::lock_guard<std::mutex> lock(mtx_map_access_);
     keyframes_[keyfrm->id_] = keyfrm;
     last_inserted_keyfrm_ = keyfrm;
+    keyfrm->set_change_journal(&journal_);
+    journal_.record_keyframe_change(keyfrm->id_, map_change_type_t::Added);
 }
 
 void map_database::erase_keyframe(const std::shared_ptr<keyframe>& keyfrm) {
     std::lock_guard<std::mutex> lock(mtx_map_access_);
-    keyframes_.erase(keyfrm->id_);
+    if (!keyframes_.erase(keyfrm->id_)) {
+        return;
+    }
+    keyfrm->set_change_journal(nullptr);
+    journal_.record_keyframe_change(keyfrm->id_, map_change_type_t::Erased);
 }
 
 std::shared_ptr<keyframe> map_database::get_keyframe(unsigned int id) const {
@@ -62,11 +68,21 @@ std::shared_ptr<keyframe> map_database::get_keyframe(unsigned int id) const {
 void map_database::add_landmark(std::shared_ptr<landmark>& lm) {
     std::lock_guard<std::mutex> lock(mtx_map_access_);
     landmarks_[lm->id_] = lm;
+    lm->attach_to_arena(&lm_arena_);
+    lm->set_change_journal(&journal_);
+    journal_.record_landmark_change(lm->id_, map_change_type_t::Added);
 }
 
 void map_database::erase_landmark(unsigned int id) {
     std::lock_guard<std::mutex> lock(mtx_map_access_);
-    landmarks_.erase(id);
+    const auto itr = landmarks_.find(id);
+    if (itr == landmarks_.end()) {
+        return;
+    }
+    itr->second->detach_from_arena();
+    itr->second->set_change_journal(nullptr);
+    landmarks_.erase(itr);
+    journal_.record_landmark_change(id, map_change_type_t::Erased);
 }
 
 std::shared_ptr<landmark> map_database::get_landmark(unsigned int id) const {
@@ -205,6 +221,45 @@ std::vector<std::shared_ptr<landmark>> map_database::get_all_landmarks() const {
     return landmarks;
 }
 
+uint64_t map_database::get_version() const {
+    return journal_.get_version();
+}
+
+void map_database::get_changes_since(const uint64_t version, map_changes& changes, const bool include_landmarks) const {
+    std::vector<map_change> keyfrm_changes;
+    std::vector<map_change> lm_changes;
+
+    // lock the map so that the changes are consistent with the keyframes and the landmarks in the database
+    std::lock_guard<std::mutex> lock(mtx_map_access_);
+    changes.is_complete_ = journal_.get_changes_since(version, keyfrm_changes, lm_changes, changes.version_, include_landmarks);
+
+    changes.updated_keyfrms_.clear();
+    changes.erased_keyfrm_ids_.clear();
+    for (const auto& change : keyfrm_changes) {
+        if (change.type_ == map_change_type_t::Erased) {
+            changes.erased_keyfrm_ids_.push_back(change.id_);
+            continue;
+        }
+        const auto itr = keyframes_.find(change.id_);
+        if (itr != keyframes_.end()) {
+            changes.updated_keyfrms_.push_back(itr->second);
+        }
+    }
+
+    changes.updated_lms_.clear();
+    changes.erased_lm_ids_.clear();
+    for (const auto& change : lm_changes) {
+        if (change.type_ == map_change_type_t::Erased) {
+            changes.erased_lm_ids_.push_back(change.id_);
+            continue;
+        }
+        const auto itr = landmarks_.find(change.id_);
+        if (itr != landmarks_.end()) {
+            changes.updated_lms_.push_back(itr->second);
+        }
+    }
+}
+
 std::shared_ptr<keyframe> map_database::get_last_inserted_keyframe() const {
     std::lock_guard<std::mutex> lock(mtx_map_access_);
     return last_inserted_keyfrm_;
@@ -234,15 +289,43 @@ unsigned int map_database::get_min_num_shared_lms() const {
     return min_num_shared_lms_;
 }
 
+void map_database::for_each_frame_statistics(const std::function<void(const frame_statistics::frame_record&, const std::shared_ptr<keyframe>&)>& visitor) const {
+    // The frames are visited without the lock, because the spilled ones are read from the disk
+    frame_statistics::snapshot frm_stats;
+    std::unordered_map<unsigned int, std::shared_ptr<keyframe>> keyframes;
+    {
+        std::lock_guard<std::mutex> lock(mtx_map_access_);
+        frm_stats = frm_stats_.get_snapshot();
+        keyframes = keyframes_;
+    }
+    frm_stats.for_each_frame([&keyframes, &visitor](const frame_statistics::frame_record& record) {
+        const auto itr = keyframes.find(record.ref_keyfrm_id_);
+        visitor(record, itr != keyframes.end() ? itr->second : nullptr);
+    });
+}
+
 void map_database::clear() {
     std::lock_guard<std::mutex> lock(mtx_map_access_);
 
+    // the landmarks can outlive the database
+    for (const auto& id_lm : landmarks_) {
+        id_lm.second->detach_from_arena();
+        id_lm.second->set_change_journal(nullptr);
+    }
+    for (const auto& id_keyfrm : keyframes_) {
+        id_keyfrm.second->set_change_journal(nullptr);
+    }
     landmarks_.clear();
+    lm_arena_.clear();
     keyframes_.clear();
+    // the consumers have to read the whole map again
+    journal_.reset();
     markers_.clear();
     last_inserted_keyfrm_ = nullptr;
     local_landmarks_.clear();
     spanning_roots_.clear();
+    keyfrm_relations_to_load_.clear();
+    landmark_ids_to_load_.clear();
 
     frm_stats_.clear();
 
@@ -255,22 +338,13 @@ void map_database::clear() {
 
 void map_database::from_json(camera_database* cam_db, orb_params_database* orb_params_db, bow_vocabulary* bow_vocab,
                              const nlohmann::json& json_keyfrms, const nlohmann::json& json_landmarks) {
-    std::lock_guard<std::mutex> lock(mtx_map_access_);
-
-    // When loading the map, leave last_inserted_keyfrm_ as nullptr.
-    last_inserted_keyfrm_ = nullptr;
-    local_landmarks_.clear();
-
     // Step 2. Register keyframes
     // If the object does not exist at this step, the corresponding pointer is set as nullptr.
     spdlog::info("decoding {} keyframes to load", json_keyfrms.size());
     for (const auto& json_id_keyfrm : json_keyfrms.items()) {
         const auto keyfrm_id_in_storage = std::stoi(json_id_keyfrm.key());
         assert(0 <= keyfrm_id_in_storage);
-        const auto keyfrm_id = keyfrm_id_in_storage + next_keyframe_id_;
-        const auto json_keyfrm = json_id_keyfrm.value();
-
-        register_keyframe(cam_db, orb_params_db, bow_vocab, keyfrm_id, json_keyfrm);
+        load_keyframe_from_json(cam_db, orb_params_db, bow_vocab, keyfrm_id_in_storage, json_id_keyfrm.value());
     }
 
     // Step 3. Register 3D landmark point
@@ -279,39 +353,71 @@ void map_database::from_json(camera_database* cam_db, orb_params_database* orb_p
     for (const auto& json_id_landmark : json_landmarks.items()) {
         const auto landmark_id_in_storage = std::stoi(json_id_landmark.key());
         assert(0 <= landmark_id_in_storage);
-        const auto landmark_id = landmark_id_in_storage + next_landmark_id_;
-        const auto json_landmark = json_id_landmark.value();
+        load_landmark_from_json(landmark_id_in_storage, json_id_landmark.value());
+    }
+
+    finish_loading_from_json(bow_vocab);
+}
+
+void map_database::load_keyframe_from_json(camera_database* cam_db, orb_params_database* orb_params_db, bow_vocabulary* bow_vocab,
+                                           const unsigned int id_in_storage, const nlohmann::json& json_keyfrm,
+                                           const bool use_stored_bow) {
+    std::lock_guard<std::mutex> lock(mtx_map_access_);
+
+    const auto keyfrm_id = id_in_storage + next_keyframe_id_;
+
+    // keep the graph information and the associations until all the objects are constructed
+    // (they are decoded first so that the keyframe is registered only if its relations are recorded)
+    keyframe_relations relations;
+    relations.id_ = keyfrm_id;
+    relations.spanning_parent_id_ = json_keyfrm.at("span_parent").get<int>();
+    relations.spanning_children_ids_ = json_keyfrm.at("span_children").get<std::vector<int>>();
+    relations.loop_edge_ids_ = json_keyfrm.at("loop_edges").get<std::vector<int>>();
+    relations.landmark_ids_ = json_keyfrm.at("lm_ids").get<std::vector<int>>();
+    assert(relations.landmark_ids_.size() == json_keyfrm.at("n_keypts").get<unsigned int>());
+
+    register_keyframe(cam_db, orb_params_db, bow_vocab, keyfrm_id, json_keyfrm, use_stored_bow);
+    keyfrm_relations_to_load_.push_back(std::move(relations));
+}
+
+void map_database::load_landmark_from_json(const unsigned int id_in_storage, const nlohmann::json& json_landmark) {
+    std::lock_guard<std::mutex> lock(mtx_map_access_);
+
+    const auto landmark_id = id_in_storage + next_landmark_id_;
+    register_landmark(landmark_id, json_landmark);
+    landmark_ids_to_load_.push_back(landmark_id);
+}
+
+void map_database::finish_loading_from_json(bow_vocabulary* bow_vocab) {
+    std::lock_guard<std::mutex> lock(mtx_map_access_);
 
-        register_landmark(landmark_id, json_landmark);
+    // When loading the map, leave last_inserted_keyfrm_ as nullptr.
+    last_inserted_keyfrm_ = nullptr;
+    local_landmarks_.clear();
+
+    std::vector<std::shared_ptr<keyframe>> keyfrms;
+    keyfrms.reserve(keyfrm_relations_to_load_.size());
+    for (const auto& relations : keyfrm_relations_to_load_) {
+        keyfrms.push_back(keyframes_.at(relations.id_));
     }
+    reconstruct_keyframes(keyfrms, bow_vocab);
 
     // Step 4. Register graph information
     spdlog::info("registering essential graph");
-    for (const auto& json_id_keyfrm : json_keyfrms.items()) {
-        const auto keyfrm_id_in_storage = std::stoi(json_id_keyfrm.key());
-        assert(0 <= keyfrm_id_in_storage);
-        const auto keyfrm_id = keyfrm_id_in_storage + next_keyframe_id_;
-        const auto json_keyfrm = json_id_keyfrm.value();
-
-        register_graph(keyfrm_id, json_keyfrm);
+    for (const auto& relations : keyfrm_relations_to_load_) {
+        register_graph(relations);
     }
 
     // Step 5. Register association between keyframs and 3D points
     spdlog::info("registering keyframe-landmark association");
-    for (const auto& json_id_keyfrm : json_keyfrms.items()) {
-        const auto keyfrm_id_in_storage = std::stoi(json_id_keyfrm.key());
-        assert(0 <= keyfrm_id_in_storage);
-        const auto keyfrm_id = keyfrm_id_in_storage + next_keyframe_id_;
-        const auto json_keyfrm = json_id_keyfrm.value();
-
-        register_association(keyfrm_id, json_keyfrm);
+    for (const auto& relations : keyfrm_relations_to_load_) {
+        register_association(relations);
     }
 
     // find root node
     std::unordered_set<unsigned int> already_found_root_ids;
-    for (const auto& json_id_keyfrm : json_keyfrms.items()) {
-        const auto id = std::stoi(json_id_keyfrm.key()) + next_keyframe_id_;
-        auto keyfrm = keyframes_.at(id);
+    for (const auto& relations : keyfrm_relations_to_load_) {
+        auto keyfrm = keyframes_.at(relations.id_);
         auto root = keyfrm->graph_node_->get_spanning_root();
         if (already_found_root_ids.count(root->id_)) {
             continue;
@@ -323,13 +429,9 @@ void map_database::from_json(camera_database* cam_db, orb_params_database* orb_p
 
     // Step 6. Update graph
     spdlog::info("updating covisibility graph");
-    for (const auto& json_id_keyfrm : json_keyfrms.items()) {
-        const auto keyfrm_id_in_storage = std::stoi(json_id_keyfrm.key());
-        assert(0 <= keyfrm_id_in_storage);
-        const auto keyfrm_id = keyfrm_id_in_storage + next_keyframe_id_;
-
-        assert(keyframes_.count(keyfrm_id));
-        auto keyfrm = keyframes_.at(keyfrm_id);
+    for (const auto& relations : keyfrm_relations_to_load_) {
+        assert(keyframes_.count(relations.id_));
+        auto keyfrm = keyframes_.at(relations.id_);
 
         keyfrm->graph_node_->update_connections(min_num_shared_lms_);
         keyfrm->graph_node_->update_covisibility_orders();
@@ -337,11 +439,7 @@ void map_database::from_json(camera_database* cam_db, orb_params_database* orb_p
 
     // Step 7. Update geometry
     spdlog::info("updating landmark geometry");
-    for (const auto& json_id_landmark : json_landmarks.items()) {
-        const auto landmark_id_in_storage = std::stoi(json_id_landmark.key());
-        assert(0 <= landmark_id_in_storage);
-        const auto landmark_id = landmark_id_in_storage + next_landmark_id_;
-
+    for (const auto landmark_id : landmark_ids_to_load_) {
         assert(landmarks_.count(landmark_id));
         const auto& lm = landmarks_.at(landmark_id);
 
@@ -352,10 +450,53 @@ void map_database::from_json(camera_database* cam_db, orb_params_database* orb_p
             lm->compute_descriptor();
         }
     }
+
+    keyfrm_relations_to_load_.clear();
+    keyfrm_relations_to_load_.shrink_to_fit();
+    landmark_ids_to_load_.clear();
+    landmark_ids_to_load_.shrink_to_fit();
+}
+
+void map_database::abort_loading_from_json() {
+    std::lock_guard<std::mutex> lock(mtx_map_access_);
+
+    spdlog::info("discard {} keyframes and {} landmarks being loaded", keyfrm_relations_to_load_.size(), landmark_ids_to_load_.size());
+    std::unordered_set<unsigned int> keyfrm_ids;
+    for (const auto& relations : keyfrm_relations_to_load_) {
+        keyfrm_ids.insert(relations.id_);
+        const auto itr = keyframes_.find(relations.id_);
+        if (itr == keyframes_.end()) {
+            continue;
+        }
+        itr->second->set_change_journal(nullptr);
+        keyframes_.erase(itr);
+        journal_.record_keyframe_change(relations.id_, map_change_type_t::Erased);
+    }
+    for (const auto landmark_id : landmark_ids_to_load_) {
+        const auto itr = landmarks_.find(landmark_id);
+        if (itr == landmarks_.end()) {
+            continue;
+        }
+        itr->second->detach_from_arena();
+        itr->second->set_change_journal(nullptr);
+        landmarks_.erase(itr);
+        journal_.record_landmark_change(landmark_id, map_change_type_t::Erased);
+    }
+    // the roots might have been found if finish_loading_from_json() failed
+    spanning_roots_.erase(std::remove_if(spanning_roots_.begin(), spanning_roots_.end(),
+                                         [&keyfrm_ids](const std::shared_ptr<keyframe>& root) {
+                                             return keyfrm_ids.count(root->id_) != 0;
+                                         }),
+                          spanning_roots_.end());
+
+    keyfrm_relations_to_load_.clear();
+    keyfrm_relations_to_load_.shrink_to_fit();
+    landmark_ids_to_load_.clear();
+    landmark_ids_to_load_.shrink_to_fit();
 }
 
 void map_database::register_keyframe(camera_database* cam_db, orb_params_database* orb_params_db, bow_vocabulary* bow_vocab,
-                                     const unsigned int id, const nlohmann::json& json_keyfrm) {
+                                     const unsigned int id, const nlohmann::json& json_keyfrm, const bool use_stored_bow) {
     // Metadata
     const auto timestamp = json_keyfrm.at("ts").get<double>();
     const auto camera_name = json_keyfrm.at("cam").get<std::string>();
@@ -376,10 +517,8 @@ void map_database::register_keyframe(camera_database* cam_db, orb_params_databas
     const auto json_undist_keypts = json_keyfrm.at("undist_keypts");
     const auto undist_keypts = convert_json_to_keypoints(json_undist_keypts);
     assert(undist_keypts.size() == num_keypts);
-    // bearings
+    // bearings (computed later in reconstruct_keyframes())
     auto bearings = eigen_alloc_vector<Vec3_t>();
-    camera->convert_keypoints_to_bearings(undist_keypts, bearings);
-    assert(bearings.size() == num_keypts);
     // stereo_x_right
     const auto stereo_x_right = json_keyfrm.at("x_rights").get<std::vector<float>>();
     // depths
@@ -394,9 +533,10 @@ void map_database::register_keyframe(camera_database* cam_db, orb_params_databas
     data::bow_feature_vector bow_feat_vec;
     // Construct frame_observation
     frame_observation frm_obs{descriptors, undist_keypts, bearings, stereo_x_right, depths};
-    // Compute BoW
-    if (bow_vocab) {
-        data::bow_vocabulary_util::compute_bow(bow_vocab, descriptors, bow_vec, bow_feat_vec);
+    // BoW is decoded if it was stored with the same vocabulary, otherwise computed later in reconstruct_keyframes()
+    if (bow_vocab && use_stored_bow && json_keyfrm.count("bow_vec") && json_keyfrm.count("bow_feat_vec")) {
+        bow_vocabulary_util::convert_json_to_bow_vector(json_keyfrm.at("bow_vec"), bow_vec);
+        bow_vocabulary_util::convert_json_to_bow_feature_vector(json_keyfrm.at("bow_feat_vec"), bow_feat_vec);
     }
     auto keyfrm = data::keyframe::make_keyframe(
         id, timestamp, pose_cw, camera, orb_params,
@@ -405,6 +545,8 @@ void map_database::register_keyframe(camera_database* cam_db, orb_params_databas
     // Append to map database
     assert(!keyframes_.count(id));
     keyframes_[keyfrm->id_] = keyfrm;
+    keyfrm->set_change_journal(&journal_);
+    journal_.record_keyframe_change(keyfrm->id_, map_change_type_t::Added);
 }
 
 void map_database::register_landmark(const unsigned int id, const nlohmann::json& json_landmark) {
@@ -420,36 +562,54 @@ void map_database::register_landmark(const unsigned int id, const nlohmann::json
         num_visible, num_found);
     assert(!landmarks_.count(id));
     landmarks_[lm->id_] = lm;
+    lm->attach_to_arena(&lm_arena_);
+    lm->set_change_journal(&journal_);
+    journal_.record_landmark_change(lm->id_, map_change_type_t::Added);
 }
 
-void map_database::register_graph(const unsigned int id, const nlohmann::json& json_keyfrm) {
+void map_database::reconstruct_keyframes(const std::vector<std::shared_ptr<keyframe>>& keyfrms, bow_vocabulary* bow_vocab) {
+    spdlog::info("computing bearings and BoW of {} keyframes", keyfrms.size());
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for (unsigned int i = 0; i < keyfrms.size(); ++i) {
+        const auto& keyfrm = keyfrms.at(i);
+        auto& frm_obs = keyfrm->frm_obs_;
+        if (frm_obs.bearings_.empty()) {
+            keyfrm->camera_->convert_keypoints_to_bearings(frm_obs.undist_keypts_, frm_obs.bearings_);
+            assert(frm_obs.bearings_.size() == frm_obs.undist_keypts_.size());
+        }
+        if (bow_vocab && !keyfrm->bow_is_available()) {
+            keyfrm->compute_bow(bow_vocab);
+        }
+    }
+}
+
+void map_database::register_graph(const keyframe_relations& relations) {
     // Graph information
-    const auto spanning_parent_id = json_keyfrm.at("span_parent").get<int>();
-    const auto spanning_children_ids = json_keyfrm.at("span_children").get<std::vector<int>>();
-    const auto loop_edge_ids = json_keyfrm.at("loop_edges").get<std::vector<int>>();
+    const auto id = relations.id_;
+    const auto spanning_parent_id = relations.spanning_parent_id_;
 
     assert(keyframes_.count(id));
     assert(spanning_parent_id == -1 || keyframes_.count(spanning_parent_id + next_keyframe_id_));
     keyframes_.at(id)->graph_node_->set_spanning_parent((spanning_parent_id == -1) ? nullptr : keyframes_.at(spanning_parent_id + next_keyframe_id_));
-    for (const auto spanning_child_id : spanning_children_ids) {
+    for (const auto spanning_child_id : relations.spanning_children_ids_) {
         assert(keyframes_.count(spanning_child_id));
         keyframes_.at(id)->graph_node_->add_spanning_child(keyframes_.at(spanning_child_id + next_keyframe_id_));
     }
-    for (const auto loop_edge_id : loop_edge_ids) {
+    for (const auto loop_edge_id : relations.loop_edge_ids_) {
         assert(keyframes_.count(loop_edge_id));
         keyframes_.at(id)->graph_node_->add_loop_edge(keyframes_.at(loop_edge_id + next_keyframe_id_));
     }
 }
 
-void map_database::register_association(const unsigned int keyfrm_id, const nlohmann::json& json_keyfrm) {
+void map_database::register_association(const keyframe_relations& relations) {
     // Key points information
-    const auto num_keypts = json_keyfrm.at("n_keypts").get<unsigned int>();
-    const auto landmark_ids = json_keyfrm.at("lm_ids").get<std::vector<int>>();
-    assert(landmark_ids.size() == num_keypts);
+    const auto& landmark_ids = relations.landmark_ids_;
 
-    assert(keyframes_.count(keyfrm_id));
-    auto keyfrm = keyframes_.at(keyfrm_id);
-    for (unsigned int idx = 0; idx < num_keypts; ++idx) {
+    assert(keyframes_.count(relations.id_));
+    auto keyfrm = keyframes_.at(relations.id_);
+    for (unsigned int idx = 0; idx < landmark_ids.size(); ++idx) {
         auto lm_id = landmark_ids.at(idx);
         if (lm_id < 0) {
             continue;
@@ -464,7 +624,7 @@ void map_database::register_association(const unsigned int keyfrm_id, const nloh
     }
 }
 
-void map_database::to_json(nlohmann::json& json_keyfrms, nlohmann::json& json_landmarks) const {
+void map_database::to_json(nlohmann::json& json_keyfrms, nlohmann::json& json_landmarks, const bool save_bow_vectors) const {
     std::lock_guard<std::mutex> lock(mtx_map_access_);
 
     // Save each keyframe as json
@@ -478,7 +638,7 @@ void map_database::to_json(nlohmann::json& json_keyfrms, nlohmann::json& json_la
         assert(!keyfrm->will_be_erased());
         keyfrm->graph_node_->update_connections(min_num_shared_lms_);
         assert(!keyfrms.count(std::to_string(id)));
-        keyfrms[std::to_string(id)] = keyfrm->to_json();
+        keyfrms[std::to_string(id)] = keyfrm->to_json(save_bow_vectors);
     }
     json_keyfrms = keyfrms;
 
@@ -574,15 +734,24 @@ bool map_database::load_keyframes_from_db(sqlite3* db,
     }
 
     int ret = SQLITE_ERROR;
+    std::vector<std::shared_ptr<keyframe>> keyfrms;
     while ((ret = sqlite3_step(stmt)) == SQLITE_ROW) {
-        auto keyfrm = data::keyframe::from_stmt(stmt, cam_db, orb_params_db, bow_vocab, next_keyframe_id_);
+        auto keyfrm = data::keyframe::from_stmt(stmt, cam_db, orb_params_db, next_keyframe_id_);
         // Append to map database
         assert(!keyframes_.count(keyfrm->id_));
         keyframes_[keyfrm->id_] = keyfrm;
+        keyfrm->set_change_journal(&journal_);
+        journal_.record_keyframe_change(keyfrm->id_, map_change_type_t::Added);
+        keyfrms.push_back(keyfrm);
     }
 
     sqlite3_finalize(stmt);
-    return ret == SQLITE_DONE;
+    if (ret != SQLITE_DONE) {
+        return false;
+    }
+
+    reconstruct_keyframes(keyfrms, bow_vocab);
+    return true;
 }
 
 bool map_database::load_landmarks_from_db(sqlite3* db, const std::string& table_name) {
@@ -596,6 +765,9 @@ bool map_database::load_landmarks_from_db(sqlite3* db, const std::string& table_
         auto lm = data::landmark::from_stmt(stmt, keyframes_, next_landmark_id_, next_keyframe_id_);
         assert(!landmarks_.count(lm->id_));
         landmarks_[lm->id_] = lm;
+        lm->attach_to_arena(&lm_arena_);
+        lm->set_change_journal(&journal_);
+        journal_.record_landmark_change(lm->id_, map_change_type_t::Added);
     }
     sqlite3_finalize(stmt);
     return ret == SQLITE_DONE;
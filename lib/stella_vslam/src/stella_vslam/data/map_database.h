@@ -3,7 +3,11 @@
 
 #include "stella_vslam/data/bow_vocabulary_fwd.h"
 #include "stella_vslam/data/frame_statistics.h"
+#include "stella_vslam/data/landmark_arena.h"
+#include "stella_vslam/data/map_change_journal.h"
+#include "stella_vslam/util/shared_mutex.h"
 
+#include <functional>
 #include <mutex>
 #include <vector>
 #include <unordered_map>
@@ -29,12 +33,30 @@ class camera_database;
 class orb_params_database;
 class bow_database;
 
+/**
+ * Changes of the keyframes and the landmarks since a version of the map
+ */
+struct map_changes {
+    //! version of the map which these changes bring the consumer to (pass it to the next query)
+    uint64_t version_ = 0;
+    //! if false, the changes since the requested version are not available, and the consumer needs to read the whole map
+    bool is_complete_ = false;
+    //! added or updated keyframes
+    std::vector<std::shared_ptr<keyframe>> updated_keyfrms_;
+    //! IDs of the erased keyframes
+    std::vector<unsigned int> erased_keyfrm_ids_;
+    //! added or updated landmarks
+    std::vector<std::shared_ptr<landmark>> updated_lms_;
+    //! IDs of the erased landmarks
+    std::vector<unsigned int> erased_lm_ids_;
+};
+
 class map_database {
 public:
     /**
      * Constructor
      */
-    map_database(unsigned int min_num_shared_lms);
+    map_database(unsigned int min_num_shared_lms, const YAML::Node& frm_stats_params);
 
     /**
      * Destructor
@@ -154,6 +176,29 @@ public:
      */
     std::vector<std::shared_ptr<landmark>> get_all_landmarks() const;
 
+    /**
+     * Get the dense storage of the attributes of the landmarks in the database
+     * @return
+     */
+    const landmark_arena& get_landmark_arena() const {
+        return lm_arena_;
+    }
+
+    /**
+     * Get the current version of the map (which is increased whenever a keyframe or a landmark is added, updated or erased)
+     * @return
+     */
+    uint64_t get_version() const;
+
+    /**
+     * Get the keyframes and the landmarks which have been added, updated or erased since the version
+     * (the cost is proportional to the number of the changes, not to the size of the map)
+     * @param version version returned by the previous query (0: since the beginning)
+     * @param changes
+     * @param include_landmarks if false, the changes of the landmarks are not collected
+     */
+    void get_changes_since(const uint64_t version, map_changes& changes, const bool include_landmarks = true) const;
+
     /**
      * Get the last keyframe added to the database
      * @return shared pointer to the last keyframe added to the database
@@ -221,14 +266,21 @@ public:
     }
 
     /**
-     * Get frame statistics
+     * Get the number of the valid frames in frame statistics
      * @return
      */
-    frame_statistics get_frame_statistics() const {
+    unsigned int get_num_valid_frames() const {
         std::lock_guard<std::mutex> lock(mtx_map_access_);
-        return frm_stats_;
+        return frm_stats_.get_num_valid_frames();
     }
 
+    /**
+     * Visit the valid frames in frame statistics in the ascending order of the IDs
+     * (the reference keyframe is nullptr if it is not found in the database)
+     * @param visitor
+     */
+    void for_each_frame_statistics(const std::function<void(const frame_statistics::frame_record&, const std::shared_ptr<keyframe>&)>& visitor) const;
+
     /**
      * Clear the database
      */
@@ -245,12 +297,49 @@ public:
     void from_json(camera_database* cam_db, orb_params_database* orb_params_db, bow_vocabulary* bow_vocab,
                    const nlohmann::json& json_keyfrms, const nlohmann::json& json_landmarks);
 
+    /**
+     * Decode JSON of a keyframe and register it to the map database
+     * (NOTE: this function is used to load keyframes one by one without keeping their JSON.
+     *        all the keyframes must be loaded before the landmarks, and finish_loading_from_json() must be called at the end)
+     * @param cam_db
+     * @param orb_params_db
+     * @param bow_vocab
+     * @param id_in_storage
+     * @param json_keyfrm
+     * @param use_stored_bow if true, the stored BoW vectors are used instead of recomputing them
+     *        (set true only if they were computed with bow_vocab)
+     */
+    void load_keyframe_from_json(camera_database* cam_db, orb_params_database* orb_params_db, bow_vocabulary* bow_vocab,
+                                 const unsigned int id_in_storage, const nlohmann::json& json_keyfrm,
+                                 const bool use_stored_bow = false);
+
+    /**
+     * Decode JSON of a landmark and register it to the map database
+     * (NOTE: see load_keyframe_from_json())
+     * @param id_in_storage
+     * @param json_landmark
+     */
+    void load_landmark_from_json(const unsigned int id_in_storage, const nlohmann::json& json_landmark);
+
+    /**
+     * Reconstruct the keyframes loaded from JSON, then register their graph and associations
+     * @param bow_vocab
+     */
+    void finish_loading_from_json(bow_vocabulary* bow_vocab);
+
+    /**
+     * Erase the keyframes and the landmarks registered by load_keyframe_from_json() and load_landmark_from_json()
+     * since the last finish_loading_from_json() (the other objects in the map database are kept)
+     */
+    void abort_loading_from_json();
+
     /**
      * Dump keyframes and landmarks as JSON
      * @param json_keyfrms
      * @param json_landmarks
+     * @param save_bow_vectors if true, BoW vectors of the keyframes are also dumped
      */
-    void to_json(nlohmann::json& json_keyfrms, nlohmann::json& json_landmarks) const;
+    void to_json(nlohmann::json& json_keyfrms, nlohmann::json& json_landmarks, const bool save_bow_vectors = false) const;
 
     /**
      * Load keyframes and landmarks from database
@@ -265,9 +354,10 @@ public:
      */
     bool to_db(sqlite3* db) const;
 
-    //! mutex for locking ALL access to the database
+    //! reader-writer mutex for locking ALL access to the database
+    //! (lock it with util::shared_lock to only read the map, and with util::exclusive_lock to modify it)
     //! (NOTE: cannot used in map_database class)
-    static std::mutex mtx_database_;
+    static util::shared_mutex mtx_database_;
 
     //! next ID
     std::atomic<unsigned int> next_keyframe_id_{0};
@@ -282,9 +372,10 @@ private:
      * @param bow_vocab
      * @param id
      * @param json_keyfrm
+     * @param use_stored_bow
      */
     void register_keyframe(camera_database* cam_db, orb_params_database* orb_params_db, bow_vocabulary* bow_vocab,
-                           const unsigned int id, const nlohmann::json& json_keyfrm);
+                           const unsigned int id, const nlohmann::json& json_keyfrm, const bool use_stored_bow);
 
     /**
      * Decode JSON and register landmark information to the map database
@@ -295,20 +386,35 @@ private:
     void register_landmark(const unsigned int id, const nlohmann::json& json_landmark);
 
     /**
-     * Decode JSON and register essential graph information
+     * Compute the bearings and the BoW of the loaded keyframes in parallel
+     * (NOTE: BoW is computed only if it was not stored in the map file)
+     * @param keyfrms
+     * @param bow_vocab
+     */
+    static void reconstruct_keyframes(const std::vector<std::shared_ptr<keyframe>>& keyfrms, bow_vocabulary* bow_vocab);
+
+    //! Graph information and landmark IDs of a keyframe, which are registered after all the objects are constructed
+    struct keyframe_relations {
+        unsigned int id_;
+        int spanning_parent_id_;
+        std::vector<int> spanning_children_ids_;
+        std::vector<int> loop_edge_ids_;
+        std::vector<int> landmark_ids_;
+    };
+
+    /**
+     * Register essential graph information
      * (NOTE: keyframe database must be completely constructed before calling this function)
-     * @param id
-     * @param json_keyfrm
+     * @param relations
      */
-    void register_graph(const unsigned int id, const nlohmann::json& json_keyfrm);
+    void register_graph(const keyframe_relations& relations);
 
     /**
-     * Decode JSON and register keyframe-landmark associations
+     * Register keyframe-landmark associations
      * (NOTE: keyframe and landmark database must be completely constructed before calling this function)
-     * @param keyfrm_id
-     * @param json_keyfrm
+     * @param relations
      */
-    void register_association(const unsigned int keyfrm_id, const nlohmann::json& json_keyfrm);
+    void register_association(const keyframe_relations& relations);
 
     bool load_keyframes_from_db(sqlite3* db,
                                 const std::string& table_name,
@@ -346,6 +452,10 @@ private:
     std::unordered_map<unsigned int, std::shared_ptr<keyframe>> keyframes_;
     //! IDs and landmarks
     std::unordered_map<unsigned int, std::shared_ptr<landmark>> landmarks_;
+    //! dense storage of the attributes of the landmarks in the database
+    landmark_arena lm_arena_;
+    //! journal of the changes of the keyframes and the landmarks
+    map_change_journal journal_;
     //! IDs and markers
     std::unordered_map<unsigned int, std::shared_ptr<marker>> markers_;
 
@@ -361,6 +471,14 @@ private:
     //! keyframes with id less than or equal to fixed_keyframe_id_threshold are not optimized
     unsigned int fixed_keyframe_id_threshold_ = 0;
 
+    //-----------------------------------------
+    // objects which are being loaded from JSON
+
+    //! relations of the keyframes loaded by load_keyframe_from_json()
+    std::vector<keyframe_relations> keyfrm_relations_to_load_;
+    //! IDs of the landmarks loaded by load_landmark_from_json()
+    std::vector<unsigned int> landmark_ids_to_load_;
+
     //-----------------------------------------
     // parameters for global/local mapping (optimization)
 
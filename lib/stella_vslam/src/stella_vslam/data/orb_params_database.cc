@@ -46,6 +46,8 @@ void orb_params_database::from_json(const nlohmann::json& json_orb_params) {
     for (const auto& json_id_orb_params : json_orb_params.items()) {
         const auto& orb_params_name = json_id_orb_params.key();
         const auto& json_orb_params = json_id_orb_params.value();
+        // the maps saved before the binned BRIEF pattern was introduced use the exact one
+        const auto num_descriptor_angle_bins = json_orb_params.value("num_descriptor_angle_bins", 0u);
 
         if (orb_params_database_.count(orb_params_name)) {
             spdlog::info("The feature extraction settings with the same name (\"{}\") already existed in database.", orb_params_name);
@@ -53,7 +55,8 @@ void orb_params_database::from_json(const nlohmann::json& json_orb_params) {
             if (std::abs(orb_params_in_database->scale_factor_ - json_orb_params.at("scale_factor").get<float>()) < 1e-6
                 && orb_params_in_database->num_levels_ - json_orb_params.at("num_levels").get<unsigned int>() == 0
                 && orb_params_in_database->ini_fast_thr_ - json_orb_params.at("ini_fast_threshold").get<unsigned int>() == 0
-                && orb_params_in_database->min_fast_thr_ - json_orb_params.at("min_fast_threshold").get<unsigned int>() == 0) {
+                && orb_params_in_database->min_fast_thr_ - json_orb_params.at("min_fast_threshold").get<unsigned int>() == 0
+                && orb_params_in_database->num_descriptor_angle_bins_ == num_descriptor_angle_bins) {
                 continue;
             }
             else {
@@ -68,7 +71,8 @@ void orb_params_database::from_json(const nlohmann::json& json_orb_params) {
                                                   json_orb_params.at("scale_factor").get<float>(),
                                                   json_orb_params.at("num_levels").get<unsigned int>(),
                                                   json_orb_params.at("ini_fast_threshold").get<unsigned int>(),
-                                                  json_orb_params.at("min_fast_threshold").get<unsigned int>());
+                                                  json_orb_params.at("min_fast_threshold").get<unsigned int>(),
+                                                  num_descriptor_angle_bins);
         assert(!orb_params_database_.count(orb_params_name));
         orb_params_database_[orb_params_name] = orb_params;
     }
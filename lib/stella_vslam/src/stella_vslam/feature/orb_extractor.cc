@@ -6,7 +6,10 @@
 #include <opencv2/imgproc.hpp>
 #include <opencv2/features2d.hpp>
 
+#include <algorithm>
+#include <cassert>
 #include <iostream>
+#include <numeric>
 
 #include <spdlog/spdlog.h>
 
@@ -17,9 +20,13 @@ orb_extractor::orb_extractor(const orb_params* orb_params,
                              const unsigned int min_area,
                              const descriptor_type desc_type,
                              const std::vector<std::vector<float>>& mask_rects)
-    : orb_params_(orb_params), mask_rects_(mask_rects), min_area_sqrt_(std::sqrt(min_area)), desc_type_(desc_type) {
+    : orb_params_(orb_params), mask_rects_(mask_rects), min_area_sqrt_(std::sqrt(min_area)), desc_type_(desc_type),
+      orb_impl_(orb_params->num_descriptor_angle_bins_) {
     // resize buffers according to the number of levels
     image_pyramid_.resize(orb_params_->num_levels_);
+    blurred_image_pyramid_.resize(orb_params_->num_levels_);
+    blurred_bands_.resize(orb_params_->num_levels_);
+    fast_buffers_.resize(orb_params_->num_levels_);
 #ifdef USE_CUDA_EFFICIENT_DESCRIPTORS
     hash_sift_ = cv::cuda::HashSIFT::create(1.0, cv::cuda::HashSIFT::SIZE_256_BITS);
 #endif
@@ -99,23 +106,16 @@ void orb_extractor::extract(const cv::_InputArray& in_image, const cv::_InputArr
             continue;
         }
 
-        cv::Mat blurred_image;
-        cv::GaussianBlur(image_pyramid_.at(level), blurred_image, cv::Size(7, 7), 2, 2, cv::BORDER_REFLECT_101);
-
         cv::Mat descriptors_at_level = descriptors.rowRange(offsets[level], offsets[level] + num_keypts_at_level);
         descriptors_at_level = cv::Mat::zeros(num_keypts_at_level, 32, CV_8UC1);
 
-        // To enable parallelization, set the environment variable OMP_MAX_ACTIVE_LEVELS to 2.
         if (desc_type_ == feature::descriptor_type::ORB) {
-#ifdef USE_OPENMP
-#pragma omp parallel for schedule(static)
-#endif
-            for (unsigned int i = 0; i < keypts_at_level.size(); ++i) {
-                compute_orb_descriptor(keypts_at_level[i], blurred_image, descriptors_at_level.ptr(i));
-            }
+            compute_orb_descriptors_in_bands(level, keypts_at_level, descriptors_at_level);
         }
         else if (desc_type_ == feature::descriptor_type::HASH_SIFT) {
 #ifdef USE_CUDA_EFFICIENT_DESCRIPTORS
+            cv::Mat& blurred_image = blurred_image_pyramid_.at(level);
+            cv::GaussianBlur(image_pyramid_.at(level), blurred_image, cv::Size(7, 7), 2, 2, cv::BORDER_REFLECT_101);
             hash_sift_->compute(blurred_image, keypts_at_level, descriptors_at_level);
 #else
             throw std::runtime_error("cuda_efficient_features is not available");
@@ -161,7 +161,7 @@ void orb_extractor::compute_image_pyramid(const cv::Mat& image) {
     }
 }
 
-void orb_extractor::compute_fast_keypoints(std::vector<std::vector<cv::KeyPoint>>& all_keypts, const cv::Mat& mask) const {
+void orb_extractor::compute_fast_keypoints(std::vector<std::vector<cv::KeyPoint>>& all_keypts, const cv::Mat& mask) {
     all_keypts.resize(orb_params_->num_levels_);
 
     // An anonymous function which checks mask(image or rectangle)
@@ -172,6 +172,9 @@ void orb_extractor::compute_fast_keypoints(std::vector<std::vector<cv::KeyPoint>
     constexpr unsigned int overlap = 6;
     constexpr unsigned int cell_size = 64;
 
+    // The scores are computed once with the lower threshold, and are shared by the both thresholds
+    const unsigned int fast_thr = std::min(orb_params_->ini_fast_thr_, orb_params_->min_fast_thr_);
+
 #ifdef USE_OPENMP
 #pragma omp parallel for schedule(dynamic)
 #endif
@@ -189,14 +192,32 @@ void orb_extractor::compute_fast_keypoints(std::vector<std::vector<cv::KeyPoint>
         const unsigned int num_cols = width / cell_size + 1;
         const unsigned int num_rows = height / cell_size + 1;
 
-        std::vector<cv::KeyPoint> keypts_to_distribute;
-        keypts_to_distribute.reserve(500);
+        auto& buffer = fast_buffers_.at(level);
+
+        // Compute the FAST scores of all the pixels which can be evaluated in any cell
+        buffer.scores_min_x_ = min_border_x + fast_border_;
+        buffer.scores_min_y_ = min_border_y + fast_border_;
+        buffer.scores_width_ = (width < 2 * fast_border_) ? 0 : width - 2 * fast_border_;
+        const unsigned int scores_height = (height < 2 * fast_border_) ? 0 : height - 2 * fast_border_;
+        buffer.scores_.resize(buffer.scores_width_ * scores_height);
+        if (!buffer.scores_.empty()) {
+            orb_impl_.compute_fast_scores(image_pyramid_.at(level),
+                                          buffer.scores_min_x_, buffer.scores_min_x_ + buffer.scores_width_,
+                                          buffer.scores_min_y_, buffer.scores_min_y_ + scores_height,
+                                          fast_thr, buffer.scores_.data());
+        }
+
+        // Each row of the cells has its own output buffer, so that no critical section is needed
+        buffer.keypts_in_rows_.resize(num_rows);
 
         // To enable parallelization, set the environment variable OMP_MAX_ACTIVE_LEVELS to 2.
 #ifdef USE_OPENMP
 #pragma omp parallel for schedule(static)
 #endif
         for (int64_t i = 0; i < num_rows; ++i) {
+            auto& keypts_in_row = buffer.keypts_in_rows_.at(i);
+            keypts_in_row.clear();
+
             const unsigned int min_y = min_border_y + i * cell_size;
             if (max_border_y - overlap <= min_y) {
                 continue;
@@ -224,46 +245,34 @@ void orb_extractor::compute_fast_keypoints(std::vector<std::vector<cv::KeyPoint>
                     }
                 }
 
-                std::vector<cv::KeyPoint> keypts_in_cell;
-                cv::FAST(image_pyramid_.at(level).rowRange(min_y, max_y).colRange(min_x, max_x),
-                         keypts_in_cell, orb_params_->ini_fast_thr_, true);
+                const auto num_keypts_before = keypts_in_row.size();
+                detect_fast_keypoints_in_cell(buffer, min_x, max_x, min_y, max_y, min_border_x, min_border_y,
+                                              orb_params_->ini_fast_thr_, keypts_in_row);
 
                 // Re-compute FAST keypoint with reduced threshold if enough keypoint was not got
-                if (keypts_in_cell.empty()) {
-                    cv::FAST(image_pyramid_.at(level).rowRange(min_y, max_y).colRange(min_x, max_x),
-                             keypts_in_cell, orb_params_->min_fast_thr_, true);
-                }
-
-                if (keypts_in_cell.empty()) {
-                    continue;
-                }
-
-                for (auto& keypt : keypts_in_cell) {
-                    keypt.pt.x += j * cell_size;
-                    keypt.pt.y += i * cell_size;
+                if (keypts_in_row.size() == num_keypts_before) {
+                    detect_fast_keypoints_in_cell(buffer, min_x, max_x, min_y, max_y, min_border_x, min_border_y,
+                                                  orb_params_->min_fast_thr_, keypts_in_row);
                 }
 
                 if (!mask.empty()) {
-                    std::vector<cv::KeyPoint> keypts_in_cell_masked;
-                    for (auto&& keypt : keypts_in_cell) {
-                        // Check if the keypoint is in the mask
-                        if (is_in_mask(min_border_y + keypt.pt.y, min_border_x + keypt.pt.x, scale_factor)) {
-                            continue;
-                        }
-                        keypts_in_cell_masked.push_back(std::move(keypt));
-                    }
-                    keypts_in_cell = std::move(keypts_in_cell_masked);
-                }
-
-#ifdef USE_OPENMP
-#pragma omp critical
-#endif
-                {
-                    keypts_to_distribute.insert(keypts_to_distribute.end(), keypts_in_cell.begin(), keypts_in_cell.end());
+                    // Check if the keypoint is in the mask
+                    const auto masked_begin = std::remove_if(keypts_in_row.begin() + num_keypts_before, keypts_in_row.end(),
+                                                             [&](const cv::KeyPoint& keypt) {
+                                                                 return is_in_mask(min_border_y + keypt.pt.y, min_border_x + keypt.pt.x, scale_factor);
+                                                             });
+                    keypts_in_row.erase(masked_begin, keypts_in_row.end());
                 }
             }
         }
 
+        // Merge the rows in order
+        auto& keypts_to_distribute = buffer.keypts_to_distribute_;
+        keypts_to_distribute.clear();
+        for (const auto& keypts_in_row : buffer.keypts_in_rows_) {
+            keypts_to_distribute.insert(keypts_to_distribute.end(), keypts_in_row.begin(), keypts_in_row.end());
+        }
+
         std::vector<cv::KeyPoint>& keypts_at_level = all_keypts.at(level);
 
         // Distribute keypoints via tree
@@ -286,6 +295,55 @@ void orb_extractor::compute_fast_keypoints(std::vector<std::vector<cv::KeyPoint>
     }
 }
 
+void orb_extractor::detect_fast_keypoints_in_cell(const fast_buffer& buffer,
+                                                  const unsigned int min_x, const unsigned int max_x,
+                                                  const unsigned int min_y, const unsigned int max_y,
+                                                  const unsigned int origin_x, const unsigned int origin_y,
+                                                  const unsigned int threshold, std::vector<cv::KeyPoint>& keypts) const {
+    // cv::FAST does not evaluate the pixels near the border of the input image (= the cell),
+    // and treats them as non-corners in the non-maximum suppression
+    const int eval_min_x = min_x + fast_border_;
+    const int eval_max_x = static_cast<int>(max_x) - static_cast<int>(fast_border_);
+    const int eval_min_y = min_y + fast_border_;
+    const int eval_max_y = static_cast<int>(max_y) - static_cast<int>(fast_border_);
+    if (eval_max_x <= eval_min_x || eval_max_y <= eval_min_y) {
+        return;
+    }
+
+    const int scores_min_x = buffer.scores_min_x_;
+    const int scores_min_y = buffer.scores_min_y_;
+    const int scores_width = buffer.scores_width_;
+    const uchar* const scores = buffer.scores_.data();
+    auto score_at = [&](const int x, const int y) -> int {
+        if (x < eval_min_x || eval_max_x <= x || y < eval_min_y || eval_max_y <= y) {
+            return 0;
+        }
+        return scores[(y - scores_min_y) * scores_width + (x - scores_min_x)];
+    };
+
+    // cv::FAST clamps the threshold to 255
+    // (a score of 0 never survives the non-maximum suppression, thus it is skipped as well)
+    const int thr = std::max(static_cast<int>(std::min(threshold, 255u)), 1);
+
+    for (int y = eval_min_y; y < eval_max_y; ++y) {
+        const uchar* const scores_row = scores + (y - scores_min_y) * scores_width - scores_min_x;
+        for (int x = eval_min_x; x < eval_max_x; ++x) {
+            // a pixel is a corner at the threshold iff its score is not less than the threshold
+            const int score = scores_row[x];
+            if (score < thr) {
+                continue;
+            }
+            // non-maximum suppression
+            if (score_at(x - 1, y - 1) < score && score_at(x, y - 1) < score && score_at(x + 1, y - 1) < score
+                && score_at(x - 1, y) < score && score_at(x + 1, y) < score
+                && score_at(x - 1, y + 1) < score && score_at(x, y + 1) < score && score_at(x + 1, y + 1) < score) {
+                keypts.emplace_back(static_cast<float>(x - static_cast<int>(origin_x)), static_cast<float>(y - static_cast<int>(origin_y)),
+                                    7.f, -1, static_cast<float>(score));
+            }
+        }
+    }
+}
+
 std::vector<cv::KeyPoint> orb_extractor::distribute_keypoints(const std::vector<cv::KeyPoint>& keypts_to_distribute,
                                                               const int min_x, const int max_x, const int min_y, const int max_y,
                                                               const float scale_factor) const {
@@ -352,5 +410,69 @@ void orb_extractor::compute_orb_descriptor(const cv::KeyPoint& keypt, const cv::
     orb_impl_.compute_orb_descriptor(keypt, image, desc);
 }
 
+void orb_extractor::compute_orb_descriptors_in_bands(const unsigned int level, const std::vector<cv::KeyPoint>& keypts_at_level,
+                                                     cv::Mat& descriptors_at_level) {
+    const cv::Mat& image = image_pyramid_.at(level);
+    cv::Mat& blurred_image = blurred_image_pyramid_.at(level);
+    if (image.isSubmatrix()) {
+        // The filter of a submatrix reads the pixels outside of it, so the level is blurred at once
+        cv::GaussianBlur(image, blurred_image, cv::Size(7, 7), 2, 2, cv::BORDER_REFLECT_101);
+        for (unsigned int i = 0; i < keypts_at_level.size(); ++i) {
+            compute_orb_descriptor(keypts_at_level[i], blurred_image, descriptors_at_level.ptr(i));
+        }
+        return;
+    }
+    blurred_image.create(image.size(), CV_8UC1);
+
+    // visit the keypoints from the top of the image, so that each row is blurred at most once
+    // and the descriptors are computed right after the rows around them are blurred
+    std::vector<unsigned int> order(keypts_at_level.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&keypts_at_level](const unsigned int a, const unsigned int b) {
+        return cvRound(keypts_at_level[a].pt.y) < cvRound(keypts_at_level[b].pt.y);
+    });
+
+    // rows [0, blurred_end) have been blurred or are not needed
+    int blurred_end = 0;
+    for (const auto idx : order) {
+        const int y = cvRound(keypts_at_level[idx].pt.y);
+        const int row_begin = std::max(0, y - static_cast<int>(orb_patch_radius_));
+        const int row_end = std::min(image.rows, y + static_cast<int>(orb_patch_radius_) + 1);
+        if (blurred_end < row_end) {
+            // the rows without any keypoint around them are skipped
+            const int begin = std::max(blurred_end, row_begin);
+            const int end = std::min(image.rows, std::max(row_end, begin + blur_band_rows_));
+            blur_rows(level, begin, end);
+            blurred_end = end;
+        }
+        compute_orb_descriptor(keypts_at_level[idx], blurred_image, descriptors_at_level.ptr(idx));
+    }
+
+#ifndef NDEBUG
+    // the descriptors must be the same as the ones computed from the level blurred at once
+    cv::Mat expected_blurred_image;
+    cv::GaussianBlur(image, expected_blurred_image, cv::Size(7, 7), 2, 2, cv::BORDER_REFLECT_101);
+    uchar expected_desc[32];
+    for (unsigned int i = 0; i < keypts_at_level.size(); ++i) {
+        compute_orb_descriptor(keypts_at_level[i], expected_blurred_image, expected_desc);
+        assert(std::equal(expected_desc, expected_desc + 32, descriptors_at_level.ptr(i)));
+    }
+#endif
+}
+
+void orb_extractor::blur_rows(const unsigned int level, const int begin, const int end) {
+    const cv::Mat& image = image_pyramid_.at(level);
+    cv::Mat blurred_rows = blurred_image_pyramid_.at(level).rowRange(begin, end);
+    // The band is blurred as an isolated image with the margins of the filter, and the margins are discarded.
+    // The rows in the band are computed from the same pixels in the same way as the whole level,
+    // so the result is bit-exact (the fixed-point implementation of OpenCV is used for isolated 8-bit images).
+    const int margin_begin = std::max(0, begin - blur_radius_);
+    const int margin_end = std::min(image.rows, end + blur_radius_);
+    cv::Mat& band = blurred_bands_.at(level);
+    cv::GaussianBlur(image.rowRange(margin_begin, margin_end), band, cv::Size(7, 7), 2, 2,
+                     cv::BORDER_REFLECT_101 | cv::BORDER_ISOLATED);
+    band.rowRange(begin - margin_begin, end - margin_begin).copyTo(blurred_rows);
+}
+
 } // namespace feature
 } // namespace stella_vslam
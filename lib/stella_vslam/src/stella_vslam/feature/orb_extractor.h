@@ -70,6 +70,10 @@ public:
     //! Image pyramid
     std::vector<cv::Mat> image_pyramid_;
 
+    //! Image pyramid smoothed with the Gaussian filter for computing descriptors
+    //! (only the rows around the keypoints are valid, see compute_orb_descriptors_in_bands())
+    std::vector<cv::Mat> blurred_image_pyramid_;
+
 private:
     //! Calculate scale factors and sigmas
     void calc_scale_factors();
@@ -80,8 +84,29 @@ private:
     //! Compute image pyramid
     void compute_image_pyramid(const cv::Mat& image);
 
+    //! Buffers for FAST detection at a pyramid level, which are reused across the frames
+    struct fast_buffer {
+        //! FAST scores of the pixels which can be evaluated in any cell (see orb_impl::compute_fast_scores)
+        std::vector<uchar> scores_;
+        unsigned int scores_min_x_ = 0;
+        unsigned int scores_min_y_ = 0;
+        unsigned int scores_width_ = 0;
+        //! keypoints detected in each row of the cells
+        std::vector<std::vector<cv::KeyPoint>> keypts_in_rows_;
+        //! keypoints of all the cells
+        std::vector<cv::KeyPoint> keypts_to_distribute_;
+    };
+
     //! Compute fast keypoints for cells in each image pyramid
-    void compute_fast_keypoints(std::vector<std::vector<cv::KeyPoint>>& all_keypts, const cv::Mat& mask) const;
+    void compute_fast_keypoints(std::vector<std::vector<cv::KeyPoint>>& all_keypts, const cv::Mat& mask);
+
+    //! Detect FAST keypoints in a cell from the precomputed scores, and append them to keypts
+    //! (the result is identical to cv::FAST with non-maximum suppression applied to the cell, translated by the origin)
+    void detect_fast_keypoints_in_cell(const fast_buffer& buffer,
+                                       const unsigned int min_x, const unsigned int max_x,
+                                       const unsigned int min_y, const unsigned int max_y,
+                                       const unsigned int origin_x, const unsigned int origin_y,
+                                       const unsigned int threshold, std::vector<cv::KeyPoint>& keypts) const;
 
     //! Pick computed keypoints on the image uniformly
     std::vector<cv::KeyPoint> distribute_keypoints(const std::vector<cv::KeyPoint>& keypts_to_distribute,
@@ -100,12 +125,34 @@ private:
     //! Compute orb descriptor of a keypoint
     void compute_orb_descriptor(const cv::KeyPoint& keypt, const cv::Mat& image, uchar* desc) const;
 
+    //! Blur the level band by band, and compute the ORB descriptors of the keypoints in each band while it is in cache
+    void compute_orb_descriptors_in_bands(const unsigned int level, const std::vector<cv::KeyPoint>& keypts_at_level,
+                                          cv::Mat& descriptors_at_level);
+
+    //! Blur the rows [begin, end) of the level into blurred_image_pyramid_
+    void blur_rows(const unsigned int level, const int begin, const int end);
+
     //! Area of node occupied by one feature point
     unsigned int min_area_sqrt_;
 
     //! size of maximum ORB patch radius
     static constexpr unsigned int orb_patch_radius_ = 19;
 
+    //! radius of the FAST circle
+    static constexpr unsigned int fast_border_ = 3;
+
+    //! radius of the Gaussian filter applied before computing descriptors
+    static constexpr int blur_radius_ = 3;
+
+    //! minimum number of the rows blurred at once
+    static constexpr int blur_band_rows_ = 32;
+
+    //! band of each level including the margins of the Gaussian filter
+    std::vector<cv::Mat> blurred_bands_;
+
+    //! FAST detection buffers for each level
+    std::vector<fast_buffer> fast_buffers_;
+
     //! rectangle mask has been already initialized or not
     bool mask_is_initialized_ = false;
     cv::Mat rect_mask_;
@@ -37,6 +37,8 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "stella_vslam/feature/orb_point_pairs.h"
 #include "stella_vslam/util/trigonometric.h"
 
+#include <algorithm>
+
 #ifdef USE_SSE_ORB
 #ifdef _MSC_VER
 #include <intrin.h>
@@ -45,10 +47,76 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #endif
 #endif // USE_SSE_ORB
 
+// The AVX2 kernel of the binned pattern is compiled with a per-function target attribute and selected at runtime,
+// so that the library itself does not need to be built with -mavx2
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define STELLA_VSLAM_ORB_X86
+#include <immintrin.h>
+#endif
+
 namespace stella_vslam {
 namespace feature {
 
-orb_impl::orb_impl() {
+namespace {
+
+using binned_tests_func_t = void (*)(const uchar*, const int, const int8_t*, const int8_t*, const int8_t*, const int8_t*,
+                                     const unsigned int, uchar*);
+
+//! Compare the pixel pairs of the binned pattern (8 pairs per byte of the descriptor)
+void compute_binned_tests_scalar(const uchar* center, const int step,
+                                 const int8_t* x_1, const int8_t* y_1, const int8_t* x_2, const int8_t* y_2,
+                                 const unsigned int num_bytes, uchar* desc) {
+    for (unsigned int i = 0; i < num_bytes; ++i) {
+        int32_t val = 0;
+        for (unsigned int k = 0; k < 8; ++k) {
+            const unsigned int idx = 8 * i + k;
+            val |= (center[y_1[idx] * step + x_1[idx]] < center[y_2[idx] * step + x_2[idx]]) << k;
+        }
+        desc[i] = static_cast<uchar>(val);
+    }
+}
+
+#ifdef STELLA_VSLAM_ORB_X86
+
+//! Gather 4 bytes from each of the 8 offsets and keep the lowest one
+__attribute__((target("avx2"))) inline __m256i gather_values_avx2(const uchar* center, const __m256i step,
+                                                                    const int8_t* x, const int8_t* y) {
+    const __m256i _x = _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(x)));
+    const __m256i _y = _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(y)));
+    const __m256i _offsets = _mm256_add_epi32(_mm256_mullo_epi32(_y, step), _x);
+    return _mm256_and_si256(_mm256_i32gather_epi32(reinterpret_cast<const int*>(center), _offsets, 1), _mm256_set1_epi32(0xff));
+}
+
+__attribute__((target("avx2"))) void compute_binned_tests_avx2(const uchar* center, const int step,
+                                                                const int8_t* x_1, const int8_t* y_1, const int8_t* x_2, const int8_t* y_2,
+                                                                const unsigned int num_bytes, uchar* desc) {
+    // (the bytes after the pattern are inside the image because the keypoints are apart from the bottom border)
+    const __m256i _step = _mm256_set1_epi32(step);
+    for (unsigned int i = 0; i < num_bytes; ++i) {
+        const __m256i _values_1 = gather_values_avx2(center, _step, x_1 + 8 * i, y_1 + 8 * i);
+        const __m256i _values_2 = gather_values_avx2(center, _step, x_2 + 8 * i, y_2 + 8 * i);
+        // the k-th bit is set if the first value of the k-th pair is less than the second one
+        const __m256i _less = _mm256_cmpgt_epi32(_values_2, _values_1);
+        desc[i] = static_cast<uchar>(_mm256_movemask_ps(_mm256_castsi256_ps(_less)));
+    }
+}
+
+#endif // STELLA_VSLAM_ORB_X86
+
+binned_tests_func_t select_binned_tests_func() {
+#ifdef STELLA_VSLAM_ORB_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return &compute_binned_tests_avx2;
+    }
+#endif
+    return &compute_binned_tests_scalar;
+}
+
+} // namespace
+
+orb_impl::orb_impl(const unsigned int num_angle_bins)
+    : num_angle_bins_(num_angle_bins) {
     // Preparate  for computation of orientation
     u_max_.resize(fast_half_patch_size_ + 1);
     const unsigned int vmax = std::floor(fast_half_patch_size_ * std::sqrt(2.0) / 2 + 1);
@@ -63,6 +131,24 @@ orb_impl::orb_impl() {
         u_max_.at(v) = v0;
         ++v0;
     }
+
+    // Rotate the point pairs to the center angle of each bin in advance (the rounding is the same as the exact one)
+    static constexpr unsigned int num_pairs = orb_point_pairs_size / 4;
+    binned_point_pairs_.resize(num_angle_bins_ * 4 * num_pairs);
+    for (unsigned int bin = 0; bin < num_angle_bins_; ++bin) {
+        const float angle = 2.0 * M_PI * bin / num_angle_bins_;
+        const float cos_angle = util::cos(angle);
+        const float sin_angle = util::sin(angle);
+        int8_t* const rotated = binned_point_pairs_.data() + bin * 4 * num_pairs;
+        for (unsigned int i = 0; i < num_pairs; ++i) {
+            for (unsigned int j = 0; j < 2; ++j) {
+                const float x = orb_point_pairs[4 * i + 2 * j];
+                const float y = orb_point_pairs[4 * i + 2 * j + 1];
+                rotated[(2 * j) * num_pairs + i] = static_cast<int8_t>(cvRound(x * cos_angle - y * sin_angle));
+                rotated[(2 * j + 1) * num_pairs + i] = static_cast<int8_t>(cvRound(x * sin_angle + y * cos_angle));
+            }
+        }
+    }
 }
 
 float orb_impl::ic_angle(const cv::Mat& image, const cv::Point2f& point) const {
@@ -91,6 +177,11 @@ float orb_impl::ic_angle(const cv::Mat& image, const cv::Point2f& point) const {
 }
 
 void orb_impl::compute_orb_descriptor(const cv::KeyPoint& keypt, const cv::Mat& image, uchar* desc) const {
+    if (0 < num_angle_bins_) {
+        compute_binned_orb_descriptor(keypt, image, desc);
+        return;
+    }
+
     const float angle = keypt.angle * M_PI / 180.0;
     const float cos_angle = util::cos(angle);
     const float sin_angle = util::sin(angle);
@@ -152,5 +243,228 @@ void orb_impl::compute_orb_descriptor(const cv::KeyPoint& keypt, const cv::Mat&
 #undef GET_VALUE
 #undef COMPARE_ORB_POINTS
 }
+
+void orb_impl::compute_binned_orb_descriptor(const cv::KeyPoint& keypt, const cv::Mat& image, uchar* desc) const {
+    int bin = cvRound(keypt.angle * num_angle_bins_ / 360.0f) % static_cast<int>(num_angle_bins_);
+    if (bin < 0) {
+        bin += num_angle_bins_;
+    }
+
+    static constexpr unsigned int num_pairs = orb_point_pairs_size / 4;
+    const int8_t* const x_1 = binned_point_pairs_.data() + bin * 4 * num_pairs;
+    const int8_t* const y_1 = x_1 + num_pairs;
+    const int8_t* const x_2 = y_1 + num_pairs;
+    const int8_t* const y_2 = x_2 + num_pairs;
+
+    const uchar* const center = &image.at<uchar>(cvRound(keypt.pt.y), cvRound(keypt.pt.x));
+    const auto step = static_cast<int>(image.step);
+
+    static const binned_tests_func_t compute_binned_tests = select_binned_tests_func();
+    compute_binned_tests(center, step, x_1, y_1, x_2, y_2, num_pairs / 8, desc);
+}
+
+namespace {
+
+// The segment test and the corner score are ported from FAST_t<16> and cornerScore<16> of OpenCV (fast.cpp, fast_score.cpp)
+
+//! Number of the pixels on the circle
+constexpr int fast_pattern_size = 16;
+//! Minimum number of the contiguous pixels minus one
+constexpr int fast_half_pattern_size = fast_pattern_size / 2;
+//! Number of the offsets (the circle is wrapped around)
+constexpr int num_fast_offsets = fast_pattern_size + fast_half_pattern_size + 1;
+
+void make_fast_offsets(int pixel[num_fast_offsets], const int row_stride) {
+    static const int offsets[fast_pattern_size][2] = {
+        {0, 3}, {1, 3}, {2, 2}, {3, 1}, {3, 0}, {3, -1}, {2, -2}, {1, -3}, {0, -3}, {-1, -3}, {-2, -2}, {-3, -1}, {-3, 0}, {-3, 1}, {-2, 2}, {-1, 3}};
+    int k = 0;
+    for (; k < fast_pattern_size; ++k) {
+        pixel[k] = offsets[k][0] + offsets[k][1] * row_stride;
+    }
+    for (; k < num_fast_offsets; ++k) {
+        pixel[k] = pixel[k - fast_pattern_size];
+    }
+}
+
+//! Largest threshold for which the pixel is still a corner (the threshold is a lower bound)
+int compute_fast_corner_score(const uchar* ptr, const int pixel[num_fast_offsets], const int threshold) {
+    const int v = ptr[0];
+    short d[num_fast_offsets];
+    for (int k = 0; k < num_fast_offsets; ++k) {
+        d[k] = static_cast<short>(v - ptr[pixel[k]]);
+    }
+
+    int a0 = threshold;
+    for (int k = 0; k < fast_pattern_size; k += 2) {
+        int a = std::min(static_cast<int>(d[k + 1]), static_cast<int>(d[k + 2]));
+        a = std::min(a, static_cast<int>(d[k + 3]));
+        if (a <= a0) {
+            continue;
+        }
+        a = std::min(a, static_cast<int>(d[k + 4]));
+        a = std::min(a, static_cast<int>(d[k + 5]));
+        a = std::min(a, static_cast<int>(d[k + 6]));
+        a = std::min(a, static_cast<int>(d[k + 7]));
+        a = std::min(a, static_cast<int>(d[k + 8]));
+        a0 = std::max(a0, std::min(a, static_cast<int>(d[k])));
+        a0 = std::max(a0, std::min(a, static_cast<int>(d[k + 9])));
+    }
+
+    int b0 = -a0;
+    for (int k = 0; k < fast_pattern_size; k += 2) {
+        int b = std::max(static_cast<int>(d[k + 1]), static_cast<int>(d[k + 2]));
+        b = std::max(b, static_cast<int>(d[k + 3]));
+        b = std::max(b, static_cast<int>(d[k + 4]));
+        b = std::max(b, static_cast<int>(d[k + 5]));
+        if (b >= b0) {
+            continue;
+        }
+        b = std::max(b, static_cast<int>(d[k + 6]));
+        b = std::max(b, static_cast<int>(d[k + 7]));
+        b = std::max(b, static_cast<int>(d[k + 8]));
+        b0 = std::min(b0, std::max(b, static_cast<int>(d[k])));
+        b0 = std::min(b0, std::max(b, static_cast<int>(d[k + 9])));
+    }
+
+    return -b0 - 1;
+}
+
+//! Segment test of a pixel (true if at least 9 contiguous pixels on the circle are darker or brighter than the threshold)
+bool fast_segment_test(const uchar* ptr, const int pixel[num_fast_offsets], const uchar* threshold_tab, const int threshold) {
+    const int v = ptr[0];
+    const uchar* tab = threshold_tab - v + 255;
+    int d = tab[ptr[pixel[0]]] | tab[ptr[pixel[8]]];
+    if (d == 0) {
+        return false;
+    }
+    d &= tab[ptr[pixel[2]]] | tab[ptr[pixel[10]]];
+    d &= tab[ptr[pixel[4]]] | tab[ptr[pixel[12]]];
+    d &= tab[ptr[pixel[6]]] | tab[ptr[pixel[14]]];
+    if (d == 0) {
+        return false;
+    }
+    d &= tab[ptr[pixel[1]]] | tab[ptr[pixel[9]]];
+    d &= tab[ptr[pixel[3]]] | tab[ptr[pixel[11]]];
+    d &= tab[ptr[pixel[5]]] | tab[ptr[pixel[13]]];
+    d &= tab[ptr[pixel[7]]] | tab[ptr[pixel[15]]];
+
+    if (d & 1) {
+        // darker
+        const int vt = v - threshold;
+        int count = 0;
+        for (int k = 0; k < num_fast_offsets; ++k) {
+            if (ptr[pixel[k]] < vt) {
+                if (++count > fast_half_pattern_size) {
+                    return true;
+                }
+            }
+            else {
+                count = 0;
+            }
+        }
+    }
+    if (d & 2) {
+        // brighter
+        const int vt = v + threshold;
+        int count = 0;
+        for (int k = 0; k < num_fast_offsets; ++k) {
+            if (vt < ptr[pixel[k]]) {
+                if (++count > fast_half_pattern_size) {
+                    return true;
+                }
+            }
+            else {
+                count = 0;
+            }
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+void orb_impl::compute_fast_scores(const cv::Mat& image, const int min_x, const int max_x, const int min_y, const int max_y,
+                                   const int threshold, uchar* scores) const {
+    const int thr = std::min(std::max(threshold, 0), 255);
+    const int width = max_x - min_x;
+
+    int pixel[num_fast_offsets];
+    make_fast_offsets(pixel, static_cast<int>(image.step));
+
+    uchar threshold_tab[512];
+    for (int i = -255; i <= 255; ++i) {
+        threshold_tab[i + 255] = static_cast<uchar>(i < -thr ? 1 : (thr < i ? 2 : 0));
+    }
+
+#ifdef USE_SSE_ORB
+    const __m128i delta = _mm_set1_epi8(static_cast<char>(0x80));
+    const __m128i t = _mm_set1_epi8(static_cast<char>(thr));
+    const __m128i k16 = _mm_set1_epi8(static_cast<char>(fast_half_pattern_size));
+#endif
+
+    for (int y = min_y; y < max_y; ++y) {
+        const uchar* const row = image.ptr<uchar>(y);
+        uchar* const scores_row = scores + (y - min_y) * width;
+        std::fill(scores_row, scores_row + width, 0);
+
+        int x = min_x;
+#ifdef USE_SSE_ORB
+        // test 16 pixels at once
+        for (; x + 16 <= max_x; x += 16) {
+            const uchar* ptr = row + x;
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+            // compare as signed integers
+            const __m128i v0 = _mm_xor_si128(_mm_adds_epu8(v, t), delta);
+            const __m128i v1 = _mm_xor_si128(_mm_subs_epu8(v, t), delta);
+
+            // at least two adjacent pixels of the four cardinal ones must pass the test
+            const __m128i x0 = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + pixel[0])), delta);
+            const __m128i x1 = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + pixel[4])), delta);
+            const __m128i x2 = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + pixel[8])), delta);
+            const __m128i x3 = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + pixel[12])), delta);
+            __m128i m0 = _mm_and_si128(_mm_cmpgt_epi8(x0, v0), _mm_cmpgt_epi8(x1, v0));
+            __m128i m1 = _mm_and_si128(_mm_cmpgt_epi8(v1, x0), _mm_cmpgt_epi8(v1, x1));
+            m0 = _mm_or_si128(m0, _mm_and_si128(_mm_cmpgt_epi8(x1, v0), _mm_cmpgt_epi8(x2, v0)));
+            m1 = _mm_or_si128(m1, _mm_and_si128(_mm_cmpgt_epi8(v1, x1), _mm_cmpgt_epi8(v1, x2)));
+            m0 = _mm_or_si128(m0, _mm_and_si128(_mm_cmpgt_epi8(x2, v0), _mm_cmpgt_epi8(x3, v0)));
+            m1 = _mm_or_si128(m1, _mm_and_si128(_mm_cmpgt_epi8(v1, x2), _mm_cmpgt_epi8(v1, x3)));
+            m0 = _mm_or_si128(m0, _mm_and_si128(_mm_cmpgt_epi8(x3, v0), _mm_cmpgt_epi8(x0, v0)));
+            m1 = _mm_or_si128(m1, _mm_and_si128(_mm_cmpgt_epi8(v1, x3), _mm_cmpgt_epi8(v1, x0)));
+            if (_mm_movemask_epi8(_mm_or_si128(m0, m1)) == 0) {
+                continue;
+            }
+
+            // count the contiguous pixels which are brighter (c0) or darker (c1)
+            __m128i c0 = _mm_setzero_si128();
+            __m128i c1 = _mm_setzero_si128();
+            __m128i max0 = _mm_setzero_si128();
+            __m128i max1 = _mm_setzero_si128();
+            for (int k = 0; k < num_fast_offsets; ++k) {
+                const __m128i xk = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr + pixel[k])), delta);
+                m0 = _mm_cmpgt_epi8(xk, v0);
+                m1 = _mm_cmpgt_epi8(v1, xk);
+                c0 = _mm_and_si128(_mm_sub_epi8(c0, m0), m0);
+                c1 = _mm_and_si128(_mm_sub_epi8(c1, m1), m1);
+                // the counts are not negative
+                max0 = _mm_max_epu8(max0, c0);
+                max1 = _mm_max_epu8(max1, c1);
+            }
+            unsigned int mask = _mm_movemask_epi8(_mm_cmpgt_epi8(_mm_max_epu8(max0, max1), k16));
+            for (int k = 0; mask != 0; ++k, mask >>= 1) {
+                if (mask & 1) {
+                    scores_row[x + k - min_x] = static_cast<uchar>(compute_fast_corner_score(ptr + k, pixel, thr));
+                }
+            }
+        }
+#endif
+        for (; x < max_x; ++x) {
+            const uchar* ptr = row + x;
+            if (fast_segment_test(ptr, pixel, threshold_tab, thr)) {
+                scores_row[x - min_x] = static_cast<uchar>(compute_fast_corner_score(ptr, pixel, thr));
+            }
+        }
+    }
+}
+
 } // namespace feature
 } // namespace stella_vslam
@@ -4,23 +4,48 @@
 #include <opencv2/core/mat.hpp>
 #include <opencv2/core/types.hpp>
 
+#include <cstdint>
+#include <vector>
+
 namespace stella_vslam {
 namespace feature {
 
 class orb_impl {
 public:
-    orb_impl();
+    /**
+     * Constructor
+     * @param num_angle_bins number of the orientation bins of the pre-rotated BRIEF pattern (0: rotate the pattern exactly for each keypoint)
+     */
+    explicit orb_impl(const unsigned int num_angle_bins = 0);
     float ic_angle(const cv::Mat& image, const cv::Point2f& point) const;
     void compute_orb_descriptor(const cv::KeyPoint& keypt, const cv::Mat& image, uchar* desc) const;
 
+    /**
+     * Compute the FAST-9 corner scores of the pixels in [min_x, max_x) x [min_y, max_y) (identical to those of cv::FAST)
+     * The scores are stored in the row-major order, and 0 is stored for the pixels which are not corners at the threshold.
+     * A corner at a higher threshold is a pixel whose score is not less than that threshold,
+     * so the detection with multiple thresholds requires only one pass with the lowest one.
+     */
+    void compute_fast_scores(const cv::Mat& image, const int min_x, const int max_x, const int min_y, const int max_y,
+                             const int threshold, uchar* scores) const;
+
     //! BRIEF orientation
     static constexpr unsigned int fast_patch_size_ = 31;
     //! half size of FAST patch
     static constexpr int fast_half_patch_size_ = fast_patch_size_ / 2;
 
 private:
+    //! Compute the descriptor with the pattern pre-rotated to the nearest orientation bin
+    void compute_binned_orb_descriptor(const cv::KeyPoint& keypt, const cv::Mat& image, uchar* desc) const;
+
     //! Index limitation that used for calculating of keypoint orientation
     std::vector<int> u_max_;
+
+    //! Number of the orientation bins (0: the binned pattern is not used)
+    const unsigned int num_angle_bins_;
+    //! Rounded coordinates of the rotated point pairs
+    //! (x of the first points, y of the first points, x of the second points and y of the second points for each bin)
+    std::vector<int8_t> binned_point_pairs_;
 };
 
 } // namespace feature
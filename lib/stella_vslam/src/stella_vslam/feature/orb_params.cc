@@ -10,9 +10,11 @@ orb_params::orb_params(const std::string& name)
     : orb_params(name, 1.2, 8, 20, 7) {}
 
 orb_params::orb_params(const std::string& name, const float scale_factor, const unsigned int num_levels,
-                       const unsigned int ini_fast_thr, const unsigned int min_fast_thr)
+                       const unsigned int ini_fast_thr, const unsigned int min_fast_thr,
+                       const unsigned int num_descriptor_angle_bins)
     : name_(name), scale_factor_(scale_factor), log_scale_factor_(std::log(scale_factor)),
-      num_levels_(num_levels), ini_fast_thr_(ini_fast_thr), min_fast_thr_(min_fast_thr) {
+      num_levels_(num_levels), ini_fast_thr_(ini_fast_thr), min_fast_thr_(min_fast_thr),
+      num_descriptor_angle_bins_(num_descriptor_angle_bins) {
     scale_factors_ = calc_scale_factors(num_levels_, scale_factor_);
     inv_scale_factors_ = calc_inv_scale_factors(num_levels_, scale_factor_);
     level_sigma_sq_ = calc_level_sigma_sq(num_levels_, scale_factor_);
@@ -24,14 +26,16 @@ orb_params::orb_params(const YAML::Node& yaml_node)
                  yaml_node["scale_factor"].as<float>(1.2),
                  yaml_node["num_levels"].as<unsigned int>(8),
                  yaml_node["ini_fast_threshold"].as<unsigned int>(20),
-                 yaml_node["min_fast_threshold"].as<unsigned int>(7)) {}
+                 yaml_node["min_fast_threshold"].as<unsigned int>(7),
+                 yaml_node["num_descriptor_angle_bins"].as<unsigned int>(0)) {}
 
 nlohmann::json orb_params::to_json() const {
     return {{"name", name_},
             {"scale_factor", scale_factor_},
             {"num_levels", num_levels_},
             {"ini_fast_threshold", ini_fast_thr_},
-            {"min_fast_threshold", min_fast_thr_}};
+            {"min_fast_threshold", min_fast_thr_},
+            {"num_descriptor_angle_bins", num_descriptor_angle_bins_}};
 }
 
 std::vector<float> orb_params::calc_scale_factors(const unsigned int num_scale_levels, const float scale_factor) {
@@ -75,6 +79,9 @@ std::ostream& operator<<(std::ostream& os, const orb_params& oparam) {
     os << "- number of levels: " << oparam.num_levels_ << std::endl;
     os << "- initial fast threshold: " << oparam.ini_fast_thr_ << std::endl;
     os << "- minimum fast threshold: " << oparam.min_fast_thr_ << std::endl;
+    if (oparam.num_descriptor_angle_bins_ > 0) {
+        os << "- number of descriptor angle bins: " << oparam.num_descriptor_angle_bins_ << std::endl;
+    }
     return os;
 }
 
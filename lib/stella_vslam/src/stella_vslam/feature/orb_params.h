@@ -13,7 +13,8 @@ struct orb_params {
 
     //! Constructor
     orb_params(const std::string& name, const float scale_factor, const unsigned int num_levels,
-               const unsigned int ini_fast_thr, const unsigned int min_fast_thr);
+               const unsigned int ini_fast_thr, const unsigned int min_fast_thr,
+               const unsigned int num_descriptor_angle_bins = 0);
     orb_params(const std::string& name);
 
     //! Constructor
@@ -32,6 +33,8 @@ struct orb_params {
     const unsigned int num_levels_ = 8;
     const unsigned int ini_fast_thr_ = 20;
     const unsigned int min_fast_thr_ = 7;
+    //! Number of the orientation bins of the pre-rotated BRIEF pattern (0: rotate the pattern exactly for each keypoint)
+    const unsigned int num_descriptor_angle_bins_ = 0;
 
     //! A list of the scale factor of each pyramid layer
     std::vector<float> scale_factors_;
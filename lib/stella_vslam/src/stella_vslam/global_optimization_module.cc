@@ -22,6 +22,7 @@ global_optimization_module::global_optimization_module(data::map_database* map_d
           util::yaml_optional_ref(yaml_node, "GlobalOptimizer")["use_huber_kernel"].as<bool>(false),
           util::yaml_optional_ref(yaml_node, "GlobalOptimizer")["verbose"].as<bool>(false))),
       map_db_(map_db),
+      keyfrms_queue_(util::yaml_optional_ref(yaml_node, "GlobalOptimizer")["keyframe_queue_capacity"].as<unsigned int>(256)),
       graph_optimizer_(new optimize::graph_optimizer(util::yaml_optional_ref(yaml_node, "GraphOptimizer"), fix_scale)),
       thr_neighbor_keyframes_(util::yaml_optional_ref(yaml_node, "GlobalOptimizer")["thr_neighbor_keyframes"].as<unsigned int>(15)) {
     spdlog::debug("CONSTRUCT: global_optimization_module");
@@ -59,14 +60,17 @@ bool global_optimization_module::loop_detector_is_enabled() const {
 }
 
 bool global_optimization_module::request_loop_closure(unsigned int keyfrm1_id, unsigned int keyfrm2_id) {
-    std::lock_guard<std::mutex> lock(mtx_loop_closure_request_);
-    if (loop_closure_is_requested_) {
-        spdlog::warn("Can not process new loop closure request while previous was not finished");
-        return false;
+    {
+        std::lock_guard<std::mutex> lock(mtx_loop_closure_request_);
+        if (loop_closure_is_requested_) {
+            spdlog::warn("Can not process new loop closure request while previous was not finished");
+            return false;
+        }
+        loop_closure_is_requested_ = true;
+        loop_closure_request_.keyfrm1_id_ = keyfrm1_id;
+        loop_closure_request_.keyfrm2_id_ = keyfrm2_id;
     }
-    loop_closure_is_requested_ = true;
-    loop_closure_request_.keyfrm1_id_ = keyfrm1_id;
-    loop_closure_request_.keyfrm2_id_ = keyfrm2_id;
+    notify_wakeup();
     return true;
 }
 
@@ -87,7 +91,7 @@ void global_optimization_module::finish_loop_closure_request() {
 
 bool global_optimization_module::loop_closure(const loop_closure_request& request) {
     {
-        std::lock_guard<std::mutex> lock(data::map_database::mtx_database_);
+        util::shared_lock lock(data::map_database::mtx_database_);
         unsigned int curr_keyfrm_id = std::max(request.keyfrm1_id_, request.keyfrm2_id_);
         unsigned int candidate_keyfrm_id = std::min(request.keyfrm1_id_, request.keyfrm2_id_);
         // not to be removed during loop detection and correction
@@ -104,14 +108,15 @@ bool global_optimization_module::loop_closure(const loop_closure_request& reques
             return false;
         }
         loop_detector_->add_loop_candidate(candidate_keyfrm);
+        loop_detector_->snapshot_candidates();
+    }
 
-        // validate candidates and select ONE candidate from them
-        if (!loop_detector_->validate_candidates()) {
-            // could not find
-            // allow the removal of the current keyframe
-            cur_keyfrm_->set_to_be_erased();
-            return false;
-        }
+    // validate candidates and select ONE candidate from them (without the map database lock)
+    if (!loop_detector_->validate_candidates()) {
+        // could not find
+        // allow the removal of the current keyframe
+        cur_keyfrm_->set_to_be_erased();
+        return false;
     }
 
     correct_loop();
@@ -125,7 +130,14 @@ void global_optimization_module::run() {
     is_terminated_ = false;
 
     while (true) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        // wait until a keyframe is queued or loop closure/pause/reset/terminate is requested
+        {
+            std::unique_lock<std::mutex> lock(mtx_wakeup_);
+            cv_wakeup_.wait(lock, [this] {
+                return terminate_is_requested() || loop_closure_is_requested() || pause_is_requested()
+                       || reset_is_requested() || keyframe_is_queued();
+            });
+        }
 
         // check if termination is requested
         if (terminate_is_requested()) {
@@ -136,7 +148,10 @@ void global_optimization_module::run() {
 
         // check if loop closure is requested
         if (loop_closure_is_requested()) {
-            loop_closure(get_loop_closure_request());
+            if (!loop_closure(get_loop_closure_request())) {
+                // discard the failed request instead of retrying it in every iteration
+                finish_loop_closure_request();
+            }
         }
 
         // check if pause is requested
@@ -144,9 +159,10 @@ void global_optimization_module::run() {
             // pause and wait
             pause();
             // check if termination or reset is requested during pause
-            while (is_paused() && !terminate_is_requested() && !reset_is_requested()) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(3));
-            }
+            std::unique_lock<std::mutex> lock(mtx_wakeup_);
+            cv_wakeup_.wait(lock, [this] {
+                return !is_paused() || terminate_is_requested() || reset_is_requested();
+            });
         }
 
         // check if reset is requested
@@ -163,13 +179,16 @@ void global_optimization_module::run() {
 
         // dequeue the keyframe from the queue -> cur_keyfrm_
         {
-            std::lock_guard<std::mutex> lock(mtx_keyfrm_queue_);
-            cur_keyfrm_ = keyfrms_queue_.front();
-            keyfrms_queue_.pop_front();
+            queued_keyframe queued;
+            if (!keyfrms_queue_.try_pop(queued)) {
+                continue;
+            }
+            cur_keyfrm_ = queued.keyfrm_;
+            queue_latency_histogram_.add(std::chrono::steady_clock::now() - queued.queued_time_);
         }
 
         {
-            std::lock_guard<std::mutex> lock(data::map_database::mtx_database_);
+            util::shared_lock lock(data::map_database::mtx_database_);
             // not to be removed during loop detection and correction
             cur_keyfrm_->set_not_to_be_erased();
 
@@ -184,28 +203,67 @@ void global_optimization_module::run() {
                 continue;
             }
 
-            // validate candidates and select ONE candidate from them
-            if (!loop_detector_->validate_candidates()) {
-                // could not find
-                // allow the removal of the current keyframe
-                cur_keyfrm_->set_to_be_erased();
-                continue;
-            }
+            // take a snapshot of the candidates, which cannot be erased during the validation
+            loop_detector_->snapshot_candidates();
+        }
+
+        // validate candidates and select ONE candidate from them
+        // (the map database is not locked so that the tracking and the mapping are not blocked during the Sim3 verification)
+        if (!loop_detector_->validate_candidates()) {
+            // could not find
+            // allow the removal of the current keyframe
+            cur_keyfrm_->set_to_be_erased();
+            continue;
         }
 
         correct_loop();
     }
 
+    spdlog::debug("global optimization module: queue latency {:.3f} ms (mean), {:.3f} ms (99th percentile)",
+                  queue_latency_histogram_.get_mean_ms(), queue_latency_histogram_.get_percentile_ms(99.0));
     spdlog::info("terminate global optimization module");
 }
 
 void global_optimization_module::queue_keyframe(const std::shared_ptr<data::keyframe>& keyfrm) {
-    std::lock_guard<std::mutex> lock(mtx_keyfrm_queue_);
-    keyfrms_queue_.push_back(keyfrm);
+    // wait while the queue is full, unless this module stops dequeuing.
+    // (the mapping module must not keep waiting when the loop correction requests it to pause)
+    const bool queued = keyfrms_queue_.push(queued_keyframe{keyfrm, std::chrono::steady_clock::now()},
+                                            [this] {
+                                                return terminate_is_requested() || is_terminated() || reset_is_requested()
+                                                       || pause_is_requested() || mapper_->pause_is_requested();
+                                            });
+    if (!queued) {
+        spdlog::warn("global optimization module: keyframe {} is not used for loop detection ({} keyframes dropped in total)",
+                     keyfrm->id_, keyfrms_queue_.get_metrics().num_dropped_);
+        return;
+    }
+    notify_wakeup();
+}
+
+const util::latency_histogram& global_optimization_module::get_queue_latency_histogram() const {
+    return queue_latency_histogram_;
+}
+
+util::queue_metrics global_optimization_module::get_queue_metrics() const {
+    return keyfrms_queue_.get_metrics();
+}
+
+void global_optimization_module::notify_wakeup() {
+    // lock the mutex once so that the notification is not lost
+    // between the evaluation of the wakeup condition and the wait
+    {
+        std::lock_guard<std::mutex> lock(mtx_wakeup_);
+    }
+    cv_wakeup_.notify_all();
+    // the mapping module waiting for room in the queue gives up when this module is reset, paused or terminated
+    notify_keyframe_producer();
+}
+
+void global_optimization_module::notify_keyframe_producer() {
+    keyfrms_queue_.notify_producer();
 }
 
 bool global_optimization_module::keyframe_is_queued() const {
-    std::lock_guard<std::mutex> lock(mtx_keyfrm_queue_);
     return !keyfrms_queue_.empty();
 }
 
@@ -251,7 +309,7 @@ void global_optimization_module::correct_loop() {
     std::unordered_map<unsigned int, unsigned int> found_lm_to_ref_keyfrm_id;
     const auto g2o_Sim3_cw_after_correction = loop_detector_->get_Sim3_world_to_current();
     {
-        std::lock_guard<std::mutex> lock(data::map_database::mtx_database_);
+        util::exclusive_lock lock(data::map_database::mtx_database_);
 
         // camera pose of the current keyframe BEFORE loop correction
         const Mat44_t cam_pose_wc_before_correction = cur_keyfrm_->get_pose_wc();
@@ -402,7 +460,7 @@ void global_optimization_module::replace_duplicated_landmarks(const std::vector<
     nondeterministic::unordered_map<std::shared_ptr<data::landmark>, std::shared_ptr<data::landmark>> replaced_lms;
     // resolve duplications of landmarks between the current keyframe and the loop candidate
     {
-        std::lock_guard<std::mutex> lock(data::map_database::mtx_database_);
+        util::exclusive_lock lock(data::map_database::mtx_database_);
 
         for (unsigned int idx = 0; idx < cur_keyfrm_->frm_obs_.undist_keypts_.size(); ++idx) {
             auto curr_match_lm_in_cand = curr_match_lms_observed_in_cand.at(idx);
@@ -461,7 +519,7 @@ void global_optimization_module::replace_duplicated_landmarks(const std::vector<
         const Vec3_t trans_cw = Sim3_nw_after_correction.block<3, 1>(0, 3) / s_cw;
         fuse_matcher.detect_duplication(neighbor, rot_cw, trans_cw, curr_match_lms_observed_in_cand_covis, 4.0, duplicated_lms_in_keyfrm, new_connections);
 
-        std::lock_guard<std::mutex> lock(data::map_database::mtx_database_);
+        util::exclusive_lock lock(data::map_database::mtx_database_);
 
         for (const auto& best_idx_lm : new_connections) {
             const auto& best_idx = best_idx_lm.first;
@@ -517,12 +575,17 @@ auto global_optimization_module::extract_new_connections(const std::vector<std::
 }
 
 std::shared_future<void> global_optimization_module::async_reset() {
-    std::lock_guard<std::mutex> lock(mtx_reset_);
-    reset_is_requested_ = true;
-    if (!future_reset_.valid()) {
-        future_reset_ = promise_reset_.get_future().share();
+    std::shared_future<void> future_reset;
+    {
+        std::lock_guard<std::mutex> lock(mtx_reset_);
+        reset_is_requested_ = true;
+        if (!future_reset_.valid()) {
+            future_reset_ = promise_reset_.get_future().share();
+        }
+        future_reset = future_reset_;
     }
-    return future_reset_;
+    notify_wakeup();
+    return future_reset;
 }
 
 bool global_optimization_module::reset_is_requested() const {
@@ -533,7 +596,9 @@ bool global_optimization_module::reset_is_requested() const {
 void global_optimization_module::reset() {
     std::lock_guard<std::mutex> lock(mtx_reset_);
     spdlog::info("reset global optimization module");
-    keyfrms_queue_.clear();
+    // discard the queued keyframes
+    queued_keyframe queued;
+    while (keyfrms_queue_.try_pop(queued)) {}
     loop_detector_->set_loop_correct_keyframe_id(0);
     reset_is_requested_ = false;
     promise_reset_.set_value();
@@ -542,12 +607,17 @@ void global_optimization_module::reset() {
 }
 
 std::shared_future<void> global_optimization_module::async_pause() {
-    std::lock_guard<std::mutex> lock1(mtx_pause_);
-    pause_is_requested_ = true;
-    if (!future_pause_.valid()) {
-        future_pause_ = promise_pause_.get_future().share();
+    std::shared_future<void> future_pause;
+    {
+        std::lock_guard<std::mutex> lock1(mtx_pause_);
+        pause_is_requested_ = true;
+        if (!future_pause_.valid()) {
+            future_pause_ = promise_pause_.get_future().share();
+        }
+        future_pause = future_pause_;
     }
-    return future_pause_;
+    notify_wakeup();
+    return future_pause;
 }
 
 bool global_optimization_module::pause_is_requested() const {
@@ -570,27 +640,35 @@ void global_optimization_module::pause() {
 }
 
 void global_optimization_module::resume() {
-    std::lock_guard<std::mutex> lock1(mtx_pause_);
-    std::lock_guard<std::mutex> lock2(mtx_terminate_);
+    {
+        std::lock_guard<std::mutex> lock1(mtx_pause_);
+        std::lock_guard<std::mutex> lock2(mtx_terminate_);
 
-    // if it has been already terminated, cannot resume
-    if (is_terminated_) {
-        return;
-    }
+        // if it has been already terminated, cannot resume
+        if (is_terminated_) {
+            return;
+        }
 
-    is_paused_ = false;
-    pause_is_requested_ = false;
+        is_paused_ = false;
+        pause_is_requested_ = false;
 
-    spdlog::info("resume global optimization module");
+        spdlog::info("resume global optimization module");
+    }
+    notify_wakeup();
 }
 
 std::shared_future<void> global_optimization_module::async_terminate() {
-    std::lock_guard<std::mutex> lock(mtx_terminate_);
-    terminate_is_requested_ = true;
-    if (!future_terminate_.valid()) {
-        future_terminate_ = promise_terminate_.get_future().share();
+    std::shared_future<void> future_terminate;
+    {
+        std::lock_guard<std::mutex> lock(mtx_terminate_);
+        terminate_is_requested_ = true;
+        if (!future_terminate_.valid()) {
+            future_terminate_ = promise_terminate_.get_future().share();
+        }
+        future_terminate = future_terminate_;
     }
-    return future_terminate_;
+    notify_wakeup();
+    return future_terminate;
 }
 
 bool global_optimization_module::is_terminated() const {
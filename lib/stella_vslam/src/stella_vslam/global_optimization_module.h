@@ -7,12 +7,15 @@
 #include "stella_vslam/module/loop_detector.h"
 #include "stella_vslam/module/loop_bundle_adjuster.h"
 #include "stella_vslam/optimize/graph_optimizer.h"
+#include "stella_vslam/util/latency_histogram.h"
+#include "stella_vslam/util/spsc_queue.h"
 
-#include <list>
 #include <mutex>
+#include <chrono>
 #include <thread>
 #include <memory>
 #include <future>
+#include <condition_variable>
 
 namespace stella_vslam {
 
@@ -63,8 +66,21 @@ public:
     void run();
 
     //! Queue a keyframe to the BoW database
+    //! (NOTE: this function must be called only from the mapping thread. It waits while the queue is full,
+    //!  and the keyframe is dropped only if this module or the mapping module is requested to pause, reset or terminate meanwhile.
+    //!  The number of the dropped keyframes is reported in the queue metrics)
     void queue_keyframe(const std::shared_ptr<data::keyframe>& keyfrm);
 
+    //! Wake up the mapping module waiting for room in the queue, so that it checks whether to give up
+    //! (called when the mapping module is requested to pause)
+    void notify_keyframe_producer();
+
+    //! Get the histogram of the time from queueing a keyframe to starting its loop detection
+    const util::latency_histogram& get_queue_latency_histogram() const;
+
+    //! Get the back-pressure metrics of the keyframe queue
+    util::queue_metrics get_queue_metrics() const;
+
     //-----------------------------------------
     // management for reset process
 
@@ -240,14 +256,33 @@ private:
     //-----------------------------------------
     // keyframe queue
 
-    //! mutex for access to keyframe queue
-    mutable std::mutex mtx_keyfrm_queue_;
-
     //! Check if keyframe is queued
     bool keyframe_is_queued() const;
 
-    //! queue for keyframes
-    std::list<std::shared_ptr<data::keyframe>> keyfrms_queue_;
+    //! keyframe and the time when it was queued
+    struct queued_keyframe {
+        std::shared_ptr<data::keyframe> keyfrm_;
+        std::chrono::steady_clock::time_point queued_time_;
+    };
+
+    //! queue for keyframes (pushed by the mapping thread, and popped by the global optimization thread)
+    util::spsc_queue<queued_keyframe> keyfrms_queue_;
+
+    //! histogram of the time from queueing a keyframe to starting its loop detection
+    util::latency_histogram queue_latency_histogram_;
+
+    //-----------------------------------------
+    // wakeup of the main loop
+
+    //! mutex for the wakeup condition
+    std::mutex mtx_wakeup_;
+
+    //! condition variable which is notified when a keyframe is queued or loop closure/pause/resume/reset/terminate is requested
+    std::condition_variable cv_wakeup_;
+
+    //! Notify the main loop that the wakeup condition may have changed
+    //! (NOTE: call this after releasing the other mutexes of this module)
+    void notify_wakeup();
 
     std::shared_ptr<data::keyframe> cur_keyfrm_ = nullptr;
 
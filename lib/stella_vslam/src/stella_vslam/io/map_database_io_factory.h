@@ -20,13 +20,14 @@ namespace io {
 
 class map_database_io_factory {
 public:
-    static std::shared_ptr<map_database_io_base> create(const std::string& map_format) {
+    static std::shared_ptr<map_database_io_base> create(const std::string& map_format, const bool save_bow_vectors = false,
+                                                        data::bow_vocabulary* bow_vocab = nullptr) {
         std::shared_ptr<map_database_io_base> map_database_io;
         if (map_format == "sqlite3") {
             map_database_io = std::make_shared<io::map_database_io_sqlite3>();
         }
         else if (map_format == "msgpack") {
-            map_database_io = std::make_shared<io::map_database_io_msgpack>();
+            map_database_io = std::make_shared<io::map_database_io_msgpack>(save_bow_vectors, bow_vocab);
         }
         else {
             throw std::runtime_error("Invalid map format: " + map_format);
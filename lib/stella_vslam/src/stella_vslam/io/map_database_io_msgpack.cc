@@ -11,22 +11,343 @@
 #include <nlohmann/json.hpp>
 
 #include <fstream>
+#include <functional>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define STELLA_VSLAM_MSGPACK_USE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace stella_vslam {
 namespace io {
 
+namespace {
+
+/**
+ * Read-only view of a whole file.
+ * The file is memory-mapped if possible, otherwise it is read into a buffer at once.
+ */
+class file_view {
+public:
+    explicit file_view(const std::string& path) {
+#ifdef STELLA_VSLAM_MSGPACK_USE_MMAP
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && 0 < st.st_size) {
+            void* addr = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                // the file is decoded from the beginning to the end
+                ::madvise(addr, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+                mapped_ = addr;
+                data_ = static_cast<const uint8_t*>(addr);
+                size_ = static_cast<size_t>(st.st_size);
+                is_open_ = true;
+            }
+        }
+        ::close(fd);
+        if (is_open_) {
+            return;
+        }
+#endif
+        std::ifstream ifs(path, std::ios::in | std::ios::binary | std::ios::ate);
+        if (!ifs.is_open()) {
+            return;
+        }
+        buffer_.resize(static_cast<size_t>(ifs.tellg()));
+        ifs.seekg(0, std::ios::beg);
+        ifs.read(reinterpret_cast<char*>(buffer_.data()), buffer_.size());
+        if (!ifs) {
+            return;
+        }
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+        is_open_ = true;
+    }
+
+    ~file_view() {
+#ifdef STELLA_VSLAM_MSGPACK_USE_MMAP
+        if (mapped_) {
+            ::munmap(mapped_, size_);
+        }
+#endif
+    }
+
+    file_view(const file_view&) = delete;
+    file_view& operator=(const file_view&) = delete;
+
+    bool is_open() const { return is_open_; }
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    bool is_open_ = false;
+    void* mapped_ = nullptr;
+    std::vector<uint8_t> buffer_;
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+/**
+ * Builder of a JSON value from the SAX events of the value
+ */
+class json_builder {
+public:
+    explicit json_builder(nlohmann::json& root)
+        : root_(root) {}
+
+    void value(nlohmann::json&& value) {
+        add(std::move(value));
+    }
+
+    void start_container(nlohmann::json&& empty_container) {
+        containers_.push_back(add(std::move(empty_container)));
+    }
+
+    void end_container() {
+        containers_.pop_back();
+    }
+
+    void key(const std::string& key) {
+        key_ = key;
+    }
+
+private:
+    //! Add the value to the current container (or set it to the root) and return its address
+    nlohmann::json* add(nlohmann::json&& value) {
+        if (containers_.empty()) {
+            root_ = std::move(value);
+            return &root_;
+        }
+        auto& container = *containers_.back();
+        if (container.is_array()) {
+            container.push_back(std::move(value));
+            return &container.back();
+        }
+        auto& element = container[key_];
+        element = std::move(value);
+        return &element;
+    }
+
+    nlohmann::json& root_;
+    //! containers which are being built
+    std::vector<nlohmann::json*> containers_;
+    //! key of the next value in the current object
+    std::string key_;
+};
+
+/**
+ * SAX handler which decodes the top-level values of a map file, and the elements of the "keyframes" and "landmarks" objects one by one.
+ * A JSON object is constructed only for each decoded value, so the whole JSON tree of the map is never held in memory.
+ * The top-level values and the elements which are not requested are skipped.
+ */
+class map_sax_handler : public nlohmann::json_sax<nlohmann::json> {
+public:
+    //! callback for a decoded value (section: "" for the top-level values, key: key of the value in the section)
+    using callback_t = std::function<void(const std::string& section, const std::string& key, const nlohmann::json& value)>;
+
+    map_sax_handler(const bool decode_top_level_values, const bool decode_elements, const callback_t& callback)
+        : decode_top_level_values_(decode_top_level_values), decode_elements_(decode_elements), callback_(callback) {}
+
+    bool null() override {
+        return handle_value(nlohmann::json(nullptr));
+    }
+
+    bool boolean(bool val) override {
+        return handle_value(nlohmann::json(val));
+    }
+
+    bool number_integer(number_integer_t val) override {
+        return handle_value(nlohmann::json(val));
+    }
+
+    bool number_unsigned(number_unsigned_t val) override {
+        return handle_value(nlohmann::json(val));
+    }
+
+    bool number_float(number_float_t val, const string_t&) override {
+        return handle_value(nlohmann::json(val));
+    }
+
+    bool string(string_t& val) override {
+        return handle_value(nlohmann::json(std::move(val)));
+    }
+
+    bool start_object(std::size_t) override {
+        if (!builder_ && depth_ == 1 && is_streamed_section(section_)) {
+            // enter the object whose elements are decoded one by one
+            ++depth_;
+            return true;
+        }
+        return handle_container_begin(nlohmann::json::object());
+    }
+
+    bool key(string_t& val) override {
+        if (builder_) {
+            builder_->key(val);
+            return true;
+        }
+        if (skip_depth_ == 0) {
+            if (depth_ == 1) {
+                section_ = val;
+            }
+            else if (depth_ == 2) {
+                element_key_ = val;
+            }
+        }
+        return true;
+    }
+
+    bool end_object() override {
+        return handle_container_end();
+    }
+
+    bool start_array(std::size_t) override {
+        return handle_container_begin(nlohmann::json::array());
+    }
+
+    bool end_array() override {
+        return handle_container_end();
+    }
+
+    bool parse_error(std::size_t position, const std::string& last_token, const nlohmann::json::exception& ex) override {
+        spdlog::critical("failed to decode the MessagePack file at byte {} (last token: {}): {}", position, last_token, ex.what());
+        return false;
+    }
+
+private:
+    static bool is_streamed_section(const std::string& section) {
+        return section == "keyframes" || section == "landmarks";
+    }
+
+    //! Check if the value which starts at the current position should be decoded
+    bool value_is_requested() const {
+        if (depth_ == 1) {
+            return decode_top_level_values_ && !is_streamed_section(section_);
+        }
+        if (depth_ == 2) {
+            return decode_elements_;
+        }
+        return false;
+    }
+
+    bool handle_value(nlohmann::json&& value) {
+        if (builder_) {
+            builder_->value(std::move(value));
+            return true;
+        }
+        if (skip_depth_ == 0 && value_is_requested()) {
+            // a scalar value is decoded immediately
+            emit(value);
+        }
+        return true;
+    }
+
+    bool handle_container_begin(nlohmann::json&& empty_container) {
+        if (builder_) {
+            ++builder_depth_;
+            builder_->start_container(std::move(empty_container));
+            return true;
+        }
+        if (skip_depth_ == 0 && value_is_requested()) {
+            value_ = nlohmann::json();
+            builder_.reset(new json_builder(value_));
+            builder_depth_ = 1;
+            builder_->start_container(std::move(empty_container));
+            return true;
+        }
+        if (skip_depth_ == 0 && depth_ == 0) {
+            // the root object
+            ++depth_;
+            return true;
+        }
+        ++skip_depth_;
+        return true;
+    }
+
+    bool handle_container_end() {
+        if (builder_) {
+            builder_->end_container();
+            if (--builder_depth_ == 0) {
+                builder_.reset();
+                emit(value_);
+                value_ = nlohmann::json();
+            }
+            return true;
+        }
+        if (0 < skip_depth_) {
+            --skip_depth_;
+            return true;
+        }
+        --depth_;
+        return true;
+    }
+
+    void emit(const nlohmann::json& value) {
+        if (depth_ == 1) {
+            callback_("", section_, value);
+        }
+        else {
+            callback_(section_, element_key_, value);
+        }
+    }
+
+    const bool decode_top_level_values_;
+    const bool decode_elements_;
+    const callback_t callback_;
+
+    //! depth of the objects which are not skipped (1: in the root object, 2: in the "keyframes" or "landmarks" object)
+    unsigned int depth_ = 0;
+    //! depth of the containers which are being skipped
+    unsigned int skip_depth_ = 0;
+    //! key in the root object
+    std::string section_;
+    //! key in the "keyframes" or "landmarks" object
+    std::string element_key_;
+
+    //! builder of the value which is being decoded
+    std::unique_ptr<json_builder> builder_;
+    //! depth of the containers in the value which is being decoded
+    unsigned int builder_depth_ = 0;
+    //! value which is being decoded
+    nlohmann::json value_;
+};
+
+bool decode_msgpack(const file_view& file, map_sax_handler& handler) {
+    const auto first = file.data();
+    const auto last = file.data() + file.size();
+#if NLOHMANN_JSON_VERSION_MAJOR > 3 || (NLOHMANN_JSON_VERSION_MAJOR == 3 && NLOHMANN_JSON_VERSION_MINOR >= 8)
+    return nlohmann::json::sax_parse(first, last, &handler, nlohmann::json::input_format_t::msgpack);
+#else
+    // the iterator range overload of sax_parse() accepts the input format since 3.8
+    return nlohmann::json::sax_parse({first, last}, &handler, nlohmann::json::input_format_t::msgpack);
+#endif
+}
+
+} // namespace
+
 bool map_database_io_msgpack::save(const std::string& path,
                                    const data::camera_database* const cam_db,
                                    const data::orb_params_database* const orb_params_db,
                                    const data::map_database* const map_db) {
-    std::lock_guard<std::mutex> lock(data::map_database::mtx_database_);
+    util::shared_lock lock(data::map_database::mtx_database_);
 
     assert(cam_db && orb_params_db && map_db);
     const auto cameras = cam_db->to_json();
     const auto orb_params = orb_params_db->to_json();
+    // the BoW vectors are saved only with the fingerprint of the vocabulary, so that they are not used with another one
+    const bool save_bow_vectors = save_bow_vectors_ && bow_vocab_;
+    if (save_bow_vectors_ && !bow_vocab_) {
+        spdlog::warn("BoW vectors are not saved because the vocabulary is not loaded");
+    }
     nlohmann::json keyfrms;
     nlohmann::json landmarks;
-    map_db->to_json(keyfrms, landmarks);
+    map_db->to_json(keyfrms, landmarks, save_bow_vectors);
 
     nlohmann::json json{{"cameras", cameras},
                         {"orb_params", orb_params},
@@ -34,6 +355,9 @@ bool map_database_io_msgpack::save(const std::string& path,
                         {"landmarks", landmarks},
                         {"keyframe_next_id", static_cast<unsigned int>(map_db->next_keyframe_id_)},
                         {"landmark_next_id", static_cast<unsigned int>(map_db->next_landmark_id_)}};
+    if (save_bow_vectors) {
+        json["bow_vocab_fingerprint"] = data::bow_vocabulary_util::get_fingerprint(bow_vocab_);
+    }
 
     std::ofstream ofs(path, std::ios::out | std::ios::binary);
 
@@ -56,50 +380,115 @@ bool map_database_io_msgpack::load(const std::string& path,
                                    data::map_database* map_db,
                                    data::bow_database* bow_db,
                                    data::bow_vocabulary* bow_vocab) {
-    std::lock_guard<std::mutex> lock(data::map_database::mtx_database_);
+    util::exclusive_lock lock(data::map_database::mtx_database_);
     assert(cam_db && orb_params_db && map_db && bow_db && bow_vocab);
 
-    // load binary bytes
+    // map the file (or read it at once)
 
-    std::ifstream ifs(path, std::ios::in | std::ios::binary);
-    if (!ifs.is_open()) {
+    const file_view file(path);
+    if (!file.is_open()) {
         spdlog::critical("cannot load the file at {}", path);
         return false;
     }
 
     spdlog::info("load the MessagePack file of database from {}", path);
-    std::vector<uint8_t> msgpack;
-    while (true) {
-        uint8_t buffer;
-        ifs.read(reinterpret_cast<char*>(&buffer), sizeof(uint8_t));
-        if (ifs.eof()) {
-            break;
+
+    // The keyframes and the landmarks are decoded one by one without constructing the JSON tree of the whole map.
+    // The cameras and the ORB parameters are needed to construct the keyframes, but they are not always stored before the keyframes,
+    // so the small top-level values are decoded in the first pass, and the keyframes and the landmarks are decoded in the second pass.
+
+    // the keys which save() always writes are required as in the JSON tree of the whole map
+    nlohmann::json json_header = nlohmann::json::object();
+    unsigned int keyfrm_next_id = 0;
+    unsigned int landmark_next_id = 0;
+    std::string bow_vocab_fingerprint;
+    {
+        map_sax_handler handler(true, false, [&](const std::string&, const std::string& key, const nlohmann::json& value) {
+            if (key == "cameras" || key == "orb_params") {
+                json_header[key] = value;
+            }
+            else if (key == "keyframe_next_id") {
+                keyfrm_next_id = value.get<unsigned int>();
+            }
+            else if (key == "landmark_next_id") {
+                landmark_next_id = value.get<unsigned int>();
+            }
+            else if (key == "bow_vocab_fingerprint") {
+                bow_vocab_fingerprint = value.get<std::string>();
+            }
+        });
+        // (the whole file is decoded in this pass, so a broken file is rejected before the databases are modified)
+        if (!decode_msgpack(file, handler)) {
+            return false;
         }
-        msgpack.push_back(buffer);
     }
-    ifs.close();
+    const auto& json_cameras = json_header.at("cameras");
+    const auto& json_orb_params = json_header.at("orb_params");
 
-    // parse into JSON
-
-    const auto json = nlohmann::json::from_msgpack(msgpack);
+    // the stored BoW vectors are used only if they were computed with the same vocabulary
+    bool use_stored_bow = false;
+    if (!bow_vocab_fingerprint.empty()) {
+        use_stored_bow = bow_vocab_fingerprint == data::bow_vocabulary_util::get_fingerprint(bow_vocab);
+        if (!use_stored_bow) {
+            spdlog::warn("the stored BoW vectors were computed with another vocabulary, so they are recomputed");
+        }
+    }
 
     // load database
-    const auto json_cameras = json.at("cameras");
+    // (the cameras and the ORB parameters are kept even if the keyframes fail to be loaded, because they do not replace the existing ones)
     cam_db->from_json(json_cameras);
-    const auto json_orb_params = json.at("orb_params");
     orb_params_db->from_json(json_orb_params);
-    const auto json_keyfrms = json.at("keyframes");
-    const auto json_landmarks = json.at("landmarks");
-    map_db->from_json(cam_db, orb_params_db, bow_vocab, json_keyfrms, json_landmarks);
+
+    // the landmarks refer to the keyframes, so they are held only if they are stored before the keyframes
+    // (they are stored after the keyframes in the files written by save(), because the keys of nlohmann::json objects are sorted)
+    std::vector<std::pair<unsigned int, nlohmann::json>> pending_json_landmarks;
+    unsigned int num_keyfrms = 0;
+    unsigned int num_landmarks = 0;
+    bool decoded = false;
+    try {
+        spdlog::info("decoding keyframes and landmarks to load");
+        map_sax_handler handler(false, true, [&](const std::string& section, const std::string& key, const nlohmann::json& value) {
+            const auto id_in_storage = std::stoi(key);
+            assert(0 <= id_in_storage);
+            if (section == "keyframes") {
+                map_db->load_keyframe_from_json(cam_db, orb_params_db, bow_vocab, id_in_storage, value, use_stored_bow);
+                ++num_keyfrms;
+            }
+            else if (0 < num_keyfrms) {
+                map_db->load_landmark_from_json(id_in_storage, value);
+                ++num_landmarks;
+            }
+            else {
+                pending_json_landmarks.emplace_back(id_in_storage, value);
+            }
+        });
+        decoded = decode_msgpack(file, handler);
+        if (decoded) {
+            for (const auto& id_json_landmark : pending_json_landmarks) {
+                map_db->load_landmark_from_json(id_json_landmark.first, id_json_landmark.second);
+                ++num_landmarks;
+            }
+            pending_json_landmarks.clear();
+            spdlog::info("decoded {} keyframes and {} landmarks", num_keyfrms, num_landmarks);
+
+            map_db->finish_loading_from_json(bow_vocab);
+        }
+    }
+    catch (...) {
+        // only the keyframes and the landmarks of this file are discarded (the map might have been loaded into another one)
+        map_db->abort_loading_from_json();
+        throw;
+    }
+    if (!decoded) {
+        map_db->abort_loading_from_json();
+        return false;
+    }
     // load next ID
-    map_db->next_keyframe_id_ += json.at("keyframe_next_id").get<unsigned int>();
-    map_db->next_landmark_id_ += json.at("landmark_next_id").get<unsigned int>();
+    map_db->next_keyframe_id_ += keyfrm_next_id;
+    map_db->next_landmark_id_ += landmark_next_id;
 
     // update bow database
-    const auto keyfrms = map_db->get_all_keyframes();
-    for (const auto& keyfrm : keyfrms) {
-        bow_db->add_keyframe(keyfrm);
-    }
+    bow_db->add_keyframes(map_db->get_all_keyframes());
     return true;
 }
 
@@ -20,8 +20,11 @@ class map_database_io_msgpack : public map_database_io_base {
 public:
     /**
      * Constructor
+     * @param save_bow_vectors if true, BoW vectors of the keyframes are also saved so that they need not be recomputed on load
+     * @param bow_vocab vocabulary which the BoW vectors are computed with (its fingerprint is saved with the BoW vectors)
      */
-    map_database_io_msgpack() = default;
+    explicit map_database_io_msgpack(const bool save_bow_vectors = false, data::bow_vocabulary* bow_vocab = nullptr)
+        : save_bow_vectors_(save_bow_vectors), bow_vocab_(bow_vocab) {}
 
     /**
      * Destructor
@@ -45,6 +48,12 @@ public:
               data::map_database* map_db,
               data::bow_database* bow_db,
               data::bow_vocabulary* bow_vocab) override;
+
+private:
+    //! save BoW vectors of the keyframes or not
+    const bool save_bow_vectors_;
+    //! vocabulary which the BoW vectors are computed with
+    data::bow_vocabulary* const bow_vocab_;
 };
 
 } // namespace io
@@ -19,7 +19,7 @@ bool map_database_io_sqlite3::save(const std::string& path,
                                    const data::camera_database* const cam_db,
                                    const data::orb_params_database* const orb_params_db,
                                    const data::map_database* const map_db) {
-    std::lock_guard<std::mutex> lock(data::map_database::mtx_database_);
+    util::shared_lock lock(data::map_database::mtx_database_);
 
     assert(cam_db && map_db);
 
@@ -52,7 +52,7 @@ bool map_database_io_sqlite3::load(const std::string& path,
                                    data::map_database* map_db,
                                    data::bow_database* bow_db,
                                    data::bow_vocabulary* bow_vocab) {
-    std::lock_guard<std::mutex> lock(data::map_database::mtx_database_);
+    util::exclusive_lock lock(data::map_database::mtx_database_);
     assert(cam_db && map_db);
 
     // Open database
@@ -70,10 +70,7 @@ bool map_database_io_sqlite3::load(const std::string& path,
 
     // update bow database
     if (ok && bow_db) {
-        const auto keyfrms = map_db->get_all_keyframes();
-        for (const auto& keyfrm : keyfrms) {
-            bow_db->add_keyframe(keyfrm);
-        }
+        bow_db->add_keyframes(map_db->get_all_keyframes());
     }
 
     sqlite3_close(db);
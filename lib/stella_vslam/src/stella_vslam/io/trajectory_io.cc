@@ -18,64 +18,57 @@ trajectory_io::trajectory_io(data::map_database* map_db)
     : map_db_(map_db) {}
 
 void trajectory_io::save_frame_trajectory(const std::string& path, const std::string& format) const {
-    std::lock_guard<std::mutex> lock(data::map_database::mtx_database_);
+    util::shared_lock lock(data::map_database::mtx_database_);
 
-    // 1. acquire the frame stats
+    // 1. check the frame stats
 
     assert(map_db_);
-    const auto frm_stats = map_db_->get_frame_statistics();
-
-    // 2. save the frames
-
-    const auto num_valid_frms = frm_stats.get_num_valid_frames();
-    const auto reference_keyframes = frm_stats.get_reference_keyframes();
-    const auto rel_cam_poses_from_ref_keyfrms = frm_stats.get_relative_cam_poses();
-    const auto timestamps = frm_stats.get_timestamps();
-    const auto is_lost_frms = frm_stats.get_lost_frames();
+    const auto num_valid_frms = map_db_->get_num_valid_frames();
 
     if (num_valid_frms == 0) {
         spdlog::warn("there are no valid frames, cannot dump frame trajectory");
         return;
     }
 
+    if (format != "KITTI" && format != "TUM") {
+        throw std::runtime_error("Not implemented: trajectory format \"" + format + "\"");
+    }
+
     std::ofstream ofs(path, std::ios::out);
     if (!ofs.is_open()) {
         spdlog::critical("cannot create a file at {}", path);
         throw std::runtime_error("cannot create a file at " + path);
     }
 
-    spdlog::info("dump frame trajectory in \"{}\" format from frame {} to frame {} ({} frames)",
-                 format, reference_keyframes.begin()->first, reference_keyframes.rbegin()->first, num_valid_frms);
+    spdlog::info("dump frame trajectory in \"{}\" format ({} frames)", format, num_valid_frms);
 
-    const auto rk_itr_bgn = reference_keyframes.begin();
-    const auto rc_itr_bgn = rel_cam_poses_from_ref_keyfrms.begin();
-    const auto rk_itr_end = reference_keyframes.end();
-    const auto rc_itr_end = rel_cam_poses_from_ref_keyfrms.end();
-    auto rk_itr = rk_itr_bgn;
-    auto rc_itr = rc_itr_bgn;
+    // 2. save the frames while streaming the frame stats
 
-    int offset = rk_itr->first;
+    bool is_first_frm = true;
     unsigned int prev_frm_id = 0;
-    for (unsigned int i = 0; i < num_valid_frms; ++i, ++rk_itr, ++rc_itr) {
-        // check frame ID
-        assert(rk_itr->first == rc_itr->first);
-        const auto frm_id = rk_itr->first;
+    map_db_->for_each_frame_statistics([&](const data::frame_statistics::frame_record& record, const std::shared_ptr<data::keyframe>& ref_keyfrm) {
+        const auto frm_id = record.frm_id_;
+
+        // check if the frame was skipped or not
+        if (!is_first_frm && frm_id != prev_frm_id + 1) {
+            spdlog::warn("frame(s) from {} to {} was/were skipped", prev_frm_id + 1, frm_id - 1);
+        }
+        is_first_frm = false;
+        prev_frm_id = frm_id;
 
         // check if the frame was lost or not
-        if (is_lost_frms.at(frm_id)) {
+        if (record.is_lost_) {
             spdlog::warn("frame {} was lost", frm_id);
-            continue;
+            return;
         }
 
-        // check if the frame was skipped or not
-        if (frm_id != i + offset) {
-            spdlog::warn("frame(s) from {} to {} was/were skipped", prev_frm_id + 1, frm_id - 1);
-            offset = frm_id - i;
+        if (!ref_keyfrm) {
+            spdlog::error("the reference keyframe {} of frame {} is not found", record.ref_keyfrm_id_, frm_id);
+            return;
         }
 
-        auto ref_keyfrm = rk_itr->second;
         const Mat44_t cam_pose_rw = ref_keyfrm->get_pose_cw();
-        const Mat44_t rel_cam_pose_cr = rc_itr->second;
+        const Mat44_t& rel_cam_pose_cr = record.rel_cam_pose_cr_;
 
         const Mat44_t cam_pose_cw = rel_cam_pose_cr * cam_pose_rw;
         Mat44_t cam_pose_wc = util::converter::inverse_pose(cam_pose_cw);
@@ -91,27 +84,18 @@ void trajectory_io::save_frame_trajectory(const std::string& path, const std::st
             const Vec3_t& trans_wc = cam_pose_wc.block<3, 1>(0, 3);
             const Quat_t quat_wc = Quat_t(rot_wc);
             ofs << std::setprecision(15)
-                << timestamps.at(frm_id) << " "
+                << record.timestamp_ << " "
                 << std::setprecision(9)
                 << trans_wc(0) << " " << trans_wc(1) << " " << trans_wc(2) << " "
                 << quat_wc.x() << " " << quat_wc.y() << " " << quat_wc.z() << " " << quat_wc.w() << std::endl;
         }
-        else {
-            throw std::runtime_error("Not implemented: trajectory format \"" + format + "\"");
-        }
-
-        prev_frm_id = frm_id;
-    }
-
-    if (rk_itr != rk_itr_end || rc_itr != rc_itr_end) {
-        spdlog::error("the sizes of frame statistics are not matched");
-    }
+    });
 
     ofs.close();
 }
 
 void trajectory_io::save_keyframe_trajectory(const std::string& path, const std::string& format) const {
-    std::lock_guard<std::mutex> lock(data::map_database::mtx_database_);
+    util::shared_lock lock(data::map_database::mtx_database_);
 
     // 1. acquire keyframes and sort them
 
@@ -20,6 +20,7 @@ namespace stella_vslam {
 mapping_module::mapping_module(const YAML::Node& yaml_node, data::map_database* map_db, data::bow_database* bow_db, data::bow_vocabulary* bow_vocab)
     : local_map_cleaner_(new module::local_map_cleaner(yaml_node, map_db, bow_db)),
       map_db_(map_db), bow_db_(bow_db), bow_vocab_(bow_vocab),
+      keyfrms_queue_(yaml_node["keyframe_queue_capacity"].as<unsigned int>(256)),
       local_bundle_adjuster_(optimize::local_bundle_adjuster_factory::create(yaml_node)),
       enable_interruption_of_landmark_generation_(yaml_node["enable_interruption_of_landmark_generation"].as<bool>(true)),
       enable_interruption_before_local_BA_(yaml_node["enable_interruption_before_local_BA"].as<bool>(true)),
@@ -66,8 +67,13 @@ void mapping_module::run() {
     is_terminated_ = false;
 
     while (true) {
-        // waiting time for the other threads
-        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        // wait until a keyframe is queued or pause/reset/terminate is requested
+        {
+            std::unique_lock<std::mutex> lock(mtx_wakeup_);
+            cv_wakeup_.wait(lock, [this] {
+                return terminate_is_requested() || reset_is_requested() || pause_is_requested() || keyframe_is_queued();
+            });
+        }
 
         // check if termination is requested
         if (terminate_is_requested()) {
@@ -93,8 +99,11 @@ void mapping_module::run() {
                 pause();
                 SPDLOG_TRACE("mapping_module: waiting");
                 // check if termination or reset is requested during pause
-                while (is_paused() && !terminate_is_requested() && !reset_is_requested()) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(3));
+                {
+                    std::unique_lock<std::mutex> lock(mtx_wakeup_);
+                    cv_wakeup_.wait(lock, [this] {
+                        return !is_paused() || terminate_is_requested() || reset_is_requested();
+                    });
                 }
                 auto future_start_keyframe_insertion = tracker_->async_start_keyframe_insertion();
                 future_start_keyframe_insertion.get();
@@ -115,27 +124,73 @@ void mapping_module::run() {
         }
     }
 
+    spdlog::debug("mapping module: queue latency {:.3f} ms (mean), {:.3f} ms (99th percentile), mapping latency {:.3f} ms (mean), {:.3f} ms (99th percentile)",
+                  queue_latency_histogram_.get_mean_ms(), queue_latency_histogram_.get_percentile_ms(99.0),
+                  mapping_latency_histogram_.get_mean_ms(), mapping_latency_histogram_.get_percentile_ms(99.0));
     spdlog::info("terminate mapping module");
 }
 
-std::shared_future<void> mapping_module::async_add_keyframe(const std::shared_ptr<data::keyframe>& keyfrm) {
-    std::lock_guard<std::mutex> lock(mtx_keyfrm_queue_);
-    keyfrms_queue_.push_back(keyfrm);
+uint64_t mapping_module::queue_keyframe(const std::shared_ptr<data::keyframe>& keyfrm) {
     abort_local_BA_ = true;
-    promise_add_keyfrm_queue_.emplace_back();
-    return promise_add_keyfrm_queue_.back().get_future().share();
+    // wait while the queue is full, unless the mapping module has been terminated
+    const bool queued = keyfrms_queue_.push(queued_keyframe{keyfrm, std::chrono::steady_clock::now()},
+                                            [this] { return terminate_is_requested() || is_terminated(); });
+    if (queued) {
+        ++num_queued_keyfrms_;
+        notify_wakeup();
+    }
+    else {
+        spdlog::warn("mapping module: keyframe {} is discarded because the module has been terminated", keyfrm->id_);
+    }
+    return num_queued_keyfrms_;
+}
+
+void mapping_module::wait_for_keyframe_mapping(const uint64_t keyfrm_seq) {
+    std::unique_lock<std::mutex> lock(mtx_finished_keyfrms_);
+    cv_finished_keyfrms_.wait(lock, [this, keyfrm_seq] {
+        return keyfrm_seq <= num_finished_keyfrms_.load();
+    });
+}
+
+void mapping_module::notify_finished_keyframes() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_finished_keyfrms_);
+        num_finished_keyfrms_ = num_dequeued_keyfrms_;
+    }
+    cv_finished_keyfrms_.notify_all();
 }
 
 unsigned int mapping_module::get_num_queued_keyframes() const {
-    std::lock_guard<std::mutex> lock(mtx_keyfrm_queue_);
     return keyfrms_queue_.size();
 }
 
 bool mapping_module::keyframe_is_queued() const {
-    std::lock_guard<std::mutex> lock(mtx_keyfrm_queue_);
     return !keyfrms_queue_.empty();
 }
 
+const util::latency_histogram& mapping_module::get_queue_latency_histogram() const {
+    return queue_latency_histogram_;
+}
+
+const util::latency_histogram& mapping_module::get_mapping_latency_histogram() const {
+    return mapping_latency_histogram_;
+}
+
+util::queue_metrics mapping_module::get_queue_metrics() const {
+    return keyfrms_queue_.get_metrics();
+}
+
+void mapping_module::notify_wakeup() {
+    // lock the mutex once so that the notification is not lost
+    // between the evaluation of the wakeup condition and the wait
+    {
+        std::lock_guard<std::mutex> lock(mtx_wakeup_);
+    }
+    cv_wakeup_.notify_all();
+    // the tracking module waiting for room in the queue gives up when this module is terminated
+    keyfrms_queue_.notify_producer();
+}
+
 bool mapping_module::is_skipping_localBA() const {
     auto queued_keyframes = get_num_queued_keyframes();
     return queued_keyframes >= queue_threshold_;
@@ -146,13 +201,15 @@ void mapping_module::abort_local_BA() {
 }
 
 void mapping_module::mapping_with_new_keyframe() {
-    // dequeue
-    {
-        std::lock_guard<std::mutex> lock(mtx_keyfrm_queue_);
-        // dequeue -> cur_keyfrm_
-        cur_keyfrm_ = keyfrms_queue_.front();
-        keyfrms_queue_.pop_front();
+    // dequeue -> cur_keyfrm_
+    queued_keyframe queued;
+    if (!keyfrms_queue_.try_pop(queued)) {
+        return;
     }
+    ++num_dequeued_keyfrms_;
+    cur_keyfrm_ = queued.keyfrm_;
+    cur_keyfrm_queued_time_ = queued.queued_time_;
+    queue_latency_histogram_.add(std::chrono::steady_clock::now() - cur_keyfrm_queued_time_);
 
     SPDLOG_TRACE("mapping_module: current keyframe is {}", cur_keyfrm_->id_);
 
@@ -185,11 +242,7 @@ void mapping_module::mapping_with_new_keyframe() {
     update_new_keyframe();
 
     if (enable_interruption_before_local_BA_ && (keyframe_is_queued() || pause_is_requested())) {
-        {
-            std::lock_guard<std::mutex> lock(mtx_keyfrm_queue_);
-            promise_add_keyfrm_queue_.front().set_value();
-            promise_add_keyfrm_queue_.pop_front();
-        }
+        finish_mapping_with_new_keyframe();
         return;
     }
 
@@ -238,11 +291,12 @@ void mapping_module::mapping_with_new_keyframe() {
 
     local_map_cleaner_->remove_redundant_keyframes(cur_keyfrm_);
 
-    {
-        std::lock_guard<std::mutex> lock(mtx_keyfrm_queue_);
-        promise_add_keyfrm_queue_.front().set_value();
-        promise_add_keyfrm_queue_.pop_front();
-    }
+    finish_mapping_with_new_keyframe();
+}
+
+void mapping_module::finish_mapping_with_new_keyframe() {
+    mapping_latency_histogram_.add(std::chrono::steady_clock::now() - cur_keyfrm_queued_time_);
+    notify_finished_keyframes();
 }
 
 void mapping_module::store_new_keyframe() {
@@ -342,46 +396,66 @@ void mapping_module::create_new_landmarks(std::atomic<bool>& abort_create_new_la
 
 void mapping_module::triangulate_with_two_keyframes(const std::shared_ptr<data::keyframe>& keyfrm_1, const std::shared_ptr<data::keyframe>& keyfrm_2,
                                                     const std::vector<std::pair<unsigned int, unsigned int>>& matches) {
-    std::lock_guard<std::mutex> lock(data::map_database::mtx_database_);
-    const module::two_view_triangulator triangulator(keyfrm_1, keyfrm_2, 1.0);
+    // The new landmarks are triangulated while the map is only read (the tracking module can run concurrently),
+    // and they are connected to the keyframes and the map database afterwards.
+    // (NOTE: the observations are added after the duplication check, because they update the covisibility graph)
+    std::vector<std::shared_ptr<data::landmark>> new_lms(matches.size());
+    {
+        util::shared_lock lock(data::map_database::mtx_database_);
+        const module::two_view_triangulator triangulator(keyfrm_1, keyfrm_2, 1.0);
 
 #ifdef USE_OPENMP
 #pragma omp parallel for
 #endif
-    for (int64_t i = 0; i < static_cast<int64_t>(matches.size()); ++i) {
+        for (int64_t i = 0; i < static_cast<int64_t>(matches.size()); ++i) {
+            const auto idx_1 = matches.at(i).first;
+            const auto idx_2 = matches.at(i).second;
+
+            // triangulate between idx_1 and idx_2
+            Vec3_t pos_w;
+            if (!triangulator.triangulate(idx_1, idx_2, pos_w)) {
+                // failed
+                continue;
+            }
+            // succeeded
+
+            // create a landmark object
+            // (the landmark is not visible from the other threads until it is connected to the keyframes)
+            new_lms.at(i) = std::make_shared<data::landmark>(map_db_->next_landmark_id_++, pos_w, keyfrm_1);
+        }
+    }
+
+    util::exclusive_lock lock(data::map_database::mtx_database_);
+    for (unsigned int i = 0; i < matches.size(); ++i) {
+        auto& lm = new_lms.at(i);
+        if (!lm) {
+            continue;
+        }
         const auto idx_1 = matches.at(i).first;
         const auto idx_2 = matches.at(i).second;
 
-        // triangulate between idx_1 and idx_2
-        Vec3_t pos_w;
-        if (!triangulator.triangulate(idx_1, idx_2, pos_w)) {
-            // failed
+        // the keypoints might have been associated with the other landmarks during triangulation
+        if (keyfrm_1->get_landmark(idx_1) || keyfrm_2->get_landmark(idx_2)) {
             continue;
         }
-        // succeeded
 
-        // create a landmark object
-        auto lm = std::make_shared<data::landmark>(map_db_->next_landmark_id_++, pos_w, keyfrm_1);
-
-        lm->connect_to_keyframe(keyfrm_1, idx_1);
-        lm->connect_to_keyframe(keyfrm_2, idx_2);
+        lm->add_observation(keyfrm_1, idx_1);
+        lm->add_observation(keyfrm_2, idx_2);
 
         lm->compute_descriptor();
         lm->update_mean_normal_and_obs_scale_variance();
 
+        keyfrm_1->add_landmark(lm, idx_1);
+        keyfrm_2->add_landmark(lm, idx_2);
+
         map_db_->add_landmark(lm);
         // wait for redundancy check
-#ifdef USE_OPENMP
-#pragma omp critical
-#endif
-        {
-            local_map_cleaner_->add_fresh_landmark(lm);
-        }
+        local_map_cleaner_->add_fresh_landmark(lm);
     }
 }
 
 void mapping_module::update_new_keyframe() {
-    std::lock_guard<std::mutex> lock(data::map_database::mtx_database_);
+    util::exclusive_lock lock(data::map_database::mtx_database_);
 
     // get the targets to check landmark fusion
     const auto fuse_tgt_keyfrms = cur_keyfrm_->graph_node_->get_top_n_covisibilities(num_covisibilities_for_landmark_fusion_);
@@ -537,12 +611,17 @@ void mapping_module::fuse_landmark_duplication(const std::vector<std::shared_ptr
 }
 
 std::shared_future<void> mapping_module::async_reset() {
-    std::lock_guard<std::mutex> lock(mtx_reset_);
-    reset_is_requested_ = true;
-    if (!future_reset_.valid()) {
-        future_reset_ = promise_reset_.get_future().share();
+    std::shared_future<void> future_reset;
+    {
+        std::lock_guard<std::mutex> lock(mtx_reset_);
+        reset_is_requested_ = true;
+        if (!future_reset_.valid()) {
+            future_reset_ = promise_reset_.get_future().share();
+        }
+        future_reset = future_reset_;
     }
-    return future_reset_;
+    notify_wakeup();
+    return future_reset;
 }
 
 bool mapping_module::reset_is_requested() const {
@@ -553,14 +632,12 @@ bool mapping_module::reset_is_requested() const {
 void mapping_module::reset() {
     std::lock_guard<std::mutex> lock(mtx_reset_);
     spdlog::info("reset mapping module");
-    keyfrms_queue_.clear();
-    {
-        std::lock_guard<std::mutex> lock_keyfrm_queue(mtx_keyfrm_queue_);
-        while (!promise_add_keyfrm_queue_.empty()) {
-            promise_add_keyfrm_queue_.front().set_value();
-            promise_add_keyfrm_queue_.pop_front();
-        }
+    // discard the queued keyframes
+    queued_keyframe queued;
+    while (keyfrms_queue_.try_pop(queued)) {
+        ++num_dequeued_keyfrms_;
     }
+    notify_finished_keyframes();
     local_map_cleaner_->reset();
     reset_is_requested_ = false;
     promise_reset_.set_value();
@@ -569,21 +646,29 @@ void mapping_module::reset() {
 }
 
 std::shared_future<void> mapping_module::async_pause() {
-    std::lock_guard<std::mutex> lock_pause(mtx_pause_);
-    pause_is_requested_ = true;
-    abort_local_BA_ = true;
-    if (!future_pause_.valid()) {
-        future_pause_ = promise_pause_.get_future().share();
-    }
+    std::shared_future<void> future_pause;
+    {
+        std::lock_guard<std::mutex> lock_pause(mtx_pause_);
+        pause_is_requested_ = true;
+        abort_local_BA_ = true;
+        if (!future_pause_.valid()) {
+            future_pause_ = promise_pause_.get_future().share();
+        }
 
-    std::lock_guard<std::mutex> lock_terminate(mtx_terminate_);
-    SPDLOG_TRACE("mapping_module::async_pause is_terminated_={} is_paused_={}", is_terminated_, is_paused_);
-    std::shared_future<void> future_pause = future_pause_;
-    if (is_terminated_ || is_paused_) {
-        promise_pause_.set_value();
-        // Clear request
-        promise_pause_ = std::promise<void>();
-        future_pause_ = std::shared_future<void>();
+        std::lock_guard<std::mutex> lock_terminate(mtx_terminate_);
+        SPDLOG_TRACE("mapping_module::async_pause is_terminated_={} is_paused_={}", is_terminated_, is_paused_);
+        future_pause = future_pause_;
+        if (is_terminated_ || is_paused_) {
+            promise_pause_.set_value();
+            // Clear request
+            promise_pause_ = std::promise<void>();
+            future_pause_ = std::shared_future<void>();
+        }
+    }
+    notify_wakeup();
+    // this module may be waiting for room in the queue of the global optimization module, which gives up when this module is paused
+    if (global_optimizer_) {
+        global_optimizer_->notify_keyframe_producer();
     }
     return future_pause;
 }
@@ -608,29 +693,37 @@ void mapping_module::pause() {
 }
 
 void mapping_module::resume() {
-    std::lock_guard<std::mutex> lock1(mtx_pause_);
-    std::lock_guard<std::mutex> lock2(mtx_terminate_);
+    {
+        std::lock_guard<std::mutex> lock1(mtx_pause_);
+        std::lock_guard<std::mutex> lock2(mtx_terminate_);
 
-    // if it has been already terminated, cannot resume
-    if (is_terminated_) {
-        return;
-    }
+        // if it has been already terminated, cannot resume
+        if (is_terminated_) {
+            return;
+        }
 
-    assert(keyfrms_queue_.empty());
+        assert(keyfrms_queue_.empty());
 
-    is_paused_ = false;
-    pause_is_requested_ = false;
+        is_paused_ = false;
+        pause_is_requested_ = false;
 
-    spdlog::info("resume mapping module");
+        spdlog::info("resume mapping module");
+    }
+    notify_wakeup();
 }
 
 std::shared_future<void> mapping_module::async_terminate() {
-    std::lock_guard<std::mutex> lock(mtx_terminate_);
-    terminate_is_requested_ = true;
-    if (!future_terminate_.valid()) {
-        future_terminate_ = promise_terminate_.get_future().share();
+    std::shared_future<void> future_terminate;
+    {
+        std::lock_guard<std::mutex> lock(mtx_terminate_);
+        terminate_is_requested_ = true;
+        if (!future_terminate_.valid()) {
+            future_terminate_ = promise_terminate_.get_future().share();
+        }
+        future_terminate = future_terminate_;
     }
-    return future_terminate_;
+    notify_wakeup();
+    return future_terminate;
 }
 
 bool mapping_module::is_terminated() const {
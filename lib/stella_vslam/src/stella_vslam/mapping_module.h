@@ -6,11 +6,16 @@
 #include "stella_vslam/module/local_map_cleaner.h"
 #include "stella_vslam/optimize/local_bundle_adjuster.h"
 #include "stella_vslam/data/bow_vocabulary_fwd.h"
+#include "stella_vslam/util/latency_histogram.h"
+#include "stella_vslam/util/spsc_queue.h"
 
 #include <mutex>
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <memory>
 #include <future>
+#include <condition_variable>
 
 #include <yaml-cpp/yaml.h>
 
@@ -50,8 +55,12 @@ public:
     //! Run main loop of the mapping module
     void run();
 
-    //! Queue a keyframe to process the mapping
-    std::shared_future<void> async_add_keyframe(const std::shared_ptr<data::keyframe>& keyfrm);
+    //! Queue a keyframe to process the mapping, and return its sequence number to wait for the mapping
+    //! (NOTE: this function must be called only from the tracking thread, and waits while the queue is full)
+    uint64_t queue_keyframe(const std::shared_ptr<data::keyframe>& keyfrm);
+
+    //! Wait until the mapping of the keyframe with the sequence number is finished (or the keyframe is discarded by reset)
+    void wait_for_keyframe_mapping(const uint64_t keyfrm_seq);
 
     //! Check if keyframe is queued
     bool keyframe_is_queued() const;
@@ -62,6 +71,15 @@ public:
     //! If the size of the queue exceeds this threshold, skip the localBA
     bool is_skipping_localBA() const;
 
+    //! Get the histogram of the time from queueing a keyframe to starting its mapping
+    const util::latency_histogram& get_queue_latency_histogram() const;
+
+    //! Get the histogram of the time from queueing a keyframe to finishing its mapping (including local BA)
+    const util::latency_histogram& get_mapping_latency_histogram() const;
+
+    //! Get the back-pressure metrics of the keyframe queue
+    util::queue_metrics get_queue_metrics() const;
+
     //-----------------------------------------
     // management for reset process
 
@@ -123,6 +141,22 @@ private:
     void fuse_landmark_duplication(const std::vector<std::shared_ptr<data::keyframe>>& fuse_tgt_keyfrms,
                                    nondeterministic::unordered_map<std::shared_ptr<data::landmark>, std::shared_ptr<data::landmark>>& replaced_lms);
 
+    //! Mark the current keyframe as finished and record its latency
+    void finish_mapping_with_new_keyframe();
+
+    //-----------------------------------------
+    // wakeup of the main loop
+
+    //! mutex for the wakeup condition
+    std::mutex mtx_wakeup_;
+
+    //! condition variable which is notified when a keyframe is queued or pause/resume/reset/terminate is requested
+    std::condition_variable cv_wakeup_;
+
+    //! Notify the main loop that the wakeup condition may have changed
+    //! (NOTE: call this after releasing the other mutexes of this module)
+    void notify_wakeup();
+
     //-----------------------------------------
     // management for reset process
 
@@ -213,14 +247,39 @@ private:
     //-----------------------------------------
     // keyframe queue
 
-    //! mutex for access to keyframe queue
-    mutable std::mutex mtx_keyfrm_queue_;
+    //! keyframe and the time when it was queued
+    struct queued_keyframe {
+        std::shared_ptr<data::keyframe> keyfrm_;
+        std::chrono::steady_clock::time_point queued_time_;
+    };
+
+    //! queue for keyframes (pushed by the tracking thread, and popped by the mapping thread)
+    util::spsc_queue<queued_keyframe> keyfrms_queue_;
+
+    //! number of the queued keyframes (written only by the tracking thread)
+    uint64_t num_queued_keyfrms_ = 0;
+
+    //! number of the dequeued keyframes (written only by the mapping thread)
+    uint64_t num_dequeued_keyfrms_ = 0;
+
+    //! number of the keyframes whose mapping was finished or which were discarded by reset
+    std::atomic<uint64_t> num_finished_keyfrms_{0};
+
+    //! mutex and condition variable to wait for the mapping of the keyframes
+    std::mutex mtx_finished_keyfrms_;
+    std::condition_variable cv_finished_keyfrms_;
+
+    //! Mark the dequeued keyframes as finished, and wake up the threads waiting for them
+    void notify_finished_keyframes();
+
+    //! time when the current keyframe was queued
+    std::chrono::steady_clock::time_point cur_keyfrm_queued_time_;
 
-    //! queue for keyframes
-    std::list<std::shared_ptr<data::keyframe>> keyfrms_queue_;
+    //! histogram of the time from queueing a keyframe to starting its mapping
+    util::latency_histogram queue_latency_histogram_;
 
-    //! queue for promises
-    std::list<std::promise<void>> promise_add_keyfrm_queue_;
+    //! histogram of the time from queueing a keyframe to finishing its mapping
+    util::latency_histogram mapping_latency_histogram_;
 
     //-----------------------------------------
     // optimizer
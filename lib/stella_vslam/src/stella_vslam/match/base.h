@@ -2,6 +2,7 @@
 #define STELLA_VSLAM_MATCH_BASE_H
 
 #include "stella_vslam/type.h"
+#include "stella_vslam/match/hamming.h"
 
 #include <array>
 #include <algorithm>
@@ -18,50 +19,25 @@ static constexpr unsigned int MAX_HAMMING_DIST = 256;
 
 //! ORB特徴量間のハミング距離を計算する
 inline unsigned int compute_descriptor_distance_32(const cv::Mat& desc_1, const cv::Mat& desc_2) {
-    // http://graphics.stanford.edu/~seander/bithacks.html#CountBitsSetParallel
-
-    constexpr uint32_t mask_1 = 0x55555555U;
-    constexpr uint32_t mask_2 = 0x33333333U;
-    constexpr uint32_t mask_3 = 0x0F0F0F0FU;
-    constexpr uint32_t mask_4 = 0x01010101U;
-
-    const auto* pa = desc_1.ptr<uint32_t>();
-    const auto* pb = desc_2.ptr<uint32_t>();
-
-    unsigned int dist = 0;
-
-    for (unsigned int i = 0; i < 8; ++i, ++pa, ++pb) {
-        auto v = *pa ^ *pb;
-        v -= ((v >> 1) & mask_1);
-        v = (v & mask_2) + ((v >> 2) & mask_2);
-        dist += (((v + (v >> 4)) & mask_3) * mask_4) >> 24;
-    }
-
-    return dist;
+    return hamming::compute_distance_256(desc_1.ptr<uint8_t>(), desc_2.ptr<uint8_t>());
 }
 
 //! ORB特徴量間のハミング距離を計算する
 inline unsigned int compute_descriptor_distance_64(const cv::Mat& desc_1, const cv::Mat& desc_2) {
-    // https://stackoverflow.com/questions/21826292/t-sql-hamming-distance-function-capable-of-decimal-string-uint64?lq=1
-
-    constexpr uint64_t mask_1 = 0x5555555555555555UL;
-    constexpr uint64_t mask_2 = 0x3333333333333333UL;
-    constexpr uint64_t mask_3 = 0x0F0F0F0F0F0F0F0FUL;
-    constexpr uint64_t mask_4 = 0x0101010101010101UL;
-
-    const auto* pa = desc_1.ptr<uint64_t>();
-    const auto* pb = desc_2.ptr<uint64_t>();
-
-    unsigned int dist = 0;
+    return hamming::compute_distance_256(desc_1.ptr<uint8_t>(), desc_2.ptr<uint8_t>());
+}
 
-    for (unsigned int i = 0; i < 4; ++i, ++pa, ++pb) {
-        auto v = *pa ^ *pb;
-        v -= (v >> 1) & mask_1;
-        v = (v & mask_2) + ((v >> 2) & mask_2);
-        dist += (((v + (v >> 4)) & mask_3) * mask_4) >> 56;
+//! Compute the Hamming distances between desc and the rows of descs specified by indices at once
+inline void compute_descriptor_distances_32(const cv::Mat& desc, const cv::Mat& descs,
+                                            const std::vector<unsigned int>& indices,
+                                            std::vector<unsigned int>& hamm_dists) {
+    hamm_dists.resize(indices.size());
+    if (indices.empty()) {
+        return;
     }
-
-    return dist;
+    hamming::compute_distances_256(desc.ptr<uint8_t>(), descs.ptr<uint8_t>(), descs.step[0],
+                                   indices.data(), static_cast<unsigned int>(indices.size()),
+                                   hamm_dists.data());
 }
 
 inline bool check_epipolar_constraint(const Vec3_t& bearing_1, const Vec3_t& bearing_2,
@@ -1,5 +1,6 @@
 #include "stella_vslam/match/fuse.h"
 #include "stella_vslam/camera/base.h"
+#include "stella_vslam/data/common.h"
 #include "stella_vslam/data/keyframe.h"
 #include "stella_vslam/data/landmark.h"
 
@@ -23,6 +24,9 @@ unsigned int fuse::detect_duplication(const std::shared_ptr<data::keyframe>& key
 
     duplicated_lms_in_keyfrm.clear();
 
+    // Buffer reused across the landmarks
+    std::vector<unsigned int> indices;
+
     for (auto& lm : landmarks_to_check) {
         if (!lm) {
             continue;
@@ -71,7 +75,7 @@ unsigned int fuse::detect_duplication(const std::shared_ptr<data::keyframe>& key
         const auto pred_scale_level = lm->predict_scale_level(cam_to_lm_dist, keyfrm->orb_params_->num_levels_, keyfrm->orb_params_->log_scale_factor_);
         const int min_level = std::max(0, static_cast<int>(pred_scale_level) - 1);
         const int max_level = std::min(keyfrm->orb_params_->num_levels_ - 1, pred_scale_level + 1);
-        const auto indices = keyfrm->get_keypoints_in_cell(reproj(0), reproj(1), margin * keyfrm->orb_params_->scale_factors_.at(pred_scale_level), min_level, max_level);
+        data::get_keypoints_in_cell(keyfrm->camera_, keyfrm->frm_obs_, reproj(0), reproj(1), margin * keyfrm->orb_params_->scale_factors_.at(pred_scale_level), min_level, max_level, indices);
 
         if (indices.empty()) {
             continue;
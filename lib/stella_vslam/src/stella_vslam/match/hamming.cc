@@ -0,0 +1,216 @@
+#include "stella_vslam/match/hamming.h"
+
+#include <cstring>
+
+// The vector kernels are compiled with per-function target attributes,
+// so that the library itself does not need to be built with -mavx2 etc.
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define STELLA_VSLAM_HAMMING_X86
+#include <immintrin.h>
+#if (defined(__clang__) && __clang_major__ >= 6) || (!defined(__clang__) && __GNUC__ >= 8)
+#define STELLA_VSLAM_HAMMING_AVX512
+#endif
+#endif
+
+namespace stella_vslam {
+namespace match {
+namespace hamming {
+
+namespace {
+
+using distance_func_t = unsigned int (*)(const uint8_t*, const uint8_t*);
+using distances_func_t = void (*)(const uint8_t*, const uint8_t*, const size_t,
+                                  const unsigned int*, const unsigned int, unsigned int*);
+
+struct kernel {
+    kernel_type_t type_;
+    distance_func_t distance_;
+    distances_func_t distances_;
+};
+
+inline uint64_t load_u64(const uint8_t* ptr) {
+    // descriptors are not guaranteed to be 8-byte aligned
+    uint64_t v;
+    std::memcpy(&v, ptr, sizeof(v));
+    return v;
+}
+
+// ----- Scalar -----
+
+unsigned int distance_scalar(const uint8_t* desc_1, const uint8_t* desc_2) {
+    // https://stackoverflow.com/questions/21826292/t-sql-hamming-distance-function-capable-of-decimal-string-uint64?lq=1
+
+    constexpr uint64_t mask_1 = 0x5555555555555555UL;
+    constexpr uint64_t mask_2 = 0x3333333333333333UL;
+    constexpr uint64_t mask_3 = 0x0F0F0F0F0F0F0F0FUL;
+    constexpr uint64_t mask_4 = 0x0101010101010101UL;
+
+    unsigned int dist = 0;
+
+    for (unsigned int i = 0; i < 32; i += 8) {
+        auto v = load_u64(desc_1 + i) ^ load_u64(desc_2 + i);
+        v -= (v >> 1) & mask_1;
+        v = (v & mask_2) + ((v >> 2) & mask_2);
+        dist += (((v + (v >> 4)) & mask_3) * mask_4) >> 56;
+    }
+
+    return dist;
+}
+
+void distances_scalar(const uint8_t* query, const uint8_t* descs, const size_t step,
+                      const unsigned int* indices, const unsigned int num_indices,
+                      unsigned int* hamm_dists) {
+    for (unsigned int i = 0; i < num_indices; ++i) {
+        hamm_dists[i] = distance_scalar(query, descs + indices[i] * step);
+    }
+}
+
+#ifdef STELLA_VSLAM_HAMMING_X86
+
+// ----- POPCNT -----
+
+__attribute__((target("popcnt"))) unsigned int distance_popcnt(const uint8_t* desc_1, const uint8_t* desc_2) {
+    return __builtin_popcountll(load_u64(desc_1) ^ load_u64(desc_2))
+           + __builtin_popcountll(load_u64(desc_1 + 8) ^ load_u64(desc_2 + 8))
+           + __builtin_popcountll(load_u64(desc_1 + 16) ^ load_u64(desc_2 + 16))
+           + __builtin_popcountll(load_u64(desc_1 + 24) ^ load_u64(desc_2 + 24));
+}
+
+__attribute__((target("popcnt"))) void distances_popcnt(const uint8_t* query, const uint8_t* descs, const size_t step,
+                                                          const unsigned int* indices, const unsigned int num_indices,
+                                                          unsigned int* hamm_dists) {
+    const uint64_t q_0 = load_u64(query);
+    const uint64_t q_1 = load_u64(query + 8);
+    const uint64_t q_2 = load_u64(query + 16);
+    const uint64_t q_3 = load_u64(query + 24);
+    for (unsigned int i = 0; i < num_indices; ++i) {
+        const uint8_t* desc = descs + indices[i] * step;
+        hamm_dists[i] = __builtin_popcountll(q_0 ^ load_u64(desc))
+                        + __builtin_popcountll(q_1 ^ load_u64(desc + 8))
+                        + __builtin_popcountll(q_2 ^ load_u64(desc + 16))
+                        + __builtin_popcountll(q_3 ^ load_u64(desc + 24));
+    }
+}
+
+// ----- AVX2 -----
+
+// Count the set bits of each byte with a 4-bit lookup table (vpshufb),
+// then sum the byte counts into the four 64-bit lanes (vpsadbw)
+__attribute__((target("avx2"))) inline __m256i popcount_avx2(const __m256i v) {
+    const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                         0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0f);
+    const __m256i lo = _mm256_and_si256(v, low_mask);
+    const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+    const __m256i cnt = _mm256_add_epi8(_mm256_shuffle_epi8(lut, lo), _mm256_shuffle_epi8(lut, hi));
+    return _mm256_sad_epu8(cnt, _mm256_setzero_si256());
+}
+
+__attribute__((target("avx2"))) void distances_avx2(const uint8_t* query, const uint8_t* descs, const size_t step,
+                                                     const unsigned int* indices, const unsigned int num_indices,
+                                                     unsigned int* hamm_dists) {
+    const __m256i q = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(query));
+
+    unsigned int i = 0;
+    for (; i + 4 <= num_indices; i += 4) {
+        const __m256i d_0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(descs + indices[i] * step));
+        const __m256i d_1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(descs + indices[i + 1] * step));
+        const __m256i d_2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(descs + indices[i + 2] * step));
+        const __m256i d_3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(descs + indices[i + 3] * step));
+        // Each 64-bit lane of the partial sums is at most 64, so four candidates can be packed
+        // into the 16-bit slots of the same lane and reduced together
+        __m256i packed = popcount_avx2(_mm256_xor_si256(q, d_0));
+        packed = _mm256_or_si256(packed, _mm256_slli_epi64(popcount_avx2(_mm256_xor_si256(q, d_1)), 16));
+        packed = _mm256_or_si256(packed, _mm256_slli_epi64(popcount_avx2(_mm256_xor_si256(q, d_2)), 32));
+        packed = _mm256_or_si256(packed, _mm256_slli_epi64(popcount_avx2(_mm256_xor_si256(q, d_3)), 48));
+        const __m128i sum_128 = _mm_add_epi16(_mm256_castsi256_si128(packed), _mm256_extracti128_si256(packed, 1));
+        const __m128i sum_64 = _mm_add_epi16(sum_128, _mm_unpackhi_epi64(sum_128, sum_128));
+        const uint64_t sums = static_cast<uint64_t>(_mm_cvtsi128_si64(sum_64));
+        hamm_dists[i] = sums & 0xffff;
+        hamm_dists[i + 1] = (sums >> 16) & 0xffff;
+        hamm_dists[i + 2] = (sums >> 32) & 0xffff;
+        hamm_dists[i + 3] = sums >> 48;
+    }
+    for (; i < num_indices; ++i) {
+        const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(descs + indices[i] * step));
+        const __m256i cnt = popcount_avx2(_mm256_xor_si256(q, d));
+        const __m128i sum_128 = _mm_add_epi64(_mm256_castsi256_si128(cnt), _mm256_extracti128_si256(cnt, 1));
+        hamm_dists[i] = static_cast<unsigned int>(_mm_cvtsi128_si64(_mm_add_epi64(sum_128, _mm_unpackhi_epi64(sum_128, sum_128))));
+    }
+}
+
+#ifdef STELLA_VSLAM_HAMMING_AVX512
+
+// ----- AVX-512 VPOPCNTDQ -----
+
+__attribute__((target("avx512f,avx512vpopcntdq"))) void distances_avx512(const uint8_t* query, const uint8_t* descs, const size_t step,
+                                                                          const unsigned int* indices, const unsigned int num_indices,
+                                                                          unsigned int* hamm_dists) {
+    // Two candidates are processed per 512-bit register
+    alignas(64) uint8_t pair[64];
+    alignas(64) uint64_t cnts[8];
+    std::memcpy(pair, query, 32);
+    std::memcpy(pair + 32, query, 32);
+    const __m512i q = _mm512_load_si512(pair);
+
+    unsigned int i = 0;
+    for (; i + 2 <= num_indices; i += 2) {
+        std::memcpy(pair, descs + indices[i] * step, 32);
+        std::memcpy(pair + 32, descs + indices[i + 1] * step, 32);
+        _mm512_store_si512(cnts, _mm512_popcnt_epi64(_mm512_xor_si512(q, _mm512_load_si512(pair))));
+        hamm_dists[i] = static_cast<unsigned int>(cnts[0] + cnts[1] + cnts[2] + cnts[3]);
+        hamm_dists[i + 1] = static_cast<unsigned int>(cnts[4] + cnts[5] + cnts[6] + cnts[7]);
+    }
+    if (i < num_indices) {
+        hamm_dists[i] = distance_popcnt(query, descs + indices[i] * step);
+    }
+}
+
+#endif // STELLA_VSLAM_HAMMING_AVX512
+
+#endif // STELLA_VSLAM_HAMMING_X86
+
+kernel select_kernel() {
+    // NOTE: A single 256-bit pair is fastest with four scalar POPCNT instructions,
+    // so the vector kernels are only used for the batched entry point.
+#ifdef STELLA_VSLAM_HAMMING_X86
+    __builtin_cpu_init();
+#ifdef STELLA_VSLAM_HAMMING_AVX512
+    if (__builtin_cpu_supports("avx512vpopcntdq") && __builtin_cpu_supports("popcnt")) {
+        return {kernel_type_t::AVX512, &distance_popcnt, &distances_avx512};
+    }
+#endif
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+        return {kernel_type_t::AVX2, &distance_popcnt, &distances_avx2};
+    }
+    if (__builtin_cpu_supports("popcnt")) {
+        return {kernel_type_t::POPCNT, &distance_popcnt, &distances_popcnt};
+    }
+#endif
+    return {kernel_type_t::Scalar, &distance_scalar, &distances_scalar};
+}
+
+const kernel& get_kernel() {
+    static const kernel selected = select_kernel();
+    return selected;
+}
+
+} // namespace
+
+kernel_type_t get_kernel_type() {
+    return get_kernel().type_;
+}
+
+unsigned int compute_distance_256(const uint8_t* desc_1, const uint8_t* desc_2) {
+    return get_kernel().distance_(desc_1, desc_2);
+}
+
+void compute_distances_256(const uint8_t* query, const uint8_t* descs, const size_t step,
+                           const unsigned int* indices, const unsigned int num_indices,
+                           unsigned int* hamm_dists) {
+    get_kernel().distances_(query, descs, step, indices, num_indices, hamm_dists);
+}
+
+} // namespace hamming
+} // namespace match
+} // namespace stella_vslam
@@ -0,0 +1,53 @@
+#ifndef STELLA_VSLAM_MATCH_HAMMING_H
+#define STELLA_VSLAM_MATCH_HAMMING_H
+
+#include <array>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace stella_vslam {
+namespace match {
+namespace hamming {
+
+//! Instruction set used by the Hamming distance kernels
+enum class kernel_type_t {
+    Scalar = 0,
+    POPCNT = 1,
+    AVX2 = 2,
+    AVX512 = 3
+};
+
+const std::array<std::string, 4> kernel_type_to_string = {{"Scalar", "POPCNT", "AVX2", "AVX512"}};
+
+/**
+ * Get the kernel which is selected once at startup by runtime CPU detection
+ */
+kernel_type_t get_kernel_type();
+
+/**
+ * Compute the Hamming distance between two 256-bit descriptors
+ * @param desc_1
+ * @param desc_2
+ * @return
+ */
+unsigned int compute_distance_256(const uint8_t* desc_1, const uint8_t* desc_2);
+
+/**
+ * Compute the Hamming distances between one 256-bit query and the descriptors at the specified rows of a matrix
+ * @param query
+ * @param descs pointer to the first row of the candidate descriptors
+ * @param step row stride of descs in bytes
+ * @param indices row indices of the candidates
+ * @param num_indices
+ * @param hamm_dists output (num_indices elements)
+ */
+void compute_distances_256(const uint8_t* query, const uint8_t* descs, const size_t step,
+                           const unsigned int* indices, const unsigned int num_indices,
+                           unsigned int* hamm_dists);
+
+} // namespace hamming
+} // namespace match
+} // namespace stella_vslam
+
+#endif // STELLA_VSLAM_MATCH_HAMMING_H
@@ -18,78 +18,134 @@ unsigned int projection::match_frame_and_landmarks(data::frame& frm,
                                                    const float margin) const {
     unsigned int num_matches = 0;
 
+    // Buffers reused across the landmarks
+    std::vector<unsigned int> indices_in_cell;
+    std::vector<unsigned int> candidate_indices;
+    std::vector<unsigned int> hamm_dists;
+
     // Reproject the 3D points to the frame, then acquire the 2D-3D matches
     for (auto local_lm : local_landmarks) {
         if (!lm_to_reproj.count(local_lm->id_)) {
             continue;
         }
-        if (local_lm->will_be_erased()) {
-            continue;
+        if (match_frame_and_landmark(frm, local_lm, cv::Mat(), lm_to_reproj.at(local_lm->id_),
+                                     lm_to_x_right.at(local_lm->id_), lm_to_scale.at(local_lm->id_), margin,
+                                     indices_in_cell, candidate_indices, hamm_dists)) {
+            ++num_matches;
         }
+    }
 
-        // Acquire keypoints in the cell where the reprojected 3D points exist
-        Vec2_t reproj = lm_to_reproj.at(local_lm->id_);
-        const auto pred_scale_level = lm_to_scale.at(local_lm->id_);
-        const int min_level = std::max(0, static_cast<int>(pred_scale_level) - 1);
-        const int max_level = std::min(frm.orb_params_->num_levels_ - 1, pred_scale_level + 1);
-        const auto indices_in_cell = frm.get_keypoints_in_cell(reproj(0), reproj(1),
-                                                               margin * frm.orb_params_->scale_factors_.at(pred_scale_level),
-                                                               min_level, max_level);
-        if (indices_in_cell.empty()) {
+    return num_matches;
+}
+
+unsigned int projection::match_frame_and_landmarks(data::frame& frm,
+                                                   const std::vector<std::shared_ptr<data::landmark>>& landmarks,
+                                                   const data::landmark_batch& batch,
+                                                   const eigen_alloc_vector<Vec2_t>& reprojs,
+                                                   const std::vector<float>& x_rights,
+                                                   const std::vector<unsigned int>& pred_scale_levels,
+                                                   const std::vector<uint8_t>& is_observable,
+                                                   const float margin) const {
+    assert(landmarks.size() == batch.size());
+    unsigned int num_matches = 0;
+
+    // Buffers reused across the landmarks
+    std::vector<unsigned int> indices_in_cell;
+    std::vector<unsigned int> candidate_indices;
+    std::vector<unsigned int> hamm_dists;
+
+    // Reproject the 3D points to the frame, then acquire the 2D-3D matches
+    for (unsigned int i = 0; i < landmarks.size(); ++i) {
+        if (!is_observable.at(i)) {
             continue;
         }
+        // the descriptor is read from the arena without locking the landmark
+        const cv::Mat lm_desc = batch.has_descriptor_.at(i) ? batch.get_descriptor(i) : cv::Mat();
+        if (match_frame_and_landmark(frm, landmarks.at(i), lm_desc, reprojs.at(i), x_rights.at(i), pred_scale_levels.at(i), margin,
+                                     indices_in_cell, candidate_indices, hamm_dists)) {
+            ++num_matches;
+        }
+    }
 
-        const cv::Mat lm_desc = local_lm->get_descriptor();
+    return num_matches;
+}
 
-        unsigned int best_hamm_dist = MAX_HAMMING_DIST;
-        int best_scale_level = -1;
-        unsigned int second_best_hamm_dist = MAX_HAMMING_DIST;
-        int second_best_scale_level = -1;
-        int best_idx = -1;
+bool projection::match_frame_and_landmark(data::frame& frm, const std::shared_ptr<data::landmark>& lm, cv::Mat lm_desc,
+                                          const Vec2_t& reproj, const float x_right, const unsigned int pred_scale_level, const float margin,
+                                          std::vector<unsigned int>& indices_in_cell, std::vector<unsigned int>& candidate_indices,
+                                          std::vector<unsigned int>& hamm_dists) const {
+    if (lm->will_be_erased()) {
+        return false;
+    }
+
+    // Acquire keypoints in the cell where the reprojected 3D points exist
+    const int min_level = std::max(0, static_cast<int>(pred_scale_level) - 1);
+    const int max_level = std::min(frm.orb_params_->num_levels_ - 1, pred_scale_level + 1);
+    data::get_keypoints_in_cell(frm.camera_, frm.frm_obs_, reproj(0), reproj(1),
+                                margin * frm.orb_params_->scale_factors_.at(pred_scale_level),
+                                min_level, max_level, indices_in_cell);
+    if (indices_in_cell.empty()) {
+        return false;
+    }
+
+    // Select the keypoints which can be matched, then score all of them at once
+    candidate_indices.clear();
+    for (const auto idx : indices_in_cell) {
+        const auto& frm_lm = frm.get_landmark(idx);
+        if (frm_lm && frm_lm->has_observation()) {
+            continue;
+        }
 
-        for (const auto idx : indices_in_cell) {
-            const auto& lm = frm.get_landmark(idx);
-            if (lm && lm->has_observation()) {
+        if (!frm.frm_obs_.stereo_x_right_.empty() && 0 < frm.frm_obs_.stereo_x_right_.at(idx)) {
+            const auto reproj_error = std::abs(x_right - frm.frm_obs_.stereo_x_right_.at(idx));
+            if (margin * frm.orb_params_->scale_factors_.at(pred_scale_level) < reproj_error) {
                 continue;
             }
+        }
 
-            if (!frm.frm_obs_.stereo_x_right_.empty() && 0 < frm.frm_obs_.stereo_x_right_.at(idx)) {
-                const auto reproj_error = std::abs(lm_to_x_right.at(local_lm->id_) - frm.frm_obs_.stereo_x_right_.at(idx));
-                if (margin * frm.orb_params_->scale_factors_.at(pred_scale_level) < reproj_error) {
-                    continue;
-                }
-            }
+        candidate_indices.push_back(idx);
+    }
+
+    if (lm_desc.empty()) {
+        lm_desc = lm->get_descriptor();
+    }
+    compute_descriptor_distances_32(lm_desc, frm.frm_obs_.descriptors_, candidate_indices, hamm_dists);
 
-            const cv::Mat& desc = frm.frm_obs_.descriptors_.row(idx);
+    unsigned int best_hamm_dist = MAX_HAMMING_DIST;
+    int best_scale_level = -1;
+    unsigned int second_best_hamm_dist = MAX_HAMMING_DIST;
+    int second_best_scale_level = -1;
+    int best_idx = -1;
 
-            const auto dist = compute_descriptor_distance_32(lm_desc, desc);
+    for (unsigned int i = 0; i < candidate_indices.size(); ++i) {
+        const auto idx = candidate_indices.at(i);
+        const auto dist = hamm_dists.at(i);
 
-            if (dist < best_hamm_dist) {
-                second_best_hamm_dist = best_hamm_dist;
-                best_hamm_dist = dist;
-                second_best_scale_level = best_scale_level;
-                best_scale_level = frm.frm_obs_.undist_keypts_.at(idx).octave;
-                best_idx = idx;
-            }
-            else if (dist < second_best_hamm_dist) {
-                second_best_scale_level = frm.frm_obs_.undist_keypts_.at(idx).octave;
-                second_best_hamm_dist = dist;
-            }
+        if (dist < best_hamm_dist) {
+            second_best_hamm_dist = best_hamm_dist;
+            best_hamm_dist = dist;
+            second_best_scale_level = best_scale_level;
+            best_scale_level = frm.frm_obs_.undist_keypts_.at(idx).octave;
+            best_idx = idx;
         }
+        else if (dist < second_best_hamm_dist) {
+            second_best_scale_level = frm.frm_obs_.undist_keypts_.at(idx).octave;
+            second_best_hamm_dist = dist;
+        }
+    }
 
-        if (best_hamm_dist <= HAMMING_DIST_THR_HIGH) {
-            // Lowe's ratio test
-            if (best_scale_level == second_best_scale_level && best_hamm_dist > lowe_ratio_ * second_best_hamm_dist) {
-                continue;
-            }
+    if (HAMMING_DIST_THR_HIGH < best_hamm_dist) {
+        return false;
+    }
 
-            // Add the matching information
-            frm.add_landmark(local_lm, best_idx);
-            ++num_matches;
-        }
+    // Lowe's ratio test
+    if (best_scale_level == second_best_scale_level && best_hamm_dist > lowe_ratio_ * second_best_hamm_dist) {
+        return false;
     }
 
-    return num_matches;
+    // Add the matching information
+    frm.add_landmark(lm, best_idx);
+    return true;
 }
 
 unsigned int projection::match_current_and_last_frames(data::frame& curr_frm, const data::frame& last_frm, const float margin) const {
@@ -105,6 +161,9 @@ unsigned int projection::match_current_and_last_frames(data::frame& curr_frm, co
 
     const Vec3_t trans_lc = rot_lw * trans_wc + trans_lw;
 
+    // Buffer reused across the landmarks
+    std::vector<unsigned int> indices;
+
     // For non-monocular, check if the z component of the current-to-last translation vector is moving forward
     // The z component is positive going -> moving forward
     const bool assume_forward = (curr_frm.camera_->setup_type_ == camera::setup_type_t::Monocular)
@@ -155,9 +214,9 @@ unsigned int projection::match_current_and_last_frames(data::frame& curr_frm, co
             min_level = std::max(0, static_cast<int>(last_scale_level) - 1);
             max_level = std::min(last_frm.orb_params_->num_levels_ - 1, last_scale_level + 1);
         }
-        auto indices = curr_frm.get_keypoints_in_cell(reproj(0), reproj(1),
-                                                      margin * curr_frm.orb_params_->scale_factors_.at(last_scale_level),
-                                                      min_level, max_level);
+        data::get_keypoints_in_cell(curr_frm.camera_, curr_frm.frm_obs_, reproj(0), reproj(1),
+                                    margin * curr_frm.orb_params_->scale_factors_.at(last_scale_level),
+                                    min_level, max_level, indices);
         if (indices.empty()) {
             continue;
         }
@@ -230,6 +289,9 @@ unsigned int projection::match_frame_and_keyframe(const Mat44_t& cam_pose_cw,
 
     const auto landmarks = keyfrm->get_landmarks();
 
+    // Buffer reused across the landmarks
+    std::vector<unsigned int> indices;
+
     // Reproject the 3D points associated to the keypoints of the keyframe,
     // then acquire the 2D-3D matches
     for (unsigned int idx = 0; idx < landmarks.size(); idx++) {
@@ -274,9 +336,9 @@ unsigned int projection::match_frame_and_keyframe(const Mat44_t& cam_pose_cw,
         const auto pred_scale_level = lm->predict_scale_level(cam_to_lm_dist, orb_params->num_levels_, orb_params->log_scale_factor_);
         const int min_level = std::max(0, static_cast<int>(pred_scale_level) - 1);
         const int max_level = std::min(orb_params->num_levels_ - 1, pred_scale_level + 1);
-        const auto indices = data::get_keypoints_in_cell(camera, frm_obs, reproj(0), reproj(1),
-                                                         margin * orb_params->scale_factors_.at(pred_scale_level),
-                                                         min_level, max_level);
+        data::get_keypoints_in_cell(camera, frm_obs, reproj(0), reproj(1),
+                                    margin * orb_params->scale_factors_.at(pred_scale_level),
+                                    min_level, max_level, indices);
 
         if (indices.empty()) {
             continue;
@@ -332,6 +394,9 @@ unsigned int projection::match_by_Sim3_transform(const std::shared_ptr<data::key
     std::set<std::shared_ptr<data::landmark>> already_matched(matched_lms_in_keyfrm.begin(), matched_lms_in_keyfrm.end());
     already_matched.erase(nullptr);
 
+    // Buffer reused across the landmarks
+    std::vector<unsigned int> indices;
+
     for (const auto& lm : landmarks) {
         if (lm->will_be_erased()) {
             continue;
@@ -377,7 +442,7 @@ unsigned int projection::match_by_Sim3_transform(const std::shared_ptr<data::key
         const auto pred_scale_level = lm->predict_scale_level(cam_to_lm_dist, keyfrm->orb_params_->num_levels_, keyfrm->orb_params_->log_scale_factor_);
         const int min_level = std::max(0, static_cast<int>(pred_scale_level) - 1);
         const int max_level = std::min(keyfrm->orb_params_->num_levels_ - 1, pred_scale_level + 1);
-        const auto indices = keyfrm->get_keypoints_in_cell(reproj(0), reproj(1), margin * keyfrm->orb_params_->scale_factors_.at(pred_scale_level), min_level, max_level);
+        data::get_keypoints_in_cell(keyfrm->camera_, keyfrm->frm_obs_, reproj(0), reproj(1), margin * keyfrm->orb_params_->scale_factors_.at(pred_scale_level), min_level, max_level, indices);
 
         if (indices.empty()) {
             continue;
@@ -452,6 +517,10 @@ unsigned int projection::match_keyframes_mutually(const std::shared_ptr<data::ke
     std::vector<int> matched_indices_2_in_keyfrm_1(landmarks_1.size(), -1);
     std::vector<int> matched_indices_1_in_keyfrm_2(landmarks_2.size(), -1);
 
+    // Buffers reused across the landmarks
+    std::vector<unsigned int> indices;
+    std::vector<unsigned int> hamm_dists;
+
     // Compute the similarity transformation from the 3D points observed in keyframe 1 to keyframe 2 coordinates,
     // then project the result, and search keypoint matches
     // (world origin -- SE3 -> keyframe 1 -- Sim3 --> keyframe 2)
@@ -502,7 +571,7 @@ unsigned int projection::match_keyframes_mutually(const std::shared_ptr<data::ke
             const auto pred_scale_level = lm->predict_scale_level(cam_to_lm_dist, keyfrm_2->orb_params_->num_levels_, keyfrm_2->orb_params_->log_scale_factor_);
             const int min_level = std::max(0, static_cast<int>(pred_scale_level) - 1);
             const int max_level = std::min(keyfrm_2->orb_params_->num_levels_ - 1, pred_scale_level + 1);
-            const auto indices = keyfrm_2->get_keypoints_in_cell(reproj(0), reproj(1), margin * keyfrm_2->orb_params_->scale_factors_.at(pred_scale_level), min_level, max_level);
+            data::get_keypoints_in_cell(keyfrm_2->camera_, keyfrm_2->frm_obs_, reproj(0), reproj(1), margin * keyfrm_2->orb_params_->scale_factors_.at(pred_scale_level), min_level, max_level, indices);
 
             if (indices.empty()) {
                 continue;
@@ -510,18 +579,15 @@ unsigned int projection::match_keyframes_mutually(const std::shared_ptr<data::ke
 
             // Find a keypoint with the closest descriptor
             const auto lm_desc = lm->get_descriptor();
+            compute_descriptor_distances_32(lm_desc, keyfrm_2->frm_obs_.descriptors_, indices, hamm_dists);
 
             unsigned int best_hamm_dist = MAX_HAMMING_DIST;
             int best_idx_2 = -1;
 
-            for (const auto idx_2 : indices) {
-                const auto& desc = keyfrm_2->frm_obs_.descriptors_.row(idx_2);
-
-                const auto hamm_dist = compute_descriptor_distance_32(lm_desc, desc);
-
-                if (hamm_dist < best_hamm_dist) {
-                    best_hamm_dist = hamm_dist;
-                    best_idx_2 = idx_2;
+            for (unsigned int i = 0; i < indices.size(); ++i) {
+                if (hamm_dists.at(i) < best_hamm_dist) {
+                    best_hamm_dist = hamm_dists.at(i);
+                    best_idx_2 = indices.at(i);
                 }
             }
 
@@ -581,7 +647,7 @@ unsigned int projection::match_keyframes_mutually(const std::shared_ptr<data::ke
             const auto pred_scale_level = lm->predict_scale_level(cam_to_lm_dist, keyfrm_1->orb_params_->num_levels_, keyfrm_1->orb_params_->log_scale_factor_);
             const int min_level = std::max(0, static_cast<int>(pred_scale_level) - 1);
             const int max_level = std::min(keyfrm_1->orb_params_->num_levels_ - 1, pred_scale_level + 1);
-            const auto indices = keyfrm_1->get_keypoints_in_cell(reproj(0), reproj(1), margin * keyfrm_1->orb_params_->scale_factors_.at(pred_scale_level), min_level, max_level);
+            data::get_keypoints_in_cell(keyfrm_1->camera_, keyfrm_1->frm_obs_, reproj(0), reproj(1), margin * keyfrm_1->orb_params_->scale_factors_.at(pred_scale_level), min_level, max_level, indices);
 
             if (indices.empty()) {
                 continue;
@@ -589,18 +655,15 @@ unsigned int projection::match_keyframes_mutually(const std::shared_ptr<data::ke
 
             // Find a keypoint with the closest descriptor
             const auto lm_desc = lm->get_descriptor();
+            compute_descriptor_distances_32(lm_desc, keyfrm_1->frm_obs_.descriptors_, indices, hamm_dists);
 
             unsigned int best_hamm_dist = MAX_HAMMING_DIST;
             int best_idx_1 = -1;
 
-            for (const auto idx_1 : indices) {
-                const auto& desc = keyfrm_1->frm_obs_.descriptors_.row(idx_1);
-
-                const auto hamm_dist = compute_descriptor_distance_32(lm_desc, desc);
-
-                if (hamm_dist < best_hamm_dist) {
-                    best_hamm_dist = hamm_dist;
-                    best_idx_1 = idx_1;
+            for (unsigned int i = 0; i < indices.size(); ++i) {
+                if (hamm_dists.at(i) < best_hamm_dist) {
+                    best_hamm_dist = hamm_dists.at(i);
+                    best_idx_1 = indices.at(i);
                 }
             }
 
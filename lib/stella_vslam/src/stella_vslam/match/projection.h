@@ -14,6 +14,7 @@ class frame;
 struct frame_observation;
 class keyframe;
 class landmark;
+struct landmark_batch;
 } // namespace data
 
 namespace match {
@@ -33,6 +34,17 @@ public:
                                            std::unordered_map<unsigned int, unsigned int>& lm_to_scale,
                                            const float margin = 5.0) const;
 
+    //! Match the landmarks gathered from the arena, whose reprojections are computed by data::frame::can_observe
+    //! (the arguments are aligned with the landmarks, and the descriptors are read from the batch if they are available)
+    unsigned int match_frame_and_landmarks(data::frame& frm,
+                                           const std::vector<std::shared_ptr<data::landmark>>& landmarks,
+                                           const data::landmark_batch& batch,
+                                           const eigen_alloc_vector<Vec2_t>& reprojs,
+                                           const std::vector<float>& x_rights,
+                                           const std::vector<unsigned int>& pred_scale_levels,
+                                           const std::vector<uint8_t>& is_observable,
+                                           const float margin = 5.0) const;
+
     //! last frameで観測している3次元点をcurrent frameに再投影し，frame.landmarks_に対応情報を記録する
     unsigned int match_current_and_last_frames(data::frame& curr_frm, const data::frame& last_frm, const float margin) const;
 
@@ -59,6 +71,14 @@ public:
     //! matched_lms_in_keyfrm_1には，keyframe1の特徴点(index)と対応する，keyframe2で観測されている3次元点が記録される
     unsigned int match_keyframes_mutually(const std::shared_ptr<data::keyframe>& keyfrm_1, const std::shared_ptr<data::keyframe>& keyfrm_2, std::vector<std::shared_ptr<data::landmark>>& matched_lms_in_keyfrm_1,
                                           const float& s_12, const Mat33_t& rot_12, const Vec3_t& trans_12, const float margin) const;
+
+private:
+    //! Match a landmark with the keypoints around its reprojection
+    //! (the descriptor of the landmark is acquired only if it is empty, and the buffers are reused across the landmarks)
+    bool match_frame_and_landmark(data::frame& frm, const std::shared_ptr<data::landmark>& lm, cv::Mat lm_desc,
+                                  const Vec2_t& reproj, const float x_right, const unsigned int pred_scale_level, const float margin,
+                                  std::vector<unsigned int>& indices_in_cell, std::vector<unsigned int>& candidate_indices,
+                                  std::vector<unsigned int>& hamm_dists) const;
 };
 
 } // namespace match
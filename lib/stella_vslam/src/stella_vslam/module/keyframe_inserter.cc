@@ -130,7 +130,7 @@ bool keyframe_inserter::new_keyframe_is_needed(data::map_database* map_db,
 std::shared_ptr<data::keyframe> keyframe_inserter::create_new_keyframe(
     data::map_database* map_db,
     data::frame& curr_frm) {
-    std::lock_guard<std::mutex> lock(data::map_database::mtx_database_);
+    util::exclusive_lock lock(data::map_database::mtx_database_);
 
     auto keyfrm = data::keyframe::make_keyframe(map_db->next_keyframe_id_++, curr_frm);
     keyfrm->update_landmarks();
@@ -220,9 +220,9 @@ void keyframe_inserter::insert_new_keyframe(data::map_database* map_db,
     SPDLOG_TRACE("keyframe_inserter: insert_new_keyframe (curr_frm={})", curr_frm.id_);
     // insert the new keyframe
     const auto ref_keyfrm = create_new_keyframe(map_db, curr_frm);
-    auto future_add_keyframe = mapper_->async_add_keyframe(ref_keyfrm);
+    const auto keyfrm_seq = mapper_->queue_keyframe(ref_keyfrm);
     if (wait_for_local_bundle_adjustment_) {
-        future_add_keyframe.get();
+        mapper_->wait_for_keyframe_mapping(keyfrm_seq);
     }
     // set the reference keyframe with the new keyframe
     if (ref_keyfrm) {
@@ -171,6 +171,9 @@ auto local_map_updater::find_second_local_keyframes(const std::vector<std::share
         second_local_keyfrms.push_back(keyfrm);
         return true;
     };
+    // buffer of the covisibilities, which is reused for all the keyframes
+    std::vector<std::shared_ptr<data::keyframe>> neighbors;
+    neighbors.reserve(10);
     for (auto iter = first_local_keyframes.cbegin(); iter != first_local_keyframes.cend(); ++iter) {
         if (max_num_local_keyfrms_ <= first_local_keyframes.size() + second_local_keyfrms.size() + num_temporal_keyfrms) {
             break;
@@ -179,7 +182,7 @@ auto local_map_updater::find_second_local_keyframes(const std::vector<std::share
         const auto& keyfrm = *iter;
 
         // covisibilities of the neighbor keyframe
-        const auto neighbors = keyfrm->graph_node_->get_top_n_covisibilities(10);
+        keyfrm->graph_node_->get_top_n_covisibilities(10, neighbors);
         for (const auto& neighbor : neighbors) {
             add_second_local_keyframe(neighbor);
             if (max_num_local_keyfrms_ <= first_local_keyframes.size() + second_local_keyfrms.size() + num_temporal_keyfrms) {
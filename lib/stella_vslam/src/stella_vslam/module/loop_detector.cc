@@ -10,6 +10,9 @@
 #include "stella_vslam/solve/pnp_solver.h"
 #include "stella_vslam/util/converter.h"
 #include "stella_vslam/util/fancy_index.h"
+#include "stella_vslam/util/thread_pool.h"
+
+#include <future>
 
 #include <spdlog/spdlog.h>
 
@@ -31,6 +34,14 @@ loop_detector::loop_detector(data::bow_database* bow_db, data::bow_vocabulary* b
       use_fixed_seed_(yaml_node["use_fixed_seed"].as<bool>(false)),
       num_common_words_thr_ratio_(yaml_node["num_common_words_thr_ratio"].as<float>(0.8f)) {
     spdlog::debug("CONSTRUCT: loop_detector");
+    const auto num_validation_threads = yaml_node["num_validation_threads"].as<unsigned int>(4);
+    if (1 < num_validation_threads) {
+        validation_pool_ = std::unique_ptr<util::thread_pool>(new util::thread_pool(num_validation_threads, num_validation_threads));
+    }
+}
+
+loop_detector::~loop_detector() {
+    spdlog::debug("DESTRUCT: loop_detector");
 }
 
 void loop_detector::enable_loop_detector() {
@@ -179,12 +190,23 @@ bool loop_detector::detect_loop_candidates_impl() {
     return !loop_candidates_to_validate_.empty();
 }
 
-bool loop_detector::validate_candidates() {
-    // disallow the removal of the candidates
+void loop_detector::snapshot_candidates() {
+    candidate_snapshots_.clear();
     for (const auto& candidate : loop_candidates_to_validate_) {
+        // disallow the removal of the candidates
         candidate->set_not_to_be_erased();
+        if (candidate->will_be_erased()) {
+            continue;
+        }
+        candidate_snapshots_.push_back(candidate_snapshot{candidate, candidate->get_rot_cw(), candidate->get_trans_cw()});
     }
 
+    cur_lms_snapshot_ = cur_keyfrm_->get_landmarks();
+    cur_rot_cw_snapshot_ = cur_keyfrm_->get_rot_cw();
+    cur_trans_cw_snapshot_ = cur_keyfrm_->get_trans_cw();
+}
+
+bool loop_detector::validate_candidates() {
     auto succeeded = validate_candidates_impl();
     if (succeeded) {
         // allow the removal of the candidates except for the selected one
@@ -201,6 +223,8 @@ bool loop_detector::validate_candidates() {
             loop_candidate->set_to_be_erased();
         }
     }
+    candidate_snapshots_.clear();
+    cur_lms_snapshot_.clear();
     return succeeded;
 }
 
@@ -208,7 +232,7 @@ bool loop_detector::validate_candidates_impl() {
     // 1. for each of the candidates, estimate and validate the Sim3 between it and the current keyframe using the observed landmarks
     //    then, select ONE candaite
 
-    const bool candidate_is_found = select_loop_candidate_via_Sim3(loop_candidates_to_validate_, selected_candidate_,
+    const bool candidate_is_found = select_loop_candidate_via_Sim3(candidate_snapshots_, selected_candidate_,
                                                                    g2o_Sim3_world_to_curr_, curr_match_lms_observed_in_cand_);
     Sim3_world_to_curr_ = util::converter::to_eigen_mat(g2o_Sim3_world_to_curr_);
 
@@ -355,7 +379,7 @@ keyframe_sets loop_detector::find_continuously_detected_keyframe_sets(const keyf
     return curr_cont_detected_keyfrm_sets;
 }
 
-bool loop_detector::select_loop_candidate_via_Sim3(const std::unordered_set<std::shared_ptr<data::keyframe>>& loop_candidates,
+bool loop_detector::select_loop_candidate_via_Sim3(const eigen_alloc_vector<candidate_snapshot>& loop_candidates,
                                                    std::shared_ptr<data::keyframe>& selected_candidate,
                                                    g2o::Sim3& g2o_Sim3_world_to_curr,
                                                    std::vector<std::shared_ptr<data::landmark>>& curr_match_lms_observed_in_cand) const {
@@ -363,240 +387,283 @@ bool loop_detector::select_loop_candidate_via_Sim3(const std::unordered_set<std:
     // the Sim3 is estimated both in linear and non-linear ways
     // if the inlier after the estimation is lower than the threshold, discard tha candidate
 
-    match::robust robust_matcher(0.75, false);
-    match::bow_tree bow_matcher(0.75, false);
-    match::projection projection_matcher(0.75, false);
+    const auto num_candidates = loop_candidates.size();
+    std::vector<verification_result_t> results(num_candidates, verification_result_t::Rejected);
+    eigen_alloc_vector<g2o::Sim3> g2o_Sim3s_world_to_curr(num_candidates);
+    std::vector<std::vector<std::shared_ptr<data::landmark>>> curr_match_lms(num_candidates);
 
-    for (const auto& candidate : loop_candidates) {
-        if (candidate->will_be_erased()) {
-            continue;
+    if (validation_pool_ && 1 < num_candidates) {
+        // verify all of the candidates concurrently
+        std::vector<std::future<verification_result_t>> futures;
+        futures.reserve(num_candidates);
+        for (unsigned int i = 0; i < num_candidates; ++i) {
+            futures.push_back(validation_pool_->submit([this, &loop_candidates, &g2o_Sim3s_world_to_curr, &curr_match_lms, i](const unsigned int) {
+                return verify_loop_candidate_via_Sim3(loop_candidates.at(i), g2o_Sim3s_world_to_curr.at(i), curr_match_lms.at(i));
+            }));
         }
+        // wait for all of the tasks before an exception is rethrown, because they refer to the local variables
+        for (const auto& future : futures) {
+            future.wait();
+        }
+        for (unsigned int i = 0; i < num_candidates; ++i) {
+            results.at(i) = futures.at(i).get();
+        }
+    }
+    else {
+        for (unsigned int i = 0; i < num_candidates; ++i) {
+            results.at(i) = verify_loop_candidate_via_Sim3(loop_candidates.at(i), g2o_Sim3s_world_to_curr.at(i), curr_match_lms.at(i));
+            if (results.at(i) != verification_result_t::Rejected) {
+                break;
+            }
+        }
+    }
 
-        // estimate the matches between the keypoints in the current keyframe and the landmarks observed in the candidate
-        curr_match_lms_observed_in_cand.clear();
-        const auto num_matches = bow_matcher.match_keyframes(cur_keyfrm_, candidate, curr_match_lms_observed_in_cand);
-
-        // check the threshold
-        if (num_matches < num_matches_thr_) {
+    // select the first candidate which is not rejected, so that the result does not depend on the number of threads
+    for (unsigned int i = 0; i < num_candidates; ++i) {
+        if (results.at(i) == verification_result_t::Rejected) {
             continue;
         }
+        if (results.at(i) == verification_result_t::Aborted) {
+            return false;
+        }
 
-        spdlog::debug("Checking if the loop candidate is appropriate: keyframe {} - keyframe {} (num_matches: {})", candidate->id_, cur_keyfrm_->id_, num_matches);
+        selected_candidate = loop_candidates.at(i).keyfrm_;
+        g2o_Sim3_world_to_curr = g2o_Sim3s_world_to_curr.at(i);
+        curr_match_lms_observed_in_cand = std::move(curr_match_lms.at(i));
+        return true;
+    }
 
-        if (num_matches_thr_brute_force_ > 0) {
-            // Look for more correspondence over more time
-            const auto num_matches_brute_force = robust_matcher.match_keyframes(cur_keyfrm_, candidate, curr_match_lms_observed_in_cand, false);
+    return false;
+}
 
-            spdlog::debug("num_matches_brute_force: {}", num_matches_brute_force);
+loop_detector::verification_result_t loop_detector::verify_loop_candidate_via_Sim3(const candidate_snapshot& candidate,
+                                                                                   g2o::Sim3& g2o_Sim3_world_to_curr,
+                                                                                   std::vector<std::shared_ptr<data::landmark>>& curr_match_lms_observed_in_cand) const {
+    match::robust robust_matcher(0.75, false);
+    match::bow_tree bow_matcher(0.75, false);
+    match::projection projection_matcher(0.75, false);
 
-            if (num_matches_brute_force < num_matches_thr_brute_force_) {
-                continue;
-            }
-        }
+    // estimate the matches between the keypoints in the current keyframe and the landmarks observed in the candidate
+    curr_match_lms_observed_in_cand.clear();
+    const auto num_matches = bow_matcher.match_keyframes(cur_keyfrm_, candidate.keyfrm_, curr_match_lms_observed_in_cand);
 
-        std::vector<unsigned int> valid_indices;
-        valid_indices.reserve(curr_match_lms_observed_in_cand.size());
-        for (unsigned int idx = 0; idx < curr_match_lms_observed_in_cand.size(); ++idx) {
-            auto lm = curr_match_lms_observed_in_cand.at(idx);
-            if (!lm) {
-                continue;
-            }
-            if (lm->will_be_erased()) {
-                continue;
-            }
-            valid_indices.push_back(idx);
-        }
+    // check the threshold
+    if (num_matches < num_matches_thr_) {
+        return verification_result_t::Rejected;
+    }
+
+    spdlog::debug("Checking if the loop candidate is appropriate: keyframe {} - keyframe {} (num_matches: {})", candidate.keyfrm_->id_, cur_keyfrm_->id_, num_matches);
+
+    if (num_matches_thr_brute_force_ > 0) {
+        // Look for more correspondence over more time
+        const auto num_matches_brute_force = robust_matcher.match_keyframes(cur_keyfrm_, candidate.keyfrm_, curr_match_lms_observed_in_cand, false);
 
-        // Resample valid elements
-        const auto valid_bearings = util::resample_by_indices(cur_keyfrm_->frm_obs_.bearings_, valid_indices);
-        const auto valid_keypts = util::resample_by_indices(cur_keyfrm_->frm_obs_.undist_keypts_, valid_indices);
-        std::vector<int> octaves(valid_indices.size());
-        for (unsigned int i = 0; i < valid_indices.size(); ++i) {
-            octaves.at(i) = valid_keypts.at(i).octave;
+        spdlog::debug("num_matches_brute_force: {}", num_matches_brute_force);
+
+        if (num_matches_brute_force < num_matches_thr_brute_force_) {
+            return verification_result_t::Rejected;
         }
-        const auto valid_assoc_lms = util::resample_by_indices(curr_match_lms_observed_in_cand, valid_indices);
-        eigen_alloc_vector<Vec3_t> valid_points(valid_indices.size());
-        for (unsigned int i = 0; i < valid_indices.size(); ++i) {
-            valid_points.at(i) = valid_assoc_lms.at(i)->get_pos_in_world();
+    }
+
+    std::vector<unsigned int> valid_indices;
+    valid_indices.reserve(curr_match_lms_observed_in_cand.size());
+    for (unsigned int idx = 0; idx < curr_match_lms_observed_in_cand.size(); ++idx) {
+        auto lm = curr_match_lms_observed_in_cand.at(idx);
+        if (!lm) {
+            continue;
         }
-        // Setup PnP solver
-        auto pnp_solver = std::unique_ptr<solve::pnp_solver>(new solve::pnp_solver(valid_bearings, octaves, valid_points,
-                                                                                   cur_keyfrm_->orb_params_->scale_factors_,
-                                                                                   10, use_fixed_seed_));
-
-        pnp_solver->find_via_ransac(30, false);
-        if (!pnp_solver->solution_is_valid()) {
-            spdlog::debug("solution is not valid.");
+        if (lm->will_be_erased()) {
             continue;
         }
+        valid_indices.push_back(idx);
+    }
 
-        const auto inlier_indices = util::resample_by_indices(valid_indices, pnp_solver->get_inlier_flags());
+    // Resample valid elements
+    const auto valid_bearings = util::resample_by_indices(cur_keyfrm_->frm_obs_.bearings_, valid_indices);
+    const auto valid_keypts = util::resample_by_indices(cur_keyfrm_->frm_obs_.undist_keypts_, valid_indices);
+    std::vector<int> octaves(valid_indices.size());
+    for (unsigned int i = 0; i < valid_indices.size(); ++i) {
+        octaves.at(i) = valid_keypts.at(i).octave;
+    }
+    const auto valid_assoc_lms = util::resample_by_indices(curr_match_lms_observed_in_cand, valid_indices);
+    eigen_alloc_vector<Vec3_t> valid_points(valid_indices.size());
+    for (unsigned int i = 0; i < valid_indices.size(); ++i) {
+        valid_points.at(i) = valid_assoc_lms.at(i)->get_pos_in_world();
+    }
+    // Setup PnP solver
+    auto pnp_solver = std::unique_ptr<solve::pnp_solver>(new solve::pnp_solver(valid_bearings, octaves, valid_points,
+                                                                               cur_keyfrm_->orb_params_->scale_factors_,
+                                                                               10, use_fixed_seed_));
+
+    pnp_solver->find_via_ransac(30, false);
+    if (!pnp_solver->solution_is_valid()) {
+        spdlog::debug("solution is not valid.");
+        return verification_result_t::Rejected;
+    }
 
-        // Set 2D-3D matches for the pose optimization
-        auto lms_in_cand = std::vector<std::shared_ptr<data::landmark>>(cur_keyfrm_->frm_obs_.undist_keypts_.size(), nullptr);
-        for (const auto idx : inlier_indices) {
-            // Set only the valid 3D points to the current frame
-            lms_in_cand.at(idx) = curr_match_lms_observed_in_cand.at(idx);
-        }
-        curr_match_lms_observed_in_cand = lms_in_cand;
-
-        // Pose optimization
-        std::vector<bool> outlier_flags;
-        Mat44_t optimized_pose;
-        auto num_valid_obs = pose_optimizer_->optimize(pnp_solver->get_best_cam_pose(), cur_keyfrm_->frm_obs_, cur_keyfrm_->orb_params_, cur_keyfrm_->camera_,
-                                                       curr_match_lms_observed_in_cand, optimized_pose, outlier_flags);
-
-        // Discard the candidate if the number of the inliers is less than the threshold
-        const int min_num_matches_after_pose_optimize = 10;
-        if (num_valid_obs < min_num_matches_after_pose_optimize) {
-            spdlog::debug("1. Number of inliers ({}) < threshold ({})", num_valid_obs, min_num_matches_after_pose_optimize);
-            continue;
-        }
+    const auto inlier_indices = util::resample_by_indices(valid_indices, pnp_solver->get_inlier_flags());
 
-        // Reject outliers
-        for (unsigned int idx = 0; idx < cur_keyfrm_->frm_obs_.undist_keypts_.size(); idx++) {
-            if (!outlier_flags.at(idx)) {
-                continue;
-            }
-            lms_in_cand.at(idx) = nullptr;
-        }
+    // Set 2D-3D matches for the pose optimization
+    auto lms_in_cand = std::vector<std::shared_ptr<data::landmark>>(cur_keyfrm_->frm_obs_.undist_keypts_.size(), nullptr);
+    for (const auto idx : inlier_indices) {
+        // Set only the valid 3D points to the current frame
+        lms_in_cand.at(idx) = curr_match_lms_observed_in_cand.at(idx);
+    }
+    curr_match_lms_observed_in_cand = lms_in_cand;
+
+    // Pose optimization
+    std::vector<bool> outlier_flags;
+    Mat44_t optimized_pose;
+    auto num_valid_obs = pose_optimizer_->optimize(pnp_solver->get_best_cam_pose(), cur_keyfrm_->frm_obs_, cur_keyfrm_->orb_params_, cur_keyfrm_->camera_,
+                                                   curr_match_lms_observed_in_cand, optimized_pose, outlier_flags);
+
+    // Discard the candidate if the number of the inliers is less than the threshold
+    const int min_num_matches_after_pose_optimize = 10;
+    if (num_valid_obs < min_num_matches_after_pose_optimize) {
+        spdlog::debug("1. Number of inliers ({}) < threshold ({})", num_valid_obs, min_num_matches_after_pose_optimize);
+        return verification_result_t::Rejected;
+    }
 
-        std::set<std::shared_ptr<data::landmark>> already_found_landmarks;
-        for (const auto idx : inlier_indices) {
-            if (outlier_flags.at(idx)) {
-                continue;
-            }
-            // Record the 3D points already associated to the frame keypoints
-            already_found_landmarks.insert(curr_match_lms_observed_in_cand.at(idx));
+    // Reject outliers
+    for (unsigned int idx = 0; idx < cur_keyfrm_->frm_obs_.undist_keypts_.size(); idx++) {
+        if (!outlier_flags.at(idx)) {
+            continue;
         }
+        lms_in_cand.at(idx) = nullptr;
+    }
 
-        // Projection match based on the pre-optimized camera pose
-        auto num_found = projection_matcher.match_frame_and_keyframe(optimized_pose, cur_keyfrm_->camera_, cur_keyfrm_->frm_obs_,
-                                                                     cur_keyfrm_->orb_params_, curr_match_lms_observed_in_cand,
-                                                                     candidate, already_found_landmarks, 10, 100);
-        // Discard the candidate if the number of the inliers is less than the threshold
-        const unsigned int min_num_valid_obs1 = 25;
-        if (already_found_landmarks.size() + num_found < min_num_valid_obs1) {
-            spdlog::debug("2. Number of matches ({}) < threshold ({})",
-                          already_found_landmarks.size() + num_found, min_num_valid_obs1);
+    std::set<std::shared_ptr<data::landmark>> already_found_landmarks;
+    for (const auto idx : inlier_indices) {
+        if (outlier_flags.at(idx)) {
             continue;
         }
+        // Record the 3D points already associated to the frame keypoints
+        already_found_landmarks.insert(curr_match_lms_observed_in_cand.at(idx));
+    }
 
-        Mat44_t optimized_pose1;
-        std::vector<bool> outlier_flags1;
-        auto num_valid_obs1 = pose_optimizer_->optimize(optimized_pose,
-                                                        cur_keyfrm_->frm_obs_, cur_keyfrm_->orb_params_, cur_keyfrm_->camera_,
-                                                        curr_match_lms_observed_in_cand, optimized_pose1, outlier_flags1);
+    // Projection match based on the pre-optimized camera pose
+    auto num_found = projection_matcher.match_frame_and_keyframe(optimized_pose, cur_keyfrm_->camera_, cur_keyfrm_->frm_obs_,
+                                                                 cur_keyfrm_->orb_params_, curr_match_lms_observed_in_cand,
+                                                                 candidate.keyfrm_, already_found_landmarks, 10, 100);
+    // Discard the candidate if the number of the inliers is less than the threshold
+    const unsigned int min_num_valid_obs1 = 25;
+    if (already_found_landmarks.size() + num_found < min_num_valid_obs1) {
+        spdlog::debug("2. Number of matches ({}) < threshold ({})",
+                      already_found_landmarks.size() + num_found, min_num_valid_obs1);
+        return verification_result_t::Rejected;
+    }
 
-        if (num_valid_obs1 < min_num_valid_obs1) {
-            spdlog::debug("2. Number of inliers ({}) < threshold ({})", num_valid_obs1, min_num_valid_obs1);
-            continue;
-        }
+    Mat44_t optimized_pose1;
+    std::vector<bool> outlier_flags1;
+    auto num_valid_obs1 = pose_optimizer_->optimize(optimized_pose,
+                                                    cur_keyfrm_->frm_obs_, cur_keyfrm_->orb_params_, cur_keyfrm_->camera_,
+                                                    curr_match_lms_observed_in_cand, optimized_pose1, outlier_flags1);
 
-        // Exclude the already-associated landmarks
-        std::set<std::shared_ptr<data::landmark>> already_found_landmarks1;
-        for (unsigned int idx = 0; idx < cur_keyfrm_->frm_obs_.undist_keypts_.size(); ++idx) {
-            if (!curr_match_lms_observed_in_cand.at(idx)) {
-                continue;
-            }
-            already_found_landmarks1.insert(curr_match_lms_observed_in_cand.at(idx));
-        }
-        // Apply projection match again, then set the 2D-3D matches
-        auto num_additional = projection_matcher.match_frame_and_keyframe(optimized_pose1, cur_keyfrm_->camera_, cur_keyfrm_->frm_obs_,
-                                                                          cur_keyfrm_->orb_params_, curr_match_lms_observed_in_cand,
-                                                                          candidate, already_found_landmarks, 3, 64);
-
-        const unsigned int min_num_valid_obs2 = 40;
-        // Discard if the number of the observations is less than the threshold
-        if (num_valid_obs1 + num_additional < min_num_valid_obs2) {
-            spdlog::debug("3. Number of matches ({}) < threshold ({})", num_valid_obs1 + num_additional, min_num_valid_obs2);
-            return false;
+    if (num_valid_obs1 < min_num_valid_obs1) {
+        spdlog::debug("2. Number of inliers ({}) < threshold ({})", num_valid_obs1, min_num_valid_obs1);
+        return verification_result_t::Rejected;
+    }
+
+    // Exclude the already-associated landmarks
+    std::set<std::shared_ptr<data::landmark>> already_found_landmarks1;
+    for (unsigned int idx = 0; idx < cur_keyfrm_->frm_obs_.undist_keypts_.size(); ++idx) {
+        if (!curr_match_lms_observed_in_cand.at(idx)) {
+            continue;
         }
+        already_found_landmarks1.insert(curr_match_lms_observed_in_cand.at(idx));
+    }
+    // Apply projection match again, then set the 2D-3D matches
+    auto num_additional = projection_matcher.match_frame_and_keyframe(optimized_pose1, cur_keyfrm_->camera_, cur_keyfrm_->frm_obs_,
+                                                                      cur_keyfrm_->orb_params_, curr_match_lms_observed_in_cand,
+                                                                      candidate.keyfrm_, already_found_landmarks, 3, 64);
+
+    const unsigned int min_num_valid_obs2 = 40;
+    // Discard if the number of the observations is less than the threshold
+    if (num_valid_obs1 + num_additional < min_num_valid_obs2) {
+        spdlog::debug("3. Number of matches ({}) < threshold ({})", num_valid_obs1 + num_additional, min_num_valid_obs2);
+        return verification_result_t::Aborted;
+    }
 
-        // Perform optimization again
-        Mat44_t optimized_pose2;
-        std::vector<bool> outlier_flags2;
-        auto num_valid_obs2 = pose_optimizer_->optimize(optimized_pose1,
-                                                        cur_keyfrm_->frm_obs_, cur_keyfrm_->orb_params_, cur_keyfrm_->camera_,
-                                                        curr_match_lms_observed_in_cand, optimized_pose2, outlier_flags2);
+    // Perform optimization again
+    Mat44_t optimized_pose2;
+    std::vector<bool> outlier_flags2;
+    auto num_valid_obs2 = pose_optimizer_->optimize(optimized_pose1,
+                                                    cur_keyfrm_->frm_obs_, cur_keyfrm_->orb_params_, cur_keyfrm_->camera_,
+                                                    curr_match_lms_observed_in_cand, optimized_pose2, outlier_flags2);
+
+    // Discard if falling below the threshold
+    if (num_valid_obs2 < min_num_valid_obs2) {
+        spdlog::debug("3. Number of inliers ({}) < threshold ({})", num_valid_obs2, min_num_valid_obs2);
+        return verification_result_t::Aborted;
+    }
 
-        // Discard if falling below the threshold
-        if (num_valid_obs2 < min_num_valid_obs2) {
-            spdlog::debug("3. Number of inliers ({}) < threshold ({})", num_valid_obs2, min_num_valid_obs2);
-            return false;
+    // Reject outliers
+    for (unsigned int idx = 0; idx < cur_keyfrm_->frm_obs_.undist_keypts_.size(); ++idx) {
+        if (!outlier_flags2.at(idx)) {
+            continue;
         }
+        curr_match_lms_observed_in_cand.at(idx) = nullptr;
+    }
 
-        // Reject outliers
-        for (unsigned int idx = 0; idx < cur_keyfrm_->frm_obs_.undist_keypts_.size(); ++idx) {
-            if (!outlier_flags2.at(idx)) {
-                continue;
-            }
-            curr_match_lms_observed_in_cand.at(idx) = nullptr;
+    const Mat44_t pose_1w_in_cand = optimized_pose2;
+    const Mat33_t rot_1w_in_cand = pose_1w_in_cand.block<3, 3>(0, 0);
+    const Vec3_t trans_1w_in_cand = pose_1w_in_cand.block<3, 1>(0, 3);
+    const auto& lms_curr = cur_lms_snapshot_;
+    std::vector<float> scales;
+    for (unsigned int idx = 0; idx < lms_curr.size(); ++idx) {
+        const auto& lm_curr = lms_curr.at(idx);
+        auto& lm_cand = curr_match_lms_observed_in_cand.at(idx);
+        if (!lm_cand || !lm_curr) {
+            continue;
         }
-
-        const Mat44_t pose_1w_in_cand = optimized_pose2;
-        const Mat33_t rot_1w_in_cand = pose_1w_in_cand.block<3, 3>(0, 0);
-        const Vec3_t trans_1w_in_cand = pose_1w_in_cand.block<3, 1>(0, 3);
-        auto lms_curr = cur_keyfrm_->get_landmarks();
-        std::vector<float> scales;
-        for (unsigned int idx = 0; idx < lms_curr.size(); ++idx) {
-            auto& lm_curr = lms_curr.at(idx);
-            auto& lm_cand = curr_match_lms_observed_in_cand.at(idx);
-            if (!lm_cand || !lm_curr) {
-                continue;
-            }
-            if (lm_cand->will_be_erased() || lm_curr->will_be_erased()) {
-                continue;
-            }
-            const Vec3_t pos_w_lm_cand = lm_cand->get_pos_in_world();
-            const Vec3_t pos_w_lm_curr = lm_curr->get_pos_in_world();
-            const Vec3_t pos_1_in_cand = rot_1w_in_cand * pos_w_lm_cand + trans_1w_in_cand;
-            const Vec3_t pos_1_in_curr = cur_keyfrm_->get_rot_cw() * pos_w_lm_curr + cur_keyfrm_->get_trans_cw();
-            const float norm_pos_1_in_cand = pos_1_in_cand.norm();
-            const float norm_pos_1_in_curr = pos_1_in_curr.norm();
-            const float cos_parallax = pos_1_in_cand.dot(pos_1_in_curr) / (norm_pos_1_in_cand * norm_pos_1_in_curr);
-            // = cos(0.5deg)
-            constexpr float cos_parallax_thr = 0.99996192306;
-            const bool parallax_is_small = cos_parallax_thr < cos_parallax;
-            if (!parallax_is_small) {
-                continue;
-            }
-            scales.push_back(norm_pos_1_in_curr / norm_pos_1_in_cand);
+        if (lm_cand->will_be_erased() || lm_curr->will_be_erased()) {
+            continue;
         }
-        if (scales.size() < 1) {
-            spdlog::debug("not enough scale references {}", scales.size());
+        const Vec3_t pos_w_lm_cand = lm_cand->get_pos_in_world();
+        const Vec3_t pos_w_lm_curr = lm_curr->get_pos_in_world();
+        const Vec3_t pos_1_in_cand = rot_1w_in_cand * pos_w_lm_cand + trans_1w_in_cand;
+        const Vec3_t pos_1_in_curr = cur_rot_cw_snapshot_ * pos_w_lm_curr + cur_trans_cw_snapshot_;
+        const float norm_pos_1_in_cand = pos_1_in_cand.norm();
+        const float norm_pos_1_in_curr = pos_1_in_curr.norm();
+        const float cos_parallax = pos_1_in_cand.dot(pos_1_in_curr) / (norm_pos_1_in_cand * norm_pos_1_in_curr);
+        // = cos(0.5deg)
+        constexpr float cos_parallax_thr = 0.99996192306;
+        const bool parallax_is_small = cos_parallax_thr < cos_parallax;
+        if (!parallax_is_small) {
             continue;
         }
-        const Mat33_t rot_12 = rot_1w_in_cand * candidate->get_rot_cw().transpose();
-        const Vec3_t trans_12 = -rot_12 * candidate->get_trans_cw() + trans_1w_in_cand;
-        std::sort(scales.begin(), scales.end());
-        const float scale_12 = scales[(scales.size() - 1) / 2];
-
-        // perforn non-linear optimization of the estimated Sim3
+        scales.push_back(norm_pos_1_in_curr / norm_pos_1_in_cand);
+    }
+    if (scales.size() < 1) {
+        spdlog::debug("not enough scale references {}", scales.size());
+        return verification_result_t::Rejected;
+    }
+    const Mat33_t rot_12 = rot_1w_in_cand * candidate.rot_cw_.transpose();
+    const Vec3_t trans_12 = -rot_12 * candidate.trans_cw_ + trans_1w_in_cand;
+    std::sort(scales.begin(), scales.end());
+    const float scale_12 = scales[(scales.size() - 1) / 2];
 
-        projection_matcher.match_keyframes_mutually(cur_keyfrm_, candidate, curr_match_lms_observed_in_cand,
-                                                    scale_12, rot_12, trans_12, 7.5);
+    // perforn non-linear optimization of the estimated Sim3
 
-        g2o::Sim3 g2o_sim3_12(rot_12, trans_12, scale_12);
-        const auto num_optimized_inliers = transform_optimizer_.optimize(cur_keyfrm_, candidate, curr_match_lms_observed_in_cand,
-                                                                         g2o_sim3_12, 10);
+    projection_matcher.match_keyframes_mutually(cur_keyfrm_, candidate.keyfrm_, curr_match_lms_observed_in_cand,
+                                                scale_12, rot_12, trans_12, 7.5);
 
-        // check the threshold
-        if (num_optimized_inliers < num_optimized_inliers_thr_) {
-            continue;
-        }
+    g2o::Sim3 g2o_sim3_12(rot_12, trans_12, scale_12);
+    const auto num_optimized_inliers = transform_optimizer_.optimize(cur_keyfrm_, candidate.keyfrm_, curr_match_lms_observed_in_cand,
+                                                                     g2o_sim3_12, 10);
 
-        spdlog::debug("found loop candidate via nonlinear Sim3 optimization: keyframe {} - keyframe {} (num_optimized_inliers: {})", candidate->id_, cur_keyfrm_->id_, num_optimized_inliers);
+    // check the threshold
+    if (num_optimized_inliers < num_optimized_inliers_thr_) {
+        return verification_result_t::Rejected;
+    }
 
-        selected_candidate = candidate;
-        // convert the estimated Sim3 from "candidate -> current" to "world -> current"
-        // this Sim3 indicates the correct camera pose oof the current keyframe after loop correction
-        g2o_Sim3_world_to_curr = g2o_sim3_12 * g2o::Sim3(candidate->get_rot_cw(), candidate->get_trans_cw(), 1.0);
+    spdlog::debug("found loop candidate via nonlinear Sim3 optimization: keyframe {} - keyframe {} (num_optimized_inliers: {})", candidate.keyfrm_->id_, cur_keyfrm_->id_, num_optimized_inliers);
 
-        return true;
-    }
+    // convert the estimated Sim3 from "candidate -> current" to "world -> current"
+    // this Sim3 indicates the correct camera pose oof the current keyframe after loop correction
+    g2o_Sim3_world_to_curr = g2o_sim3_12 * g2o::Sim3(candidate.rot_cw_, candidate.trans_cw_, 1.0);
 
-    return false;
+    return verification_result_t::Accepted;
 }
 
 std::shared_ptr<data::keyframe> loop_detector::get_selected_candidate_keyframe() const {
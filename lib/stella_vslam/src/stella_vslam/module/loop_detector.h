@@ -8,6 +8,7 @@
 
 #include <atomic>
 #include <memory>
+#include <vector>
 
 #include <yaml-cpp/yaml.h>
 
@@ -18,6 +19,10 @@ class keyframe;
 class bow_database;
 } // namespace data
 
+namespace util {
+class thread_pool;
+} // namespace util
+
 namespace module {
 
 class loop_detector {
@@ -29,6 +34,11 @@ public:
      */
     loop_detector(data::bow_database* bow_db, data::bow_vocabulary* bow_vocab, const YAML::Node& yaml_node, const bool fix_scale_in_Sim3_estimation);
 
+    /**
+     * Destructor
+     */
+    ~loop_detector();
+
     /**
      * Enable loop detection
      */
@@ -59,8 +69,17 @@ public:
      */
     void add_loop_candidate(const std::shared_ptr<data::keyframe>& keyfrm);
 
+    /**
+     * Take a snapshot of the loop candidates and the current keyframe for validate_candidates()
+     * (NOTE: this function must be called while the map database is locked,
+     *        then the candidates cannot be erased until the validation is finished)
+     */
+    void snapshot_candidates();
+
     /**
      * Validate loop candidates selected in detect_loop_candidate()
+     * (NOTE: this function does not require the map database lock,
+     *        and the candidates are verified concurrently if num_validation_threads > 1)
      */
     bool validate_candidates();
 
@@ -111,15 +130,44 @@ private:
     keyframe_sets find_continuously_detected_keyframe_sets(const keyframe_sets& prev_cont_detected_keyfrm_sets,
                                                            const std::vector<std::shared_ptr<data::keyframe>>& keyfrms_to_search) const;
 
+    //! result of the Sim3 verification of a candidate
+    enum class verification_result_t {
+        //! the candidate is discarded
+        Rejected,
+        //! the candidate is selected
+        Accepted,
+        //! the candidate is discarded, and the remaining candidates are not verified
+        Aborted
+    };
+
+    //! the candidate keyframe and its camera pose when the snapshot was taken
+    struct candidate_snapshot {
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+        std::shared_ptr<data::keyframe> keyfrm_;
+        Mat33_t rot_cw_;
+        Vec3_t trans_cw_;
+    };
+
     /**
      * Select ONE candidate from the candidates via linear and nonlinear Sim3 validation
+     * (the first candidate in the snapshot which passes the validation is selected, whether the candidates are verified concurrently or not)
      */
     bool select_loop_candidate_via_Sim3(
-        const std::unordered_set<std::shared_ptr<data::keyframe>>& loop_candidates,
+        const eigen_alloc_vector<candidate_snapshot>& loop_candidates,
         std::shared_ptr<data::keyframe>& selected_candidate,
         g2o::Sim3& g2o_Sim3_world_to_curr,
         std::vector<std::shared_ptr<data::landmark>>& curr_match_lms_observed_in_cand) const;
 
+    /**
+     * Verify ONE candidate via linear and nonlinear Sim3 validation
+     * (NOTE: this function is called from the worker threads concurrently)
+     */
+    verification_result_t verify_loop_candidate_via_Sim3(
+        const candidate_snapshot& candidate,
+        g2o::Sim3& g2o_Sim3_world_to_curr,
+        std::vector<std::shared_ptr<data::landmark>>& curr_match_lms_observed_in_cand) const;
+
     //! BoW database
     data::bow_database* bow_db_;
     //! BoW vocabulary
@@ -177,6 +225,14 @@ private:
     //! loop candidate for validation
     std::unordered_set<std::shared_ptr<data::keyframe>> loop_candidates_to_validate_;
 
+    //! snapshot of the loop candidates (taken by snapshot_candidates())
+    eigen_alloc_vector<candidate_snapshot> candidate_snapshots_;
+    //! snapshot of the landmarks observed in the current keyframe
+    std::vector<std::shared_ptr<data::landmark>> cur_lms_snapshot_;
+    //! snapshot of the camera pose of the current keyframe
+    Mat33_t cur_rot_cw_snapshot_;
+    Vec3_t cur_trans_cw_snapshot_;
+
     //! matches between the keypoint indices of the current keyframe and the landmarks observed in the candidate
     std::vector<std::shared_ptr<data::landmark>> curr_match_lms_observed_in_cand_;
     //! matches between the keypoint indices of the current keyframe and the landmarks observed in covisibilities of the candidate
@@ -193,6 +249,9 @@ private:
     //! Use fixed random seed for RANSAC if true
     const bool use_fixed_seed_;
 
+    //! worker threads to verify the candidates concurrently (nullptr if num_validation_threads <= 1)
+    std::unique_ptr<util::thread_pool> validation_pool_;
+
     const float num_common_words_thr_ratio_ = 0.8f;
 };
 
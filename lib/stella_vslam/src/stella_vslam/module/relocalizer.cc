@@ -7,6 +7,9 @@
 #include "stella_vslam/optimize/pose_optimizer_g2o.h"
 #include "stella_vslam/util/fancy_index.h"
 
+#include <atomic>
+#include <mutex>
+
 #include <spdlog/spdlog.h>
 
 namespace stella_vslam {
@@ -70,22 +73,50 @@ bool relocalizer::reloc_by_candidates(data::frame& curr_frm,
 
     spdlog::debug("Start relocalization. Number of candidate keyframes is {}", num_candidates);
 
+    // Each candidate is tried on a copy of the current frame.
+    // The succeeded candidate which comes first in the list is adopted regardless of the completion order,
+    // so that the result is deterministic (if use_fixed_seed is true) and the same as trying the candidates one by one.
+    // The candidates after the succeeded one are cancelled.
+    std::atomic<unsigned int> best_idx{static_cast<unsigned int>(num_candidates)};
+    std::mutex mtx_best_frm;
+    data::frame best_frm;
+
     // Compute matching points for each candidate by using BoW tree matcher
+#ifdef USE_OPENMP
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
     for (unsigned int i = 0; i < num_candidates; ++i) {
+        const auto is_cancelled = [&best_idx, i]() {
+            return best_idx.load() < i;
+        };
+        if (is_cancelled()) {
+            continue;
+        }
+
         const auto& candidate_keyfrm = reloc_candidates.at(i);
         if (candidate_keyfrm->will_be_erased()) {
             spdlog::debug("keyframe will be erased. candidate keyframe id is {}", candidate_keyfrm->id_);
             continue;
         }
 
-        bool ok = reloc_by_candidate(curr_frm, candidate_keyfrm, use_robust_matcher);
+        data::frame frm = curr_frm;
+        bool ok = reloc_by_candidate(frm, candidate_keyfrm, use_robust_matcher, is_cancelled);
         if (ok) {
-            spdlog::info("relocalization succeeded (frame={}, keyframe={})", curr_frm.id_, candidate_keyfrm->id_);
-            // TODO: should set the reference keyframe of the current frame
-            return true;
+            std::lock_guard<std::mutex> lock(mtx_best_frm);
+            if (i < best_idx.load()) {
+                best_idx = i;
+                best_frm = frm;
+            }
         }
     }
 
+    if (best_idx.load() < num_candidates) {
+        curr_frm = best_frm;
+        spdlog::info("relocalization succeeded (frame={}, keyframe={})", curr_frm.id_, reloc_candidates.at(best_idx.load())->id_);
+        // TODO: should set the reference keyframe of the current frame
+        return true;
+    }
+
     curr_frm.invalidate_pose();
     return false;
 }
@@ -93,10 +124,17 @@ bool relocalizer::reloc_by_candidates(data::frame& curr_frm,
 bool relocalizer::reloc_by_candidate(data::frame& curr_frm,
                                      const std::shared_ptr<stella_vslam::data::keyframe>& candidate_keyfrm,
                                      bool use_robust_matcher) {
+    return reloc_by_candidate(curr_frm, candidate_keyfrm, use_robust_matcher, []() { return false; });
+}
+
+bool relocalizer::reloc_by_candidate(data::frame& curr_frm,
+                                     const std::shared_ptr<stella_vslam::data::keyframe>& candidate_keyfrm,
+                                     bool use_robust_matcher,
+                                     const std::function<bool()>& is_cancelled) {
     std::vector<unsigned int> inlier_indices;
     std::vector<std::shared_ptr<data::landmark>> matched_landmarks;
     bool ok = relocalize_by_pnp_solver(curr_frm, candidate_keyfrm, use_robust_matcher, inlier_indices, matched_landmarks);
-    if (!ok) {
+    if (!ok || is_cancelled()) {
         return false;
     }
 
@@ -109,7 +147,7 @@ bool relocalizer::reloc_by_candidate(data::frame& curr_frm,
 
     std::vector<bool> outlier_flags;
     ok = optimize_pose(curr_frm, candidate_keyfrm, outlier_flags);
-    if (!ok) {
+    if (!ok || is_cancelled()) {
         return false;
     }
 
@@ -123,7 +161,7 @@ bool relocalizer::reloc_by_candidate(data::frame& curr_frm,
     }
 
     ok = refine_pose(curr_frm, candidate_keyfrm, already_found_landmarks);
-    if (!ok) {
+    if (!ok || is_cancelled()) {
         return false;
     }
 
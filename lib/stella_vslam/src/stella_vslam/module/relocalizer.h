@@ -7,6 +7,7 @@
 #include "stella_vslam/optimize/pose_optimizer.h"
 #include "stella_vslam/solve/pnp_solver.h"
 
+#include <functional>
 #include <memory>
 
 namespace stella_vslam {
@@ -41,6 +42,7 @@ public:
     bool relocalize(data::bow_database* bow_db, data::frame& curr_frm);
 
     //! Relocalize the specified frame by given candidates list
+    //! (the candidates are tried in parallel, and the first succeeded one in the list is adopted)
     bool reloc_by_candidates(data::frame& curr_frm,
                              const std::vector<std::shared_ptr<stella_vslam::data::keyframe>>& reloc_candidates,
                              bool use_robust_matcher = false);
@@ -62,6 +64,12 @@ public:
                                   const std::shared_ptr<stella_vslam::data::keyframe>& candidate_keyfrm) const;
 
 private:
+    //! Relocalize the specified frame by the candidate, aborting when is_cancelled() returns true
+    bool reloc_by_candidate(data::frame& curr_frm,
+                            const std::shared_ptr<stella_vslam::data::keyframe>& candidate_keyfrm,
+                            bool use_robust_matcher,
+                            const std::function<bool()>& is_cancelled);
+
     //! Extract valid (non-deleted) landmarks from landmark vector
     std::vector<unsigned int> extract_valid_indices(const std::vector<std::shared_ptr<data::landmark>>& landmarks) const;
 
@@ -254,7 +254,7 @@ void graph_optimizer::optimize(const std::shared_ptr<data::keyframe>& loop_keyfr
     // 5. Update the camera poses and point-cloud
 
     {
-        std::lock_guard<std::mutex> lock(data::map_database::mtx_database_);
+        util::exclusive_lock lock(data::map_database::mtx_database_);
 
         // For modification of a point-cloud, save the post-modified poses of all the keyframes
         std::unordered_map<unsigned int, g2o::Sim3> corrected_Sim3s_wc;
@@ -312,7 +312,7 @@ void local_bundle_adjuster_gtsam::optimize(data::map_database* map_db,
     // 8. Update the information
 
     {
-        std::lock_guard<std::mutex> lock(data::map_database::mtx_database_);
+        util::exclusive_lock lock(data::map_database::mtx_database_);
 
         for (const auto& outlier_obs : outlier_observations) {
             const auto& keyfrm = outlier_obs.first;
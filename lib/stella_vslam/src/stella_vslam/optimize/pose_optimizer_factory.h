@@ -2,6 +2,7 @@
 #define STELLA_VSLAM_OPTIMIZE_POSE_OPTIMIZER_FACTORY_H
 
 #include "stella_vslam/optimize/pose_optimizer_g2o.h"
+#include "stella_vslam/optimize/pose_optimizer_gn.h"
 #ifdef USE_GTSAM
 #include "stella_vslam/optimize/pose_optimizer_gtsam.h"
 #endif // USE_GTSAM
@@ -24,6 +25,13 @@ public:
                 g2o_node["num_trials"].as<unsigned int>(2),
                 g2o_node["num_each_iter"].as<unsigned int>(10)));
         }
+        else if (backend == "gn") {
+            YAML::Node gn_node = util::yaml_optional_ref(yaml_node, "gn");
+            return std::unique_ptr<pose_optimizer>(new pose_optimizer_gn(
+                gn_node["num_trials_robust"].as<unsigned int>(2),
+                gn_node["num_trials"].as<unsigned int>(2),
+                gn_node["num_each_iter"].as<unsigned int>(10)));
+        }
         else if (backend == "gtsam") {
 #ifdef USE_GTSAM
             YAML::Node gtsam_node = util::yaml_optional_ref(yaml_node, "gtsam");
@@ -0,0 +1,484 @@
+#include "stella_vslam/camera/perspective.h"
+#include "stella_vslam/camera/fisheye.h"
+#include "stella_vslam/camera/equirectangular.h"
+#include "stella_vslam/camera/radial_division.h"
+#include "stella_vslam/data/frame.h"
+#include "stella_vslam/data/keyframe.h"
+#include "stella_vslam/data/landmark.h"
+#include "stella_vslam/optimize/pose_optimizer_gn.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <Eigen/Cholesky>
+
+namespace stella_vslam {
+namespace optimize {
+
+namespace {
+
+// Chi-squared value with significance level of 5%
+// Two degree-of-freedom (n=2)
+constexpr float chi_sq_2D = 5.99146;
+// Three degree-of-freedom (n=3)
+constexpr float chi_sq_3D = 7.81473;
+
+//! Intrinsics used in the error functions
+struct camera_params {
+    explicit camera_params(const camera::base* camera)
+        : is_equirectangular_(camera->model_type_ == camera::model_type_t::Equirectangular),
+          focal_x_baseline_(camera->focal_x_baseline_), cols_(camera->cols_), rows_(camera->rows_) {
+        switch (camera->model_type_) {
+            case camera::model_type_t::Perspective: {
+                const auto c = static_cast<const camera::perspective*>(camera);
+                fx_ = c->fx_;
+                fy_ = c->fy_;
+                cx_ = c->cx_;
+                cy_ = c->cy_;
+                break;
+            }
+            case camera::model_type_t::Fisheye: {
+                const auto c = static_cast<const camera::fisheye*>(camera);
+                fx_ = c->fx_;
+                fy_ = c->fy_;
+                cx_ = c->cx_;
+                cy_ = c->cy_;
+                break;
+            }
+            case camera::model_type_t::Equirectangular: {
+                break;
+            }
+            case camera::model_type_t::RadialDivision: {
+                const auto c = static_cast<const camera::radial_division*>(camera);
+                fx_ = c->fx_;
+                fy_ = c->fy_;
+                cx_ = c->cx_;
+                cy_ = c->cy_;
+                break;
+            }
+        }
+    }
+
+    const bool is_equirectangular_;
+    double fx_ = 0.0, fy_ = 0.0, cx_ = 0.0, cy_ = 0.0;
+    const double focal_x_baseline_;
+    const double cols_, rows_;
+};
+
+//! Observations of the landmarks stored as structure of arrays
+//! (a buffer is kept per thread and reused, so that its capacity survives between the calls)
+struct observation_buffer {
+    void clear() {
+        pos_w_x_.clear();
+        pos_w_y_.clear();
+        pos_w_z_.clear();
+        obs_x_.clear();
+        obs_y_.clear();
+        obs_x_right_.clear();
+        inv_sigma_sq_.clear();
+        idx_.clear();
+        is_inlier_.clear();
+    }
+
+    void push_back(const Vec3_t& pos_w, const float obs_x, const float obs_y, const float obs_x_right,
+                   const float inv_sigma_sq, const unsigned int idx) {
+        pos_w_x_.push_back(pos_w(0));
+        pos_w_y_.push_back(pos_w(1));
+        pos_w_z_.push_back(pos_w(2));
+        obs_x_.push_back(obs_x);
+        obs_y_.push_back(obs_y);
+        obs_x_right_.push_back(obs_x_right);
+        inv_sigma_sq_.push_back(inv_sigma_sq);
+        idx_.push_back(idx);
+        is_inlier_.push_back(1);
+    }
+
+    unsigned int size() const {
+        return idx_.size();
+    }
+
+    bool is_monocular(const unsigned int i) const {
+        return obs_x_right_[i] < 0;
+    }
+
+    std::vector<double> pos_w_x_, pos_w_y_, pos_w_z_;
+    std::vector<double> obs_x_, obs_y_, obs_x_right_;
+    std::vector<double> inv_sigma_sq_;
+    std::vector<unsigned int> idx_;
+    //! std::vector<bool> is avoided because of its bit access
+    std::vector<unsigned char> is_inlier_;
+};
+
+//! Camera pose stored in the same form as g2o::SE3Quat
+struct pose_t {
+    Quat_t rot_;
+    Vec3_t trans_;
+};
+
+/**
+ * Compute the reprojection error of the i-th observation (and the Jacobian w.r.t. the left-multiplied increment of the pose)
+ * The third row is zero for the monocular observations.
+ * The error functions and the Jacobians are identical to the pose optimization edges of g2o.
+ */
+inline void compute_error(const observation_buffer& buf, const unsigned int i, const camera_params& cam,
+                          const Mat33_t& rot_cw, const Vec3_t& trans_cw,
+                          Vec3_t& error, MatRC_t<3, 6>* jacobian) {
+    const Vec3_t pos_c = rot_cw * Vec3_t{buf.pos_w_x_[i], buf.pos_w_y_[i], buf.pos_w_z_[i]} + trans_cw;
+    const double x = pos_c(0);
+    const double y = pos_c(1);
+    const double z = pos_c(2);
+
+    if (cam.is_equirectangular_) {
+        const double L = pos_c.norm();
+        const double theta = std::atan2(x, z);
+        const double phi = -std::asin(y / L);
+        error(0) = buf.obs_x_[i] - cam.cols_ * (0.5 + theta / (2 * M_PI));
+        error(1) = buf.obs_y_[i] - cam.rows_ * (0.5 - phi / M_PI);
+        error(2) = 0.0;
+        if (!jacobian) {
+            return;
+        }
+
+        // derivatives of the camera coordinates w.r.t. the increment x = [rx, ry, rz, tx, ty, tz]
+        VecR_t<6> d_pcx_d_x;
+        d_pcx_d_x << 0.0, z, -y, 1.0, 0.0, 0.0;
+        VecR_t<6> d_pcy_d_x;
+        d_pcy_d_x << -z, 0.0, x, 0.0, 1.0, 0.0;
+        VecR_t<6> d_pcz_d_x;
+        d_pcz_d_x << y, -x, 0.0, 0.0, 0.0, 1.0;
+        const Vec6_t d_L_d_x = (1.0 / L) * (x * d_pcx_d_x + y * d_pcy_d_x + z * d_pcz_d_x);
+
+        auto& jac = *jacobian;
+        jac.block<1, 6>(0, 0) = -(cam.cols_ / (2 * M_PI)) * (1.0 / (x * x + z * z))
+                                * (z * d_pcx_d_x - x * d_pcz_d_x);
+        jac.block<1, 6>(1, 0) = -(cam.rows_ / M_PI) * (1.0 / (L * std::sqrt(x * x + z * z)))
+                                * (L * d_pcy_d_x - y * d_L_d_x);
+        jac.block<1, 6>(2, 0).setZero();
+        return;
+    }
+
+    const double reproj_x = cam.fx_ * x / z + cam.cx_;
+    error(0) = buf.obs_x_[i] - reproj_x;
+    error(1) = buf.obs_y_[i] - (cam.fy_ * y / z + cam.cy_);
+    const bool is_monocular = buf.is_monocular(i);
+    error(2) = is_monocular ? 0.0 : buf.obs_x_right_[i] - (reproj_x - cam.focal_x_baseline_ / z);
+    if (!jacobian) {
+        return;
+    }
+
+    const double z_sq = z * z;
+    auto& jac = *jacobian;
+    jac(0, 0) = x * y / z_sq * cam.fx_;
+    jac(0, 1) = -(1.0 + (x * x / z_sq)) * cam.fx_;
+    jac(0, 2) = y / z * cam.fx_;
+    jac(0, 3) = -1.0 / z * cam.fx_;
+    jac(0, 4) = 0.0;
+    jac(0, 5) = x / z_sq * cam.fx_;
+
+    jac(1, 0) = (1.0 + y * y / z_sq) * cam.fy_;
+    jac(1, 1) = -x * y / z_sq * cam.fy_;
+    jac(1, 2) = -x / z * cam.fy_;
+    jac(1, 3) = 0.0;
+    jac(1, 4) = -1.0 / z * cam.fy_;
+    jac(1, 5) = y / z_sq * cam.fy_;
+
+    if (is_monocular) {
+        jac.block<1, 6>(2, 0).setZero();
+        return;
+    }
+    jac(2, 0) = jac(0, 0) - cam.focal_x_baseline_ * y / z_sq;
+    jac(2, 1) = jac(0, 1) + cam.focal_x_baseline_ * x / z_sq;
+    jac(2, 2) = jac(0, 2);
+    jac(2, 3) = jac(0, 3);
+    jac(2, 4) = 0.0;
+    jac(2, 5) = jac(0, 5) - cam.focal_x_baseline_ / z_sq;
+}
+
+//! Chi-squared value of the i-th observation
+inline double compute_chi_sq(const observation_buffer& buf, const unsigned int i, const camera_params& cam,
+                             const Mat33_t& rot_cw, const Vec3_t& trans_cw) {
+    Vec3_t error;
+    compute_error(buf, i, cam, rot_cw, trans_cw, error, nullptr);
+    return buf.inv_sigma_sq_[i] * error.squaredNorm();
+}
+
+//! Value of the Huber loss (rho[0] of g2o::RobustKernelHuber)
+inline double robustify(const double chi_sq, const double delta) {
+    const double delta_sq = delta * delta;
+    if (chi_sq <= delta_sq) {
+        return chi_sq;
+    }
+    return 2.0 * std::sqrt(chi_sq) * delta - delta_sq;
+}
+
+//! Sum of the (robustified) chi-squared values of the inliers (activeRobustChi2 of g2o)
+double compute_total_chi_sq(const observation_buffer& buf, const camera_params& cam, const pose_t& pose,
+                            const bool use_robust_kernel, const double delta) {
+    const Mat33_t rot_cw = pose.rot_.toRotationMatrix();
+    double total_chi_sq = 0.0;
+    for (unsigned int i = 0; i < buf.size(); ++i) {
+        if (!buf.is_inlier_[i]) {
+            continue;
+        }
+        const double chi_sq = compute_chi_sq(buf, i, cam, rot_cw, pose.trans_);
+        total_chi_sq += use_robust_kernel ? robustify(chi_sq, delta) : chi_sq;
+    }
+    return total_chi_sq;
+}
+
+//! Build the normal equations at the pose (the sign of the right hand side follows g2o)
+//! and return the total chi-squared value at the same time
+double build_system(const observation_buffer& buf, const camera_params& cam, const pose_t& pose,
+                    const bool use_robust_kernel, const double delta,
+                    Mat66_t& hessian, Vec6_t& rhs) {
+    const Mat33_t rot_cw = pose.rot_.toRotationMatrix();
+    hessian.setZero();
+    rhs.setZero();
+    double total_chi_sq = 0.0;
+    Vec3_t error;
+    MatRC_t<3, 6> jacobian;
+    for (unsigned int i = 0; i < buf.size(); ++i) {
+        if (!buf.is_inlier_[i]) {
+            continue;
+        }
+        compute_error(buf, i, cam, rot_cw, pose.trans_, error, &jacobian);
+        double weight = buf.inv_sigma_sq_[i];
+        const double chi_sq = weight * error.squaredNorm();
+        if (use_robust_kernel) {
+            total_chi_sq += robustify(chi_sq, delta);
+            // first derivative of the Huber loss
+            if (delta * delta < chi_sq) {
+                weight *= delta / std::sqrt(chi_sq);
+            }
+        }
+        else {
+            total_chi_sq += chi_sq;
+        }
+        hessian.noalias() += weight * jacobian.transpose() * jacobian;
+        rhs.noalias() -= weight * jacobian.transpose() * error;
+    }
+    return total_chi_sq;
+}
+
+//! Left-multiply the exponential of the increment to the pose (identical to g2o::SE3Quat::exp(update) * pose)
+void update_pose(const Vec6_t& update, pose_t& pose) {
+    const Vec3_t omega = update.head<3>();
+    const Vec3_t upsilon = update.tail<3>();
+    const double theta = omega.norm();
+
+    Mat33_t Omega;
+    Omega << 0.0, -omega(2), omega(1),
+        omega(2), 0.0, -omega(0),
+        -omega(1), omega(0), 0.0;
+    Mat33_t R;
+    Mat33_t V;
+    if (theta < 0.00001) {
+        R = Mat33_t::Identity() + Omega + Omega * Omega;
+        V = R;
+    }
+    else {
+        const Mat33_t Omega2 = Omega * Omega;
+        R = Mat33_t::Identity() + std::sin(theta) / theta * Omega + (1 - std::cos(theta)) / (theta * theta) * Omega2;
+        V = Mat33_t::Identity() + (1 - std::cos(theta)) / (theta * theta) * Omega + (theta - std::sin(theta)) / (theta * theta * theta) * Omega2;
+    }
+
+    Quat_t rot_update(R);
+    if (rot_update.w() < 0) {
+        rot_update.coeffs() *= -1;
+    }
+    rot_update.normalize();
+
+    pose.trans_ = V * upsilon + rot_update * pose.trans_;
+    pose.rot_ = rot_update * pose.rot_;
+    if (pose.rot_.w() < 0) {
+        pose.rot_.coeffs() *= -1;
+    }
+    pose.rot_.normalize();
+}
+
+/**
+ * Levenberg-Marquardt optimization with the same schedule as g2o::OptimizationAlgorithmLevenberg
+ * and the same termination criterion as terminate_action (gain threshold of 1e-3)
+ */
+void optimize_pose(const observation_buffer& buf, const camera_params& cam,
+                   const bool use_robust_kernel, const double delta,
+                   const unsigned int num_iter, pose_t& pose) {
+    constexpr double gain_threshold = 1e-3;
+    constexpr unsigned int max_trials_after_failure = 10;
+    constexpr double tau = 1e-5;
+    constexpr double good_step_lower_scale = 1.0 / 3.0;
+    constexpr double good_step_upper_scale = 2.0 / 3.0;
+
+    Mat66_t hessian;
+    Vec6_t rhs;
+    double lambda = 0.0;
+    double ni = 2.0;
+    double last_chi_sq = 0.0;
+
+    for (unsigned int iter = 0; iter < num_iter; ++iter) {
+        double current_chi_sq = build_system(buf, cam, pose, use_robust_kernel, delta, hessian, rhs);
+
+        if (iter == 0) {
+            lambda = tau * hessian.diagonal().maxCoeff();
+            ni = 2.0;
+        }
+
+        double rho = 0.0;
+        unsigned int num_trials = 0;
+        do {
+            const pose_t prev_pose = pose;
+
+            Mat66_t damped_hessian = hessian;
+            damped_hessian.diagonal().array() += lambda;
+            const Eigen::LDLT<Mat66_t> ldlt(damped_hessian);
+            const Vec6_t update = ldlt.solve(rhs);
+            const bool solved = ldlt.info() == Eigen::Success;
+            update_pose(update, pose);
+
+            const double temp_chi_sq = solved
+                                           ? compute_total_chi_sq(buf, cam, pose, use_robust_kernel, delta)
+                                           : std::numeric_limits<double>::max();
+            const double scale = update.dot(lambda * update + rhs) + 1e-3;
+            rho = (current_chi_sq - temp_chi_sq) / scale;
+
+            if (0 < rho && std::isfinite(temp_chi_sq)) {
+                // the last step was good
+                const double alpha = std::min(1.0 - std::pow(2.0 * rho - 1.0, 3), good_step_upper_scale);
+                lambda *= std::max(good_step_lower_scale, alpha);
+                ni = 2.0;
+                current_chi_sq = temp_chi_sq;
+            }
+            else {
+                lambda *= ni;
+                ni *= 2.0;
+                pose = prev_pose;
+            }
+            ++num_trials;
+        } while (rho < 0 && num_trials < max_trials_after_failure);
+
+        // corresponds to terminate_action, which is called after each iteration
+        if (iter == 0) {
+            last_chi_sq = current_chi_sq;
+        }
+        else {
+            const double gain = (last_chi_sq - current_chi_sq) / current_chi_sq;
+            last_chi_sq = current_chi_sq;
+            if (0 <= gain && gain < gain_threshold) {
+                break;
+            }
+        }
+
+        if (num_trials == max_trials_after_failure || rho == 0 || !std::isfinite(lambda)) {
+            break;
+        }
+    }
+}
+
+} // namespace
+
+pose_optimizer_gn::pose_optimizer_gn(const unsigned int num_trials_robust, const unsigned int num_trials, const unsigned int num_each_iter)
+    : num_trials_robust_(num_trials_robust), num_trials_(num_trials), num_each_iter_(num_each_iter) {}
+
+unsigned int pose_optimizer_gn::optimize(const data::frame& frm, Mat44_t& optimized_pose, std::vector<bool>& outlier_flags) const {
+    auto num_valid_obs = optimize(frm.get_pose_cw(), frm.frm_obs_, frm.orb_params_, frm.camera_,
+                                  frm.get_landmarks(), optimized_pose, outlier_flags);
+    return num_valid_obs;
+}
+
+unsigned int pose_optimizer_gn::optimize(const data::keyframe* keyfrm, Mat44_t& optimized_pose, std::vector<bool>& outlier_flags) const {
+    auto num_valid_obs = optimize(keyfrm->get_pose_cw(), keyfrm->frm_obs_, keyfrm->orb_params_, keyfrm->camera_,
+                                  keyfrm->get_landmarks(), optimized_pose, outlier_flags);
+    return num_valid_obs;
+}
+
+unsigned int pose_optimizer_gn::optimize(const Mat44_t& cam_pose_cw, const data::frame_observation& frm_obs,
+                                         const feature::orb_params* orb_params,
+                                         const camera::base* camera,
+                                         const std::vector<std::shared_ptr<data::landmark>>& landmarks,
+                                         Mat44_t& optimized_pose,
+                                         std::vector<bool>& outlier_flags) const {
+    // 1. Collect the observations
+
+    // The optimizer can be called from several threads at the same time (e.g. relocalization)
+    static thread_local observation_buffer buf;
+    buf.clear();
+
+    const camera_params cam(camera);
+
+    pose_t pose;
+    pose.rot_ = Quat_t(Mat33_t(cam_pose_cw.block<3, 3>(0, 0)));
+    pose.rot_.normalize();
+    pose.trans_ = cam_pose_cw.block<3, 1>(0, 3);
+
+    const unsigned int num_keypts = frm_obs.undist_keypts_.size();
+    outlier_flags.resize(num_keypts);
+    std::fill(outlier_flags.begin(), outlier_flags.end(), false);
+
+    for (unsigned int idx = 0; idx < num_keypts; ++idx) {
+        const auto& lm = landmarks.at(idx);
+        if (!lm) {
+            continue;
+        }
+        if (lm->will_be_erased()) {
+            continue;
+        }
+
+        const auto& undist_keypt = frm_obs.undist_keypts_.at(idx);
+        const float x_right = frm_obs.stereo_x_right_.empty() ? -1.0f : frm_obs.stereo_x_right_.at(idx);
+        const float inv_sigma_sq = orb_params->inv_level_sigma_sq_.at(undist_keypt.octave);
+        buf.push_back(lm->get_pos_in_world(), undist_keypt.pt.x, undist_keypt.pt.y, x_right, inv_sigma_sq, idx);
+    }
+
+    const unsigned int num_init_obs = buf.size();
+    if (num_init_obs < 5) {
+        return 0;
+    }
+
+    // 2. Perform robust optimization with the same outlier rejection schedule as pose_optimizer_g2o
+
+    const float sqrt_chi_sq = (camera->setup_type_ == camera::setup_type_t::Monocular)
+                                  ? std::sqrt(chi_sq_2D)
+                                  : std::sqrt(chi_sq_3D);
+
+    unsigned int num_bad_obs = 0;
+    for (unsigned int trial = 0; trial < num_trials_robust_ + num_trials_; ++trial) {
+        // The robust kernel is removed after the last robust trial, unless no non-robust trial follows
+        const bool use_robust_kernel = num_trials_robust_ != 0
+                                       && (num_trials_ == 0 || trial < num_trials_robust_);
+        optimize_pose(buf, cam, use_robust_kernel, sqrt_chi_sq, num_each_iter_, pose);
+
+        num_bad_obs = 0;
+
+        const Mat33_t rot_cw = pose.rot_.toRotationMatrix();
+        for (unsigned int i = 0; i < buf.size(); ++i) {
+            const double chi_sq = compute_chi_sq(buf, i, cam, rot_cw, pose.trans_);
+            const float chi_sq_thr = buf.is_monocular(i) ? chi_sq_2D : chi_sq_3D;
+            if (chi_sq_thr < chi_sq) {
+                outlier_flags.at(buf.idx_[i]) = true;
+                buf.is_inlier_[i] = 0;
+                ++num_bad_obs;
+            }
+            else {
+                outlier_flags.at(buf.idx_[i]) = false;
+                buf.is_inlier_[i] = 1;
+            }
+        }
+
+        if (num_init_obs - num_bad_obs < 5) {
+            break;
+        }
+    }
+
+    // 3. Update the information
+
+    optimized_pose = Mat44_t::Identity();
+    optimized_pose.block<3, 3>(0, 0) = pose.rot_.toRotationMatrix();
+    optimized_pose.block<3, 1>(0, 3) = pose.trans_;
+
+    return num_init_obs - num_bad_obs;
+}
+
+} // namespace optimize
+} // namespace stella_vslam
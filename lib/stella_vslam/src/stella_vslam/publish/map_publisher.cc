@@ -63,9 +63,13 @@ unsigned int map_publisher::get_landmarks(std::vector<std::shared_ptr<data::land
         }
     }
 
+    get_local_landmarks(local_landmarks);
+    return map_db_->get_num_landmarks();
+}
+
+void map_publisher::get_local_landmarks(std::set<std::shared_ptr<data::landmark>>& local_landmarks) {
     const auto _local_landmarks = map_db_->get_local_landmarks();
     local_landmarks = std::set<std::shared_ptr<data::landmark>>(_local_landmarks.begin(), _local_landmarks.end());
-    return map_db_->get_num_landmarks();
 }
 
 unsigned int map_publisher::get_markers(std::vector<std::shared_ptr<data::marker>>& all_markers) {
@@ -73,5 +77,13 @@ unsigned int map_publisher::get_markers(std::vector<std::shared_ptr<data::marker
     return all_markers.size();
 }
 
+uint64_t map_publisher::get_map_version() {
+    return map_db_->get_version();
+}
+
+void map_publisher::get_changes_since(const uint64_t version, data::map_changes& changes, const bool include_landmarks) {
+    map_db_->get_changes_since(version, changes, include_landmarks);
+}
+
 } // namespace publish
 } // namespace stella_vslam
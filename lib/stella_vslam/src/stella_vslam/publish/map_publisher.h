@@ -3,8 +3,11 @@
 
 #include "stella_vslam/type.h"
 
+#include <set>
 #include <mutex>
 #include <memory>
+#include <vector>
+#include <cstdint>
 
 namespace stella_vslam {
 
@@ -14,6 +17,7 @@ namespace data {
 class keyframe;
 class landmark;
 class map_database;
+struct map_changes;
 class marker;
 } // namespace data
 
@@ -65,8 +69,29 @@ public:
     unsigned int get_landmarks(std::vector<std::shared_ptr<data::landmark>>& all_landmarks,
                                std::set<std::shared_ptr<data::landmark>>& local_landmarks);
 
+    /**
+     * Get local landmarks
+     * @param local_landmarks
+     */
+    void get_local_landmarks(std::set<std::shared_ptr<data::landmark>>& local_landmarks);
+
     unsigned int get_markers(std::vector<std::shared_ptr<data::marker>>& all_markers);
 
+    /**
+     * Get the current version of the map
+     * @return
+     */
+    uint64_t get_map_version();
+
+    /**
+     * Get the keyframes and the landmarks changed since the version of the map
+     * (use this instead of get_keyframes() and get_landmarks() to publish only the changes)
+     * @param version
+     * @param changes
+     * @param include_landmarks if false, the changes of the landmarks are not collected
+     */
+    void get_changes_since(const uint64_t version, data::map_changes& changes, const bool include_landmarks = true);
+
 private:
     //! config
     std::shared_ptr<config> cfg_;
@@ -19,6 +19,7 @@
 #include "stella_vslam/marker_model/aruconano.h"
 #include "stella_vslam/marker_detector/aruconano.h"
 #endif // USE_ARUCO_NANO
+#include "stella_vslam/match/hamming.h"
 #include "stella_vslam/match/stereo.h"
 #include "stella_vslam/feature/orb_extractor.h"
 #include "stella_vslam/io/trajectory_io.h"
@@ -27,14 +28,26 @@
 #include "stella_vslam/publish/frame_publisher.h"
 #include "stella_vslam/util/converter.h"
 #include "stella_vslam/util/image_converter.h"
+#include "stella_vslam/util/thread_pool.h"
 #include "stella_vslam/util/yaml.h"
 
+#include <algorithm>
 #include <thread>
 
 #include <spdlog/spdlog.h>
 
 namespace stella_vslam {
 
+namespace {
+
+std::future<std::shared_ptr<Mat44_t>> make_ready_future(std::shared_ptr<Mat44_t> cam_pose_wc) {
+    std::promise<std::shared_ptr<Mat44_t>> promise;
+    promise.set_value(std::move(cam_pose_wc));
+    return promise.get_future();
+}
+
+} // namespace
+
 system::system(const std::shared_ptr<config>& cfg, const std::string& vocab_file_path)
     : cfg_(cfg) {
     spdlog::debug("CONSTRUCT: system");
@@ -54,11 +67,13 @@ system::system(const std::shared_ptr<config>& cfg, const std::string& vocab_file
     camera_ = camera::camera_factory::create(util::yaml_optional_ref(cfg->yaml_node_, "Camera"));
     orb_params_ = new feature::orb_params(util::yaml_optional_ref(cfg->yaml_node_, "Feature"));
     spdlog::info("load orb_params \"{}\"", orb_params_->name_);
+    spdlog::debug("Hamming distance kernel: {}", match::hamming::kernel_type_to_string.at(static_cast<unsigned int>(match::hamming::get_kernel_type())));
 
     // database
     cam_db_ = new data::camera_database();
     cam_db_->add_camera(camera_);
-    map_db_ = new data::map_database(system_params["min_num_shared_lms"].as<unsigned int>(15));
+    map_db_ = new data::map_database(system_params["min_num_shared_lms"].as<unsigned int>(15),
+                                     util::yaml_optional_ref(cfg->yaml_node_, "FrameStatistics"));
     if (bow_vocab_) {
         bow_db_ = new data::bow_database(bow_vocab_);
     }
@@ -71,7 +86,7 @@ system::system(const std::shared_ptr<config>& cfg, const std::string& vocab_file
 
     // map I/O
     auto map_format = system_params["map_format"].as<std::string>("msgpack");
-    map_database_io_ = io::map_database_io_factory::create(map_format);
+    map_database_io_ = io::map_database_io_factory::create(map_format, system_params["save_bow_vectors"].as<bool>(false), bow_vocab_);
 
     // tracking module
     tracker_ = new tracking_module(cfg_, camera_, map_db_, bow_vocab_, bow_db_);
@@ -100,6 +115,16 @@ system::system(const std::shared_ptr<config>& cfg, const std::string& vocab_file
         extractor_right_ = new feature::orb_extractor(orb_params_, min_size, desc_type, mask_rectangles);
     }
 
+    // frame pipeline (each preprocessing thread has its own ORB extractors)
+    num_preprocessing_threads_ = system_params["num_preprocessing_threads"].as<unsigned int>(0);
+    max_num_queued_frames_ = std::max(1u, system_params["max_num_queued_frames"].as<unsigned int>(2));
+    for (unsigned int i = 0; i < num_preprocessing_threads_; ++i) {
+        pipeline_extractors_left_.emplace_back(new feature::orb_extractor(orb_params_, min_size, desc_type, mask_rectangles));
+        if (camera_->setup_type_ == camera::setup_type_t::Stereo) {
+            pipeline_extractors_right_.emplace_back(new feature::orb_extractor(orb_params_, min_size, desc_type, mask_rectangles));
+        }
+    }
+
     num_grid_cols_ = preprocessing_params["num_grid_cols"].as<unsigned int>(64);
     num_grid_rows_ = preprocessing_params["num_grid_rows"].as<unsigned int>(48);
 
@@ -136,6 +161,9 @@ system::system(const std::shared_ptr<config>& cfg, const std::string& vocab_file
 }
 
 system::~system() {
+    tracking_pool_.reset(nullptr);
+    preprocessing_pool_.reset(nullptr);
+
     global_optimization_thread_.reset(nullptr);
     if (global_optimizer_) {
         delete global_optimizer_;
@@ -208,9 +236,20 @@ void system::startup(const bool need_initialize) {
     if (global_optimizer_) {
         global_optimization_thread_ = std::unique_ptr<std::thread>(new std::thread(&stella_vslam::global_optimization_module::run, global_optimizer_));
     }
+
+    if (0 < num_preprocessing_threads_) {
+        spdlog::info("frame pipeline: {} preprocessing threads, {} queued frames at most", num_preprocessing_threads_, max_num_queued_frames_);
+        preprocessing_pool_ = std::unique_ptr<util::thread_pool>(new util::thread_pool(num_preprocessing_threads_, max_num_queued_frames_));
+        tracking_pool_ = std::unique_ptr<util::thread_pool>(new util::thread_pool(1, max_num_queued_frames_));
+    }
 }
 
 void system::shutdown() {
+    // finish the frames in the pipeline
+    // (the tracking thread waits for the preprocessing threads, so it must be stopped first)
+    tracking_pool_.reset(nullptr);
+    preprocessing_pool_.reset(nullptr);
+
     // terminate the other threads
     if (global_optimizer_) {
         auto future_mapper_terminate = mapper_->async_terminate();
@@ -229,6 +268,13 @@ void system::shutdown() {
         global_optimization_thread_->join();
     }
 
+    const auto& mtx_database = data::map_database::mtx_database_;
+    spdlog::debug("map database lock (99th percentile): exclusive wait {:.3f} ms, exclusive hold {:.3f} ms, shared wait {:.3f} ms, shared hold {:.3f} ms",
+                  mtx_database.get_exclusive_wait_histogram().get_percentile_ms(99.0),
+                  mtx_database.get_exclusive_hold_histogram().get_percentile_ms(99.0),
+                  mtx_database.get_shared_wait_histogram().get_percentile_ms(99.0),
+                  mtx_database.get_shared_hold_histogram().get_percentile_ms(99.0));
+
     spdlog::info("shutdown SLAM system");
     system_is_running_ = false;
 }
@@ -253,7 +299,11 @@ bool system::load_map_database(const std::string& path) const {
     bool ok = map_database_io_->load(path, cam_db_, orb_params_db_, map_db_, bow_db_, bow_vocab_);
     auto keyfrms = map_db_->get_all_keyframes();
 
-    for (const auto& keyfrm : keyfrms) {
+#ifdef USE_OPENMP
+#pragma omp parallel for
+#endif
+    for (unsigned int i = 0; i < keyfrms.size(); ++i) {
+        const auto& keyfrm = keyfrms.at(i);
         keyfrm->frm_obs_.num_grid_cols_ = num_grid_cols_;
         keyfrm->frm_obs_.num_grid_rows_ = num_grid_rows_;
         data::assign_keypoints_to_grid(keyfrm->camera_, keyfrm->frm_obs_.undist_keypts_, keyfrm->frm_obs_.keypt_indices_in_cells_,
@@ -365,7 +415,40 @@ void system::enable_temporal_mapping() {
     map_db_->set_fixed_keyframe_id_threshold();
 }
 
+const util::latency_histogram& system::get_mapping_queue_latency_histogram() const {
+    return mapper_->get_queue_latency_histogram();
+}
+
+const util::latency_histogram& system::get_mapping_latency_histogram() const {
+    return mapper_->get_mapping_latency_histogram();
+}
+
+const util::latency_histogram* system::get_global_optimization_queue_latency_histogram() const {
+    return global_optimizer_ ? &global_optimizer_->get_queue_latency_histogram() : nullptr;
+}
+
+util::queue_metrics system::get_mapping_queue_metrics() const {
+    return mapper_->get_queue_metrics();
+}
+
+util::queue_metrics system::get_global_optimization_queue_metrics() const {
+    return global_optimizer_ ? global_optimizer_->get_queue_metrics() : util::queue_metrics();
+}
+
+struct system::preprocessed_frame {
+    data::frame frm_;
+    //! keypoints before undistortion (for visualization)
+    std::vector<cv::KeyPoint> keypts_;
+    double extraction_time_elapsed_ms_;
+};
+
 data::frame system::create_monocular_frame(const cv::Mat& img, const double timestamp, const cv::Mat& mask) {
+    return create_monocular_frame(img, timestamp, mask, next_frame_id_++, extractor_left_, keypts_);
+}
+
+data::frame system::create_monocular_frame(const cv::Mat& img, const double timestamp, const cv::Mat& mask,
+                                           const unsigned int frame_id, feature::orb_extractor* extractor,
+                                           std::vector<cv::KeyPoint>& keypts) {
     // color conversion
     if (!camera_->is_valid_shape(img)) {
         spdlog::warn("preprocess: Input image size is invalid");
@@ -376,17 +459,14 @@ data::frame system::create_monocular_frame(const cv::Mat& img, const double time
     data::frame_observation frm_obs;
 
     // Extract ORB feature
-    keypts_.clear();
-    extractor_left_->extract(img_gray, mask, keypts_, frm_obs.descriptors_);
-    if (keypts_.empty()) {
+    keypts.clear();
+    extractor->extract(img_gray, mask, keypts, frm_obs.descriptors_);
+    if (keypts.empty()) {
         spdlog::warn("preprocess: cannot extract any keypoints");
     }
 
-    // Undistort keypoints
-    camera_->undistort_keypoints(keypts_, frm_obs.undist_keypts_);
-
-    // Convert to bearing vector
-    camera_->convert_keypoints_to_bearings(frm_obs.undist_keypts_, frm_obs.bearings_);
+    // Undistort keypoints and convert them to bearing vectors
+    camera_->undistort_keypoints_and_convert_to_bearings(keypts, frm_obs.undist_keypts_, frm_obs.bearings_);
 
     // Assign all the keypoints into grid
     frm_obs.num_grid_cols_ = num_grid_cols_;
@@ -396,14 +476,18 @@ data::frame system::create_monocular_frame(const cv::Mat& img, const double time
 
     // Detect marker
     std::unordered_map<unsigned int, data::marker2d> markers_2d;
-    if (marker_detector_) {
-        marker_detector_->detect(img_gray, markers_2d);
-    }
+    detect_markers(img_gray, markers_2d);
 
-    return data::frame(next_frame_id_++, timestamp, camera_, orb_params_, frm_obs, std::move(markers_2d));
+    return data::frame(frame_id, timestamp, camera_, orb_params_, frm_obs, std::move(markers_2d));
 }
 
 data::frame system::create_stereo_frame(const cv::Mat& left_img, const cv::Mat& right_img, const double timestamp, const cv::Mat& mask) {
+    return create_stereo_frame(left_img, right_img, timestamp, mask, next_frame_id_++, extractor_left_, extractor_right_, keypts_, true);
+}
+
+data::frame system::create_stereo_frame(const cv::Mat& left_img, const cv::Mat& right_img, const double timestamp, const cv::Mat& mask,
+                                        const unsigned int frame_id, feature::orb_extractor* extractor_left, feature::orb_extractor* extractor_right,
+                                        std::vector<cv::KeyPoint>& keypts, const bool extract_in_parallel) {
     // color conversion
     if (!camera_->is_valid_shape(left_img)) {
         spdlog::warn("preprocess: Input image size is invalid");
@@ -423,32 +507,33 @@ data::frame system::create_stereo_frame(const cv::Mat& left_img, const cv::Mat&
     cv::Mat descriptors_right;
 
     // Extract ORB feature
-    keypts_.clear();
-    std::thread thread_left([this, &frm_obs, &img_gray, &mask]() {
-        extractor_left_->extract(img_gray, mask, keypts_, frm_obs.descriptors_);
-    });
-    std::thread thread_right([this, &frm_obs, &right_img_gray, &mask, &keypts_right, &descriptors_right]() {
-        extractor_right_->extract(right_img_gray, mask, keypts_right, descriptors_right);
-    });
-    thread_left.join();
-    thread_right.join();
-    if (keypts_.empty()) {
+    // (the right image is processed by another thread only when the frames are not preprocessed in parallel)
+    keypts.clear();
+    if (extract_in_parallel) {
+        std::thread thread_right([extractor_right, &right_img_gray, &mask, &keypts_right, &descriptors_right]() {
+            extractor_right->extract(right_img_gray, mask, keypts_right, descriptors_right);
+        });
+        extractor_left->extract(img_gray, mask, keypts, frm_obs.descriptors_);
+        thread_right.join();
+    }
+    else {
+        extractor_left->extract(img_gray, mask, keypts, frm_obs.descriptors_);
+        extractor_right->extract(right_img_gray, mask, keypts_right, descriptors_right);
+    }
+    if (keypts.empty()) {
         spdlog::warn("preprocess: cannot extract any keypoints");
     }
 
-    // Undistort keypoints
-    camera_->undistort_keypoints(keypts_, frm_obs.undist_keypts_);
+    // Undistort keypoints and convert them to bearing vectors
+    camera_->undistort_keypoints_and_convert_to_bearings(keypts, frm_obs.undist_keypts_, frm_obs.bearings_);
 
     // Estimate depth with stereo match
-    match::stereo stereo_matcher(extractor_left_->image_pyramid_, extractor_right_->image_pyramid_,
-                                 keypts_, keypts_right, frm_obs.descriptors_, descriptors_right,
+    match::stereo stereo_matcher(extractor_left->image_pyramid_, extractor_right->image_pyramid_,
+                                 keypts, keypts_right, frm_obs.descriptors_, descriptors_right,
                                  orb_params_->scale_factors_, orb_params_->inv_scale_factors_,
                                  camera_->focal_x_baseline_, camera_->true_baseline_);
     stereo_matcher.compute(frm_obs.stereo_x_right_, frm_obs.depths_);
 
-    // Convert to bearing vector
-    camera_->convert_keypoints_to_bearings(frm_obs.undist_keypts_, frm_obs.bearings_);
-
     // Assign all the keypoints into grid
     frm_obs.num_grid_cols_ = num_grid_cols_;
     frm_obs.num_grid_rows_ = num_grid_rows_;
@@ -457,14 +542,18 @@ data::frame system::create_stereo_frame(const cv::Mat& left_img, const cv::Mat&
 
     // Detect marker
     std::unordered_map<unsigned int, data::marker2d> markers_2d;
-    if (marker_detector_) {
-        marker_detector_->detect(img_gray, markers_2d);
-    }
+    detect_markers(img_gray, markers_2d);
 
-    return data::frame(next_frame_id_++, timestamp, camera_, orb_params_, frm_obs, std::move(markers_2d));
+    return data::frame(frame_id, timestamp, camera_, orb_params_, frm_obs, std::move(markers_2d));
 }
 
 data::frame system::create_RGBD_frame(const cv::Mat& rgb_img, const cv::Mat& depthmap, const double timestamp, const cv::Mat& mask) {
+    return create_RGBD_frame(rgb_img, depthmap, timestamp, mask, next_frame_id_++, extractor_left_, keypts_);
+}
+
+data::frame system::create_RGBD_frame(const cv::Mat& rgb_img, const cv::Mat& depthmap, const double timestamp, const cv::Mat& mask,
+                                      const unsigned int frame_id, feature::orb_extractor* extractor,
+                                      std::vector<cv::KeyPoint>& keypts) {
     // color and depth scale conversion
     if (!camera_->is_valid_shape(rgb_img)) {
         spdlog::warn("preprocess: Input image size is invalid");
@@ -480,14 +569,14 @@ data::frame system::create_RGBD_frame(const cv::Mat& rgb_img, const cv::Mat& dep
     data::frame_observation frm_obs;
 
     // Extract ORB feature
-    keypts_.clear();
-    extractor_left_->extract(img_gray, mask, keypts_, frm_obs.descriptors_);
-    if (keypts_.empty()) {
+    keypts.clear();
+    extractor->extract(img_gray, mask, keypts, frm_obs.descriptors_);
+    if (keypts.empty()) {
         spdlog::warn("preprocess: cannot extract any keypoints");
     }
 
-    // Undistort keypoints
-    camera_->undistort_keypoints(keypts_, frm_obs.undist_keypts_);
+    // Undistort keypoints and convert them to bearing vectors
+    camera_->undistort_keypoints_and_convert_to_bearings(keypts, frm_obs.undist_keypts_, frm_obs.bearings_);
 
     // Calculate disparity from depth
     // Initialize with invalid value
@@ -495,7 +584,7 @@ data::frame system::create_RGBD_frame(const cv::Mat& rgb_img, const cv::Mat& dep
     frm_obs.depths_ = std::vector<float>(frm_obs.undist_keypts_.size(), -1);
 
     for (unsigned int idx = 0; idx < frm_obs.undist_keypts_.size(); idx++) {
-        const auto& keypt = keypts_.at(idx);
+        const auto& keypt = keypts.at(idx);
         const auto& undist_keypt = frm_obs.undist_keypts_.at(idx);
 
         const float x = keypt.pt.x;
@@ -511,9 +600,6 @@ data::frame system::create_RGBD_frame(const cv::Mat& rgb_img, const cv::Mat& dep
         frm_obs.stereo_x_right_.at(idx) = undist_keypt.pt.x - camera_->focal_x_baseline_ / depth;
     }
 
-    // Convert to bearing vector
-    camera_->convert_keypoints_to_bearings(frm_obs.undist_keypts_, frm_obs.bearings_);
-
     // Assign all the keypoints into grid
     frm_obs.num_grid_cols_ = num_grid_cols_;
     frm_obs.num_grid_rows_ = num_grid_rows_;
@@ -522,14 +608,24 @@ data::frame system::create_RGBD_frame(const cv::Mat& rgb_img, const cv::Mat& dep
 
     // Detect marker
     std::unordered_map<unsigned int, data::marker2d> markers_2d;
-    if (marker_detector_) {
-        marker_detector_->detect(img_gray, markers_2d);
-    }
+    detect_markers(img_gray, markers_2d);
 
-    return data::frame(next_frame_id_++, timestamp, camera_, orb_params_, frm_obs, std::move(markers_2d));
+    return data::frame(frame_id, timestamp, camera_, orb_params_, frm_obs, std::move(markers_2d));
+}
+
+void system::detect_markers(const cv::Mat& img_gray, std::unordered_map<unsigned int, data::marker2d>& markers_2d) {
+    if (!marker_detector_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mtx_marker_detector_);
+    marker_detector_->detect(img_gray, markers_2d);
 }
 
 std::shared_ptr<Mat44_t> system::feed_monocular_frame(const cv::Mat& img, const double timestamp, const cv::Mat& mask) {
+    if (frame_pipeline_is_enabled()) {
+        return async_feed_monocular_frame(img, timestamp, mask).get();
+    }
+
     check_reset_request();
 
     assert(camera_->setup_type_ == camera::setup_type_t::Monocular);
@@ -545,6 +641,10 @@ std::shared_ptr<Mat44_t> system::feed_monocular_frame(const cv::Mat& img, const
 }
 
 std::shared_ptr<Mat44_t> system::feed_stereo_frame(const cv::Mat& left_img, const cv::Mat& right_img, const double timestamp, const cv::Mat& mask) {
+    if (frame_pipeline_is_enabled()) {
+        return async_feed_stereo_frame(left_img, right_img, timestamp, mask).get();
+    }
+
     check_reset_request();
 
     assert(camera_->setup_type_ == camera::setup_type_t::Stereo);
@@ -560,6 +660,10 @@ std::shared_ptr<Mat44_t> system::feed_stereo_frame(const cv::Mat& left_img, cons
 }
 
 std::shared_ptr<Mat44_t> system::feed_RGBD_frame(const cv::Mat& rgb_img, const cv::Mat& depthmap, const double timestamp, const cv::Mat& mask) {
+    if (frame_pipeline_is_enabled()) {
+        return async_feed_RGBD_frame(rgb_img, depthmap, timestamp, mask).get();
+    }
+
     check_reset_request();
 
     assert(camera_->setup_type_ == camera::setup_type_t::RGBD);
@@ -574,7 +678,99 @@ std::shared_ptr<Mat44_t> system::feed_RGBD_frame(const cv::Mat& rgb_img, const c
     return feed_frame(frm, rgb_img, extraction_time_elapsed_ms);
 }
 
+std::future<std::shared_ptr<Mat44_t>> system::async_feed_monocular_frame(const cv::Mat& img, const double timestamp, const cv::Mat& mask) {
+    if (!frame_pipeline_is_enabled()) {
+        return make_ready_future(feed_monocular_frame(img, timestamp, mask));
+    }
+    if (img.empty()) {
+        spdlog::warn("preprocess: empty image");
+        return make_ready_future(nullptr);
+    }
+
+    assert(camera_->setup_type_ == camera::setup_type_t::Monocular);
+    // the frame ID is assigned in the order of feeding
+    const auto frame_id = next_frame_id_++;
+    auto preprocessed = preprocessing_pool_->submit([this, img, timestamp, mask, frame_id](const unsigned int worker_idx) {
+        const auto start = std::chrono::system_clock::now();
+        std::vector<cv::KeyPoint> keypts;
+        auto frm = create_monocular_frame(img, timestamp, mask, frame_id, pipeline_extractors_left_.at(worker_idx).get(), keypts);
+        const auto end = std::chrono::system_clock::now();
+        double extraction_time_elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+        return preprocessed_frame{std::move(frm), std::move(keypts), extraction_time_elapsed_ms};
+    });
+    return queue_tracking(std::move(preprocessed), img);
+}
+
+std::future<std::shared_ptr<Mat44_t>> system::async_feed_stereo_frame(const cv::Mat& left_img, const cv::Mat& right_img, const double timestamp, const cv::Mat& mask) {
+    if (!frame_pipeline_is_enabled()) {
+        return make_ready_future(feed_stereo_frame(left_img, right_img, timestamp, mask));
+    }
+    if (left_img.empty() || right_img.empty()) {
+        spdlog::warn("preprocess: empty image");
+        return make_ready_future(nullptr);
+    }
+
+    assert(camera_->setup_type_ == camera::setup_type_t::Stereo);
+    // the frame ID is assigned in the order of feeding
+    const auto frame_id = next_frame_id_++;
+    auto preprocessed = preprocessing_pool_->submit([this, left_img, right_img, timestamp, mask, frame_id](const unsigned int worker_idx) {
+        const auto start = std::chrono::system_clock::now();
+        std::vector<cv::KeyPoint> keypts;
+        // the left and right images are processed sequentially because the frames are already processed in parallel
+        auto frm = create_stereo_frame(left_img, right_img, timestamp, mask, frame_id,
+                                       pipeline_extractors_left_.at(worker_idx).get(), pipeline_extractors_right_.at(worker_idx).get(),
+                                       keypts, false);
+        const auto end = std::chrono::system_clock::now();
+        double extraction_time_elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+        return preprocessed_frame{std::move(frm), std::move(keypts), extraction_time_elapsed_ms};
+    });
+    return queue_tracking(std::move(preprocessed), left_img);
+}
+
+std::future<std::shared_ptr<Mat44_t>> system::async_feed_RGBD_frame(const cv::Mat& rgb_img, const cv::Mat& depthmap, const double timestamp, const cv::Mat& mask) {
+    if (!frame_pipeline_is_enabled()) {
+        return make_ready_future(feed_RGBD_frame(rgb_img, depthmap, timestamp, mask));
+    }
+    if (rgb_img.empty() || depthmap.empty()) {
+        spdlog::warn("preprocess: empty image");
+        return make_ready_future(nullptr);
+    }
+
+    assert(camera_->setup_type_ == camera::setup_type_t::RGBD);
+    // the frame ID is assigned in the order of feeding
+    const auto frame_id = next_frame_id_++;
+    auto preprocessed = preprocessing_pool_->submit([this, rgb_img, depthmap, timestamp, mask, frame_id](const unsigned int worker_idx) {
+        const auto start = std::chrono::system_clock::now();
+        std::vector<cv::KeyPoint> keypts;
+        auto frm = create_RGBD_frame(rgb_img, depthmap, timestamp, mask, frame_id, pipeline_extractors_left_.at(worker_idx).get(), keypts);
+        const auto end = std::chrono::system_clock::now();
+        double extraction_time_elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+        return preprocessed_frame{std::move(frm), std::move(keypts), extraction_time_elapsed_ms};
+    });
+    return queue_tracking(std::move(preprocessed), rgb_img);
+}
+
+bool system::frame_pipeline_is_enabled() const {
+    return static_cast<bool>(tracking_pool_);
+}
+
+std::future<std::shared_ptr<Mat44_t>> system::queue_tracking(std::future<preprocessed_frame> preprocessed, const cv::Mat& img) {
+    // NOTE: std::future cannot be moved into a lambda in C++11
+    auto shared_preprocessed = std::make_shared<std::future<preprocessed_frame>>(std::move(preprocessed));
+    // The single tracking thread processes the frames in the order of feeding
+    return tracking_pool_->submit([this, shared_preprocessed, img](const unsigned int) {
+        auto preprocessed_frm = shared_preprocessed->get();
+        check_reset_request();
+        return feed_frame(preprocessed_frm.frm_, img, preprocessed_frm.extraction_time_elapsed_ms_, preprocessed_frm.keypts_);
+    });
+}
+
 std::shared_ptr<Mat44_t> system::feed_frame(const data::frame& frm, const cv::Mat& img, const double extraction_time_elapsed_ms) {
+    return feed_frame(frm, img, extraction_time_elapsed_ms, keypts_);
+}
+
+std::shared_ptr<Mat44_t> system::feed_frame(const data::frame& frm, const cv::Mat& img, const double extraction_time_elapsed_ms,
+                                            std::vector<cv::KeyPoint>& keypts) {
     const auto start = std::chrono::system_clock::now();
 
     const auto cam_pose_wc = tracker_->feed_frame(frm);
@@ -589,7 +785,7 @@ std::shared_ptr<Mat44_t> system::feed_frame(const data::frame& frm, const cv::Ma
     frame_publisher_->update(tracker_->curr_frm_.get_landmarks(),
                              !mapper_->is_paused(),
                              tracker_->tracking_state_,
-                             keypts_,
+                             keypts,
                              mkrs2d,
                              img,
                              tracking_time_elapsed_ms,
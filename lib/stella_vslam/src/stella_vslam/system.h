@@ -10,6 +10,9 @@
 #include <mutex>
 #include <atomic>
 #include <memory>
+#include <future>
+#include <vector>
+#include <unordered_map>
 
 #include <opencv2/core/mat.hpp>
 
@@ -30,6 +33,7 @@ class camera_database;
 class orb_params_database;
 class map_database;
 class bow_database;
+class marker2d;
 } // namespace data
 
 namespace feature {
@@ -50,6 +54,12 @@ namespace io {
 class map_database_io_base;
 }
 
+namespace util {
+class latency_histogram;
+struct queue_metrics;
+class thread_pool;
+} // namespace util
+
 class system {
 public:
     //! Constructor
@@ -124,6 +134,23 @@ public:
     //! Enable temporal mapping
     void enable_temporal_mapping();
 
+    //! Get the histogram of the time from queueing a keyframe to starting its mapping
+    const util::latency_histogram& get_mapping_queue_latency_histogram() const;
+
+    //! Get the histogram of the time from queueing a keyframe to finishing its mapping (including local BA)
+    const util::latency_histogram& get_mapping_latency_histogram() const;
+
+    //! Get the histogram of the time from queueing a keyframe to starting its loop detection
+    //! (nullptr if the global optimization module is not used)
+    const util::latency_histogram* get_global_optimization_queue_latency_histogram() const;
+
+    //! Get the back-pressure metrics of the keyframe queue of the mapping module
+    util::queue_metrics get_mapping_queue_metrics() const;
+
+    //! Get the back-pressure metrics of the keyframe queue of the global optimization module
+    //! (all zero if the global optimization module is not used)
+    util::queue_metrics get_global_optimization_queue_metrics() const;
+
     //-----------------------------------------
     // data feeding methods
 
@@ -144,6 +171,18 @@ public:
     data::frame create_RGBD_frame(const cv::Mat& rgb_img, const cv::Mat& depthmap, const double timestamp, const cv::Mat& mask);
     std::shared_ptr<Mat44_t> feed_RGBD_frame(const cv::Mat& rgb_img, const cv::Mat& depthmap, const double timestamp, const cv::Mat& mask = cv::Mat{});
 
+    //! Feed frames asynchronously
+    //! If System.num_preprocessing_threads is positive, the feature extraction of the next frames overlaps the tracking of the current one,
+    //! and the caller is blocked only when System.max_num_queued_frames frames are waiting.
+    //! Otherwise, the frame is processed synchronously and a ready future is returned.
+    //! (NOTE: the futures become ready in the order of feeding. The images must not be modified until then.)
+    std::future<std::shared_ptr<Mat44_t>> async_feed_monocular_frame(const cv::Mat& img, const double timestamp, const cv::Mat& mask = cv::Mat{});
+    std::future<std::shared_ptr<Mat44_t>> async_feed_stereo_frame(const cv::Mat& left_img, const cv::Mat& right_img, const double timestamp, const cv::Mat& mask = cv::Mat{});
+    std::future<std::shared_ptr<Mat44_t>> async_feed_RGBD_frame(const cv::Mat& rgb_img, const cv::Mat& depthmap, const double timestamp, const cv::Mat& mask = cv::Mat{});
+
+    //! The frames are processed by the pipeline or not
+    bool frame_pipeline_is_enabled() const;
+
     //-----------------------------------------
     // pose initializing/updating
 
@@ -194,6 +233,31 @@ private:
     //! Check reset request of the system
     void check_reset_request();
 
+    //! Result of the preprocessing of a frame
+    struct preprocessed_frame;
+
+    //! Create frames with the given ORB extractors
+    //! (NOTE: keypts is the output of the keypoints before undistortion)
+    data::frame create_monocular_frame(const cv::Mat& img, const double timestamp, const cv::Mat& mask,
+                                       const unsigned int frame_id, feature::orb_extractor* extractor,
+                                       std::vector<cv::KeyPoint>& keypts);
+    data::frame create_stereo_frame(const cv::Mat& left_img, const cv::Mat& right_img, const double timestamp, const cv::Mat& mask,
+                                    const unsigned int frame_id, feature::orb_extractor* extractor_left, feature::orb_extractor* extractor_right,
+                                    std::vector<cv::KeyPoint>& keypts, const bool extract_in_parallel);
+    data::frame create_RGBD_frame(const cv::Mat& rgb_img, const cv::Mat& depthmap, const double timestamp, const cv::Mat& mask,
+                                  const unsigned int frame_id, feature::orb_extractor* extractor,
+                                  std::vector<cv::KeyPoint>& keypts);
+
+    //! Feed a frame to the tracking module and update the publishers
+    std::shared_ptr<Mat44_t> feed_frame(const data::frame& frm, const cv::Mat& img, const double extraction_time_elapsed_ms,
+                                        std::vector<cv::KeyPoint>& keypts);
+
+    //! Queue the tracking of a frame which is being preprocessed in the pipeline
+    std::future<std::shared_ptr<Mat44_t>> queue_tracking(std::future<preprocessed_frame> preprocessed, const cv::Mat& img);
+
+    //! Detect markers (the marker detector is shared by all the preprocessing threads)
+    void detect_markers(const cv::Mat& img_gray, std::unordered_map<unsigned int, data::marker2d>& markers_2d);
+
     //! Pause the mapping module and the global optimization module
     void pause_other_threads() const;
 
@@ -247,6 +311,22 @@ private:
     //! ORB extractor only when used in initializing
     feature::orb_extractor* ini_extractor_left_ = nullptr;
 
+    // frame pipeline
+    //! number of threads to preprocess frames (0: the frame pipeline is disabled)
+    unsigned int num_preprocessing_threads_ = 0;
+    //! maximum number of frames waiting for preprocessing or tracking
+    unsigned int max_num_queued_frames_ = 2;
+    //! ORB extractors for left/monocular image of the preprocessing threads
+    std::vector<std::unique_ptr<feature::orb_extractor>> pipeline_extractors_left_;
+    //! ORB extractors for right image of the preprocessing threads
+    std::vector<std::unique_ptr<feature::orb_extractor>> pipeline_extractors_right_;
+    //! threads to preprocess frames (feature extraction, undistortion, etc.)
+    std::unique_ptr<util::thread_pool> preprocessing_pool_;
+    //! single thread to track the preprocessed frames in order
+    std::unique_ptr<util::thread_pool> tracking_pool_;
+    //! mutex for the marker detector
+    std::mutex mtx_marker_detector_;
+
     //! number of columns of grid to accelerate reprojection matching
     unsigned int num_grid_cols_ = 64;
     //! number of rows of grid to accelerate reprojection matching
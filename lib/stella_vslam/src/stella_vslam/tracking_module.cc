@@ -190,7 +190,7 @@ bool tracking_module::track(bool relocalization_is_needed,
                             unsigned int& num_reliable_lms,
                             const unsigned int min_num_obs_thr) {
     // LOCK the map database
-    std::lock_guard<std::mutex> lock1(data::map_database::mtx_database_);
+    util::shared_lock lock1(data::map_database::mtx_database_);
     std::lock_guard<std::mutex> lock2(mtx_last_frm_);
 
     // update the camera pose of the last frame
@@ -301,7 +301,7 @@ bool tracking_module::track_local_map_without_temporal_keyframes(unsigned int& n
 bool tracking_module::initialize() {
     {
         // LOCK the map database
-        std::lock_guard<std::mutex> lock1(data::map_database::mtx_database_);
+        util::exclusive_lock lock1(data::map_database::mtx_database_);
         std::lock_guard<std::mutex> lock2(mtx_stop_keyframe_insertion_);
 
         // try to initialize with the current frame
@@ -322,8 +322,7 @@ bool tracking_module::initialize() {
     // pass all of the keyframes to the mapping module
     assert(!is_stopped_keyframe_insertion_);
     for (const auto& keyfrm : curr_frm_.ref_keyfrm_->graph_node_->get_keyframes_from_root()) {
-        auto future = mapper_->async_add_keyframe(keyfrm);
-        future.get();
+        mapper_->wait_for_keyframe_mapping(mapper_->queue_keyframe(keyfrm));
     }
 
     // succeeded
@@ -549,14 +548,11 @@ bool tracking_module::search_local_landmarks(unsigned int fixed_keyframe_id_thre
         lm->increase_num_observable();
     }
 
-    bool found_proj_candidate = false;
-    // temporary variables
-    Vec2_t reproj;
-    float x_right;
-    unsigned int pred_scale_level;
-    eigen_alloc_unord_map<unsigned int, Vec2_t> lm_to_reproj;
-    std::unordered_map<unsigned int, float> lm_to_x_right;
-    std::unordered_map<unsigned int, unsigned int> lm_to_scale;
+    // select the landmarks to be tested, then gather their attributes from the arena
+    std::vector<std::shared_ptr<data::landmark>> candidate_lms;
+    std::vector<data::landmark_handle> candidate_handles;
+    candidate_lms.reserve(local_landmarks_.size());
+    candidate_handles.reserve(local_landmarks_.size());
     for (const auto& lm : local_landmarks_) {
         if (curr_landmark_ids.count(lm->id_)) {
             continue;
@@ -579,18 +575,34 @@ bool tracking_module::search_local_landmarks(unsigned int fixed_keyframe_id_thre
                 continue;
             }
         }
+        candidate_lms.push_back(lm);
+        candidate_handles.push_back(lm->get_handle());
+    }
 
-        // check the observability
-        if (curr_frm_.can_observe(lm, 0.5, reproj, x_right, pred_scale_level)) {
-            lm_to_reproj[lm->id_] = reproj;
-            lm_to_x_right[lm->id_] = x_right;
-            lm_to_scale[lm->id_] = pred_scale_level;
-
-            // this landmark is observable from the current frame
-            lm->increase_num_observable();
+    // check the observability of all the candidates at once
+    data::landmark_batch candidate_batch;
+    map_db_->get_landmark_arena().gather(candidate_handles, candidate_batch);
+    eigen_alloc_vector<Vec2_t> reprojs;
+    std::vector<float> x_rights;
+    std::vector<unsigned int> pred_scale_levels;
+    std::vector<uint8_t> is_observable;
+    curr_frm_.can_observe(candidate_batch, 0.5, reprojs, x_rights, pred_scale_levels, is_observable);
 
-            found_proj_candidate = true;
+    bool found_proj_candidate = false;
+    for (unsigned int i = 0; i < candidate_lms.size(); ++i) {
+        const auto& lm = candidate_lms.at(i);
+        // the landmarks which are not mirrored in the arena are checked one by one
+        if (!candidate_batch.is_valid_.at(i)) {
+            is_observable.at(i) = curr_frm_.can_observe(lm, 0.5, reprojs.at(i), x_rights.at(i), pred_scale_levels.at(i));
+        }
+        if (!is_observable.at(i)) {
+            continue;
         }
+
+        // this landmark is observable from the current frame
+        lm->increase_num_observable();
+
+        found_proj_candidate = true;
     }
 
     if (!found_proj_candidate) {
@@ -603,7 +615,8 @@ bool tracking_module::search_local_landmarks(unsigned int fixed_keyframe_id_thre
     const float margin = (curr_frm_.id_ < last_reloc_frm_id_ + 2)
                              ? margin_local_map_projection_unstable_
                              : margin_local_map_projection_;
-    projection_matcher.match_frame_and_landmarks(curr_frm_, local_landmarks_, lm_to_reproj, lm_to_x_right, lm_to_scale, margin);
+    projection_matcher.match_frame_and_landmarks(curr_frm_, candidate_lms, candidate_batch, reprojs, x_rights, pred_scale_levels,
+                                                 is_observable, margin);
     return true;
 }
 
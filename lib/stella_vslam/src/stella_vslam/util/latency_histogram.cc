@@ -0,0 +1,88 @@
+#include "stella_vslam/util/latency_histogram.h"
+
+#include <algorithm>
+
+namespace stella_vslam {
+namespace util {
+
+constexpr unsigned int latency_histogram::num_bins;
+
+latency_histogram::latency_histogram() {
+    clear();
+}
+
+void latency_histogram::add(const std::chrono::steady_clock::duration& latency) {
+    const auto latency_us = static_cast<uint64_t>(std::max<long long>(0, std::chrono::duration_cast<std::chrono::microseconds>(latency).count()));
+
+    // index of the most significant bit
+    unsigned int bin = 0;
+    for (auto v = latency_us >> 1; v != 0 && bin + 1 < num_bins; v >>= 1) {
+        ++bin;
+    }
+
+    bins_.at(bin).fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_us_.fetch_add(latency_us, std::memory_order_relaxed);
+    auto max_us = max_us_.load(std::memory_order_relaxed);
+    while (max_us < latency_us && !max_us_.compare_exchange_weak(max_us, latency_us, std::memory_order_relaxed)) {
+    }
+}
+
+void latency_histogram::clear() {
+    for (auto& bin : bins_) {
+        bin.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_us_.store(0, std::memory_order_relaxed);
+    max_us_.store(0, std::memory_order_relaxed);
+}
+
+unsigned int latency_histogram::get_count() const {
+    return count_.load(std::memory_order_relaxed);
+}
+
+double latency_histogram::get_mean_ms() const {
+    const auto count = count_.load(std::memory_order_relaxed);
+    return count == 0 ? 0.0 : static_cast<double>(sum_us_.load(std::memory_order_relaxed)) / count / 1e3;
+}
+
+double latency_histogram::get_max_ms() const {
+    return static_cast<double>(max_us_.load(std::memory_order_relaxed)) / 1e3;
+}
+
+double latency_histogram::get_percentile_ms(const double percentile) const {
+    const auto bins = get_bins();
+    unsigned int count = 0;
+    for (const auto num_samples : bins) {
+        count += num_samples;
+    }
+    const double max_ms = get_max_ms();
+    if (count == 0) {
+        return 0.0;
+    }
+    const double target = std::min(std::max(percentile, 0.0), 100.0) / 100.0 * count;
+    unsigned int accum = 0;
+    for (unsigned int i = 0; i < num_bins; ++i) {
+        accum += bins[i];
+        if (bins[i] != 0 && target <= accum) {
+            // the maximum is a tighter limit for the last occupied bin
+            return i + 1 < num_bins ? std::min(get_bin_lower_limit_ms(i + 1), max_ms) : max_ms;
+        }
+    }
+    return max_ms;
+}
+
+std::array<unsigned int, latency_histogram::num_bins> latency_histogram::get_bins() const {
+    std::array<unsigned int, num_bins> bins;
+    for (unsigned int i = 0; i < num_bins; ++i) {
+        bins[i] = bins_[i].load(std::memory_order_relaxed);
+    }
+    return bins;
+}
+
+double latency_histogram::get_bin_lower_limit_ms(const unsigned int i) {
+    return i == 0 ? 0.0 : static_cast<double>(1ull << i) / 1e3;
+}
+
+} // namespace util
+} // namespace stella_vslam
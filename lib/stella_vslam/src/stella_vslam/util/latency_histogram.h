@@ -0,0 +1,62 @@
+#ifndef STELLA_VSLAM_UTIL_LATENCY_HISTOGRAM_H
+#define STELLA_VSLAM_UTIL_LATENCY_HISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace stella_vslam {
+namespace util {
+
+/**
+ * Lock-free histogram of latencies with logarithmic bins.
+ * The samples are counted with atomic operations, so that recording does not serialize the callers
+ * (the statistics read while samples are being added can be slightly inconsistent with each other).
+ * The i-th bin counts the latencies in [2^i, 2^(i+1)) microseconds
+ * (the first bin also includes latencies shorter than 1 microsecond, and the last bin has no upper limit).
+ */
+class latency_histogram {
+public:
+    static constexpr unsigned int num_bins = 24;
+
+    latency_histogram();
+
+    latency_histogram(const latency_histogram&) = delete;
+    latency_histogram& operator=(const latency_histogram&) = delete;
+
+    //! Add a latency
+    void add(const std::chrono::steady_clock::duration& latency);
+
+    //! Clear all the samples
+    void clear();
+
+    //! Get the number of samples
+    unsigned int get_count() const;
+
+    //! Get the mean latency [ms]
+    double get_mean_ms() const;
+
+    //! Get the maximum latency [ms]
+    double get_max_ms() const;
+
+    //! Get the upper limit of the bin containing the given percentile (0-100) [ms]
+    double get_percentile_ms(const double percentile) const;
+
+    //! Get the sample counts of the bins
+    std::array<unsigned int, num_bins> get_bins() const;
+
+    //! Get the lower limit of the i-th bin [ms]
+    static double get_bin_lower_limit_ms(const unsigned int i);
+
+private:
+    std::array<std::atomic<unsigned int>, num_bins> bins_;
+    std::atomic<unsigned int> count_;
+    std::atomic<uint64_t> sum_us_;
+    std::atomic<uint64_t> max_us_;
+};
+
+} // namespace util
+} // namespace stella_vslam
+
+#endif // STELLA_VSLAM_UTIL_LATENCY_HISTOGRAM_H
@@ -0,0 +1,78 @@
+#include "stella_vslam/util/shared_mutex.h"
+
+namespace stella_vslam {
+namespace util {
+
+void shared_mutex::lock() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    ++num_waiting_writers_;
+    cv_writer_.wait(lock, [this] { return !writer_is_active_ && num_readers_ == 0; });
+    --num_waiting_writers_;
+    writer_is_active_ = true;
+}
+
+void shared_mutex::unlock() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        writer_is_active_ = false;
+    }
+    // the waiting writer has priority, and the readers check it by themselves
+    cv_writer_.notify_one();
+    cv_readers_.notify_all();
+}
+
+void shared_mutex::lock_shared() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    cv_readers_.wait(lock, [this] { return !writer_is_active_ && num_waiting_writers_ == 0; });
+    ++num_readers_;
+}
+
+void shared_mutex::unlock_shared() {
+    bool writer_can_acquire = false;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        --num_readers_;
+        writer_can_acquire = num_readers_ == 0 && num_waiting_writers_ != 0;
+    }
+    if (writer_can_acquire) {
+        cv_writer_.notify_one();
+    }
+}
+
+void shared_mutex::clear_histograms() {
+    exclusive_wait_hist_.clear();
+    exclusive_hold_hist_.clear();
+    shared_wait_hist_.clear();
+    shared_hold_hist_.clear();
+}
+
+exclusive_lock::exclusive_lock(shared_mutex& mtx)
+    : mtx_(mtx) {
+    const auto start = std::chrono::steady_clock::now();
+    mtx_.lock();
+    locked_time_ = std::chrono::steady_clock::now();
+    mtx_.exclusive_wait_hist_.add(locked_time_ - start);
+}
+
+exclusive_lock::~exclusive_lock() {
+    const auto hold_time = std::chrono::steady_clock::now() - locked_time_;
+    mtx_.unlock();
+    mtx_.exclusive_hold_hist_.add(hold_time);
+}
+
+shared_lock::shared_lock(shared_mutex& mtx)
+    : mtx_(mtx) {
+    const auto start = std::chrono::steady_clock::now();
+    mtx_.lock_shared();
+    locked_time_ = std::chrono::steady_clock::now();
+    mtx_.shared_wait_hist_.add(locked_time_ - start);
+}
+
+shared_lock::~shared_lock() {
+    const auto hold_time = std::chrono::steady_clock::now() - locked_time_;
+    mtx_.unlock_shared();
+    mtx_.shared_hold_hist_.add(hold_time);
+}
+
+} // namespace util
+} // namespace stella_vslam
@@ -0,0 +1,118 @@
+#ifndef STELLA_VSLAM_UTIL_SHARED_MUTEX_H
+#define STELLA_VSLAM_UTIL_SHARED_MUTEX_H
+
+#include "stella_vslam/util/latency_histogram.h"
+
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
+
+namespace stella_vslam {
+namespace util {
+
+/**
+ * Reader-writer mutex (substitute for std::shared_mutex, which is not available in C++11).
+ * Writers are preferred, so that a stream of readers cannot starve a writer.
+ * The time to acquire and the time to hold the ownership are recorded
+ * when the mutex is locked via exclusive_lock and shared_lock.
+ */
+class shared_mutex {
+public:
+    shared_mutex() = default;
+    shared_mutex(const shared_mutex&) = delete;
+    shared_mutex& operator=(const shared_mutex&) = delete;
+
+    //! Acquire the exclusive ownership
+    void lock();
+
+    //! Release the exclusive ownership
+    void unlock();
+
+    //! Acquire the shared ownership
+    void lock_shared();
+
+    //! Release the shared ownership
+    void unlock_shared();
+
+    //! histogram of the time to acquire the exclusive ownership
+    const latency_histogram& get_exclusive_wait_histogram() const {
+        return exclusive_wait_hist_;
+    }
+
+    //! histogram of the time to hold the exclusive ownership
+    const latency_histogram& get_exclusive_hold_histogram() const {
+        return exclusive_hold_hist_;
+    }
+
+    //! histogram of the time to acquire the shared ownership
+    const latency_histogram& get_shared_wait_histogram() const {
+        return shared_wait_hist_;
+    }
+
+    //! histogram of the time to hold the shared ownership
+    const latency_histogram& get_shared_hold_histogram() const {
+        return shared_hold_hist_;
+    }
+
+    //! Clear all the histograms
+    void clear_histograms();
+
+private:
+    friend class exclusive_lock;
+    friend class shared_lock;
+
+    std::mutex mtx_;
+    //! notified when a writer can acquire the ownership
+    std::condition_variable cv_writer_;
+    //! notified when readers can acquire the ownership
+    std::condition_variable cv_readers_;
+
+    //! number of the readers holding the shared ownership
+    unsigned int num_readers_ = 0;
+    //! number of the writers waiting for the exclusive ownership
+    unsigned int num_waiting_writers_ = 0;
+    //! true if a writer holds the exclusive ownership
+    bool writer_is_active_ = false;
+
+    latency_histogram exclusive_wait_hist_;
+    latency_histogram exclusive_hold_hist_;
+    latency_histogram shared_wait_hist_;
+    latency_histogram shared_hold_hist_;
+};
+
+/**
+ * RAII guard for the exclusive ownership of shared_mutex
+ */
+class exclusive_lock {
+public:
+    explicit exclusive_lock(shared_mutex& mtx);
+    ~exclusive_lock();
+
+    exclusive_lock(const exclusive_lock&) = delete;
+    exclusive_lock& operator=(const exclusive_lock&) = delete;
+
+private:
+    shared_mutex& mtx_;
+    std::chrono::steady_clock::time_point locked_time_;
+};
+
+/**
+ * RAII guard for the shared ownership of shared_mutex
+ */
+class shared_lock {
+public:
+    explicit shared_lock(shared_mutex& mtx);
+    ~shared_lock();
+
+    shared_lock(const shared_lock&) = delete;
+    shared_lock& operator=(const shared_lock&) = delete;
+
+private:
+    shared_mutex& mtx_;
+    std::chrono::steady_clock::time_point locked_time_;
+};
+
+} // namespace util
+} // namespace stella_vslam
+
+#endif // STELLA_VSLAM_UTIL_SHARED_MUTEX_H
@@ -0,0 +1,205 @@
+#ifndef STELLA_VSLAM_UTIL_SPSC_QUEUE_H
+#define STELLA_VSLAM_UTIL_SPSC_QUEUE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+namespace stella_vslam {
+namespace util {
+
+/**
+ * Back-pressure metrics of a queue
+ */
+struct queue_metrics {
+    //! maximum number of the items
+    unsigned int capacity_ = 0;
+    //! current number of the items
+    unsigned int depth_ = 0;
+    //! maximum number of the items observed so far
+    unsigned int max_depth_ = 0;
+    //! number of the pushes which found the queue full
+    unsigned int num_full_ = 0;
+    //! number of the items which were dropped because the producer gave up waiting
+    unsigned int num_dropped_ = 0;
+};
+
+/**
+ * Bounded lock-free queue for one producer thread and one consumer thread.
+ * The items are stored in a ring buffer which is allocated at construction.
+ * The producer blocks on a condition variable while the queue is full, and the consumer notifies it only when it is waiting.
+ */
+template<typename T>
+class spsc_queue {
+public:
+    /**
+     * Constructor
+     * @param capacity (rounded up to a power of two)
+     */
+    explicit spsc_queue(const unsigned int capacity)
+        : slots_(round_up_to_power_of_two(capacity)), mask_(slots_.size() - 1) {}
+
+    spsc_queue(const spsc_queue&) = delete;
+    spsc_queue& operator=(const spsc_queue&) = delete;
+
+    /**
+     * Push an item if the queue is not full (producer only)
+     * @param item
+     * @return true if the item was pushed
+     */
+    bool try_push(T&& item) {
+        if (try_push_impl(item)) {
+            return true;
+        }
+        num_full_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    /**
+     * Push an item, waiting while the queue is full (producer only)
+     * (should_abort is evaluated when the producer is woken up, so notify_producer() must be called when its result can change)
+     * @param item
+     * @param should_abort predicate to give up waiting
+     * @return true if the item was pushed, false if should_abort returned true
+     */
+    template<typename Predicate>
+    bool push(T&& item, Predicate should_abort) {
+        if (try_push(std::move(item))) {
+            return true;
+        }
+        std::unique_lock<std::mutex> lock(mtx_producer_);
+        while (true) {
+            // the flag is published before the queue is checked again, so that the consumer sees it after popping
+            producer_is_waiting_.store(true, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (try_push_impl(item)) {
+                producer_is_waiting_.store(false, std::memory_order_relaxed);
+                return true;
+            }
+            if (should_abort()) {
+                producer_is_waiting_.store(false, std::memory_order_relaxed);
+                num_dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            cv_producer_.wait(lock);
+        }
+    }
+
+    /**
+     * Wake up the producer waiting in push() so that it checks the queue and should_abort again
+     */
+    void notify_producer() {
+        // lock the mutex once so that the notification is not lost
+        // between the check of the queue and the wait
+        {
+            std::lock_guard<std::mutex> lock(mtx_producer_);
+        }
+        cv_producer_.notify_one();
+    }
+
+    /**
+     * Pop an item if the queue is not empty (consumer only)
+     * @param item
+     * @return true if an item was popped
+     */
+    bool try_pop(T& item) {
+        const auto head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        // move out the item so that the slot does not keep the resources
+        item = std::move(slots_[head & mask_]);
+        slots_[head & mask_] = T();
+        head_.store(head + 1, std::memory_order_release);
+
+        // notify the producer only if it is waiting for room (see push())
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (producer_is_waiting_.load(std::memory_order_relaxed)) {
+            notify_producer();
+        }
+        return true;
+    }
+
+    //! Whether the queue is empty or not
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    //! Get the number of the items
+    unsigned int size() const {
+        const auto head = head_.load(std::memory_order_acquire);
+        const auto tail = tail_.load(std::memory_order_acquire);
+        return tail - head;
+    }
+
+    //! Get the maximum number of the items
+    unsigned int capacity() const {
+        return slots_.size();
+    }
+
+    //! Get the back-pressure metrics
+    queue_metrics get_metrics() const {
+        queue_metrics metrics;
+        metrics.capacity_ = capacity();
+        metrics.depth_ = size();
+        metrics.max_depth_ = max_depth_.load(std::memory_order_relaxed);
+        metrics.num_full_ = num_full_.load(std::memory_order_relaxed);
+        metrics.num_dropped_ = num_dropped_.load(std::memory_order_relaxed);
+        return metrics;
+    }
+
+private:
+    static size_t round_up_to_power_of_two(const unsigned int n) {
+        size_t capacity = 1;
+        while (capacity < n) {
+            capacity <<= 1;
+        }
+        return capacity;
+    }
+
+    //! the item is moved only if it is pushed
+    bool try_push_impl(T& item) {
+        const auto tail = tail_.load(std::memory_order_relaxed);
+        const auto head = head_.load(std::memory_order_acquire);
+        if (tail - head == slots_.size()) {
+            return false;
+        }
+        slots_[tail & mask_] = std::move(item);
+        tail_.store(tail + 1, std::memory_order_release);
+
+        const unsigned int depth = tail + 1 - head;
+        if (max_depth_.load(std::memory_order_relaxed) < depth) {
+            max_depth_.store(depth, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    //! ring buffer
+    std::vector<T> slots_;
+    //! capacity - 1
+    const size_t mask_;
+
+    //! number of the popped items (written only by the consumer)
+    std::atomic<size_t> head_{0};
+    //! keep head_ and tail_ in the different cache lines
+    char padding_[64];
+    //! number of the pushed items (written only by the producer)
+    std::atomic<size_t> tail_{0};
+
+    //! whether the producer is waiting in push()
+    std::atomic<bool> producer_is_waiting_{false};
+    //! mutex and condition variable on which the producer waits
+    std::mutex mtx_producer_;
+    std::condition_variable cv_producer_;
+
+    //! metrics (written only by the producer)
+    std::atomic<unsigned int> max_depth_{0};
+    std::atomic<unsigned int> num_full_{0};
+    std::atomic<unsigned int> num_dropped_{0};
+};
+
+} // namespace util
+} // namespace stella_vslam
+
+#endif // STELLA_VSLAM_UTIL_SPSC_QUEUE_H
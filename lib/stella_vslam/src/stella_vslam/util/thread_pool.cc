@@ -0,0 +1,61 @@
+#include "stella_vslam/util/thread_pool.h"
+
+#include <algorithm>
+
+namespace stella_vslam {
+namespace util {
+
+thread_pool::thread_pool(const unsigned int num_threads, const unsigned int max_queue_size)
+    : max_queue_size_(std::max(1u, max_queue_size)) {
+    const auto num_workers = std::max(1u, num_threads);
+    workers_.reserve(num_workers);
+    for (unsigned int worker_idx = 0; worker_idx < num_workers; ++worker_idx) {
+        workers_.emplace_back(&thread_pool::run, this, worker_idx);
+    }
+}
+
+thread_pool::~thread_pool() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        terminate_is_requested_ = true;
+    }
+    cv_task_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+unsigned int thread_pool::get_queue_size() const {
+    std::lock_guard<std::mutex> lock(mtx_);
+    return tasks_.size();
+}
+
+void thread_pool::enqueue(std::function<void(unsigned int)> task) {
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        cv_space_.wait(lock, [this] { return tasks_.size() < max_queue_size_; });
+        tasks_.push_back(std::move(task));
+    }
+    cv_task_.notify_one();
+}
+
+void thread_pool::run(const unsigned int worker_idx) {
+    while (true) {
+        std::function<void(unsigned int)> task;
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            cv_task_.wait(lock, [this] { return terminate_is_requested_ || !tasks_.empty(); });
+            // finish the queued tasks before terminating
+            if (tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        cv_space_.notify_one();
+        task(worker_idx);
+    }
+}
+
+} // namespace util
+} // namespace stella_vslam
@@ -0,0 +1,86 @@
+#ifndef STELLA_VSLAM_UTIL_THREAD_POOL_H
+#define STELLA_VSLAM_UTIL_THREAD_POOL_H
+
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace stella_vslam {
+namespace util {
+
+/**
+ * Persistent worker threads with a bounded FIFO task queue.
+ * A task receives the index of the worker running it, so that per-worker resources can be used without locking.
+ * With a single worker, the tasks are executed in the order of submission.
+ */
+class thread_pool {
+public:
+    /**
+     * Constructor
+     * @param num_threads number of the worker threads (at least one)
+     * @param max_queue_size maximum number of the tasks waiting to be executed (at least one)
+     */
+    thread_pool(const unsigned int num_threads, const unsigned int max_queue_size);
+
+    /**
+     * Destructor (the queued tasks are executed before the workers are joined)
+     */
+    ~thread_pool();
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    /**
+     * Submit a task, which is called as task(worker_idx)
+     * (NOTE: this function blocks while the queue is full)
+     * @param task
+     * @return future of the return value of the task
+     */
+    template<typename Task>
+    std::future<typename std::result_of<Task(unsigned int)>::type> submit(Task&& task) {
+        using result_t = typename std::result_of<Task(unsigned int)>::type;
+        // std::function requires a copyable target
+        auto packaged_task = std::make_shared<std::packaged_task<result_t(unsigned int)>>(std::forward<Task>(task));
+        auto future = packaged_task->get_future();
+        enqueue([packaged_task](const unsigned int worker_idx) { (*packaged_task)(worker_idx); });
+        return future;
+    }
+
+    //! Get the number of the worker threads
+    unsigned int get_num_threads() const {
+        return workers_.size();
+    }
+
+    //! Get the number of the tasks waiting to be executed
+    unsigned int get_queue_size() const;
+
+private:
+    //! Push a task to the queue, blocking while the queue is full
+    void enqueue(std::function<void(unsigned int)> task);
+
+    //! Main loop of the worker threads
+    void run(const unsigned int worker_idx);
+
+    const unsigned int max_queue_size_;
+
+    std::vector<std::thread> workers_;
+
+    mutable std::mutex mtx_;
+    //! notified when a task is pushed or termination is requested
+    std::condition_variable cv_task_;
+    //! notified when a task is popped
+    std::condition_variable cv_space_;
+    std::deque<std::function<void(unsigned int)>> tasks_;
+    bool terminate_is_requested_ = false;
+};
+
+} // namespace util
+} // namespace stella_vslam
+
+#endif // STELLA_VSLAM_UTIL_THREAD_POOL_H
@@ -1,4 +1,5 @@
 #include "util/euroc_util.h"
+#include "util/image_prefetcher.h"
 
 #ifdef HAVE_PANGOLIN_VIEWER
 #include "pangolin_viewer/viewer.h"
@@ -51,6 +52,7 @@ int mono_tracking(const std::shared_ptr<stella_vslam::system>& slam,
                   const std::string& eval_log_dir,
                   const std::string& map_db_path,
                   const bool equal_hist,
+                  const unsigned int num_decode_threads,
                   const std::string& viewer_string) {
     const euroc_sequence sequence(sequence_dir_path);
     const auto frames = sequence.get_frames();
@@ -117,6 +119,20 @@ int mono_tracking(const std::shared_ptr<stella_vslam::system>& slam,
     }
 #endif
 
+    // decode the images in the other threads so that the decoding time is not added to the SLAM loop
+    std::vector<std::vector<std::string>> img_paths;
+    img_paths.reserve(frames.size());
+    for (const auto& frame : frames) {
+        img_paths.push_back({frame.left_img_path_});
+    }
+    image_prefetcher prefetcher(img_paths, {equal_hist ? cv::IMREAD_UNCHANGED : cv::IMREAD_GRAYSCALE},
+                                num_decode_threads, 4 * num_decode_threads,
+                                [equal_hist](std::vector<cv::Mat>& imgs) {
+                                    if (equal_hist) {
+                                        stella_vslam::util::equalize_histogram(imgs.at(0));
+                                    }
+                                });
+
     std::vector<double> track_times;
     track_times.reserve(frames.size());
 
@@ -150,14 +166,9 @@ int mono_tracking(const std::shared_ptr<stella_vslam::system>& slam,
             }
 
             const auto& frame = frames.at(i);
-            cv::Mat img;
-            if (equal_hist) {
-                img = cv::imread(frame.left_img_path_, cv::IMREAD_UNCHANGED);
-                stella_vslam::util::equalize_histogram(img);
-            }
-            else {
-                img = cv::imread(frame.left_img_path_, cv::IMREAD_GRAYSCALE);
-            }
+            std::vector<cv::Mat> imgs;
+            prefetcher.get_next(imgs);
+            const auto& img = imgs.at(0);
 
             const auto tp_1 = std::chrono::steady_clock::now();
 
@@ -282,6 +293,7 @@ int stereo_tracking(const std::shared_ptr<stella_vslam::system>& slam,
                     const std::string& eval_log_dir,
                     const std::string& map_db_path,
                     const bool equal_hist,
+                    const unsigned int num_decode_threads,
                     const std::string& viewer_string) {
     const euroc_sequence sequence(sequence_dir_path);
     const auto frames = sequence.get_frames();
@@ -350,11 +362,32 @@ int stereo_tracking(const std::shared_ptr<stella_vslam::system>& slam,
     }
 #endif
 
+    // decode the images in the other threads so that the decoding time is not added to the SLAM loop
+    std::vector<std::vector<std::string>> img_paths;
+    img_paths.reserve(frames.size());
+    for (const auto& frame : frames) {
+        img_paths.push_back({frame.left_img_path_, frame.right_img_path_});
+    }
+    const int imread_flag = equal_hist ? cv::IMREAD_UNCHANGED : cv::IMREAD_GRAYSCALE;
+    image_prefetcher prefetcher(img_paths, {imread_flag, imread_flag},
+                                num_decode_threads, 4 * num_decode_threads,
+                                [equal_hist, &rectifier](std::vector<cv::Mat>& imgs) {
+                                    if (imgs.at(0).empty() || imgs.at(1).empty()) {
+                                        return;
+                                    }
+                                    if (equal_hist) {
+                                        stella_vslam::util::equalize_histogram(imgs.at(0));
+                                        stella_vslam::util::equalize_histogram(imgs.at(1));
+                                    }
+                                    cv::Mat left_img_rect, right_img_rect;
+                                    rectifier.rectify(imgs.at(0), imgs.at(1), left_img_rect, right_img_rect);
+                                    imgs.at(0) = left_img_rect;
+                                    imgs.at(1) = right_img_rect;
+                                });
+
     std::vector<double> track_times;
     track_times.reserve(frames.size());
 
-    cv::Mat left_img_rect, right_img_rect;
-
     // run the slam in another thread
     std::thread thread([&]() {
         for (unsigned int i = 0; i < frames.size(); ++i) {
@@ -385,24 +418,16 @@ int stereo_tracking(const std::shared_ptr<stella_vslam::system>& slam,
             }
 
             const auto& frame = frames.at(i);
-            cv::Mat left_img, right_img;
-            if (equal_hist) {
-                left_img = cv::imread(frame.left_img_path_, cv::IMREAD_UNCHANGED);
-                right_img = cv::imread(frame.right_img_path_, cv::IMREAD_UNCHANGED);
-                stella_vslam::util::equalize_histogram(left_img);
-                stella_vslam::util::equalize_histogram(right_img);
-            }
-            else {
-                left_img = cv::imread(frame.left_img_path_, cv::IMREAD_GRAYSCALE);
-                right_img = cv::imread(frame.right_img_path_, cv::IMREAD_GRAYSCALE);
-            }
+            // the images are rectified in the decoder threads
+            std::vector<cv::Mat> imgs;
+            prefetcher.get_next(imgs);
+            const auto& left_img_rect = imgs.at(0);
+            const auto& right_img_rect = imgs.at(1);
 
-            if (left_img.empty() || right_img.empty()) {
+            if (left_img_rect.empty() || right_img_rect.empty()) {
                 continue;
             }
 
-            rectifier.rectify(left_img, right_img, left_img_rect, right_img_rect);
-
             const auto tp_1 = std::chrono::steady_clock::now();
 
             if (i % frame_skip == 0) {
@@ -539,6 +564,7 @@ int main(int argc, char* argv[]) {
     auto disable_mapping = op.add<popl::Switch>("", "disable-mapping", "disable mapping");
     auto temporal_mapping = op.add<popl::Switch>("", "temporal-mapping", "enable temporal mapping");
     auto equal_hist = op.add<popl::Switch>("", "equal-hist", "apply histogram equalization");
+    auto num_decode_threads = op.add<popl::Value<unsigned int>>("", "decode-threads", "number of threads to decode the images in advance", 2);
     auto viewer = op.add<popl::Value<std::string>>("", "viewer", "viewer [iridescence_viewer, pangolin_viewer, socket_publisher, none]");
 
     try {
@@ -680,6 +706,7 @@ int main(int argc, char* argv[]) {
                             eval_log_dir->value(),
                             map_db_path_out->value(),
                             equal_hist->is_set(),
+                            num_decode_threads->value(),
                             viewer_string);
     }
     else if (slam->get_camera()->setup_type_ == stella_vslam::camera::setup_type_t::Stereo) {
@@ -693,6 +720,7 @@ int main(int argc, char* argv[]) {
                               eval_log_dir->value(),
                               map_db_path_out->value(),
                               equal_hist->is_set(),
+                              num_decode_threads->value(),
                               viewer_string);
     }
     else {
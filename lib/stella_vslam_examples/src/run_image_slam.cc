@@ -1,4 +1,5 @@
 #include "util/image_util.h"
+#include "util/image_prefetcher.h"
 
 #ifdef HAVE_PANGOLIN_VIEWER
 #include "pangolin_viewer/viewer.h"
@@ -48,6 +49,8 @@ int mono_tracking(const std::shared_ptr<stella_vslam::system>& slam,
                   const std::string& eval_log_dir,
                   const std::string& map_db_path,
                   const double start_timestamp,
+                  const unsigned int num_decode_threads,
+                  const bool decode_gray,
                   const std::string& viewer_string) {
     // load the mask image
     const cv::Mat mask = mask_img_path.empty() ? cv::Mat{} : cv::imread(mask_img_path, cv::IMREAD_GRAYSCALE);
@@ -117,6 +120,15 @@ int mono_tracking(const std::shared_ptr<stella_vslam::system>& slam,
     }
 #endif
 
+    // decode the images in the other threads so that the decoding time is not added to the SLAM loop
+    std::vector<std::vector<std::string>> img_paths;
+    img_paths.reserve(frames.size());
+    for (const auto& frame : frames) {
+        img_paths.push_back({frame.img_path_});
+    }
+    image_prefetcher prefetcher(img_paths, {decode_gray ? cv::IMREAD_GRAYSCALE : cv::IMREAD_UNCHANGED},
+                                num_decode_threads, 4 * num_decode_threads);
+
     std::vector<double> track_times;
     track_times.reserve(frames.size());
     double timestamp = start_timestamp;
@@ -150,8 +162,9 @@ int mono_tracking(const std::shared_ptr<stella_vslam::system>& slam,
                 }
             }
 
-            const auto& frame = frames.at(i);
-            const auto img = cv::imread(frame.img_path_, cv::IMREAD_UNCHANGED);
+            std::vector<cv::Mat> imgs;
+            prefetcher.get_next(imgs);
+            const auto& img = imgs.at(0);
 
             const auto tp_1 = std::chrono::steady_clock::now();
 
@@ -292,6 +305,8 @@ int main(int argc, char* argv[]) {
     auto disable_mapping = op.add<popl::Switch>("", "disable-mapping", "disable mapping");
     auto temporal_mapping = op.add<popl::Switch>("", "temporal-mapping", "enable temporal mapping");
     auto start_timestamp = op.add<popl::Value<double>>("t", "start-timestamp", "timestamp of the start of the video capture");
+    auto num_decode_threads = op.add<popl::Value<unsigned int>>("", "decode-threads", "number of threads to decode the images in advance", 2);
+    auto decode_gray = op.add<popl::Switch>("", "decode-gray", "decode the images to grayscale directly");
     auto viewer = op.add<popl::Value<std::string>>("", "viewer", "viewer [iridescence_viewer, pangolin_viewer, socket_publisher, none]");
     try {
         op.parse(argc, argv);
@@ -449,6 +464,8 @@ int main(int argc, char* argv[]) {
                             eval_log_dir->value(),
                             map_db_path_out->value(),
                             timestamp,
+                            num_decode_threads->value(),
+                            decode_gray->is_set(),
                             viewer_string);
     }
     else {
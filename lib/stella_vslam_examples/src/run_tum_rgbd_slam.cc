@@ -1,4 +1,5 @@
 #include "util/tum_rgbd_util.h"
+#include "util/image_prefetcher.h"
 
 #ifdef HAVE_PANGOLIN_VIEWER
 #include "pangolin_viewer/viewer.h"
@@ -48,6 +49,8 @@ int mono_tracking(const std::shared_ptr<stella_vslam::system>& slam,
                   const bool auto_term,
                   const std::string& eval_log_dir,
                   const std::string& map_db_path,
+                  const unsigned int num_decode_threads,
+                  const bool decode_gray,
                   const std::string& viewer_string) {
     tum_rgbd_sequence sequence(sequence_dir_path);
     const auto frames = sequence.get_frames();
@@ -114,6 +117,15 @@ int mono_tracking(const std::shared_ptr<stella_vslam::system>& slam,
     }
 #endif
 
+    // decode the images in the other threads so that the decoding time is not added to the SLAM loop
+    std::vector<std::vector<std::string>> img_paths;
+    img_paths.reserve(frames.size());
+    for (const auto& frame : frames) {
+        img_paths.push_back({frame.rgb_img_path_});
+    }
+    image_prefetcher prefetcher(img_paths, {decode_gray ? cv::IMREAD_GRAYSCALE : cv::IMREAD_UNCHANGED},
+                                num_decode_threads, 4 * num_decode_threads);
+
     std::vector<double> track_times;
     track_times.reserve(frames.size());
 
@@ -147,7 +159,9 @@ int mono_tracking(const std::shared_ptr<stella_vslam::system>& slam,
             }
 
             const auto& frame = frames.at(i);
-            const auto rgb_img = cv::imread(frame.rgb_img_path_, cv::IMREAD_UNCHANGED);
+            std::vector<cv::Mat> imgs;
+            prefetcher.get_next(imgs);
+            const auto& rgb_img = imgs.at(0);
 
             const auto tp_1 = std::chrono::steady_clock::now();
 
@@ -261,6 +275,8 @@ int rgbd_tracking(const std::shared_ptr<stella_vslam::system>& slam,
                   const bool auto_term,
                   const std::string& eval_log_dir,
                   const std::string& map_db_path,
+                  const unsigned int num_decode_threads,
+                  const bool decode_gray,
                   const std::string& viewer_string) {
     tum_rgbd_sequence sequence(sequence_dir_path);
     const auto frames = sequence.get_frames();
@@ -327,6 +343,16 @@ int rgbd_tracking(const std::shared_ptr<stella_vslam::system>& slam,
     }
 #endif
 
+    // decode the images in the other threads so that the decoding time is not added to the SLAM loop
+    std::vector<std::vector<std::string>> img_paths;
+    img_paths.reserve(frames.size());
+    for (const auto& frame : frames) {
+        img_paths.push_back({frame.rgb_img_path_, frame.depth_img_path_});
+    }
+    // the depth images are always decoded as they are
+    image_prefetcher prefetcher(img_paths, {decode_gray ? cv::IMREAD_GRAYSCALE : cv::IMREAD_UNCHANGED, cv::IMREAD_UNCHANGED},
+                                num_decode_threads, 4 * num_decode_threads);
+
     std::vector<double> track_times;
     track_times.reserve(frames.size());
 
@@ -360,8 +386,10 @@ int rgbd_tracking(const std::shared_ptr<stella_vslam::system>& slam,
             }
 
             const auto& frame = frames.at(i);
-            const auto rgb_img = cv::imread(frame.rgb_img_path_, cv::IMREAD_UNCHANGED);
-            const auto depth_img = cv::imread(frame.depth_img_path_, cv::IMREAD_UNCHANGED);
+            std::vector<cv::Mat> imgs;
+            prefetcher.get_next(imgs);
+            const auto& rgb_img = imgs.at(0);
+            const auto& depth_img = imgs.at(1);
 
             const auto tp_1 = std::chrono::steady_clock::now();
 
@@ -498,6 +526,8 @@ int main(int argc, char* argv[]) {
     auto map_db_path_out = op.add<popl::Value<std::string>>("o", "map-db-out", "store a map database at this path after slam", "");
     auto disable_mapping = op.add<popl::Switch>("", "disable-mapping", "disable mapping");
     auto temporal_mapping = op.add<popl::Switch>("", "temporal-mapping", "enable temporal mapping");
+    auto num_decode_threads = op.add<popl::Value<unsigned int>>("", "decode-threads", "number of threads to decode the images in advance", 2);
+    auto decode_gray = op.add<popl::Switch>("", "decode-gray", "decode the images to grayscale directly");
     auto viewer = op.add<popl::Value<std::string>>("", "viewer", "viewer [iridescence_viewer, pangolin_viewer, socket_publisher, none]");
 
     try {
@@ -638,6 +668,8 @@ int main(int argc, char* argv[]) {
                             auto_term->is_set(),
                             eval_log_dir->value(),
                             map_db_path_out->value(),
+                            num_decode_threads->value(),
+                            decode_gray->is_set(),
                             viewer_string);
     }
     else if (slam->get_camera()->setup_type_ == stella_vslam::camera::setup_type_t::RGBD) {
@@ -650,6 +682,8 @@ int main(int argc, char* argv[]) {
                             auto_term->is_set(),
                             eval_log_dir->value(),
                             map_db_path_out->value(),
+                            num_decode_threads->value(),
+                            decode_gray->is_set(),
                             viewer_string);
     }
     else {
@@ -0,0 +1,82 @@
+#include "image_prefetcher.h"
+
+#include <algorithm>
+
+#include <opencv2/imgcodecs.hpp>
+
+image_prefetcher::image_prefetcher(const std::vector<std::vector<std::string>>& img_paths,
+                                   const std::vector<int>& imread_flags,
+                                   const unsigned int num_threads,
+                                   const unsigned int capacity,
+                                   const preprocessor_t& preprocessor)
+    : img_paths_(img_paths), imread_flags_(imread_flags), capacity_(std::max(capacity, 1u)), preprocessor_(preprocessor),
+      slots_(capacity_), slot_is_ready_(capacity_, false) {
+    const auto num_workers = std::max(num_threads, 1u);
+    workers_.reserve(num_workers);
+    for (unsigned int i = 0; i < num_workers; ++i) {
+        workers_.emplace_back(&image_prefetcher::run, this);
+    }
+}
+
+image_prefetcher::~image_prefetcher() {
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        terminate_is_requested_ = true;
+    }
+    cv_space_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+bool image_prefetcher::get_next(std::vector<cv::Mat>& imgs) {
+    {
+        std::unique_lock<std::mutex> lock(mtx_);
+        if (img_paths_.size() <= head_) {
+            return false;
+        }
+        const auto slot = head_ % capacity_;
+        cv_ready_.wait(lock, [this, slot] {
+            return static_cast<bool>(slot_is_ready_.at(slot));
+        });
+        imgs = std::move(slots_.at(slot));
+        slots_.at(slot).clear();
+        slot_is_ready_.at(slot) = false;
+        ++head_;
+    }
+    cv_space_.notify_all();
+    return true;
+}
+
+void image_prefetcher::run() {
+    while (true) {
+        unsigned int idx;
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            // the frames after head_ + capacity_ cannot be stored until the preceding frames are consumed
+            cv_space_.wait(lock, [this] {
+                return terminate_is_requested_ || img_paths_.size() <= next_idx_ || next_idx_ < head_ + capacity_;
+            });
+            if (terminate_is_requested_ || img_paths_.size() <= next_idx_) {
+                return;
+            }
+            idx = next_idx_++;
+        }
+
+        const auto& paths = img_paths_.at(idx);
+        std::vector<cv::Mat> imgs(paths.size());
+        for (unsigned int i = 0; i < paths.size(); ++i) {
+            imgs.at(i) = cv::imread(paths.at(i), imread_flags_.at(i));
+        }
+        if (preprocessor_) {
+            preprocessor_(imgs);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            slots_.at(idx % capacity_) = std::move(imgs);
+            slot_is_ready_.at(idx % capacity_) = true;
+        }
+        cv_ready_.notify_all();
+    }
+}
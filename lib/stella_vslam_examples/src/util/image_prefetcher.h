@@ -0,0 +1,83 @@
+#ifndef EXAMPLE_UTIL_IMAGE_PREFETCHER_H
+#define EXAMPLE_UTIL_IMAGE_PREFETCHER_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core/mat.hpp>
+
+/**
+ * Load the images of a sequence ahead of the SLAM loop.
+ * The decoder threads fill a bounded ring of decoded frames, and the frames are returned in the order of the sequence.
+ */
+class image_prefetcher {
+public:
+    //! called in the decoder threads for the decoded images of each frame (e.g. histogram equalization, rectification)
+    using preprocessor_t = std::function<void(std::vector<cv::Mat>&)>;
+
+    /**
+     * Constructor (the decoder threads are launched immediately)
+     * @param img_paths paths of the images of each frame (e.g. left and right images)
+     * @param imread_flags flag passed to cv::imread for each image of a frame (e.g. cv::IMREAD_GRAYSCALE)
+     * @param num_threads number of the decoder threads (at least one)
+     * @param capacity maximum number of the decoded frames waiting to be consumed (at least one)
+     * @param preprocessor
+     */
+    image_prefetcher(const std::vector<std::vector<std::string>>& img_paths,
+                     const std::vector<int>& imread_flags,
+                     const unsigned int num_threads,
+                     const unsigned int capacity,
+                     const preprocessor_t& preprocessor = nullptr);
+
+    /**
+     * Destructor (the frames which are not decoded yet are discarded)
+     */
+    ~image_prefetcher();
+
+    image_prefetcher(const image_prefetcher&) = delete;
+    image_prefetcher& operator=(const image_prefetcher&) = delete;
+
+    /**
+     * Get the images of the next frame, waiting until they are decoded
+     * (the image is empty if it cannot be read)
+     * @param imgs
+     * @return false if all of the frames have been consumed
+     */
+    bool get_next(std::vector<cv::Mat>& imgs);
+
+    //! Get the number of the frames
+    unsigned int get_num_frames() const {
+        return img_paths_.size();
+    }
+
+private:
+    //! Main loop of the decoder threads
+    void run();
+
+    const std::vector<std::vector<std::string>> img_paths_;
+    const std::vector<int> imread_flags_;
+    const unsigned int capacity_;
+    const preprocessor_t preprocessor_;
+
+    std::vector<std::thread> workers_;
+
+    std::mutex mtx_;
+    //! notified when a frame is consumed or termination is requested
+    std::condition_variable cv_space_;
+    //! notified when a frame is decoded
+    std::condition_variable cv_ready_;
+    //! ring of the decoded frames (the frame i is stored at i % capacity_)
+    std::vector<std::vector<cv::Mat>> slots_;
+    std::vector<bool> slot_is_ready_;
+    //! index of the next frame to be consumed
+    unsigned int head_ = 0;
+    //! index of the next frame to be decoded
+    unsigned int next_idx_ = 0;
+    bool terminate_is_requested_ = false;
+};
+
+#endif // EXAMPLE_UTIL_IMAGE_PREFETCHER_H
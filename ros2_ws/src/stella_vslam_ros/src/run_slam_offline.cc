@@ -280,6 +280,9 @@ void tracking(const std::shared_ptr<stella_vslam_ros::system>& slam_ros,
         viewer_thread->join();
     }
 
+    // stop the tracking thread before shutting down the SLAM process
+    slam_ros->stop_async_tracking();
+
     // shutdown the SLAM process
     SLAM->shutdown();
 
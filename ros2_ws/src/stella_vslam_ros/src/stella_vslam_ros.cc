@@ -1,12 +1,16 @@
 #include <stella_vslam_ros.h>
 #include <stella_vslam/publish/map_publisher.h>
 #include <stella_vslam/data/keyframe.h>
+#include <stella_vslam/data/landmark.h>
+#include <stella_vslam/data/map_database.h>
 
 #include <chrono>
 
 #include <tf2_eigen/tf2_eigen.hpp>
 #include <tf2_geometry_msgs/tf2_geometry_msgs.hpp>
 #include <geometry_msgs/msg/transform_stamped.h>
+#include <sensor_msgs/point_cloud2_iterator.hpp>
+#include <visualization_msgs/msg/marker.hpp>
 #include <opencv2/core/core.hpp>
 #include <opencv2/imgcodecs.hpp>
 #include <Eigen/Geometry>
@@ -32,6 +36,8 @@ system::system(const std::shared_ptr<stella_vslam::system>& slam,
       pose_pub_(node_->create_publisher<nav_msgs::msg::Odometry>("~/camera_pose", 1)),
       keyframes_pub_(node_->create_publisher<geometry_msgs::msg::PoseArray>("~/keyframes", 1)),
       keyframes_2d_pub_(node_->create_publisher<geometry_msgs::msg::PoseArray>("~/keyframes_2d", 1)),
+      keyframes_delta_pub_(node_->create_publisher<visualization_msgs::msg::MarkerArray>("~/keyframes_delta", 10)),
+      landmarks_pub_(node_->create_publisher<sensor_msgs::msg::PointCloud2>("~/landmarks", 1)),
       map_to_odom_broadcaster_(std::make_shared<tf2_ros::TransformBroadcaster>(node_)),
       tf_(std::make_unique<tf2_ros::Buffer>(node_->get_clock())),
       transform_listener_(std::make_shared<tf2_ros::TransformListener>(*tf_)) {
@@ -48,6 +54,120 @@ system::system(const std::shared_ptr<stella_vslam::system>& slam,
                                 -1, 0, 0,
                                 0, -1, 0)
                                    .finished();
+
+    if (async_tracking_) {
+        // The frames are tracked and the results are published in the dedicated threads
+        // so that slow frames do not block the executor
+        frame_queue_ = std::make_unique<bounded_queue<std::function<void()>>>(std::max(frame_queue_size_, 1), frame_queue_policy_ != "fifo");
+        // The results are always latest-wins regardless of the frame queue policy,
+        // so that the newest pose is not dropped in favor of the stale ones
+        result_queue_ = std::make_unique<bounded_queue<tracking_result>>(std::max(frame_queue_size_, 1), true);
+        tracking_thread_ = std::make_unique<std::thread>(&system::run_tracking, this);
+        publishing_thread_ = std::make_unique<std::thread>(&system::run_publishing, this);
+        diagnostics_pub_ = node_->create_publisher<diagnostic_msgs::msg::DiagnosticArray>("/diagnostics", 1);
+        diagnostics_timer_ = node_->create_wall_timer(std::chrono::seconds(1), [this]() { publish_diagnostics(); });
+        RCLCPP_INFO(node_->get_logger(), "Asynchronous tracking: %d queued frames at most (%s)",
+                    frame_queue_size_, frame_queue_policy_.c_str());
+    }
+}
+
+system::~system() {
+    stop_async_tracking();
+}
+
+void system::stop_async_tracking() {
+    if (diagnostics_timer_) {
+        diagnostics_timer_->cancel();
+    }
+    if (tracking_thread_) {
+        frame_queue_->close();
+        tracking_thread_->join();
+        tracking_thread_.reset();
+    }
+    if (publishing_thread_) {
+        result_queue_->close();
+        publishing_thread_->join();
+        publishing_thread_.reset();
+    }
+}
+
+void system::dispatch_tracking(std::function<void()>&& track) {
+    if (!async_tracking_) {
+        track();
+        return;
+    }
+    frame_queue_->push(std::move(track));
+}
+
+void system::publish_tracking_result(const std::shared_ptr<Eigen::Matrix4d>& cam_pose_wc, const rclcpp::Time& stamp) {
+    if (async_tracking_) {
+        result_queue_->push(tracking_result{cam_pose_wc, stamp});
+        return;
+    }
+    if (cam_pose_wc) {
+        publish_pose(*cam_pose_wc, stamp);
+    }
+    if (publish_keyframes_ || publish_landmarks_) {
+        publish_map(stamp);
+    }
+}
+
+void system::run_tracking() {
+    std::function<void()> track;
+    while (frame_queue_->pop(track)) {
+        track();
+        // release the image messages
+        track = nullptr;
+    }
+}
+
+void system::run_publishing() {
+    tracking_result result;
+    while (result_queue_->pop(result)) {
+        if (result.cam_pose_wc_) {
+            publish_pose(*result.cam_pose_wc_, result.stamp_);
+        }
+        // The map is published only for the latest result
+        if ((publish_keyframes_ || publish_landmarks_) && result_queue_->size() == 0) {
+            publish_map(result.stamp_);
+        }
+    }
+}
+
+void system::publish_diagnostics() {
+    const auto num_dropped_frames = frame_queue_->get_num_dropped();
+
+    diagnostic_msgs::msg::DiagnosticStatus status;
+    status.name = std::string(node_->get_name()) + ": tracking queue";
+    status.hardware_id = node_->get_fully_qualified_name();
+    if (num_dropped_frames == prev_num_dropped_frames_) {
+        status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+        status.message = "OK";
+    }
+    else {
+        status.level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
+        status.message = std::to_string(num_dropped_frames - prev_num_dropped_frames_) + " frames dropped";
+    }
+    prev_num_dropped_frames_ = num_dropped_frames;
+
+    const auto add_value = [&status](const std::string& key, const std::string& value) {
+        diagnostic_msgs::msg::KeyValue key_value;
+        key_value.key = key;
+        key_value.value = value;
+        status.values.push_back(key_value);
+    };
+    add_value("frame_queue_policy", frame_queue_->keeps_latest() ? "latest" : "fifo");
+    add_value("frame_queue_capacity", std::to_string(frame_queue_->capacity()));
+    add_value("frame_queue_depth", std::to_string(frame_queue_->size()));
+    add_value("num_received_frames", std::to_string(frame_queue_->get_num_pushed()));
+    add_value("num_dropped_frames", std::to_string(num_dropped_frames));
+    add_value("result_queue_depth", std::to_string(result_queue_->size()));
+    add_value("num_dropped_results", std::to_string(result_queue_->get_num_dropped()));
+
+    diagnostic_msgs::msg::DiagnosticArray diagnostics_msg;
+    diagnostics_msg.header.stamp = node_->now();
+    diagnostics_msg.status.push_back(status);
+    diagnostics_pub_->publish(diagnostics_msg);
 }
 
 void system::publish_pose(const Eigen::Matrix4d& cam_pose_wc, const rclcpp::Time& stamp) {
@@ -97,28 +217,200 @@ void system::publish_pose(const Eigen::Matrix4d& cam_pose_wc, const rclcpp::Time
     }
 }
 
+void system::publish_map(const rclcpp::Time& stamp) {
+    const auto now = std::chrono::steady_clock::now();
+    if (now < next_map_publication_) {
+        return;
+    }
+    next_map_publication_ = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(map_publish_period_));
+
+    const bool is_incremental = update_map_cache();
+
+    if (publish_keyframes_) {
+        // The delta is published in every cycle, so that the consumers of the delta do not miss any change
+        publish_keyframes_delta(stamp);
+        if ((!is_incremental || next_keyfrms_snapshot_ <= now) && keyfrms_changed_since_snapshot_) {
+            publish_keyframes(stamp);
+            next_keyfrms_snapshot_ = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(keyframes_snapshot_period_));
+        }
+    }
+    updated_keyfrm_ids_.clear();
+    erased_keyfrm_ids_.clear();
+    keyfrms_reloaded_ = false;
+
+    if (publish_landmarks_) {
+        publish_landmarks(stamp);
+    }
+}
+
 void system::publish_keyframes(const rclcpp::Time& stamp) {
     geometry_msgs::msg::PoseArray keyframes_msg;
     geometry_msgs::msg::PoseArray keyframes_2d_msg;
     keyframes_msg.header.stamp = stamp;
     keyframes_msg.header.frame_id = map_frame_;
     keyframes_2d_msg.header = keyframes_msg.header;
-    std::vector<std::shared_ptr<stella_vslam::data::keyframe>> all_keyfrms;
-    slam_->get_map_publisher()->get_keyframes(all_keyfrms);
-    for (const auto& keyfrm : all_keyfrms) {
+    keyframes_msg.poses.reserve(keyfrm_poses_.size());
+    keyframes_2d_msg.poses.reserve(keyfrm_poses_.size());
+    for (const auto& id_poses : keyfrm_poses_) {
+        keyframes_msg.poses.push_back(id_poses.second.pose_);
+        keyframes_2d_msg.poses.push_back(id_poses.second.pose_2d_);
+    }
+    keyframes_pub_->publish(keyframes_msg);
+    keyframes_2d_pub_->publish(keyframes_2d_msg);
+    keyfrms_changed_since_snapshot_ = false;
+}
+
+void system::publish_keyframes_delta(const rclcpp::Time& stamp) {
+    if (!keyfrms_reloaded_ && updated_keyfrm_ids_.empty() && erased_keyfrm_ids_.empty()) {
+        return;
+    }
+    visualization_msgs::msg::MarkerArray keyframes_delta_msg;
+    visualization_msgs::msg::Marker marker;
+    marker.header.stamp = stamp;
+    marker.header.frame_id = map_frame_;
+    marker.ns = "keyframes";
+    marker.type = visualization_msgs::msg::Marker::ARROW;
+    marker.scale.x = 0.1;
+    marker.scale.y = 0.02;
+    marker.scale.z = 0.02;
+    marker.color.g = 1.0;
+    marker.color.a = 1.0;
+
+    if (keyfrms_reloaded_) {
+        // the cache was read again, so the previous keyframes are discarded and all of the cached ones are sent
+        keyframes_delta_msg.markers.reserve(keyfrm_poses_.size() + 1);
+        marker.action = visualization_msgs::msg::Marker::DELETEALL;
+        keyframes_delta_msg.markers.push_back(marker);
+        marker.action = visualization_msgs::msg::Marker::ADD;
+        for (const auto& id_poses : keyfrm_poses_) {
+            marker.id = id_poses.first;
+            marker.pose = id_poses.second.pose_;
+            keyframes_delta_msg.markers.push_back(marker);
+        }
+    }
+    else {
+        keyframes_delta_msg.markers.reserve(updated_keyfrm_ids_.size() + erased_keyfrm_ids_.size());
+        marker.action = visualization_msgs::msg::Marker::ADD;
+        for (const auto id : updated_keyfrm_ids_) {
+            const auto itr = keyfrm_poses_.find(id);
+            if (itr == keyfrm_poses_.end()) {
+                continue;
+            }
+            marker.id = id;
+            marker.pose = itr->second.pose_;
+            keyframes_delta_msg.markers.push_back(marker);
+        }
+        marker.action = visualization_msgs::msg::Marker::DELETE;
+        marker.pose = geometry_msgs::msg::Pose();
+        for (const auto id : erased_keyfrm_ids_) {
+            marker.id = id;
+            keyframes_delta_msg.markers.push_back(marker);
+        }
+    }
+    keyframes_delta_pub_->publish(keyframes_delta_msg);
+}
+
+void system::publish_landmarks(const rclcpp::Time& stamp) {
+    sensor_msgs::msg::PointCloud2 landmarks_msg;
+    landmarks_msg.header.stamp = stamp;
+    landmarks_msg.header.frame_id = map_frame_;
+    // The buffer of the points is allocated at once, and the positions are written into it directly
+    sensor_msgs::PointCloud2Modifier modifier(landmarks_msg);
+    modifier.setPointCloud2FieldsByString(1, "xyz");
+    modifier.resize(lm_positions_.size());
+    sensor_msgs::PointCloud2Iterator<float> iter_x(landmarks_msg, "x");
+    sensor_msgs::PointCloud2Iterator<float> iter_y(landmarks_msg, "y");
+    sensor_msgs::PointCloud2Iterator<float> iter_z(landmarks_msg, "z");
+    for (const auto& id_pos : lm_positions_) {
+        *iter_x = id_pos.second(0);
+        *iter_y = id_pos.second(1);
+        *iter_z = id_pos.second(2);
+        ++iter_x;
+        ++iter_y;
+        ++iter_z;
+    }
+    landmarks_pub_->publish(landmarks_msg);
+}
+
+system::keyframe_poses system::to_keyframe_poses(const Eigen::Matrix4d& cam_pose_wc) const {
+    Eigen::Matrix3d rot(cam_pose_wc.block<3, 3>(0, 0));
+    Eigen::Translation3d trans(cam_pose_wc.block<3, 1>(0, 3));
+    Eigen::Affine3d map_to_camera_affine(trans * rot);
+    Eigen::Affine3d pose_affine = rot_ros_to_cv_map_frame_ * map_to_camera_affine * rot_ros_to_cv_map_frame_.inverse();
+    keyframe_poses poses;
+    poses.pose_ = tf2::toMsg(pose_affine);
+    poses.pose_2d_ = tf2::toMsg(project_to_xy_plane(pose_affine));
+    return poses;
+}
+
+bool system::update_map_cache() {
+    const auto map_publisher = slam_->get_map_publisher();
+    stella_vslam::data::map_changes changes;
+    // The changes of the landmarks are not collected unless they are published
+    map_publisher->get_changes_since(map_version_, changes, publish_landmarks_);
+    map_version_ = changes.version_;
+    const Eigen::Matrix3d rot_ros_to_cv = rot_ros_to_cv_map_frame_.toRotationMatrix();
+
+    if (!changes.is_complete_) {
+        // The changes are not available (e.g. the map was reset), so read the whole map again.
+        // The changes after map_version_ are applied again in the next update, which is harmless.
+        keyfrm_poses_.clear();
+        std::vector<std::shared_ptr<stella_vslam::data::keyframe>> all_keyfrms;
+        map_publisher->get_keyframes(all_keyfrms);
+        for (const auto& keyfrm : all_keyfrms) {
+            if (!keyfrm || keyfrm->will_be_erased()) {
+                continue;
+            }
+            keyfrm_poses_[keyfrm->id_] = to_keyframe_poses(keyfrm->get_pose_wc());
+        }
+        keyfrms_changed_since_snapshot_ = true;
+        keyfrms_reloaded_ = true;
+        updated_keyfrm_ids_.clear();
+        erased_keyfrm_ids_.clear();
+
+        lm_positions_.clear();
+        if (publish_landmarks_) {
+            std::vector<std::shared_ptr<stella_vslam::data::landmark>> all_lms;
+            std::set<std::shared_ptr<stella_vslam::data::landmark>> local_lms;
+            map_publisher->get_landmarks(all_lms, local_lms);
+            lm_positions_.reserve(all_lms.size());
+            for (const auto& lm : all_lms) {
+                if (!lm || lm->will_be_erased()) {
+                    continue;
+                }
+                lm_positions_[lm->id_] = (rot_ros_to_cv * lm->get_pos_in_world()).cast<float>();
+            }
+        }
+        return false;
+    }
+
+    for (const auto& keyfrm : changes.updated_keyfrms_) {
         if (!keyfrm || keyfrm->will_be_erased()) {
             continue;
         }
-        Eigen::Matrix4d cam_pose_wc = keyfrm->get_pose_wc();
-        Eigen::Matrix3d rot(cam_pose_wc.block<3, 3>(0, 0));
-        Eigen::Translation3d trans(cam_pose_wc.block<3, 1>(0, 3));
-        Eigen::Affine3d map_to_camera_affine(trans * rot);
-        Eigen::Affine3d pose_affine = rot_ros_to_cv_map_frame_ * map_to_camera_affine * rot_ros_to_cv_map_frame_.inverse();
-        keyframes_msg.poses.push_back(tf2::toMsg(pose_affine));
-        keyframes_2d_msg.poses.push_back(tf2::toMsg(project_to_xy_plane(pose_affine)));
+        keyfrm_poses_[keyfrm->id_] = to_keyframe_poses(keyfrm->get_pose_wc());
+        updated_keyfrm_ids_.push_back(keyfrm->id_);
     }
-    keyframes_pub_->publish(keyframes_msg);
-    keyframes_2d_pub_->publish(keyframes_2d_msg);
+    for (const auto id : changes.erased_keyfrm_ids_) {
+        keyfrm_poses_.erase(id);
+        erased_keyfrm_ids_.push_back(id);
+    }
+    if (!changes.updated_keyfrms_.empty() || !changes.erased_keyfrm_ids_.empty()) {
+        keyfrms_changed_since_snapshot_ = true;
+    }
+
+    if (publish_landmarks_) {
+        for (const auto& lm : changes.updated_lms_) {
+            if (!lm || lm->will_be_erased()) {
+                continue;
+            }
+            lm_positions_[lm->id_] = (rot_ros_to_cv * lm->get_pos_in_world()).cast<float>();
+        }
+        for (const auto id : changes.erased_lm_ids_) {
+            lm_positions_.erase(id);
+        }
+    }
+    return true;
 }
 
 void system::setParams() {
@@ -143,6 +435,15 @@ void system::setParams() {
     publish_keyframes_ = true;
     publish_keyframes_ = node_->declare_parameter("publish_keyframes", publish_keyframes_);
 
+    publish_landmarks_ = false;
+    publish_landmarks_ = node_->declare_parameter("publish_landmarks", publish_landmarks_);
+
+    map_publish_period_ = 1.0;
+    map_publish_period_ = node_->declare_parameter("map_publish_period", map_publish_period_);
+
+    keyframes_snapshot_period_ = 5.0;
+    keyframes_snapshot_period_ = node_->declare_parameter("keyframes_snapshot_period", keyframes_snapshot_period_);
+
     transform_tolerance_ = 0.5;
     transform_tolerance_ = node_->declare_parameter("transform_tolerance", transform_tolerance_);
 
@@ -158,6 +459,19 @@ void system::setParams() {
 
     encoding_ = "";
     encoding_ = node_->declare_parameter("encoding", encoding_);
+
+    async_tracking_ = false;
+    async_tracking_ = node_->declare_parameter("async_tracking", async_tracking_);
+
+    frame_queue_size_ = 2;
+    frame_queue_size_ = node_->declare_parameter("frame_queue_size", frame_queue_size_);
+
+    frame_queue_policy_ = std::string("latest");
+    frame_queue_policy_ = node_->declare_parameter("frame_queue_policy", frame_queue_policy_);
+    if (frame_queue_policy_ != "latest" && frame_queue_policy_ != "fifo") {
+        RCLCPP_WARN(node_->get_logger(), "Unknown frame_queue_policy: %s (use latest)", frame_queue_policy_.c_str());
+        frame_queue_policy_ = "latest";
+    }
 }
 
 void system::init_pose_callback(
@@ -234,35 +548,25 @@ mono::mono(const std::shared_ptr<stella_vslam::system>& slam,
     raw_image_sub_ = node_->create_subscription<sensor_msgs::msg::Image>(
         "camera/image_raw", qos, [this](sensor_msgs::msg::Image::UniquePtr msg_unique_ptr) { callback(std::move(msg_unique_ptr)); });
 }
-void mono::callback(sensor_msgs::msg::Image::UniquePtr msg_unique_ptr) {
-    sensor_msgs::msg::Image::ConstSharedPtr msg = std::move(msg_unique_ptr);
-    if (camera_optical_frame_.empty()) {
-        camera_optical_frame_ = msg->header.frame_id;
-    }
-    const rclcpp::Time tp_1 = node_->now();
-    const double timestamp = rclcpp::Time(msg->header.stamp).seconds();
-
-    // input the current frame and estimate the camera pose
-    auto cam_pose_wc = slam_->feed_monocular_frame(cv_bridge::toCvShare(msg, encoding_)->image, timestamp, mask_);
 
-    const rclcpp::Time tp_2 = node_->now();
-    const double track_time = (tp_2 - tp_1).seconds();
-
-    // track times in seconds
-    track_times_.push_back(track_time);
+mono::~mono() {
+    // the tracking thread calls track() of this class, so it must be stopped before the members are destroyed
+    stop_async_tracking();
+}
 
-    if (cam_pose_wc) {
-        publish_pose(*cam_pose_wc, msg->header.stamp);
-    }
-    if (publish_keyframes_) {
-        publish_keyframes(msg->header.stamp);
-    }
+void mono::callback(sensor_msgs::msg::Image::UniquePtr msg_unique_ptr) {
+    // the message is shared with the tracking thread without copying
+    callback(sensor_msgs::msg::Image::ConstSharedPtr(std::move(msg_unique_ptr)));
 }
 
 void mono::callback(const sensor_msgs::msg::Image::ConstSharedPtr& msg) {
     if (camera_optical_frame_.empty()) {
         camera_optical_frame_ = msg->header.frame_id;
     }
+    dispatch_tracking([this, msg]() { track(msg); });
+}
+
+void mono::track(const sensor_msgs::msg::Image::ConstSharedPtr& msg) {
     const rclcpp::Time tp_1 = node_->now();
     const double timestamp = rclcpp::Time(msg->header.stamp).seconds();
 
@@ -275,12 +579,7 @@ void mono::callback(const sensor_msgs::msg::Image::ConstSharedPtr& msg) {
     // track times in seconds
     track_times_.push_back(track_time);
 
-    if (cam_pose_wc) {
-        publish_pose(*cam_pose_wc, msg->header.stamp);
-    }
-    if (publish_keyframes_) {
-        publish_keyframes(msg->header.stamp);
-    }
+    publish_tracking_result(cam_pose_wc, msg->header.stamp);
 }
 
 stereo::stereo(const std::shared_ptr<stella_vslam::system>& slam,
@@ -303,10 +602,19 @@ stereo::stereo(const std::shared_ptr<stella_vslam::system>& slam,
     }
 }
 
+stereo::~stereo() {
+    // the tracking thread calls track() of this class, so it must be stopped before the members are destroyed
+    stop_async_tracking();
+}
+
 void stereo::callback(const sensor_msgs::msg::Image::ConstSharedPtr& left, const sensor_msgs::msg::Image::ConstSharedPtr& right) {
     if (camera_optical_frame_.empty()) {
         camera_optical_frame_ = left->header.frame_id;
     }
+    dispatch_tracking([this, left, right]() { track(left, right); });
+}
+
+void stereo::track(const sensor_msgs::msg::Image::ConstSharedPtr& left, const sensor_msgs::msg::Image::ConstSharedPtr& right) {
     auto leftcv = cv_bridge::toCvShare(left, encoding_)->image;
     auto rightcv = cv_bridge::toCvShare(right, encoding_)->image;
     if (leftcv.empty() || rightcv.empty()) {
@@ -329,12 +637,7 @@ void stereo::callback(const sensor_msgs::msg::Image::ConstSharedPtr& left, const
     // track times in seconds
     track_times_.push_back(track_time);
 
-    if (cam_pose_wc) {
-        publish_pose(*cam_pose_wc, left->header.stamp);
-    }
-    if (publish_keyframes_) {
-        publish_keyframes(left->header.stamp);
-    }
+    publish_tracking_result(cam_pose_wc, left->header.stamp);
 }
 
 rgbd::rgbd(const std::shared_ptr<stella_vslam::system>& slam,
@@ -355,10 +658,19 @@ rgbd::rgbd(const std::shared_ptr<stella_vslam::system>& slam,
     }
 }
 
+rgbd::~rgbd() {
+    // the tracking thread calls track() of this class, so it must be stopped before the members are destroyed
+    stop_async_tracking();
+}
+
 void rgbd::callback(const sensor_msgs::msg::Image::ConstSharedPtr& color, const sensor_msgs::msg::Image::ConstSharedPtr& depth) {
     if (camera_optical_frame_.empty()) {
         camera_optical_frame_ = color->header.frame_id;
     }
+    dispatch_tracking([this, color, depth]() { track(color, depth); });
+}
+
+void rgbd::track(const sensor_msgs::msg::Image::ConstSharedPtr& color, const sensor_msgs::msg::Image::ConstSharedPtr& depth) {
     auto colorcv = cv_bridge::toCvShare(color, encoding_)->image;
     auto depthcv = cv_bridge::toCvShare(depth)->image;
     if (colorcv.empty() || depthcv.empty()) {
@@ -380,12 +692,7 @@ void rgbd::callback(const sensor_msgs::msg::Image::ConstSharedPtr& color, const
     // track time in seconds
     track_times_.push_back(track_time);
 
-    if (cam_pose_wc) {
-        publish_pose(*cam_pose_wc, color->header.stamp);
-    }
-    if (publish_keyframes_) {
-        publish_keyframes(color->header.stamp);
-    }
+    publish_tracking_result(cam_pose_wc, color->header.stamp);
 }
 
 } // namespace stella_vslam_ros
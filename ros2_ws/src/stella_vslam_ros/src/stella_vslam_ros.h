@@ -15,6 +15,9 @@
 #include <cv_bridge/cv_bridge.h>
 #include <nav_msgs/msg/odometry.hpp>
 #include <geometry_msgs/msg/pose_array.hpp>
+#include <sensor_msgs/msg/point_cloud2.hpp>
+#include <visualization_msgs/msg/marker_array.hpp>
+#include <diagnostic_msgs/msg/diagnostic_array.hpp>
 
 #include <tf2_ros/transform_listener.h>
 #include <tf2_ros/transform_broadcaster.h>
@@ -24,15 +27,131 @@
 #include <sensor_msgs/msg/image.hpp>
 #include <geometry_msgs/msg/pose_with_covariance_stamped.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
 namespace stella_vslam_ros {
+
+/**
+ * Bounded queue between threads.
+ * When the queue is full, the oldest item is dropped if keep_latest is true (latest-wins),
+ * otherwise the new item is dropped (FIFO).
+ */
+template<typename T>
+class bounded_queue {
+public:
+    bounded_queue(const size_t capacity, const bool keep_latest)
+        : capacity_(std::max<size_t>(capacity, 1)), keep_latest_(keep_latest) {}
+
+    //! Push an item without blocking, return false if an item is dropped
+    bool push(T&& item) {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            if (is_closed_) {
+                return false;
+            }
+            ++num_pushed_;
+            if (capacity_ <= items_.size()) {
+                ++num_dropped_;
+                if (!keep_latest_) {
+                    return false;
+                }
+                items_.pop_front();
+                items_.push_back(std::move(item));
+                return false;
+            }
+            items_.push_back(std::move(item));
+        }
+        cv_.notify_one();
+        return true;
+    }
+
+    //! Pop an item, waiting until an item is pushed; return false if the queue is closed
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mtx_);
+        cv_.wait(lock, [this] {
+            return is_closed_ || !items_.empty();
+        });
+        if (is_closed_) {
+            return false;
+        }
+        item = std::move(items_.front());
+        items_.pop_front();
+        return true;
+    }
+
+    //! Wake up the consumer and discard the remaining items
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            is_closed_ = true;
+            items_.clear();
+        }
+        cv_.notify_all();
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return items_.size();
+    }
+
+    size_t capacity() const {
+        return capacity_;
+    }
+
+    bool keeps_latest() const {
+        return keep_latest_;
+    }
+
+    //! number of the items passed to push()
+    uint64_t get_num_pushed() const {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return num_pushed_;
+    }
+
+    //! number of the items dropped because the queue was full
+    uint64_t get_num_dropped() const {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return num_dropped_;
+    }
+
+private:
+    const size_t capacity_;
+    const bool keep_latest_;
+    mutable std::mutex mtx_;
+    std::condition_variable cv_;
+    std::deque<T> items_;
+    bool is_closed_ = false;
+    uint64_t num_pushed_ = 0;
+    uint64_t num_dropped_ = 0;
+};
+
 class system {
 public:
     system(const std::shared_ptr<stella_vslam::system>& slam,
            rclcpp::Node* node,
            const std::string& mask_img_path);
+    virtual ~system();
     void publish_pose(const Eigen::Matrix4d& cam_pose_wc, const rclcpp::Time& stamp);
+    // Publish the changes of the map at most once per map_publish_period_ (and the snapshot of the keyframes at most once per keyframes_snapshot_period_)
+    // ~/keyframes_delta is a MarkerArray whose marker IDs are the keyframe IDs (ADD: added or moved, DELETE: erased, DELETEALL: reloaded)
+    void publish_map(const rclcpp::Time& stamp);
+    // Publish the poses of all keyframes
     void publish_keyframes(const rclcpp::Time& stamp);
     void setParams();
+
+    // Stop the tracking and publishing threads of the asynchronous mode (the queued frames are discarded).
+    // Call this before stella_vslam::system::shutdown(). The destructors of the derived classes also call this,
+    // because the tracking thread runs their track() which uses their members.
+    void stop_async_tracking();
     std::shared_ptr<stella_vslam::system> slam_;
     std::shared_ptr<stella_vslam::config> cfg_;
     rclcpp::Node* node_;
@@ -42,6 +161,8 @@ public:
     std::shared_ptr<rclcpp::Publisher<nav_msgs::msg::Odometry>> pose_pub_;
     std::shared_ptr<rclcpp::Publisher<geometry_msgs::msg::PoseArray>> keyframes_pub_;
     std::shared_ptr<rclcpp::Publisher<geometry_msgs::msg::PoseArray>> keyframes_2d_pub_;
+    std::shared_ptr<rclcpp::Publisher<visualization_msgs::msg::MarkerArray>> keyframes_delta_pub_;
+    std::shared_ptr<rclcpp::Publisher<sensor_msgs::msg::PointCloud2>> landmarks_pub_;
     std::shared_ptr<rclcpp::Subscription<geometry_msgs::msg::PoseWithCovarianceStamped>>
         init_pose_sub_;
     std::shared_ptr<tf2_ros::TransformBroadcaster> map_to_odom_broadcaster_;
@@ -59,6 +180,15 @@ public:
     // If true, publish keyframes
     bool publish_keyframes_;
 
+    // If true, publish landmarks as a point cloud
+    bool publish_landmarks_;
+
+    // Minimum interval [s] of the publication of the changed keyframes and the landmarks
+    double map_publish_period_;
+
+    // Minimum interval [s] of the publication of all keyframes
+    double keyframes_snapshot_period_;
+
     // Publish pose's timestamp in the future
     double transform_tolerance_;
 
@@ -67,9 +197,67 @@ public:
 
     std::string encoding_;
 
+    // If true, the subscription callbacks only enqueue the images, and the frames are tracked in a dedicated thread
+    bool async_tracking_;
+
+    // Maximum number of the frames waiting to be tracked in the asynchronous mode
+    int frame_queue_size_;
+
+    // "latest": drop the oldest frame when the queue is full, "fifo": drop the new frame
+    std::string frame_queue_policy_;
+
+protected:
+    // Run the tracking in the dedicated thread if async_tracking_ is true, otherwise run it immediately
+    void dispatch_tracking(std::function<void()>&& track);
+
+    // Publish the pose and the keyframes in the dedicated thread if async_tracking_ is true, otherwise publish them immediately
+    void publish_tracking_result(const std::shared_ptr<Eigen::Matrix4d>& cam_pose_wc, const rclcpp::Time& stamp);
+
 private:
     void init_pose_callback(const geometry_msgs::msg::PoseWithCovarianceStamped::SharedPtr msg);
 
+    struct tracking_result {
+        std::shared_ptr<Eigen::Matrix4d> cam_pose_wc_;
+        rclcpp::Time stamp_;
+    };
+
+    void run_tracking();
+    void run_publishing();
+    void publish_diagnostics();
+
+    struct keyframe_poses {
+        geometry_msgs::msg::Pose pose_;
+        geometry_msgs::msg::Pose pose_2d_;
+    };
+
+    keyframe_poses to_keyframe_poses(const Eigen::Matrix4d& cam_pose_wc) const;
+    // Apply the changes of the map since map_version_ to the cache (return false if the whole map was read again)
+    bool update_map_cache();
+    void publish_keyframes_delta(const rclcpp::Time& stamp);
+    void publish_landmarks(const rclcpp::Time& stamp);
+
+    std::unique_ptr<bounded_queue<std::function<void()>>> frame_queue_;
+    std::unique_ptr<bounded_queue<tracking_result>> result_queue_;
+    std::unique_ptr<std::thread> tracking_thread_;
+    std::unique_ptr<std::thread> publishing_thread_;
+    std::shared_ptr<rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>> diagnostics_pub_;
+    rclcpp::TimerBase::SharedPtr diagnostics_timer_;
+    uint64_t prev_num_dropped_frames_ = 0;
+
+    // Cache of the map in ROS coordinate system, which is updated with the changes since map_version_
+    // (accessed only in the thread publishing the tracking results)
+    uint64_t map_version_ = 0;
+    std::map<unsigned int, keyframe_poses> keyfrm_poses_;
+    std::unordered_map<unsigned int, Eigen::Vector3f> lm_positions_;
+    // keyframes added, updated or erased since the last delta
+    std::vector<unsigned int> updated_keyfrm_ids_;
+    std::vector<unsigned int> erased_keyfrm_ids_;
+    // if true, the cache was read again, and the next delta replaces all the keyframes
+    bool keyfrms_reloaded_ = true;
+    bool keyfrms_changed_since_snapshot_ = true;
+    std::chrono::steady_clock::time_point next_map_publication_;
+    std::chrono::steady_clock::time_point next_keyfrms_snapshot_;
+
     Eigen::AngleAxisd rot_ros_to_cv_map_frame_;
 };
 
@@ -78,8 +266,10 @@ public:
     mono(const std::shared_ptr<stella_vslam::system>& slam,
          rclcpp::Node* node,
          const std::string& mask_img_path);
+    ~mono() override;
     void callback(sensor_msgs::msg::Image::UniquePtr msg);
     void callback(const sensor_msgs::msg::Image::ConstSharedPtr& msg);
+    void track(const sensor_msgs::msg::Image::ConstSharedPtr& msg);
 
     std::shared_ptr<rclcpp::Subscription<sensor_msgs::msg::Image>> raw_image_sub_;
 };
@@ -118,7 +308,9 @@ public:
            rclcpp::Node* node,
            const std::string& mask_img_path,
            const std::shared_ptr<stella_vslam::util::stereo_rectifier>& rectifier);
+    ~stereo() override;
     void callback(const sensor_msgs::msg::Image::ConstSharedPtr& left, const sensor_msgs::msg::Image::ConstSharedPtr& right);
+    void track(const sensor_msgs::msg::Image::ConstSharedPtr& left, const sensor_msgs::msg::Image::ConstSharedPtr& right);
 
     std::shared_ptr<stella_vslam::util::stereo_rectifier> rectifier_;
     ModifiedSubscriber<sensor_msgs::msg::Image> left_sf_, right_sf_;
@@ -134,7 +326,9 @@ public:
     rgbd(const std::shared_ptr<stella_vslam::system>& slam,
          rclcpp::Node* node,
          const std::string& mask_img_path);
+    ~rgbd() override;
     void callback(const sensor_msgs::msg::Image::ConstSharedPtr& color, const sensor_msgs::msg::Image::ConstSharedPtr& depth);
+    void track(const sensor_msgs::msg::Image::ConstSharedPtr& color, const sensor_msgs::msg::Image::ConstSharedPtr& depth);
 
     ModifiedSubscriber<sensor_msgs::msg::Image> color_sf_, depth_sf_;
     using ApproximateTimeSyncPolicy = message_filters::sync_policies::ApproximateTime<sensor_msgs::msg::Image, sensor_msgs::msg::Image>;
@@ -250,6 +250,11 @@ System::~System() {
         viewer_thread_->join();
     }
 
+    // stop the tracking thread before shutting down the SLAM process
+    if (slam_ros_) {
+        slam_ros_->stop_async_tracking();
+    }
+
     // shutdown the SLAM process
     slam_->shutdown();
 